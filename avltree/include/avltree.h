@@ -1,21 +1,46 @@
 #ifndef _AVLTREE_H
-#define _AVL_TREE_H
-#include <btree.h>
+#define _AVLTREE_H
 #include <stdint.h>
-//typedef struct avltree_t avltree;
-typedef struct btree_t avltree;
+#include <stdbool.h>
+typedef struct avltree_t avltree;
 typedef struct avltree_node avlnode;
+typedef struct avltree_iter avliter;
 
 avltree * avltree_init(void * p_data, void (* destroy)(void * p_data), int8_t (* compare)(void * key1, void * key2));
+avltree * avltree_build_sorted(void ** pp_items, int64_t count, void (* destroy)(void * p_data), int8_t (* compare)(void * key1, void * key2));
 void avltree_destroy(avltree * p_tree);
 int avltree_insert(avltree * p_tree, void * p_data);
 int8_t avltree_remove(avltree * p_tree, void * p_data);
+void * avltree_lookup(avltree * p_tree, void * p_key);
+int64_t avltree_lookup_batch(avltree * p_tree, void ** pp_keys, int64_t count, void ** pp_out);
+int8_t avltree_set_finger(avltree * p_tree, bool b_finger);
+int8_t avltree_set_prefix(avltree * p_tree, uint64_t (* prefix)(void * p_data), bool b_exact);
+int64_t avltree_rank(avltree * p_tree, void * p_key);
+void * avltree_select(avltree * p_tree, int64_t index);
+int64_t avltree_count_range(avltree * p_tree, void * p_low, void * p_high);
+int8_t avltree_set_lazy(avltree * p_tree, double fraction);
+int8_t avltree_compact(avltree * p_tree);
+int8_t avltree_join(avltree * p_dest, avltree * p_source);
+avltree * avltree_split(avltree * p_tree, void * p_key);
+int8_t avltree_union(avltree * p_dest, avltree * p_source, int threads);
+int8_t avltree_intersection(avltree * p_dest, avltree * p_source, int threads);
+int8_t avltree_difference(avltree * p_dest, avltree * p_source, int threads);
 int64_t avltree_size(avltree * p_tree);
+int64_t avltree_hidden(avltree * p_tree);
 void * avltree_data(avlnode * p_node);
 void avltree_preorder(avltree * p_tree, void (* func)(void * p_data));
 void avltree_inorder(avltree * p_tree, void (* func)(void * p_data));
 void avltree_postorder(avltree * p_tree, void (* func)(void * p_data));
 avlnode * avltree_root(avltree * p_tree);
+int64_t avltree_range(avltree * p_tree, void * p_low, void * p_high, void (* func)(void * p_data, void * p_ctx), void * p_ctx);
+avliter * avltree_iter_init(avltree * p_tree);
+void avltree_iter_destroy(avliter * p_iter);
+void * avltree_iter_first(avliter * p_iter);
+void * avltree_iter_last(avliter * p_iter);
+void * avltree_iter_seek(avliter * p_iter, void * p_key);
+void * avltree_iter_next(avliter * p_iter);
+void * avltree_iter_prev(avliter * p_iter);
+void * avltree_iter_data(avliter * p_iter);
 #define LEFT_HEAVY 1
 #define BALANCED 0
 #define RIGHT_HEAVY -1
@@ -0,0 +1,12 @@
+#ifndef _CAVLTREE_H
+#define _CAVLTREE_H
+#include <stdint.h>
+typedef struct cavltree cavltree;
+cavltree * cavltree_init(int threads, void (* destroy)(void * p_data), int8_t (* compare)(void * p_key1, void * p_key2));
+void cavltree_destroy(cavltree * p_tree);
+int8_t cavltree_insert(cavltree * p_tree, void * p_data);
+int8_t cavltree_remove(cavltree * p_tree, void * p_key);
+void * cavltree_lookup(cavltree * p_tree, void * p_key);
+int64_t cavltree_size(cavltree * p_tree);
+void cavltree_inorder(cavltree * p_tree, void (* func)(void * p_data));
+#endif
@@ -0,0 +1,12 @@
+#ifndef _INTERVAL_H
+#define _INTERVAL_H
+#include <stdint.h>
+typedef struct interval_t interval;
+interval * interval_init(void (* destroy)(void * p_data), int8_t (* compare)(void * p_point1, void * p_point2));
+void interval_destroy(interval * p_tree);
+int8_t interval_insert(interval * p_tree, void * p_low, void * p_high, void * p_data);
+int8_t interval_remove(interval * p_tree, void * p_low, void * p_high);
+int64_t interval_stab(interval * p_tree, void * p_point, void (* func)(void * p_data, void * p_ctx), void * p_ctx);
+int64_t interval_overlap(interval * p_tree, void * p_low, void * p_high, void (* func)(void * p_data, void * p_ctx), void * p_ctx);
+int64_t interval_size(interval * p_tree);
+#endif
@@ -0,0 +1,13 @@
+#ifndef _PAVLTREE_H
+#define _PAVLTREE_H
+#include <stdint.h>
+typedef struct pavltree pavltree;
+pavltree * pavltree_init(void (* destroy)(void * p_data), int8_t (* compare)(void * p_key1, void * p_key2));
+pavltree * pavltree_snapshot(pavltree * p_tree);
+void pavltree_destroy(pavltree * p_tree);
+int8_t pavltree_insert(pavltree * p_tree, void * p_data);
+int8_t pavltree_remove(pavltree * p_tree, void * p_key);
+void * pavltree_lookup(pavltree * p_tree, void * p_key);
+int64_t pavltree_size(pavltree * p_tree);
+void pavltree_inorder(pavltree * p_tree, void (* func)(void * p_data));
+#endif
@@ -1,329 +1,2041 @@
 #include <avltree.h>
-#include <btree.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <pthread.h>
 
 /*
- * @brief avltree node structure
- * @param p_data data for the node
+ * @param FIRST_BLOCK the number of nodes in the first block of the pool
+ * @param LAST_BLOCK the number of nodes blocks stop growing at
+ */
+enum {FIRST_BLOCK = 64, LAST_BLOCK = 4096};
+
+/*
+ * @param MAX_HEIGHT the most nodes on a path, an avltree of 2^64 nodes is
+ *  less than 93 nodes tall
+ */
+enum {MAX_HEIGHT = 96};
+
+/*
+ * @param IN_FLIGHT the number of searches a batched lookup advances in lock
+ *  step, enough to cover the latency of a miss to memory with the others
+ */
+enum {IN_FLIGHT = 16};
+
+/*
+ * @param UNION keep the data in either tree
+ * @param INTERSECTION keep the data in both trees
+ * @param DIFFERENCE keep the data only in the first tree
+ * @param PARALLEL_CUTOFF the fewest nodes both subtrees of a set operation
+ *  need before it forks a thread, the work shrinks with the smaller one
+ */
+enum {UNION = 0, INTERSECTION = 1, DIFFERENCE = 2, PARALLEL_CUTOFF = 2048};
+
+/*
+ * @brief avltree node structure, the links and data share one allocation
+ * @param p_left the left child of the node or the next free node in the pool
+ * @param p_right the right child of the node
+ * @param p_data data for the node or NULL while in the pool
+ * @param prefix the key prefix of the data, compared inline before the
+ *  compare function when the tree has a prefix function
+ * @param factor the balance factor of the node
  * @param b_hidden bool value to note if node should be hidden or not
- * @factor the balance factor of the node
+ * @param count the number of data that are not hidden in the subtree of the
+ *  node, kept in 32 bits so the node stays 40 bytes
  */
 typedef struct avltree_node {
+    struct avltree_node * p_left;
+    struct avltree_node * p_right;
     void * p_data;
+    uint64_t prefix;
+    int8_t factor;
     bool b_hidden;
-    int factor;
+    uint32_t count;
 } avltree_node;
 
-static void avltree_rotate_left(btnode ** p_node)
+/*
+ * @brief a block of nodes allocated at once for the pool
+ * @param p_next the next block in the pool
+ * @param count the number of nodes in the block
+ * @param nodes the nodes of the block
+ */
+typedef struct avltree_block {
+    struct avltree_block * p_next;
+    int64_t count;
+    avlnode nodes[];
+} avltree_block;
+
+/*
+ * @brief the blocks of nodes shared by the trees split from one another, a
+ *  pool merged into another by a join forwards to it, the free nodes stay
+ *  with each tree so only adding a block, split, join and destroy touch the
+ *  pool and they hold the pool lock while they do
+ * @param p_parent the pool this one was merged into, NULL while it holds the
+ *  blocks itself
+ * @param refs the number of trees and merged pools using this pool
+ * @param p_blocks the blocks of the pool
+ */
+typedef struct avltree_pool {
+    struct avltree_pool * p_parent;
+    int64_t refs;
+    avltree_block * p_blocks;
+} avltree_pool;
+
+/*
+ * @brief guards every pool so trees sharing one can be used by different
+ *  threads, it is only taken when a tree adds a block, splits, joins or is
+ *  torn down
+ */
+static pthread_mutex_t avltree_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * @brief a search path from the root of an avltree
+ * @param depth the number of nodes on the path
+ * @param p_nodes the nodes on the path starting at the root
+ * @param p_low the closest node above each node on the path whose data is
+ *  smaller than everything below it, NULL when there is none
+ * @param p_high the closest node above each node on the path whose data is
+ *  larger than everything below it, NULL when there is none
+ */
+typedef struct avltree_path {
+    int depth;
+    avlnode * p_nodes[MAX_HEIGHT];
+    avlnode * p_low[MAX_HEIGHT];
+    avlnode * p_high[MAX_HEIGHT];
+} avltree_path;
+
+/*
+ * @brief an iterator over an avltree in order, valid until the tree changes
+ * @param p_tree the tree being iterated
+ * @param depth the number of nodes on the path, 0 when outside the tree
+ * @param p_nodes the path from the root to the current node
+ */
+struct avltree_iter {
+    avltree * p_tree;
+    int depth;
+    avlnode * p_nodes[MAX_HEIGHT];
+};
+
+/*
+ * @brief the parts of a subtree split around a key
+ * @param p_left the subtree of data smaller than the key
+ * @param left_height the height of the smaller subtree
+ * @param p_mid the node holding data equal to the key or NULL
+ * @param p_right the subtree of data larger than the key
+ * @param right_height the height of the larger subtree
+ */
+typedef struct avltree_parts {
+    avlnode * p_left;
+    int left_height;
+    avlnode * p_mid;
+    avlnode * p_right;
+    int right_height;
+} avltree_parts;
+
+/*
+ * @brief one task of a set operation, tasks for disjoint subtrees share no
+ *  nodes so they can run on their own threads
+ * @param p_tree the tree providing the compare function
+ * @param op the set operation to run
+ * @param threads the threads the task may fork into
+ * @param p_first the subtree of the destination
+ * @param first_height the height of the destination subtree
+ * @param p_second the subtree of the source
+ * @param second_height the height of the source subtree
+ * @param p_result set to the root of the result
+ * @param height set to the height of the result
+ * @param p_discard the nodes left out of the result linked through p_left
+ * @param p_tail the last node linked into p_discard
+ */
+typedef struct avltree_setop {
+    avltree * p_tree;
+    int op;
+    int threads;
+    avlnode * p_first;
+    int first_height;
+    avlnode * p_second;
+    int second_height;
+    avlnode * p_result;
+    int height;
+    avlnode * p_discard;
+    avlnode * p_tail;
+} avltree_setop;
+
+/*
+ * @brief avltree structure
+ * @param p_root the root node of the tree
+ * @param size the number of nodes that are not hidden
+ * @param hidden the number of nodes removed in lazy mode but still linked
+ * @param lazy the fraction of hidden nodes that triggers a compaction,
+ *  0 when removed nodes are unlinked right away
+ * @param destroy user defined function to tear down the data
+ * @param compare user defined function to compare the data
+ * @param prefix user defined function giving the key prefix of the data,
+ *  NULL to always use the compare function
+ * @param b_exact true when equal prefixes mean equal data
+ * @param p_pool the pool the nodes of the tree come from
+ * @param p_free the nodes of the tree that are not linked into it
+ * @param block_size the number of nodes in the next block the tree adds
+ * @param p_finger the path of the last insert or remove, NULL unless set
+ */
+typedef struct avltree_t {
+    avlnode * p_root;
+    int64_t size;
+    int64_t hidden;
+    double lazy;
+    void (* destroy)(void * p_data);
+    int8_t (* compare)(void * key1, void * key2);
+    uint64_t (* prefix)(void * p_data);
+    bool b_exact;
+    avltree_pool * p_pool;
+    avlnode * p_free;
+    int64_t block_size;
+    avltree_path * p_finger;
+} avltree_t;
+
+/*
+ * @brief creates an empty pool used by one tree
+ * @return the new pool or NULL on error
+ */
+static avltree_pool * avltree_pool_init(void)
+{
+    avltree_pool * p_pool = calloc(1, sizeof(*p_pool));
+    if (NULL == p_pool){
+        perror("avltree pool ");
+        return NULL;
+    }
+    p_pool->refs = 1;
+    return p_pool;
+}
+
+/*
+ * @brief drops a reference to a pool, freeing its blocks once no tree uses
+ *  them and the pools that forward to a merged pool along the way, the
+ *  caller holds the pool lock
+ * @param p_pool the pool to drop
+ */
+static void avltree_pool_release(avltree_pool * p_pool)
+{
+    while ((NULL != p_pool) && (0 == --p_pool->refs)){
+        avltree_pool * p_parent = p_pool->p_parent;
+        avltree_block * p_block = p_pool->p_blocks;
+        while (NULL != p_block){
+            avltree_block * p_next = p_block->p_next;
+            free(p_block);
+            p_block = p_next;
+        }
+        free(p_pool);
+        p_pool = p_parent;
+    }
+}
+
+/*
+ * @brief gets the pool holding the blocks for the nodes of a tree, pointing
+ *  the tree straight at it when its pool was merged into another, the
+ *  caller holds the pool lock
+ * @param p_tree the tree to get the pool of
+ * @return the pool holding the blocks
+ */
+static avltree_pool * avltree_pool_find(avltree * p_tree)
+{
+    avltree_pool * p_pool = p_tree->p_pool;
+    if (NULL == p_pool->p_parent){
+        return p_pool;
+    }
+    while (NULL != p_pool->p_parent){
+        p_pool = p_pool->p_parent;
+    }
+    p_pool->refs++;
+    avltree_pool_release(p_tree->p_pool);
+    p_tree->p_pool = p_pool;
+    return p_pool;
+}
+
+/*
+ * @brief merges the pool of one tree into the pool of another so nodes of
+ *  both trees can be linked together, trees still using the merged pool
+ *  are forwarded to the other
+ * @param p_dest the tree whose pool takes the blocks and free nodes
+ * @param p_source the tree whose pool gives them up
+ */
+static void avltree_pool_merge(avltree * p_dest, avltree * p_source)
+{
+    // the free nodes of the source are only its own
+    while (NULL != p_source->p_free){
+        avlnode * p_node = p_source->p_free;
+        p_source->p_free = p_node->p_left;
+        p_node->p_left = p_dest->p_free;
+        p_dest->p_free = p_node;
+    }
+    if (p_dest->block_size < p_source->block_size){
+        p_dest->block_size = p_source->block_size;
+    }
+    pthread_mutex_lock(&avltree_pool_lock);
+    avltree_pool * p_into = avltree_pool_find(p_dest);
+    avltree_pool * p_from = avltree_pool_find(p_source);
+    if (p_into == p_from){
+        pthread_mutex_unlock(&avltree_pool_lock);
+        return;
+    }
+    // hand the blocks and free nodes of the source over to the destination
+    if (NULL != p_from->p_blocks){
+        avltree_block * p_last = p_from->p_blocks;
+        while (NULL != p_last->p_next){
+            p_last = p_last->p_next;
+        }
+        p_last->p_next = p_into->p_blocks;
+        p_into->p_blocks = p_from->p_blocks;
+    }
+    p_from->p_blocks = NULL;
+    p_from->p_parent = p_into;
+    p_into->refs++;
+    pthread_mutex_unlock(&avltree_pool_lock);
+}
+
+/*
+ * @brief allocates a block of nodes and adds it to the pool of a tree
+ *  without threading its nodes onto the free list
+ * @param p_tree the tree whose pool takes the block
+ * @param count the number of nodes in the block
+ * @return the new block or NULL on error
+ */
+static avltree_block * avltree_block_alloc(avltree * p_tree, int64_t count)
+{
+    avltree_block * p_block = calloc(1, sizeof(*p_block) + (count * sizeof(avlnode)));
+    if (NULL == p_block){
+        perror("avltree block ");
+        return NULL;
+    }
+    p_block->count = count;
+    pthread_mutex_lock(&avltree_pool_lock);
+    avltree_pool * p_pool = avltree_pool_find(p_tree);
+    p_block->p_next = p_pool->p_blocks;
+    p_pool->p_blocks = p_block;
+    pthread_mutex_unlock(&avltree_pool_lock);
+    return p_block;
+}
+
+/*
+ * @brief gets the key prefix of data once so a search can compare it inline
+ * @param p_tree the tree providing the prefix function
+ * @param p_key the data or key to get the prefix of
+ * @return the prefix or 0 when the tree has no prefix function
+ */
+static uint64_t avltree_prefix(avltree * p_tree, void * p_key)
+{
+    return (NULL == p_tree->prefix) ? 0 : p_tree->prefix(p_key);
+}
+
+/*
+ * @brief compares a key with the data of a node, the prefixes are compared
+ *  inline and the compare function only runs when they are equal
+ * @param p_tree the tree providing the compare function
+ * @param p_key the key to compare
+ * @param prefix the prefix of the key
+ * @param p_node the node to compare with
+ * @return less than, equal to or greater than 0 as the key is smaller than,
+ *  equal to or larger than the data of the node
+ */
+static int avltree_order(avltree * p_tree, void * p_key, uint64_t prefix, avlnode * p_node)
+{
+    if (NULL != p_tree->prefix){
+        if (prefix != p_node->prefix){
+            return (prefix < p_node->prefix) ? -1 : 1;
+        }
+        if (p_tree->b_exact){
+            return 0;
+        }
+    }
+    return p_tree->compare(p_key, p_node->p_data);
+}
+
+/*
+ * @brief hints that memory will be read soon so the miss overlaps other work
+ * @param p_addr the address to fetch
+ */
+static void avltree_prefetch(const void * p_addr)
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(p_addr, 0, 3);
+#else
+    (void)p_addr;
+#endif
+}
+
+/*
+ * @brief takes a free node of the tree adding a block to its pool when it
+ *  has none
+ * @param p_tree the tree the node is for
+ * @param p_data the data for the node
+ * @return a balanced leaf holding the data or NULL on error
+ */
+static avlnode * avltree_node_alloc(avltree * p_tree, void * p_data)
+{
+    if (NULL == p_tree->p_free){
+        avltree_block * p_block = avltree_block_alloc(p_tree, p_tree->block_size);
+        if (NULL == p_block){
+            return NULL;
+        }
+        // thread the new nodes onto the free list
+        for (int64_t index = 0; index < p_block->count; index++){
+            p_block->nodes[index].p_left = p_tree->p_free;
+            p_tree->p_free = &p_block->nodes[index];
+        }
+        if (p_tree->block_size < LAST_BLOCK){
+            p_tree->block_size *= 2;
+        }
+    }
+    avlnode * p_node = p_tree->p_free;
+    p_tree->p_free = p_node->p_left;
+    p_node->p_left = NULL;
+    p_node->p_right = NULL;
+    p_node->p_data = p_data;
+    p_node->prefix = avltree_prefix(p_tree, p_data);
+    p_node->factor = BALANCED;
+    p_node->b_hidden = false;
+    p_node->count = 1;
+    return p_node;
+}
+
+/*
+ * @brief returns a node to the free nodes of the tree and runs the destroy
+ *  function on its data
+ * @param p_tree the tree the node was in
+ * @param p_node the unlinked node to return
+ */
+static void release(avltree * p_tree, avlnode * p_node)
+{
+    if (NULL != p_tree->destroy){
+        p_tree->destroy(p_node->p_data);
+    }
+    p_node->p_data = NULL;
+    p_node->p_right = NULL;
+    p_node->p_left = p_tree->p_free;
+    p_tree->p_free = p_node;
+}
+
+/*
+ * @brief returns every node of a subtree to the pool without recursion
+ * @param p_tree the tree the nodes were in
+ * @param p_node the root of the subtree
+ */
+static void release_all(avltree * p_tree, avlnode * p_node)
+{
+    while (NULL != p_node){
+        if (NULL != p_node->p_left){
+            // rotate the left child up until the node has none
+            avlnode * p_left = p_node->p_left;
+            p_node->p_left = p_left->p_right;
+            p_left->p_right = p_node;
+            p_node = p_left;
+            continue;
+        }
+        avlnode * p_right = p_node->p_right;
+        release(p_tree, p_node);
+        p_node = p_right;
+    }
+}
+
+/*
+ * @brief gets the number of data that are not hidden below a node
+ * @param p_node the root of the subtree, NULL for an empty subtree
+ * @return the number of data in the subtree
+ */
+static int64_t avltree_count(avlnode * p_node)
+{
+    return (NULL == p_node) ? 0 : p_node->count;
+}
+
+/*
+ * @brief recomputes the subtree count of a node from its children, every
+ *  change to the links or hidden flag of a node goes through here
+ * @param p_node the node to update
+ */
+static void avltree_update(avlnode * p_node)
+{
+    p_node->count = (p_node->b_hidden ? 0 : 1) + avltree_count(p_node->p_left) + avltree_count(p_node->p_right);
+}
+
+/*
+ * @brief rotates a subtree to the right so its left child becomes the root
+ *  and updates the balance factors for any shape of the subtree
+ * @param p_node the root of the subtree
+ * @return the new root of the subtree
+ */
+static avlnode * avltree_rotate_right(avlnode * p_node)
+{
+    avlnode * p_left = p_node->p_left;
+    p_node->p_left = p_left->p_right;
+    p_left->p_right = p_node;
+    // the heights are recovered from the factors before the rotation
+    p_node->factor = p_node->factor - 1 - ((p_left->factor > 0) ? p_left->factor : 0);
+    p_left->factor = p_left->factor - 1 + ((p_node->factor < 0) ? p_node->factor : 0);
+    avltree_update(p_node);
+    avltree_update(p_left);
+    return p_left;
+}
+
+/*
+ * @brief rotates a subtree to the left so its right child becomes the root
+ *  and updates the balance factors for any shape of the subtree
+ * @param p_node the root of the subtree
+ * @return the new root of the subtree
+ */
+static avlnode * avltree_rotate_left(avlnode * p_node)
+{
+    avlnode * p_right = p_node->p_right;
+    p_node->p_right = p_right->p_left;
+    p_right->p_left = p_node;
+    p_node->factor = p_node->factor + 1 - ((p_right->factor < 0) ? p_right->factor : 0);
+    p_right->factor = p_right->factor + 1 + ((p_node->factor > 0) ? p_node->factor : 0);
+    avltree_update(p_node);
+    avltree_update(p_right);
+    return p_right;
+}
+
+/*
+ * @brief restores the balance of a subtree whose factor reached two
+ * @param p_node the root of the subtree
+ * @return the new root of the subtree
+ */
+static avlnode * avltree_rebalance(avlnode * p_node)
+{
+    if (p_node->factor > LEFT_HEAVY){
+        // a right heavy left child needs a left right rotation
+        if (RIGHT_HEAVY == (p_node->p_left)->factor){
+            p_node->p_left = avltree_rotate_left(p_node->p_left);
+        }
+        return avltree_rotate_right(p_node);
+    }
+    if (p_node->factor < RIGHT_HEAVY){
+        // a left heavy right child needs a right left rotation
+        if (LEFT_HEAVY == (p_node->p_right)->factor){
+            p_node->p_right = avltree_rotate_right(p_node->p_right);
+        }
+        return avltree_rotate_left(p_node);
+    }
+    return p_node;
+}
+
+/*
+ * @brief searches for a key keeping the path, a path left by an earlier
+ *  search is climbed only until the key falls below one of its nodes
+ * @param p_tree the tree to search
+ * @param p_path the path to search from, empty to start at the root
+ * @param p_key the key to search for
+ * @return 0 when the last node on the path holds the key, otherwise the
+ *  side of the last node where the key belongs, with an empty path for an
+ *  empty tree
+ */
+static int avltree_seek(avltree * p_tree, avltree_path * p_path, void * p_key)
+{
+    int depth = p_path->depth - 1;
+    int cmpval = 0;
+    uint64_t prefix = avltree_prefix(p_tree, p_key);
+    if (NULL == p_tree->p_root){
+        p_path->depth = 0;
+        return -1;
+    }
+    if (depth < 0){
+        p_path->p_nodes[0] = p_tree->p_root;
+        p_path->p_low[0] = NULL;
+        p_path->p_high[0] = NULL;
+        depth = 0;
+    }
+    // climb until the key is strictly between the bounds of the subtree
+    while (depth > 0){
+        if (((NULL == p_path->p_low[depth]) || (avltree_order(p_tree, p_key, prefix, p_path->p_low[depth]) > 0)) && \
+            ((NULL == p_path->p_high[depth]) || (avltree_order(p_tree, p_key, prefix, p_path->p_high[depth]) < 0))){
+            break;
+        }
+        depth--;
+    }
+    for (;;){
+        avlnode * p_node = p_path->p_nodes[depth];
+        avlnode * p_child = NULL;
+        cmpval = avltree_order(p_tree, p_key, prefix, p_node);
+        p_child = (cmpval < 0) ? p_node->p_left : p_node->p_right;
+        if ((0 == cmpval) || (NULL == p_child)){
+            break;
+        }
+        // the node bounds the child subtree on the side it was left from
+        p_path->p_nodes[depth + 1] = p_child;
+        p_path->p_low[depth + 1] = (cmpval < 0) ? p_path->p_low[depth] : p_node;
+        p_path->p_high[depth + 1] = (cmpval < 0) ? p_node : p_path->p_high[depth];
+        depth++;
+    }
+    p_path->depth = depth + 1;
+    return cmpval;
+}
+
+/*
+ * @brief inserts data at the end of a search path and rebalances the path
+ *  from the bottom up
+ * @param p_tree the tree to insert into
+ * @param p_path the path left by searching for the data
+ * @param cmpval the result of the search
+ * @param p_data the data to insert
+ * @return 0 on success -1 when the data is already in the tree or on failure
+ */
+static int insert(avltree * p_tree, avltree_path * p_path, int cmpval, void * p_data)
+{
+    avlnode * p_node = p_path->p_nodes[p_path->depth - 1];
+    avlnode * p_child = NULL;
+    if (0 == cmpval){
+        // the data is already in the tree and not hidden
+        if (!p_node->b_hidden){
+            return -1;
+        }
+        // reuse the hidden node for the new data and label it not hidden
+        if (NULL != p_tree->destroy){
+            p_tree->destroy(p_node->p_data);
+        }
+        p_node->p_data = p_data;
+        p_node->prefix = avltree_prefix(p_tree, p_data);
+        p_node->b_hidden = false;
+        p_tree->hidden--;
+        p_tree->size++;
+        for (int depth = 0; depth < p_path->depth; depth++){
+            p_path->p_nodes[depth]->count++;
+        }
+        return 0;
+    }
+    // insert the data as a new leaf
+    p_child = avltree_node_alloc(p_tree, p_data);
+    if (NULL == p_child){
+        return -1;
+    }
+    if (cmpval < 0){
+        p_node->p_left = p_child;
+    }
+    else {
+        p_node->p_right = p_child;
+    }
+    p_tree->size++;
+    p_path->p_nodes[p_path->depth] = p_child;
+    p_path->p_low[p_path->depth] = (cmpval < 0) ? p_path->p_low[p_path->depth - 1] : p_node;
+    p_path->p_high[p_path->depth] = (cmpval < 0) ? p_node : p_path->p_high[p_path->depth - 1];
+    for (int depth = 0; depth < p_path->depth; depth++){
+        p_path->p_nodes[depth]->count++;
+    }
+    p_path->depth++;
+    // keep the tree balanced, every subtree on the path grew until a
+    // factor balances out or a rotation restores the old height
+    for (int depth = p_path->depth - 2; depth >= 0; depth--){
+        p_node = p_path->p_nodes[depth];
+        p_node->factor += (p_path->p_nodes[depth + 1] == p_node->p_left) ? 1 : -1;
+        if (BALANCED == p_node->factor){
+            break;
+        }
+        if ((p_node->factor > LEFT_HEAVY) || (p_node->factor < RIGHT_HEAVY)){
+            p_child = avltree_rebalance(p_node);
+            if (0 == depth){
+                p_tree->p_root = p_child;
+            }
+            else if (p_path->p_nodes[depth - 1]->p_left == p_node){
+                p_path->p_nodes[depth - 1]->p_left = p_child;
+            }
+            else {
+                p_path->p_nodes[depth - 1]->p_right = p_child;
+            }
+            // the nodes above the rotation keep their place
+            p_path->depth = depth;
+            break;
+        }
+    }
+    return 0;
+}
+
+/*
+ * @brief updates the balance of a node after one of its subtrees shrunk
+ * @param p_node the node whose subtree shrunk
+ * @param b_left true when the left subtree shrunk
+ * @param p_shrunk set when the node's subtree got shorter too
+ * @return the new root of the subtree
+ */
+static avlnode * shrink(avlnode * p_node, bool b_left, bool * p_shrunk)
+{
+    p_node->factor += (b_left) ? -1 : 1;
+    if ((LEFT_HEAVY == p_node->factor) || (RIGHT_HEAVY == p_node->factor)){
+        // the other subtree still holds the height
+        *p_shrunk = false;
+        return p_node;
+    }
+    if (BALANCED == p_node->factor){
+        return p_node;
+    }
+    // a rotation only keeps the height when the new root ends up unbalanced
+    p_node = avltree_rebalance(p_node);
+    *p_shrunk = (BALANCED == p_node->factor);
+    return p_node;
+}
+
+/*
+ * @brief unlinks the smallest node of a subtree
+ * @param p_node the root of the subtree
+ * @param pp_min set to the unlinked node
+ * @param p_shrunk set when the subtree got shorter
+ * @return the new root of the subtree
+ */
+static avlnode * detach_min(avlnode * p_node, avlnode ** pp_min, bool * p_shrunk)
+{
+    if (NULL == p_node->p_left){
+        *pp_min = p_node;
+        *p_shrunk = true;
+        return p_node->p_right;
+    }
+    p_node->p_left = detach_min(p_node->p_left, pp_min, p_shrunk);
+    avltree_update(p_node);
+    return (*p_shrunk) ? shrink(p_node, true, p_shrunk) : p_node;
+}
+
+/*
+ * @brief unlinks the node holding data equal to the key from a subtree
+ * @param p_tree the tree to remove from
+ * @param p_node the root of the subtree
+ * @param p_data the key to remove
+ * @param prefix the prefix of the key
+ * @param pp_removed set to the unlinked node which holds the removed data
+ * @param p_shrunk set when the subtree got shorter
+ * @return the new root of the subtree
+ */
+static avlnode * detach(avltree * p_tree, avlnode * p_node, void * p_data, uint64_t prefix, avlnode ** pp_removed, bool * p_shrunk)
+{
+    avlnode * p_successor = NULL;
+    void * p_swap = NULL;
+    bool b_swap = false;
+    int cmpval = 0;
+    // data cant be found if node is end of branch
+    if (NULL == p_node){
+        return NULL;
+    }
+    cmpval = avltree_order(p_tree, p_data, prefix, p_node);
+    if (cmpval < 0){
+        p_node->p_left = detach(p_tree, p_node->p_left, p_data, prefix, pp_removed, p_shrunk);
+        avltree_update(p_node);
+        return (*p_shrunk) ? shrink(p_node, true, p_shrunk) : p_node;
+    }
+    if (cmpval > 0){
+        p_node->p_right = detach(p_tree, p_node->p_right, p_data, prefix, pp_removed, p_shrunk);
+        avltree_update(p_node);
+        return (*p_shrunk) ? shrink(p_node, false, p_shrunk) : p_node;
+    }
+    *p_shrunk = true;
+    if (NULL == p_node->p_left){
+        *pp_removed = p_node;
+        return p_node->p_right;
+    }
+    if (NULL == p_node->p_right){
+        *pp_removed = p_node;
+        return p_node->p_left;
+    }
+    // a node with two children takes the data of its successor, which is
+    // unlinked in its place holding the removed data
+    p_node->p_right = detach_min(p_node->p_right, &p_successor, p_shrunk);
+    p_swap = p_node->p_data;
+    b_swap = p_node->b_hidden;
+    p_node->p_data = p_successor->p_data;
+    p_node->prefix = p_successor->prefix;
+    p_node->b_hidden = p_successor->b_hidden;
+    p_successor->p_data = p_swap;
+    p_successor->b_hidden = b_swap;
+    avltree_update(p_node);
+    *pp_removed = p_successor;
+    return (*p_shrunk) ? shrink(p_node, false, p_shrunk) : p_node;
+}
+
+/*
+ * @brief hides the node holding data equal to a key and takes it out of the
+ *  subtree counts on its path
+ * @param p_tree the tree to hide the data in
+ * @param p_data the key of the data to hide
+ * @return 0 on success -1 when the data is not in the tree
+ */
+static int hide(avltree * p_tree, void * p_data)
+{
+    avltree_path path;
+    avltree_path * p_path = (NULL != p_tree->p_finger) ? p_tree->p_finger : &path;
+    if (p_path == &path){
+        path.depth = 0;
+    }
+    if ((0 != avltree_seek(p_tree, p_path, p_data)) || (0 == p_path->depth) || \
+        p_path->p_nodes[p_path->depth - 1]->b_hidden){
+        return -1;
+    }
+    p_path->p_nodes[p_path->depth - 1]->b_hidden = true;
+    for (int depth = 0; depth < p_path->depth; depth++){
+        p_path->p_nodes[depth]->count--;
+    }
+    return 0;
+}
+
+/*
+ * @brief forgets the path of the last search once the nodes on it may have
+ *  moved
+ * @param p_tree the tree to forget the path of
+ */
+static void avltree_forget(avltree * p_tree)
+{
+    if (NULL != p_tree->p_finger){
+        p_tree->p_finger->depth = 0;
+    }
+}
+
+/*
+ * @brief gathers the nodes of a subtree in order while freeing the hidden ones
+ * @param p_tree the tree the nodes belong to
+ * @param p_node the root of the subtree
+ * @param pp_nodes storage for the nodes that are not hidden
+ * @param p_count the number of nodes gathered so far
+ */
+static void gather(avltree * p_tree, avlnode * p_node, avlnode ** pp_nodes, int64_t * p_count)
+{
+    avlnode * p_right = NULL;
+    if (NULL == p_node){
+        return;
+    }
+    p_right = p_node->p_right;
+    gather(p_tree, p_node->p_left, pp_nodes, p_count);
+    if (p_node->b_hidden){
+        release(p_tree, p_node);
+    }
+    else {
+        pp_nodes[(*p_count)++] = p_node;
+    }
+    gather(p_tree, p_right, pp_nodes, p_count);
+}
+
+/*
+ * @brief links nodes in order into a perfectly balanced subtree
+ * @param pp_nodes the nodes in order
+ * @param count the number of nodes
+ * @param p_height set to the height of the subtree
+ * @return the root of the subtree
+ */
+static avlnode * relink(avlnode ** pp_nodes, int64_t count, int * p_height)
+{
+    int left_height = 0;
+    int right_height = 0;
+    avlnode * p_node = NULL;
+    if (0 == count){
+        *p_height = 0;
+        return NULL;
+    }
+    // the left half takes the extra node so no factor is right heavy
+    p_node = pp_nodes[count / 2];
+    p_node->p_left = relink(pp_nodes, count / 2, &left_height);
+    p_node->p_right = relink(pp_nodes + (count / 2) + 1, count - (count / 2) - 1, &right_height);
+    p_node->factor = left_height - right_height;
+    avltree_update(p_node);
+    *p_height = ((left_height > right_height) ? left_height : right_height) + 1;
+    return p_node;
+}
+
+/*
+ * @brief fills consecutive nodes with sorted data and links them into a
+ *  perfectly balanced subtree
+ * @param p_nodes the nodes in order
+ * @param pp_items the data for the nodes in order
+ * @param count the number of nodes
+ * @param p_height set to the height of the subtree
+ * @return the root of the subtree
+ */
+static avlnode * build(avlnode * p_nodes, void ** pp_items, int64_t count, int * p_height)
+{
+    int left_height = 0;
+    int right_height = 0;
+    avlnode * p_node = NULL;
+    if (0 == count){
+        *p_height = 0;
+        return NULL;
+    }
+    p_node = &p_nodes[count / 2];
+    p_node->p_data = pp_items[count / 2];
+    p_node->prefix = 0;
+    p_node->p_left = build(p_nodes, pp_items, count / 2, &left_height);
+    p_node->p_right = build(p_node + 1, pp_items + (count / 2) + 1, count - (count / 2) - 1, &right_height);
+    p_node->factor = left_height - right_height;
+    avltree_update(p_node);
+    *p_height = ((left_height > right_height) ? left_height : right_height) + 1;
+    return p_node;
+}
+
+/*
+ * @brief frees all hidden nodes and rebuilds the rest into a perfectly
+ *  balanced tree in linear time
+ * @param p_tree the tree to compact
+ * @return 0 on success -1 on failure
+ */
+static int8_t compact(avltree * p_tree)
+{
+    int64_t count = 0;
+    int height = 0;
+    avlnode ** pp_nodes = calloc(p_tree->size + 1, sizeof(*pp_nodes));
+    if (NULL == pp_nodes){
+        perror("avltree_compact ");
+        return -1;
+    }
+    // the nodes are reused so the rebuild can not fail part way through
+    gather(p_tree, p_tree->p_root, pp_nodes, &count);
+    p_tree->p_root = relink(pp_nodes, count, &height);
+    p_tree->hidden = 0;
+    avltree_forget(p_tree);
+    free(pp_nodes);
+    return 0;
+}
+
+/*
+ * @brief runs a function on the data of every node that is not hidden
+ * @param p_node the root of the subtree to traverse
+ * @param order negative for preorder, 0 for inorder, positive for postorder
+ * @param func user defined function to run
+ */
+static void traverse(avlnode * p_node, int order, void (* func)(void * p_data))
+{
+    if (NULL == p_node){
+        return;
+    }
+    if ((order < 0) && !p_node->b_hidden){
+        func(p_node->p_data);
+    }
+    traverse(p_node->p_left, order, func);
+    if ((0 == order) && !p_node->b_hidden){
+        func(p_node->p_data);
+    }
+    traverse(p_node->p_right, order, func);
+    if ((order > 0) && !p_node->b_hidden){
+        func(p_node->p_data);
+    }
+}
+
+/*
+ * @brief gets the height of a subtree in O(log n) by following the taller
+ *  child down
+ * @param p_node the root of the subtree
+ * @return the number of nodes on its longest path
+ */
+static int avltree_height(avlnode * p_node)
+{
+    int height = 0;
+    while (NULL != p_node){
+        height++;
+        p_node = (RIGHT_HEAVY == p_node->factor) ? p_node->p_right : p_node->p_left;
+    }
+    return height;
+}
+
+/*
+ * @brief gets the height of a child from the height of its parent
+ * @param p_node the parent
+ * @param height the height of the parent
+ * @param b_left true for the left child, false for the right one
+ * @return the height of the child
+ */
+static int avltree_child_height(avlnode * p_node, int height, bool b_left)
+{
+    // a child on the lighter side is two shorter than its parent
+    if (b_left){
+        return height - ((RIGHT_HEAVY == p_node->factor) ? 2 : 1);
+    }
+    return height - ((LEFT_HEAVY == p_node->factor) ? 2 : 1);
+}
+
+/*
+ * @brief updates the balance of a node after one of its subtrees grew
+ * @param p_node the node whose subtree grew
+ * @param b_left true when the left subtree grew
+ * @param p_grew set when the subtree of the node got taller too
+ * @return the new root of the subtree
+ */
+static avlnode * grow(avlnode * p_node, bool b_left, bool * p_grew)
+{
+    p_node->factor += (b_left) ? 1 : -1;
+    if (BALANCED == p_node->factor){
+        *p_grew = false;
+        return p_node;
+    }
+    if ((LEFT_HEAVY == p_node->factor) || (RIGHT_HEAVY == p_node->factor)){
+        return p_node;
+    }
+    // a single rotation over a balanced child leaves the subtree taller
+    p_node = avltree_rebalance(p_node);
+    *p_grew = (BALANCED != p_node->factor);
+    return p_node;
+}
+
+/*
+ * @brief joins a node and a shorter subtree onto the right spine of a taller
+ *  subtree
+ * @param p_left the taller subtree
+ * @param left_height the height of the taller subtree
+ * @param p_mid the node whose data lies between the subtrees
+ * @param p_right the shorter subtree
+ * @param right_height the height of the shorter subtree
+ * @param p_grew set when the result is taller than the taller subtree
+ * @return the root of the result
+ */
+static avlnode * join_right(avlnode * p_left, int left_height, avlnode * p_mid, avlnode * p_right, int right_height, bool * p_grew)
+{
+    avlnode * p_child = p_left->p_right;
+    int child_height = avltree_child_height(p_left, left_height, false);
+    if (child_height <= right_height + 1){
+        // the spine is never shorter than the subtree here
+        p_mid->p_left = p_child;
+        p_mid->p_right = p_right;
+        p_mid->factor = child_height - right_height;
+        avltree_update(p_mid);
+        p_left->p_right = p_mid;
+        *p_grew = true;
+    }
+    else {
+        p_left->p_right = join_right(p_child, child_height, p_mid, p_right, right_height, p_grew);
+    }
+    avltree_update(p_left);
+    return (*p_grew) ? grow(p_left, false, p_grew) : p_left;
+}
+
+/*
+ * @brief joins a node and a shorter subtree onto the left spine of a taller
+ *  subtree
+ * @param p_left the shorter subtree
+ * @param left_height the height of the shorter subtree
+ * @param p_mid the node whose data lies between the subtrees
+ * @param p_right the taller subtree
+ * @param right_height the height of the taller subtree
+ * @param p_grew set when the result is taller than the taller subtree
+ * @return the root of the result
+ */
+static avlnode * join_left(avlnode * p_left, int left_height, avlnode * p_mid, avlnode * p_right, int right_height, bool * p_grew)
+{
+    avlnode * p_child = p_right->p_left;
+    int child_height = avltree_child_height(p_right, right_height, true);
+    if (child_height <= left_height + 1){
+        p_mid->p_left = p_left;
+        p_mid->p_right = p_child;
+        p_mid->factor = left_height - child_height;
+        avltree_update(p_mid);
+        p_right->p_left = p_mid;
+        *p_grew = true;
+    }
+    else {
+        p_right->p_left = join_left(p_left, left_height, p_mid, p_child, child_height, p_grew);
+    }
+    avltree_update(p_right);
+    return (*p_grew) ? grow(p_right, true, p_grew) : p_right;
+}
+
+/*
+ * @brief joins two subtrees and a node whose data lies between them in
+ *  O(1 + the difference of their heights)
+ * @param p_left the subtree of smaller data
+ * @param left_height the height of the smaller subtree
+ * @param p_mid the node to join them with
+ * @param p_right the subtree of larger data
+ * @param right_height the height of the larger subtree
+ * @param p_height set to the height of the result
+ * @return the root of the result
+ */
+static avlnode * join(avlnode * p_left, int left_height, avlnode * p_mid, avlnode * p_right, int right_height, int * p_height)
+{
+    bool b_grew = false;
+    if (left_height > right_height + 1){
+        p_left = join_right(p_left, left_height, p_mid, p_right, right_height, &b_grew);
+        *p_height = left_height + ((b_grew) ? 1 : 0);
+        return p_left;
+    }
+    if (right_height > left_height + 1){
+        p_right = join_left(p_left, left_height, p_mid, p_right, right_height, &b_grew);
+        *p_height = right_height + ((b_grew) ? 1 : 0);
+        return p_right;
+    }
+    p_mid->p_left = p_left;
+    p_mid->p_right = p_right;
+    p_mid->factor = left_height - right_height;
+    avltree_update(p_mid);
+    *p_height = ((left_height > right_height) ? left_height : right_height) + 1;
+    return p_mid;
+}
+
+/*
+ * @brief joins two subtrees using the smallest node of the larger one as the
+ *  node between them
+ * @param p_left the subtree of smaller data
+ * @param left_height the height of the smaller subtree
+ * @param p_right the subtree of larger data
+ * @param right_height the height of the larger subtree
+ * @param p_height set to the height of the result
+ * @return the root of the result
+ */
+static avlnode * join_two(avlnode * p_left, int left_height, avlnode * p_right, int right_height, int * p_height)
+{
+    avlnode * p_min = NULL;
+    bool b_shrunk = false;
+    if (NULL == p_right){
+        *p_height = left_height;
+        return p_left;
+    }
+    p_right = detach_min(p_right, &p_min, &b_shrunk);
+    return join(p_left, left_height, p_min, p_right, right_height - ((b_shrunk) ? 1 : 0), p_height);
+}
+
+/*
+ * @brief splits a subtree around a key in O(log n)
+ * @param p_tree the tree providing the compare function
+ * @param p_node the root of the subtree
+ * @param height the height of the subtree
+ * @param p_key the key to split around
+ * @param prefix the prefix of the key
+ * @param p_parts set to the subtrees below and above the key and the node
+ *  equal to it, whose links are left as they were
+ */
+static void split(avltree * p_tree, avlnode * p_node, int height, void * p_key, uint64_t prefix, avltree_parts * p_parts)
+{
+    int left_height = 0;
+    int right_height = 0;
+    int cmpval = 0;
+    if (NULL == p_node){
+        *p_parts = (avltree_parts){NULL, 0, NULL, NULL, 0};
+        return;
+    }
+    left_height = avltree_child_height(p_node, height, true);
+    right_height = avltree_child_height(p_node, height, false);
+    cmpval = avltree_order(p_tree, p_key, prefix, p_node);
+    if (0 == cmpval){
+        *p_parts = (avltree_parts){p_node->p_left, left_height, p_node, p_node->p_right, right_height};
+    }
+    else if (cmpval < 0){
+        avlnode * p_right = p_node->p_right;
+        split(p_tree, p_node->p_left, left_height, p_key, prefix, p_parts);
+        p_parts->p_right = join(p_parts->p_right, p_parts->right_height, p_node, p_right, right_height, &p_parts->right_height);
+    }
+    else {
+        avlnode * p_left = p_node->p_left;
+        split(p_tree, p_node->p_right, right_height, p_key, prefix, p_parts);
+        p_parts->p_left = join(p_left, left_height, p_node, p_parts->p_left, p_parts->left_height, &p_parts->left_height);
+    }
+}
+
+/*
+ * @brief adds the nodes of a subtree to the nodes a set operation left out,
+ *  the subtree is flattened without recursion
+ * @param p_op the task leaving the nodes out
+ * @param p_node the root of the subtree
+ */
+static void discard(avltree_setop * p_op, avlnode * p_node)
+{
+    while (NULL != p_node){
+        if (NULL != p_node->p_left){
+            // rotate the left child up until the node has none
+            avlnode * p_left = p_node->p_left;
+            p_node->p_left = p_left->p_right;
+            p_left->p_right = p_node;
+            p_node = p_left;
+            continue;
+        }
+        avlnode * p_right = p_node->p_right;
+        p_node->p_right = NULL;
+        p_node->p_left = p_op->p_discard;
+        p_op->p_discard = p_node;
+        if (NULL == p_op->p_tail){
+            p_op->p_tail = p_node;
+        }
+        p_node = p_right;
+    }
+}
+
+/*
+ * @brief runs a join based set operation on two subtrees, the source subtree
+ *  is split around the root of the destination and both halves are solved on
+ *  their own, forking a thread for one half while threads are left
+ * @param p_arg the task to run
+ * @return NULL
+ */
+static void * setop(void * p_arg)
+{
+    avltree_setop * p_op = p_arg;
+    avltree_setop halves[2];
+    avltree_parts parts;
+    avlnode * p_node = p_op->p_first;
+    pthread_t thread;
+    bool b_forked = false;
+    bool b_keep = false;
+    if ((NULL == p_op->p_first) || (NULL == p_op->p_second)){
+        if ((UNION == p_op->op) && (NULL == p_op->p_first)){
+            p_op->p_result = p_op->p_second;
+            p_op->height = p_op->second_height;
+            return NULL;
+        }
+        discard(p_op, p_op->p_second);
+        p_op->p_result = p_op->p_first;
+        p_op->height = p_op->first_height;
+        if (INTERSECTION == p_op->op){
+            discard(p_op, p_op->p_first);
+            p_op->p_result = NULL;
+            p_op->height = 0;
+        }
+        return NULL;
+    }
+    split(p_op->p_tree, p_op->p_second, p_op->second_height, p_node->p_data, p_node->prefix, &parts);
+    halves[0] = *p_op;
+    halves[1] = *p_op;
+    halves[0].p_first = p_node->p_left;
+    halves[0].first_height = avltree_child_height(p_node, p_op->first_height, true);
+    halves[0].p_second = parts.p_left;
+    halves[0].second_height = parts.left_height;
+    halves[1].p_first = p_node->p_right;
+    halves[1].first_height = avltree_child_height(p_node, p_op->first_height, false);
+    halves[1].p_second = parts.p_right;
+    halves[1].second_height = parts.right_height;
+    for (int side = 0; side < 2; side++){
+        halves[side].p_discard = NULL;
+        halves[side].p_tail = NULL;
+    }
+    if ((p_op->threads > 1) && (avltree_count(p_node) >= PARALLEL_CUTOFF) && \
+        (avltree_count(p_op->p_second) >= PARALLEL_CUTOFF)){
+        halves[0].threads = p_op->threads / 2;
+        halves[1].threads = p_op->threads - halves[0].threads;
+        b_forked = (0 == pthread_create(&thread, NULL, setop, &halves[0]));
+    }
+    if (!b_forked){
+        setop(&halves[0]);
+    }
+    setop(&halves[1]);
+    if (b_forked){
+        pthread_join(thread, NULL);
+    }
+    // gather the nodes both halves left out
+    for (int side = 0; side < 2; side++){
+        if (NULL != halves[side].p_discard){
+            halves[side].p_tail->p_left = p_op->p_discard;
+            p_op->p_discard = halves[side].p_discard;
+            if (NULL == p_op->p_tail){
+                p_op->p_tail = halves[side].p_tail;
+            }
+        }
+    }
+    // an equal node of the source always goes, the destination keeps its data
+    if (NULL != parts.p_mid){
+        parts.p_mid->p_left = NULL;
+        parts.p_mid->p_right = NULL;
+        discard(p_op, parts.p_mid);
+    }
+    b_keep = (UNION == p_op->op) || ((INTERSECTION == p_op->op) == (NULL != parts.p_mid));
+    if (b_keep){
+        p_op->p_result = join(halves[0].p_result, halves[0].height, p_node, halves[1].p_result, halves[1].height, &p_op->height);
+    }
+    else {
+        p_node->p_left = NULL;
+        p_node->p_right = NULL;
+        discard(p_op, p_node);
+        p_op->p_result = join_two(halves[0].p_result, halves[0].height, halves[1].p_result, halves[1].height, &p_op->height);
+    }
+    return NULL;
+}
+
+/*
+ * @brief checks two trees can have their nodes linked together and frees
+ *  the nodes hidden in lazy mode, which ordered set algebra does not skip
+ * @param p_dest the tree taking the nodes
+ * @param p_source the tree giving them up
+ * @return 0 on success -1 on failure
+ */
+static int8_t avltree_prepare(avltree * p_dest, avltree * p_source)
+{
+    if ((NULL == p_dest) || (NULL == p_source) || (p_dest == p_source) || \
+        (p_dest->compare != p_source->compare) || (p_dest->destroy != p_source->destroy) || \
+        (p_dest->prefix != p_source->prefix) || (p_dest->b_exact != p_source->b_exact)){
+        return -1;
+    }
+    if (((0 != p_dest->hidden) && (0 != compact(p_dest))) || \
+        ((0 != p_source->hidden) && (0 != compact(p_source)))){
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * @brief runs a set operation of two trees, moving the nodes of the source
+ *  into the destination and destroying the data left out once every thread
+ *  is done
+ * @param p_dest the tree holding the result
+ * @param p_source the other tree, left empty
+ * @param op the set operation to run
+ * @param threads the most threads to run the operation on
+ * @return 0 on success -1 on failure
+ */
+static int8_t avltree_algebra(avltree * p_dest, avltree * p_source, int op, int threads)
+{
+    avltree_setop task = {0};
+    if ((threads < 1) || (0 != avltree_prepare(p_dest, p_source))){
+        return -1;
+    }
+    if ((UNION == op) && (p_dest->size + p_source->size > UINT32_MAX)){
+        return -1;
+    }
+    avltree_pool_merge(p_dest, p_source);
+    task.p_tree = p_dest;
+    task.op = op;
+    task.threads = threads;
+    task.p_first = p_dest->p_root;
+    task.first_height = avltree_height(p_dest->p_root);
+    task.p_second = p_source->p_root;
+    task.second_height = avltree_height(p_source->p_root);
+    setop(&task);
+    p_dest->p_root = task.p_result;
+    p_dest->size = avltree_count(task.p_result);
+    p_source->p_root = NULL;
+    p_source->size = 0;
+    avltree_forget(p_dest);
+    avltree_forget(p_source);
+    while (NULL != task.p_discard){
+        avlnode * p_next = task.p_discard->p_left;
+        release(p_dest, task.p_discard);
+        task.p_discard = p_next;
+    }
+    return 0;
+}
+
+/*
+ * @brief runs a function on the data of a subtree between two keys,
+ *  skipping the children that lie outside the range
+ * @param p_tree the tree providing the compare function
+ * @param p_node the root of the subtree
+ * @param p_low the smallest key to visit
+ * @param p_high the largest key to visit
+ * @param func user defined function to run with the data and context
+ * @param p_ctx the context passed to the function
+ * @return the number of data visited
+ */
+static int64_t range(avltree * p_tree, avlnode * p_node, void * p_low, void * p_high, \
+    void (* func)(void * p_data, void * p_ctx), void * p_ctx)
+{
+    int64_t count = 0;
+    int cmp_low = 0;
+    int cmp_high = 0;
+    if ((NULL == p_node) || (0 == p_node->count)){
+        return 0;
+    }
+    cmp_low = p_tree->compare(p_low, p_node->p_data);
+    cmp_high = p_tree->compare(p_high, p_node->p_data);
+    if (cmp_low < 0){
+        count += range(p_tree, p_node->p_left, p_low, p_high, func, p_ctx);
+    }
+    if ((cmp_low <= 0) && (cmp_high >= 0) && !p_node->b_hidden){
+        func(p_node->p_data, p_ctx);
+        count++;
+    }
+    if (cmp_high > 0){
+        count += range(p_tree, p_node->p_right, p_low, p_high, func, p_ctx);
+    }
+    return count;
+}
+
+/*
+ * @brief moves an iterator to the next or previous node whether it is
+ *  hidden or not
+ * @param p_iter the iterator to move
+ * @param b_forward true to move to the next node, false for the previous one
+ * @return the new current node or NULL when the iterator left the tree
+ */
+static avlnode * iter_step(avliter * p_iter, bool b_forward)
+{
+    avlnode * p_node = NULL;
+    avlnode * p_child = NULL;
+    if (0 == p_iter->depth){
+        return NULL;
+    }
+    p_node = p_iter->p_nodes[p_iter->depth - 1];
+    p_child = (b_forward) ? p_node->p_right : p_node->p_left;
+    if (NULL != p_child){
+        // the closest node on that side is the far end of the child subtree
+        while (NULL != p_child){
+            p_iter->p_nodes[p_iter->depth++] = p_child;
+            p_child = (b_forward) ? p_child->p_left : p_child->p_right;
+        }
+        return p_iter->p_nodes[p_iter->depth - 1];
+    }
+    // otherwise climb until the path turns the other way
+    while (p_iter->depth > 1){
+        p_child = p_iter->p_nodes[--p_iter->depth];
+        p_node = p_iter->p_nodes[p_iter->depth - 1];
+        if (p_child == ((b_forward) ? p_node->p_left : p_node->p_right)){
+            return p_node;
+        }
+    }
+    p_iter->depth = 0;
+    return NULL;
+}
+
+/*
+ * @brief moves an iterator past hidden nodes
+ * @param p_iter the iterator to move
+ * @param p_node the current node of the iterator
+ * @param b_forward true to move to later nodes, false for earlier ones
+ * @return the data of the first node that is not hidden or NULL when the
+ *  iterator left the tree
+ */
+static void * iter_skip(avliter * p_iter, avlnode * p_node, bool b_forward)
+{
+    while ((NULL != p_node) && p_node->b_hidden){
+        p_node = iter_step(p_iter, b_forward);
+    }
+    return (NULL == p_node) ? NULL : p_node->p_data;
+}
+
+/*
+ * @brief moves an iterator to one end of the tree
+ * @param p_iter the iterator to move
+ * @param b_first true for the smallest data, false for the largest
+ * @return the data at that end or NULL for an empty tree
+ */
+static void * iter_end(avliter * p_iter, bool b_first)
+{
+    avlnode * p_node = p_iter->p_tree->p_root;
+    p_iter->depth = 0;
+    while (NULL != p_node){
+        p_iter->p_nodes[p_iter->depth++] = p_node;
+        p_node = (b_first) ? p_node->p_left : p_node->p_right;
+    }
+    if (0 == p_iter->depth){
+        return NULL;
+    }
+    return iter_skip(p_iter, p_iter->p_nodes[p_iter->depth - 1], b_first);
+}
+
+/*
+ * @brief creates and initializes a avltree
+ * @param p_data the data for the root node of the tree or NULL for an
+ *  empty tree
+ * @param destroy user defined destroy function for the tree
+ * @param compare user defined function to compare the data in the tree
+ * @return a pointer to the newly created avltree
+ */
+avltree * avltree_init(void * p_data, void (* destroy)(void * p_data), int8_t (* compare)(void * key1, void * key2))
+{
+    // a tree can not order its data without a compare function
+    if (NULL == compare){
+        return NULL;
+    }
+    avltree * p_tree = calloc(1, sizeof(*p_tree));
+    if (NULL == p_tree){
+        perror("avltree_init ");
+        return NULL;
+    }
+    p_tree->destroy = destroy;
+    p_tree->compare = compare;
+    p_tree->block_size = FIRST_BLOCK;
+    p_tree->p_pool = avltree_pool_init();
+    if (NULL == p_tree->p_pool){
+        free(p_tree);
+        return NULL;
+    }
+    // create the root node
+    if (NULL != p_data){
+        p_tree->p_root = avltree_node_alloc(p_tree, p_data);
+        if (NULL == p_tree->p_root){
+            pthread_mutex_lock(&avltree_pool_lock);
+            avltree_pool_release(p_tree->p_pool);
+            pthread_mutex_unlock(&avltree_pool_lock);
+            free(p_tree);
+            return NULL;
+        }
+        p_tree->size = 1;
+    }
+    return p_tree;
+}
+
+/*
+ * @brief creates an avltree from sorted data in O(n), the nodes are
+ *  allocated in one block and linked into a perfectly balanced tree
+ * @param pp_items the data in strictly increasing order
+ * @param count the number of items
+ * @param destroy user defined destroy function for the tree
+ * @param compare user defined function to compare the data in the tree
+ * @return a pointer to the newly created avltree or NULL when the items are
+ *  not strictly increasing or on failure
+ */
+avltree * avltree_build_sorted(void ** pp_items, int64_t count, void (* destroy)(void * p_data), int8_t (* compare)(void * key1, void * key2))
+{
+    avltree_block * p_block = NULL;
+    int height = 0;
+    if ((count < 0) || ((count > 0) && (NULL == pp_items)) || (count > UINT32_MAX)){
+        return NULL;
+    }
+    // one pass proves the items are sorted without duplicates
+    for (int64_t index = 0; index < count; index++){
+        if ((NULL == pp_items[index]) || ((index > 0) && (NULL != compare) && \
+            (compare(pp_items[index - 1], pp_items[index]) >= 0))){
+            return NULL;
+        }
+    }
+    avltree * p_tree = avltree_init(NULL, destroy, compare);
+    if ((NULL == p_tree) || (0 == count)){
+        return p_tree;
+    }
+    p_block = avltree_block_alloc(p_tree, count);
+    if (NULL == p_block){
+        avltree_destroy(p_tree);
+        return NULL;
+    }
+    p_tree->p_root = build(p_block->nodes, pp_items, count, &height);
+    p_tree->size = count;
+    return p_tree;
+}
+
+/*
+ * @brief tears down an avltree and its pool once no split tree shares it
+ * @param p_tree avltree to tear down
+ */
+void avltree_destroy(avltree * p_tree)
 {
-    btnode * p_left = btree_left(*p_node);
-    btnode * p_grandchild = NULL;
-    // check if left node is left heavy and perform left left rotation
-    if (((avlnode *)btree_data(p_left))->factor == LEFT_HEAVY){
-        btree_set_left(*p_node, btree_right(p_left));
-        btree_set_right(p_left, *p_node);
-        // reset the balance levels of the after the rotation
-        ((avlnode *)btree_data(*p_node))->factor = BALANCED;
-        ((avlnode *)btree_data(p_left))->factor = BALANCED;
-        *p_node = p_left;
+    // only tear down if p_tree is not null
+    if (NULL == p_tree){
+        return;
     }
-    else {
-        // else node is right heavy so perform a left right rotation
-        p_grandchild = btree_right(p_left);
-        btree_set_right(p_left, btree_left(p_grandchild));
-        btree_set_left(p_grandchild, p_left);
-        btree_set_left(*p_node, btree_right(p_grandchild));
-        btree_set_right(p_grandchild, *p_node);
-        // set the new balance factors based on current values
-        switch (((avlnode *)btree_data(p_grandchild))->factor){
-            case LEFT_HEAVY:
-            ((avlnode *)btree_data(*p_node))->factor = RIGHT_HEAVY;
-            ((avlnode *)btree_data(p_left))->factor = BALANCED;
-            break;
-            case BALANCED:
-            ((avlnode *)btree_data(*p_node))->factor = BALANCED;
-            ((avlnode *)btree_data(p_left))->factor = BALANCED;
-            break;
-            case RIGHT_HEAVY:
-            ((avlnode *)btree_data(*p_node))->factor = BALANCED;
-            ((avlnode *)btree_data(p_left))->factor = LEFT_HEAVY;
-            break;
+    pthread_mutex_lock(&avltree_pool_lock);
+    avltree_pool * p_pool = avltree_pool_find(p_tree);
+    bool b_alone = (1 == p_pool->refs);
+    pthread_mutex_unlock(&avltree_pool_lock);
+    // no other tree can take a reference to the pool while this one is torn down
+    if (b_alone){
+        // nodes in the pool have no data so only nodes in the tree are torn down
+        for (avltree_block * p_block = p_pool->p_blocks; NULL != p_block; p_block = p_block->p_next){
+            for (int64_t index = 0; index < p_block->count; index++){
+                if ((NULL != p_tree->destroy) && (NULL != p_block->nodes[index].p_data)){
+                    p_tree->destroy(p_block->nodes[index].p_data);
+                }
+            }
         }
-        ((avlnode *)btree_data(p_grandchild))->factor = BALANCED;
-        *p_node = p_grandchild;
     }
+    else {
+        // the other trees sharing the pool keep their nodes
+        release_all(p_tree, p_tree->p_root);
+    }
+    pthread_mutex_lock(&avltree_pool_lock);
+    avltree_pool_release(p_pool);
+    pthread_mutex_unlock(&avltree_pool_lock);
+    free(p_tree->p_finger);
+    free(p_tree);
 }
 
-static void avltree_rotate_right(btnode ** p_node)
+/*
+ * @brief inserts data into an avltree, reusing the node of equal data that
+ *  was removed in lazy mode
+ * @param p_tree the tree to insert into
+ * @param p_data the data to insert
+ * @return 0 on success -1 when the data is already in the tree or on failure
+ */
+int avltree_insert(avltree * p_tree, void * p_data)
 {
-    btnode * p_right = btree_right(*p_node);
-    btnode * p_grandchild = NULL;
-    // check if right node is right heavy and perform right right rotation
-    if (((avlnode *)btree_data(p_right))->factor == RIGHT_HEAVY){
-        btree_set_right(*p_node, btree_left(p_right));
-        btree_set_left(p_right, *p_node);
-        // reset the balance levels of the after the rotation
-        ((avlnode *)btree_data(*p_node))->factor = BALANCED;
-        ((avlnode *)btree_data(p_right))->factor = BALANCED;
-        *p_node = p_right;
+    avltree_path path;
+    // the subtree counts in the nodes hold up to 32 bits
+    if ((NULL == p_tree) || (NULL == p_data) || (p_tree->size >= UINT32_MAX)){
+        return -1;
     }
-    else {
-        // else node is left heavy so perform a right left rotation
-        p_grandchild = btree_left(p_right);
-        btree_set_left(p_right, btree_right(p_grandchild));
-        btree_set_right(p_grandchild, p_right);
-        btree_set_right(*p_node, btree_left(p_grandchild));
-        btree_set_left(p_grandchild, *p_node);
-        // set the new balance factors based on current values
-        switch (((avlnode *)btree_data(p_grandchild))->factor){
-            case LEFT_HEAVY:
-            ((avlnode *)btree_data(*p_node))->factor = BALANCED;
-            ((avlnode *)btree_data(p_right))->factor = RIGHT_HEAVY; 
-            break;
-            case BALANCED:
-            ((avlnode *)btree_data(*p_node))->factor = BALANCED;
-            ((avlnode *)btree_data(p_right))->factor = BALANCED;
-            break;
-            case RIGHT_HEAVY:
-            ((avlnode *)btree_data(*p_node))->factor = LEFT_HEAVY;
-            ((avlnode *)btree_data(p_right))->factor = BALANCED;
-            break;
+    if (NULL == p_tree->p_root){
+        // insert into an empty tree
+        p_tree->p_root = avltree_node_alloc(p_tree, p_data);
+        if (NULL == p_tree->p_root){
+            return -1;
         }
-        ((avlnode *)btree_data(p_grandchild))->factor = BALANCED;
-        *p_node = p_grandchild;
+        p_tree->size++;
+        return 0;
+    }
+    if (NULL != p_tree->p_finger){
+        return insert(p_tree, p_tree->p_finger, avltree_seek(p_tree, p_tree->p_finger, p_data), p_data);
     }
+    path.depth = 0;
+    return insert(p_tree, &path, avltree_seek(p_tree, &path, p_data), p_data);
 }
 
-static int insert(avltree * p_tree, btnode ** pp_node, void * p_data, int * balanced){
-    avlnode * p_avl_data = NULL;
-    int cmpval = 0;
-    int retval = 0;
-    // insert data into the tree
-    if (btree_is_eob(*pp_node)){
-        // insert into empty tree
-        p_avl_data = calloc(1, sizeof(*p_avl_data));
-        if (NULL == p_data){
+/*
+ * @brief removes the data equal to a key from an avltree and runs the destroy
+ *  function on it. The node is unlinked and the tree rebalanced unless lazy
+ *  mode is set, where the node is hidden until a compaction frees it
+ * @param p_tree the tree to remove from
+ * @param p_data the key of the data to remove
+ * @return 0 on success -1 when the data is not in the tree
+ */
+int8_t avltree_remove(avltree * p_tree, void * p_data)
+{
+    avlnode * p_removed = NULL;
+    bool b_shrunk = false;
+    if ((NULL == p_tree) || (NULL == p_data)){
+        return -1;
+    }
+    if (p_tree->lazy > 0){
+        // the destroy function runs once the hidden node is freed
+        if (0 != hide(p_tree, p_data)){
             return -1;
         }
-        p_avl_data->p_data = p_data;
-        p_avl_data->b_hidden = 0;
-        p_avl_data->factor = BALANCED;
-        return (NULL == btree_ins_left(p_tree, *pp_node, p_avl_data)) ? -1 : 0 ;
+        p_tree->size--;
+        p_tree->hidden++;
+        if (p_tree->hidden > p_tree->lazy * (p_tree->size + p_tree->hidden)){
+            compact(p_tree);
+        }
+        return 0;
     }
-    else {
-        // insert into a tree that is not empty
-        cmpval = btree_compare(p_tree, p_data, ((avlnode *)btree_data(*pp_node))->p_data);
-        if (cmpval < 0){
-            // move to the left
-            if (btree_is_eob(btree_left(*pp_node))){
-                p_avl_data = calloc(1, sizeof(*p_avl_data));
-                if (NULL == p_avl_data){
-                    return -1;
-                }
-                p_avl_data->p_data = p_data;
-                p_avl_data->b_hidden = 0;
-                p_avl_data->factor = BALANCED;
-                return (NULL == btree_ins_left(p_tree, *pp_node, p_avl_data)) ? -1 : 0 ;
-                *balanced = 0;
-            }
-            else {
-                btnode * p_left = btree_left(*pp_node);
-                if ((retval = (insert(p_tree, &p_left, p_data, balanced))) != 0){
-                    return retval;
-                }
-            }
-            // keep the tree balanced
-            if (!(*balanced)){
-                switch (((avlnode *)btree_data(*pp_node))->factor){
-                    case LEFT_HEAVY:
-                        avltree_rotate_left(pp_node);
-                        *balanced = 1;
-                    break;
-                    case BALANCED:
-                        ((avlnode *)btree_data(*pp_node))->factor = LEFT_HEAVY;
-                    break;
-                    case RIGHT_HEAVY:
-                        ((avlnode *)btree_data(*pp_node))->factor = LEFT_HEAVY;
-                        *balanced = 1;
-                    break;
-                }
-            }
+    p_tree->p_root = detach(p_tree, p_tree->p_root, p_data, avltree_prefix(p_tree, p_data), &p_removed, &b_shrunk);
+    // the data of nodes on the path may have moved
+    avltree_forget(p_tree);
+    if (NULL == p_removed){
+        return -1;
+    }
+    if (p_removed->b_hidden){
+        // a node hidden before lazy mode was turned off is not in the tree
+        p_tree->hidden--;
+        release(p_tree, p_removed);
+        return -1;
+    }
+    p_tree->size--;
+    release(p_tree, p_removed);
+    return 0;
+}
+
+/*
+ * @brief sets the lazy mode of an avltree, where removed nodes are only hidden
+ *  and all of them are freed in one linear rebuild once they make up more than
+ *  a fraction of the nodes
+ * @param p_tree the tree to set the mode of
+ * @param fraction the fraction of hidden nodes that triggers the rebuild
+ *  between 0 and 1, 0 to unlink removed nodes right away
+ * @return 0 on success -1 on failure
+ */
+int8_t avltree_set_lazy(avltree * p_tree, double fraction)
+{
+    if ((NULL == p_tree) || (fraction < 0) || (fraction >= 1)){
+        return -1;
+    }
+    p_tree->lazy = fraction;
+    // nodes hidden so far are freed when lazy mode is turned off
+    if ((fraction <= 0) && (0 != p_tree->hidden)){
+        return compact(p_tree);
+    }
+    return 0;
+}
+
+/*
+ * @brief compacts an avltree by freeing the hidden nodes of lazy mode
+ * @param p_tree the tree to compact
+ * @return 0 on success -1 on failure
+ */
+int8_t avltree_compact(avltree * p_tree)
+{
+    if (NULL == p_tree){
+        return -1;
+    }
+    return (0 == p_tree->hidden) ? 0 : compact(p_tree);
+}
+
+/*
+ * @brief joins the data of one avltree onto the end of another in
+ *  O(log n), every data of the destination has to be smaller than every data
+ *  of the source
+ * @param p_dest the tree to join onto, which takes the nodes
+ * @param p_source the tree of larger data, left empty
+ * @return 0 on success -1 when the trees overlap or do not share the compare
+ *  and destroy functions
+ */
+int8_t avltree_join(avltree * p_dest, avltree * p_source)
+{
+    avlnode * p_max = NULL;
+    avlnode * p_min = NULL;
+    int height = 0;
+    if (0 != avltree_prepare(p_dest, p_source)){
+        return -1;
+    }
+    if (NULL == p_source->p_root){
+        return 0;
+    }
+    if (NULL != p_dest->p_root){
+        p_max = p_dest->p_root;
+        while (NULL != p_max->p_right){
+            p_max = p_max->p_right;
         }
-        else if (cmpval > 0){
-            // move to the right
-            if (btree_is_eob(btree_right(*pp_node))){
-                p_avl_data = calloc(1, sizeof(*p_avl_data));
-                if (NULL == p_avl_data){
-                    return -1;
-                }
-                p_avl_data->p_data = p_data;
-                p_avl_data->b_hidden = 0;
-                p_avl_data->factor = BALANCED;
-                return (NULL == btree_ins_right(p_tree, *pp_node, p_avl_data)) ? -1 : 0 ;
-                *balanced = 0;
-            }
-            else {
-                btnode * p_right = btree_right(*pp_node);
-                if ((retval = (insert(p_tree, &p_right, p_data, balanced))) != 0){
-                    return retval;
-                }
-            }
-            // keep the tree balanced
-            if (!(*balanced)){
-                switch (((avlnode *)btree_data(*pp_node))->factor){
-                    case LEFT_HEAVY:
-                        ((avlnode *)btree_data(*pp_node))->factor = BALANCED;
-                        *balanced = 1;
-                    break;
-                    case BALANCED:
-                        ((avlnode *)btree_data(*pp_node))->factor = RIGHT_HEAVY;
-                    break;
-                    case RIGHT_HEAVY:
-                        avltree_rotate_right(pp_node);
-                        *balanced = 1;
-                    break;
-                }
-            }
+        p_min = p_source->p_root;
+        while (NULL != p_min->p_left){
+            p_min = p_min->p_left;
         }
-        else {
-            // handle copy of data found
-            if (!((avlnode *)btree_data(*pp_node))->b_hidden){
-                // the data is already in the tree and not hidden
-                return -1;
-            }
-            else {
-                // insert the new data and label it not hidden
-                btree_destroy(((avlnode *)btree_data(*pp_node))->p_data);
-                ((avlnode *)btree_data(*pp_node))->p_data = p_data;
-                ((avlnode *)btree_data(*pp_node))->b_hidden = 0;
-                // no rebalance needed
-                *balanced = 1;
-            }
+        if ((p_dest->compare(p_max->p_data, p_min->p_data) >= 0) || \
+            (p_dest->size + p_source->size > UINT32_MAX)){
+            return -1;
         }
     }
-        return 0;
+    avltree_pool_merge(p_dest, p_source);
+    p_dest->p_root = join_two(p_dest->p_root, avltree_height(p_dest->p_root), \
+        p_source->p_root, avltree_height(p_source->p_root), &height);
+    p_dest->size += p_source->size;
+    p_source->p_root = NULL;
+    p_source->size = 0;
+    avltree_forget(p_dest);
+    avltree_forget(p_source);
+    return 0;
 }
 
-static int hide(avltree * p_tree, btnode * p_node, void * p_data)
+/*
+ * @brief splits an avltree around a key in O(log n), the tree keeps the data
+ *  smaller than the key and the rest moves to a new tree sharing its pool,
+ *  each tree keeps its own free nodes so both can be used from different
+ *  threads, the blocks of the pool are freed once neither tree uses them
+ * @param p_tree the tree to split
+ * @param p_key the key to split around
+ * @return a new avltree holding the data equal to or larger than the key or
+ *  NULL on error
+ */
+avltree * avltree_split(avltree * p_tree, void * p_key)
 {
-    int cmpval = 0;
-    int retval = 0;
-    // data cant be found if node is end of branch
-    if (btree_is_eob(p_node)){
-        return -1;
+    avltree_parts parts;
+    int height = 0;
+    if ((NULL == p_tree) || (NULL == p_key)){
+        return NULL;
     }
-    cmpval = btree_compare(p_tree, p_data, ((avlnode *)btree_data(p_node))->p_data);
-    // move to the lef
-    if (cmpval < 0){
-        retval = hide(p_tree, btree_left(p_node), p_data);
+    if ((0 != p_tree->hidden) && (0 != compact(p_tree))){
+        return NULL;
     }
-    else if (cmpval > 0){
-        // move to the right
-        retval = hide(p_tree, btree_right(p_node), p_data);
+    avltree * p_upper = calloc(1, sizeof(*p_upper));
+    if (NULL == p_upper){
+        perror("avltree_split ");
+        return NULL;
     }
-    else {
-        // the node is hidden
-        ((avlnode *)btree_data(p_node))->b_hidden = true;
-        retval = 0;
+    p_upper->destroy = p_tree->destroy;
+    p_upper->compare = p_tree->compare;
+    p_upper->prefix = p_tree->prefix;
+    p_upper->b_exact = p_tree->b_exact;
+    p_upper->lazy = p_tree->lazy;
+    p_upper->block_size = FIRST_BLOCK;
+    // the new tree keeps a reference to the pool its nodes live in
+    pthread_mutex_lock(&avltree_pool_lock);
+    p_upper->p_pool = avltree_pool_find(p_tree);
+    p_upper->p_pool->refs++;
+    pthread_mutex_unlock(&avltree_pool_lock);
+    split(p_tree, p_tree->p_root, avltree_height(p_tree->p_root), p_key, avltree_prefix(p_tree, p_key), &parts);
+    p_tree->p_root = parts.p_left;
+    p_tree->size = avltree_count(parts.p_left);
+    p_upper->p_root = parts.p_right;
+    if (NULL != parts.p_mid){
+        p_upper->p_root = join(NULL, 0, parts.p_mid, parts.p_right, parts.right_height, &height);
     }
-    return retval;
+    p_upper->size = avltree_count(p_upper->p_root);
+    avltree_forget(p_tree);
+    return p_upper;
+}
+
+/*
+ * @brief merges the data of one avltree into another, keeping the data of
+ *  the destination where both hold equal data
+ * @param p_dest the tree to merge into
+ * @param p_source the tree to merge from, left empty
+ * @param threads the most threads to run the merge on
+ * @return 0 on success -1 on failure
+ */
+int8_t avltree_union(avltree * p_dest, avltree * p_source, int threads)
+{
+    return avltree_algebra(p_dest, p_source, UNION, threads);
 }
 
-static int lookup(avltree * p_tree, btnode * p_node, void ** pp_data)
+/*
+ * @brief keeps the data of an avltree that is also in another one
+ * @param p_dest the tree to keep data in
+ * @param p_source the tree to compare against, left empty
+ * @param threads the most threads to run the intersection on
+ * @return 0 on success -1 on failure
+ */
+int8_t avltree_intersection(avltree * p_dest, avltree * p_source, int threads)
+{
+    return avltree_algebra(p_dest, p_source, INTERSECTION, threads);
+}
+
+/*
+ * @brief removes the data of an avltree that is also in another one
+ * @param p_dest the tree to remove data from
+ * @param p_source the tree of data to remove, left empty
+ * @param threads the most threads to run the difference on
+ * @return 0 on success -1 on failure
+ */
+int8_t avltree_difference(avltree * p_dest, avltree * p_source, int threads)
+{
+    return avltree_algebra(p_dest, p_source, DIFFERENCE, threads);
+}
+
+/*
+ * @brief looks up the data equal to a key in an avltree without recursion,
+ *  the finger is not used or moved so lookups only read the tree and
+ *  readers may share it
+ * @param p_tree the tree to search
+ * @param p_key the key to search for
+ * @return the data in the tree or NULL when it is not in the tree
+ */
+void * avltree_lookup(avltree * p_tree, void * p_key)
 {
+    avlnode * p_node = NULL;
+    uint64_t prefix = 0;
     int cmpval = 0;
-    int retval = 0;
-    // data cant be found in a node that is end of branch
-    if (btree_is_eob(p_node)){
-        return -1;
+    if ((NULL == p_tree) || (NULL == p_key)){
+        return NULL;
     }
-    cmpval = btree_compare(p_tree, *pp_data, ((avlnode *)btree_data(p_node))->p_data);
-    if (cmpval < 0){
-        // move to the left
-        retval = lookup(p_tree, btree_left(p_node), pp_data);
+    p_node = p_tree->p_root;
+    prefix = avltree_prefix(p_tree, p_key);
+    while (NULL != p_node){
+        cmpval = avltree_order(p_tree, p_key, prefix, p_node);
+        if (0 == cmpval){
+            return (p_node->b_hidden) ? NULL : p_node->p_data;
+        }
+        p_node = (cmpval < 0) ? p_node->p_left : p_node->p_right;
     }
-    else if (cmpval > 0){
-        // move to the right
-        retval = lookup(p_tree, btree_right(p_node), pp_data);
+    return NULL;
+}
+
+/*
+ * @brief looks up the data equal to many keys at once. Up to IN_FLIGHT
+ *  searches descend in lock step and each prefetches the next node it will
+ *  visit, so the misses of one level of all of them overlap instead of
+ *  being waited for one after another. The finger is not used or moved
+ * @param p_tree the tree to search
+ * @param pp_keys the keys to search for, a NULL key finds nothing
+ * @param count the number of keys
+ * @param pp_out set to the data equal to each key or NULL when it is not in
+ *  the tree, may be the same array as the keys
+ * @return the number of keys found or -1 on error
+ */
+int64_t avltree_lookup_batch(avltree * p_tree, void ** pp_keys, int64_t count, void ** pp_out)
+{
+    avlnode * p_nodes[IN_FLIGHT];
+    uint64_t prefixes[IN_FLIGHT];
+    void * p_keys[IN_FLIGHT];
+    int64_t found = 0;
+    if ((NULL == p_tree) || (count < 0) || ((count > 0) && ((NULL == pp_keys) || (NULL == pp_out)))){
+        return -1;
     }
-    else {
-        if (!(((avlnode *)btree_data(p_node))->b_hidden)){
-            // return data from the tree;
-            *pp_data = ((avlnode *)btree_data(p_node))->p_data;
-            retval = 0;
+    for (int64_t first = 0; first < count; first += IN_FLIGHT){
+        int batch = (count - first < IN_FLIGHT) ? (int)(count - first) : IN_FLIGHT;
+        int active = 0;
+        for (int index = 0; index < batch; index++){
+            p_keys[index] = pp_keys[first + index];
+            p_nodes[index] = (NULL == p_keys[index]) ? NULL : p_tree->p_root;
+            prefixes[index] = (NULL == p_keys[index]) ? 0 : avltree_prefix(p_tree, p_keys[index]);
+            pp_out[first + index] = NULL;
+            active += (NULL != p_nodes[index]);
+        }
+        while (active > 0){
+            // the nodes were fetched a level ago, their data may still miss
+            if (NULL == p_tree->prefix){
+                for (int index = 0; index < batch; index++){
+                    if (NULL != p_nodes[index]){
+                        avltree_prefetch(p_nodes[index]->p_data);
+                    }
+                }
+            }
+            active = 0;
+            for (int index = 0; index < batch; index++){
+                avlnode * p_node = p_nodes[index];
+                if (NULL == p_node){
+                    continue;
+                }
+                int cmpval = avltree_order(p_tree, p_keys[index], prefixes[index], p_node);
+                if (0 == cmpval){
+                    pp_out[first + index] = (p_node->b_hidden) ? NULL : p_node->p_data;
+                    found += !p_node->b_hidden;
+                    p_nodes[index] = NULL;
+                    continue;
+                }
+                p_node = (cmpval < 0) ? p_node->p_left : p_node->p_right;
+                p_nodes[index] = p_node;
+                if (NULL != p_node){
+                    avltree_prefetch(p_node);
+                    active++;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+/*
+ * @brief counts the data in an avltree that are smaller than a key, or not
+ *  larger than it
+ * @param p_tree the tree to count in
+ * @param p_key the key to count up to
+ * @param b_inclusive true to count data equal to the key as well
+ * @return the number of data
+ */
+static int64_t avltree_count_below(avltree * p_tree, void * p_key, bool b_inclusive)
+{
+    avlnode * p_node = p_tree->p_root;
+    uint64_t prefix = avltree_prefix(p_tree, p_key);
+    int64_t count = 0;
+    int cmpval = 0;
+    while (NULL != p_node){
+        cmpval = avltree_order(p_tree, p_key, prefix, p_node);
+        if ((cmpval > 0) || (b_inclusive && (0 == cmpval))){
+            // the node and everything left of it are below the key
+            count += avltree_count(p_node->p_left) + (p_node->b_hidden ? 0 : 1);
+            p_node = p_node->p_right;
         }
         else {
-            // data was not found
-            return -1;
+            p_node = p_node->p_left;
         }
-    }   
-    return retval;
+    }
+    return count;
 }
 
 /*
- * @brief creates and initializes a avltree
- * @param p_data the data for the root node of the tree
- * @param destroy user defined destroy function for the tree
- * @param compare user defined function to compare the data in the tree
- * @return a pointer to the newly created avltree
+ * @brief gets the rank of a key in an avltree in O(log n)
+ * @param p_tree the tree to rank the key in
+ * @param p_key the key to rank, it does not have to be in the tree
+ * @return the number of data smaller than the key which is the index of the
+ *  key in order when it is in the tree, -1 on error
  */
-avltree * avltree_init(void * p_data, void (* destroy)(void * p_data), int8_t (* compare)(void * key1, void * key2))
+int64_t avltree_rank(avltree * p_tree, void * p_key)
 {
-    // do not allow creating a tree without a data for its root node
-    if (NULL == p_data){
-        return NULL;
+    if ((NULL == p_tree) || (NULL == p_key)){
+        return -1;
     }
-    // create the root node
-    avlnode * p_root = calloc(1, sizeof(*p_root));
-    if (NULL == p_root){
+    return avltree_count_below(p_tree, p_key, false);
+}
+
+/*
+ * @brief gets the data at an index in order in O(log n)
+ * @param p_tree the tree to select from
+ * @param index the number of data smaller than the one to get, 0 for the
+ *  smallest
+ * @return the data or NULL when the index is outside the tree
+ */
+void * avltree_select(avltree * p_tree, int64_t index)
+{
+    avlnode * p_node = NULL;
+    if ((NULL == p_tree) || (index < 0) || (index >= p_tree->size)){
         return NULL;
     }
-    p_root->p_data = p_data;
-    p_root->b_hidden = false;
-    p_root->factor = BALANCED;
-    // create the avltree and return
-    avltree * p_tree = btree_init(p_root, destroy, compare);
-    if (NULL == p_tree){
-        return NULL;
-    } 
-    return p_tree;
+    p_node = p_tree->p_root;
+    while (NULL != p_node){
+        int64_t left = avltree_count(p_node->p_left);
+        if (index < left){
+            p_node = p_node->p_left;
+            continue;
+        }
+        index -= left;
+        if (!p_node->b_hidden){
+            if (0 == index){
+                return p_node->p_data;
+            }
+            index--;
+        }
+        p_node = p_node->p_right;
+    }
+    return NULL;
 }
 
 /*
- * @brief tears down an avltree
- * @param p_tree avltree to tear down
+ * @brief counts the data between two keys in O(log n)
+ * @param p_tree the tree to count in
+ * @param p_low the smallest key to count
+ * @param p_high the largest key to count
+ * @return the number of data not smaller than p_low and not larger than
+ *  p_high, -1 on error
  */
-void avltree_destroy(avltree * p_tree)
+int64_t avltree_count_range(avltree * p_tree, void * p_low, void * p_high)
 {
-    // only tear down if p_tree is not null
-    if (NULL != p_tree){
-        btree_destroy(p_tree);
+    if ((NULL == p_tree) || (NULL == p_low) || (NULL == p_high)){
+        return -1;
     }
+    if (p_tree->compare(p_low, p_high) > 0){
+        return 0;
+    }
+    return avltree_count_below(p_tree, p_high, true) - avltree_count_below(p_tree, p_low, false);
 }
 
-int avltree_insert(avltree * p_tree, void * p_data)
+/*
+ * @brief sets whether an avltree keeps the path of the last insert or
+ *  remove so the next one climbs only as far as needed, which speeds up
+ *  sequential and clustered keys, lookups always start at the root and
+ *  leave the path alone
+ * @param p_tree the tree to set the finger of
+ * @param b_finger true to keep the path, false to start at the root
+ * @return 0 on success -1 on failure
+ */
+int8_t avltree_set_finger(avltree * p_tree, bool b_finger)
 {
-    int balanced = 0;
-    btnode * p_root = btree_root(p_tree);
-    return insert(p_tree, &p_root, p_data, &balanced);
+    if (NULL == p_tree){
+        return -1;
+    }
+    if (!b_finger){
+        free(p_tree->p_finger);
+        p_tree->p_finger = NULL;
+    }
+    else if (NULL == p_tree->p_finger){
+        p_tree->p_finger = calloc(1, sizeof(*p_tree->p_finger));
+        if (NULL == p_tree->p_finger){
+            perror("avltree_set_finger ");
+            return -1;
+        }
+    }
+    return 0;
 }
 
-int8_t avltree_remove(avltree * p_tree, void * p_data)
+/*
+ * @brief stores the key prefix of the data in every node of a subtree,
+ *  hidden nodes included
+ * @param p_tree the tree providing the prefix function
+ * @param p_node the root of the subtree
+ */
+static void avltree_reprefix(avltree * p_tree, avlnode * p_node)
 {
-    return hide(p_tree, btree_root(p_tree), p_data);
+    while (NULL != p_node){
+        avltree_reprefix(p_tree, p_node->p_left);
+        p_node->prefix = avltree_prefix(p_tree, p_node->p_data);
+        p_node = p_node->p_right;
+    }
 }
 
-int avltree_lookup(avltree * p_tree, void * p_data)
+/*
+ * @brief sets a function giving an order preserving 64 bit prefix of the
+ *  keys, such as their first 8 bytes big endian or an integer key itself.
+ *  Every node keeps the prefix of its data so searches compare it inline and
+ *  only call the compare function when the prefixes are equal. The prefixes
+ *  of the data already in the tree are computed in O(n)
+ * @param p_tree the tree to set the prefix function of
+ * @param prefix the prefix function, a smaller prefix must mean smaller
+ *  data, NULL to compare with the compare function alone
+ * @param b_exact true when equal prefixes mean equal data so the compare
+ *  function is never called on a search
+ * @return 0 on success -1 on failure
+ */
+int8_t avltree_set_prefix(avltree * p_tree, uint64_t (* prefix)(void * p_data), bool b_exact)
 {
-    return lookup(p_tree, btree_root(p_tree), p_data);
+    if (NULL == p_tree){
+        return -1;
+    }
+    p_tree->prefix = prefix;
+    p_tree->b_exact = (NULL != prefix) && b_exact;
+    avltree_reprefix(p_tree, p_tree->p_root);
+    return 0;
 }
 
+/*
+ * @brief gets the number of data in an avltree
+ * @param p_tree the tree to get the size of
+ * @return the number of nodes that are not hidden or -1 on error
+ */
 int64_t avltree_size(avltree * p_tree)
 {
-    return btree_size(p_tree);
+    if (NULL == p_tree){
+        return -1;
+    }
+    return p_tree->size;
+}
+
+/*
+ * @brief gets the number of nodes removed in lazy mode but not yet freed
+ * @param p_tree the tree to get the hidden nodes of
+ * @return the number of hidden nodes or -1 on error
+ */
+int64_t avltree_hidden(avltree * p_tree)
+{
+    if (NULL == p_tree){
+        return -1;
+    }
+    return p_tree->hidden;
 }
 
 void * avltree_data(avlnode * p_node)
@@ -333,20 +2045,157 @@ void * avltree_data(avlnode * p_node)
 
 void avltree_preorder(avltree * p_tree, void (* func)(void * p_data))
 {
-    btree_preorder(p_tree, btree_root(p_tree) ,func);
+    traverse(p_tree->p_root, -1, func);
 }
 
 void avltree_inorder(avltree * p_tree, void (* func)(void * p_data))
 {
-    btree_inorder(p_tree, btree_root(p_tree) ,func);
+    traverse(p_tree->p_root, 0, func);
 }
 
 void avltree_postorder(avltree * p_tree, void (* func)(void * p_data))
 {
-    btree_postorder(p_tree, btree_root(p_tree), func);
+    traverse(p_tree->p_root, 1, func);
 }
 
 avlnode * avltree_root(avltree * p_tree)
 {
-    return (avlnode *)btree_data(btree_root(p_tree));
+    return p_tree->p_root;
+}
+
+/*
+ * @brief runs a function on the data between two keys in order in
+ *  O(log n + k) for k data in the range
+ * @param p_tree the tree to visit
+ * @param p_low the smallest key to visit
+ * @param p_high the largest key to visit
+ * @param func user defined function to run with the data and context
+ * @param p_ctx the context passed to the function
+ * @return the number of data visited or -1 on error
+ */
+int64_t avltree_range(avltree * p_tree, void * p_low, void * p_high, void (* func)(void * p_data, void * p_ctx), void * p_ctx)
+{
+    if ((NULL == p_tree) || (NULL == p_low) || (NULL == p_high) || (NULL == func)){
+        return -1;
+    }
+    return range(p_tree, p_tree->p_root, p_low, p_high, func, p_ctx);
+}
+
+/*
+ * @brief creates an iterator over an avltree, it starts outside the tree
+ *  and is only valid while the tree is not changed
+ * @param p_tree the tree to iterate
+ * @return a pointer to the new iterator or NULL on failure
+ */
+avliter * avltree_iter_init(avltree * p_tree)
+{
+    if (NULL == p_tree){
+        return NULL;
+    }
+    avliter * p_iter = calloc(1, sizeof(*p_iter));
+    if (NULL == p_iter){
+        perror("avltree_iter_init ");
+        return NULL;
+    }
+    p_iter->p_tree = p_tree;
+    return p_iter;
+}
+
+/*
+ * @brief tears down an iterator
+ * @param p_iter the iterator to tear down
+ */
+void avltree_iter_destroy(avliter * p_iter)
+{
+    free(p_iter);
+}
+
+/*
+ * @brief moves an iterator to the smallest data in the tree
+ * @param p_iter the iterator to move
+ * @return the smallest data or NULL for an empty tree
+ */
+void * avltree_iter_first(avliter * p_iter)
+{
+    return (NULL == p_iter) ? NULL : iter_end(p_iter, true);
+}
+
+/*
+ * @brief moves an iterator to the largest data in the tree
+ * @param p_iter the iterator to move
+ * @return the largest data or NULL for an empty tree
+ */
+void * avltree_iter_last(avliter * p_iter)
+{
+    return (NULL == p_iter) ? NULL : iter_end(p_iter, false);
+}
+
+/*
+ * @brief moves an iterator to the smallest data not smaller than a key
+ * @param p_iter the iterator to move
+ * @param p_key the key to seek
+ * @return the data found or NULL when every data is smaller than the key
+ */
+void * avltree_iter_seek(avliter * p_iter, void * p_key)
+{
+    avlnode * p_node = NULL;
+    uint64_t prefix = 0;
+    int found = 0;
+    int cmpval = 0;
+    if ((NULL == p_iter) || (NULL == p_key)){
+        return NULL;
+    }
+    p_node = p_iter->p_tree->p_root;
+    prefix = avltree_prefix(p_iter->p_tree, p_key);
+    p_iter->depth = 0;
+    // keep the whole path but remember the last node not smaller than the key
+    while (NULL != p_node){
+        p_iter->p_nodes[p_iter->depth++] = p_node;
+        cmpval = avltree_order(p_iter->p_tree, p_key, prefix, p_node);
+        if (cmpval <= 0){
+            found = p_iter->depth;
+            if (0 == cmpval){
+                break;
+            }
+        }
+        p_node = (cmpval < 0) ? p_node->p_left : p_node->p_right;
+    }
+    p_iter->depth = found;
+    if (0 == found){
+        return NULL;
+    }
+    return iter_skip(p_iter, p_iter->p_nodes[found - 1], true);
+}
+
+/*
+ * @brief moves an iterator to the next data in order
+ * @param p_iter the iterator to move
+ * @return the next data or NULL when the iterator left the tree
+ */
+void * avltree_iter_next(avliter * p_iter)
+{
+    return (NULL == p_iter) ? NULL : iter_skip(p_iter, iter_step(p_iter, true), true);
+}
+
+/*
+ * @brief moves an iterator to the previous data in order
+ * @param p_iter the iterator to move
+ * @return the previous data or NULL when the iterator left the tree
+ */
+void * avltree_iter_prev(avliter * p_iter)
+{
+    return (NULL == p_iter) ? NULL : iter_skip(p_iter, iter_step(p_iter, false), false);
+}
+
+/*
+ * @brief gets the data at the position of an iterator
+ * @param p_iter the iterator
+ * @return the current data or NULL when the iterator is outside the tree
+ */
+void * avltree_iter_data(avliter * p_iter)
+{
+    if ((NULL == p_iter) || (0 == p_iter->depth)){
+        return NULL;
+    }
+    return p_iter->p_nodes[p_iter->depth - 1]->p_data;
 }
@@ -370,22 +370,32 @@ bool btree_is_leaf(btnode * p_node)
 
 // setters
 
+/*
+ * @brief sets the left child of a node
+ * @param p_parent the node to set the left child of
+ * @param p_child the new left child, NULL to clear the link
+ */
 void btree_set_left(btnode * p_parent, btnode * p_child)
 {
-    // ensure neither node is null
-    if ((NULL == p_parent) || (NULL == p_child)){
+    // ensure the parent is not null
+    if (NULL == p_parent){
         return;
     }
     p_parent->p_left = p_child;
 }
 
+/*
+ * @brief sets the right child of a node
+ * @param p_parent the node to set the right child of
+ * @param p_child the new right child, NULL to clear the link
+ */
 void btree_set_right(btnode * p_parent, btnode * p_child)
 {
-    // ensure neither node is null
-    if ((NULL == p_parent) || (NULL == p_child)){
+    // ensure the parent is not null
+    if (NULL == p_parent){
         return;
     }
-    p_parent->p_left = p_child;
+    p_parent->p_right = p_child;
 }
 
 void btree_size_decrease(btree * p_tree)
@@ -0,0 +1,1138 @@
+#include <cavltree.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <sched.h>
+
+/*
+ * @param LINE the cache line size the epoch slots are padded to
+ * @param SPINS the number of polls of a busy lock or a rotating node before
+ *  a thread yields the processor
+ * @param RECLAIM_AFTER the number of unlinked nodes between attempts to
+ *  advance the epoch and free the nodes no reader can reach anymore
+ */
+enum {LINE = 64, SPINS = 128, RECLAIM_AFTER = 64};
+
+/*
+ * @param UNLINKED set in the version of a node that left the tree, the
+ *  version never changes again
+ * @param SHRINKING set in the version of a node while a rotation moves it
+ *  down, searches below it have to wait and start over
+ * @param SHRINK_COUNT added to the version once a rotation is done
+ */
+enum {UNLINKED = 1, SHRINKING = 2, SHRINK_COUNT = 4};
+
+/*
+ * @param RETRY returned when the node an attempt started from changed, the
+ *  caller starts over from its own node
+ * @param UNLINK_REQUIRED a routing node with less than two children
+ * @param REBALANCE_REQUIRED a node whose children differ in height by two
+ * @param NOTHING_REQUIRED a node whose height is up to date
+ */
+enum {RETRY = 1, UNLINK_REQUIRED = -1, REBALANCE_REQUIRED = -2, NOTHING_REQUIRED = -3};
+
+/*
+ * @brief node of a concurrent avltree, searches read the links without
+ *  locks and check the version of the node they came from did not change.
+ *  A removed node with two children stays in the tree as a routing node
+ *  without data until a rebalance can unlink it
+ * @param p_key the data the node was made for, it orders the node for as
+ *  long as it is reachable
+ * @param p_data the data in the node or NULL for a routing node
+ * @param version the UNLINKED and SHRINKING bits and the rotation count
+ * @param height the height of the subtree, 1 for a leaf
+ * @param b_locked true while a writer owns the node
+ * @param p_parent the parent of the node
+ * @param p_left the left child of the node
+ * @param p_right the right child of the node
+ * @param p_retired the next node waiting to be freed once unlinked
+ */
+typedef struct cavlnode cavlnode;
+struct cavlnode {
+    void * p_key;
+    _Atomic(void *) p_data;
+    atomic_ullong version;
+    atomic_int height;
+    atomic_bool b_locked;
+    _Atomic(cavlnode *) p_parent;
+    _Atomic(cavlnode *) p_left;
+    _Atomic(cavlnode *) p_right;
+    cavlnode * p_retired;
+};
+
+/*
+ * @brief the operations of the threads sharing a slot that are running in
+ *  each of the last three epochs
+ * @param pins the count of running operations per epoch
+ */
+typedef struct cavltree_slot {
+    _Alignas(LINE) atomic_long pins[3];
+} cavltree_slot;
+
+/*
+ * @brief concurrent avltree structure
+ * @param holder a node without a key whose right child is the root so the
+ *  root can be rotated like any other node
+ * @param size the number of data in the tree
+ * @param destroy the user defined destroy function
+ * @param compare the user defined compare function
+ * @param epoch the epoch new operations are pinned to
+ * @param slots the number of epoch slots
+ * @param p_slots the epoch slots threads are spread over
+ * @param b_retiring true while a thread adds to the unlinked nodes
+ * @param p_limbo the unlinked nodes of the last three epochs
+ * @param retired the number of nodes unlinked since the epoch advanced
+ */
+struct cavltree {
+    cavlnode holder;
+    atomic_llong size;
+    void (* destroy)(void * p_data);
+    int8_t (* compare)(void * p_key1, void * p_key2);
+    atomic_ullong epoch;
+    int slots;
+    cavltree_slot * p_slots;
+    atomic_bool b_retiring;
+    cavlnode * p_limbo[3];
+    int64_t retired;
+};
+
+/*
+ * @brief gets a number for the calling thread that stays the same for as
+ *  long as the thread runs
+ * @return the number of the thread
+ */
+static int cavltree_thread(void)
+{
+    static atomic_int threads = 0;
+    static _Thread_local int thread = -1;
+    if (thread < 0){
+        thread = atomic_fetch_add_explicit(&threads, 1, memory_order_relaxed);
+    }
+    return thread;
+}
+
+/*
+ * @brief takes ownership of a lock, yielding while another thread holds it
+ * @param p_lock the lock to take
+ */
+static void cavltree_lock(atomic_bool * p_lock)
+{
+    int spins = 0;
+    while (atomic_load_explicit(p_lock, memory_order_relaxed) || \
+        atomic_exchange_explicit(p_lock, true, memory_order_acquire)){
+        if (++spins >= SPINS){
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
+
+/*
+ * @brief gives up ownership of a lock
+ * @param p_lock the lock to release
+ */
+static void cavltree_unlock(atomic_bool * p_lock)
+{
+    atomic_store_explicit(p_lock, false, memory_order_release);
+}
+
+/*
+ * @brief waits for the rotation moving a node down to finish, the writer
+ *  changing the version is running so it is never long
+ * @param p_node the node being rotated
+ * @param version the version seen while the rotation ran
+ */
+static void cavltree_wait(cavlnode * p_node, uint64_t version)
+{
+    int spins = 0;
+    while (version == atomic_load(&p_node->version)){
+        if (++spins >= SPINS){
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
+
+/*
+ * @brief pins the calling thread to the current epoch so nodes it can reach
+ *  are not freed until it leaves
+ * @param p_tree the tree the operation runs on
+ * @param pp_slot set to the slot of the thread
+ * @return the index of the pinned epoch in the slot
+ */
+static int cavltree_enter(cavltree * p_tree, cavltree_slot ** pp_slot)
+{
+    cavltree_slot * p_slot = &p_tree->p_slots[cavltree_thread() % p_tree->slots];
+    *pp_slot = p_slot;
+    while (true){
+        uint64_t epoch = atomic_load(&p_tree->epoch);
+        atomic_fetch_add(&p_slot->pins[epoch % 3], 1);
+        // an epoch that moved on before the pin was seen may free nodes
+        if (epoch == atomic_load(&p_tree->epoch)){
+            return epoch % 3;
+        }
+        atomic_fetch_sub(&p_slot->pins[epoch % 3], 1);
+    }
+}
+
+/*
+ * @brief unpins the calling thread from its epoch
+ * @param p_slot the slot of the thread
+ * @param index the index of the pinned epoch
+ */
+static void cavltree_leave(cavltree_slot * p_slot, int index)
+{
+    atomic_fetch_sub_explicit(&p_slot->pins[index], 1, memory_order_release);
+}
+
+/*
+ * @brief frees a list of unlinked nodes, running the destroy function on the
+ *  data they were ordered by
+ * @param p_tree the tree the nodes were in
+ * @param p_node the first node of the list
+ */
+static void cavltree_free(cavltree * p_tree, cavlnode * p_node)
+{
+    while (NULL != p_node){
+        cavlnode * p_next = p_node->p_retired;
+        if (NULL != p_tree->destroy){
+            p_tree->destroy(p_node->p_key);
+        }
+        free(p_node);
+        p_node = p_next;
+    }
+}
+
+/*
+ * @brief adds an unlinked node to the nodes of the current epoch and frees
+ *  the nodes of the epoch before last once no operation from the last epoch
+ *  is still running
+ * @param p_tree the tree the node was in
+ * @param p_node the unlinked node
+ */
+static void cavltree_retire(cavltree * p_tree, cavlnode * p_node)
+{
+    cavlnode * p_free = NULL;
+    cavltree_lock(&p_tree->b_retiring);
+    uint64_t epoch = atomic_load(&p_tree->epoch);
+    p_node->p_retired = p_tree->p_limbo[epoch % 3];
+    p_tree->p_limbo[epoch % 3] = p_node;
+    if (++p_tree->retired >= RECLAIM_AFTER){
+        bool b_quiet = true;
+        for (int index = 0; b_quiet && (index < p_tree->slots); index++){
+            b_quiet = (0 == atomic_load(&p_tree->p_slots[index].pins[(epoch + 2) % 3]));
+        }
+        // every running operation started in this epoch so none of them can
+        // reach a node unlinked two epochs ago
+        if (b_quiet){
+            p_free = p_tree->p_limbo[(epoch + 1) % 3];
+            p_tree->p_limbo[(epoch + 1) % 3] = NULL;
+            p_tree->retired = 0;
+            atomic_store(&p_tree->epoch, epoch + 1);
+        }
+    }
+    cavltree_unlock(&p_tree->b_retiring);
+    cavltree_free(p_tree, p_free);
+}
+
+/*
+ * @brief allocates a leaf
+ * @param p_data the data for the leaf
+ * @param p_parent the parent of the leaf
+ * @return the new leaf or NULL on error
+ */
+static cavlnode * cavltree_node(void * p_data, cavlnode * p_parent)
+{
+    cavlnode * p_node = calloc(1, sizeof(*p_node));
+    if (NULL == p_node){
+        perror("cavltree_insert ");
+        return NULL;
+    }
+    p_node->p_key = p_data;
+    atomic_init(&p_node->p_data, p_data);
+    atomic_init(&p_node->version, 0);
+    atomic_init(&p_node->height, 1);
+    atomic_init(&p_node->b_locked, false);
+    atomic_init(&p_node->p_parent, p_parent);
+    atomic_init(&p_node->p_left, NULL);
+    atomic_init(&p_node->p_right, NULL);
+    return p_node;
+}
+
+/*
+ * @brief gets the link to the child of a node on the side of a comparison
+ * @param p_node the parent
+ * @param cmpval the result of comparing a key against the parent
+ * @return the left link for keys below the parent else the right one
+ */
+static _Atomic(cavlnode *) * cavltree_child(cavlnode * p_node, int cmpval)
+{
+    return (cmpval < 0) ? &p_node->p_left : &p_node->p_right;
+}
+
+/*
+ * @brief gets the height of a subtree
+ * @param p_node the root of the subtree
+ * @return its height or 0 for an empty subtree
+ */
+static int cavltree_height(cavlnode * p_node)
+{
+    return (NULL == p_node) ? 0 : atomic_load_explicit(&p_node->height, memory_order_relaxed);
+}
+
+/*
+ * @brief checks what a node needs to be balanced, read without locks so the
+ *  answer is only a hint
+ * @param p_node the node to check
+ * @return UNLINK_REQUIRED, REBALANCE_REQUIRED, NOTHING_REQUIRED or the
+ *  height the node should have
+ */
+static int cavltree_condition(cavlnode * p_node)
+{
+    cavlnode * p_left = atomic_load(&p_node->p_left);
+    cavlnode * p_right = atomic_load(&p_node->p_right);
+    if (((NULL == p_left) || (NULL == p_right)) && (NULL == atomic_load(&p_node->p_data))){
+        return UNLINK_REQUIRED;
+    }
+    int left_height = cavltree_height(p_left);
+    int right_height = cavltree_height(p_right);
+    int height = 1 + ((left_height > right_height) ? left_height : right_height);
+    int balance = left_height - right_height;
+    if ((balance < -1) || (balance > 1)){
+        return REBALANCE_REQUIRED;
+    }
+    return (height != cavltree_height(p_node)) ? height : NOTHING_REQUIRED;
+}
+
+/*
+ * @brief updates the height of a locked node
+ * @param p_node the node to update
+ * @return the next node that may need work or NULL
+ */
+static cavlnode * fix_height(cavlnode * p_node)
+{
+    int condition = cavltree_condition(p_node);
+    if ((REBALANCE_REQUIRED == condition) || (UNLINK_REQUIRED == condition)){
+        return p_node;
+    }
+    if (NOTHING_REQUIRED == condition){
+        return NULL;
+    }
+    atomic_store_explicit(&p_node->height, condition, memory_order_relaxed);
+    return atomic_load(&p_node->p_parent);
+}
+
+/*
+ * @brief unlinks a node with less than two children from its parent, both
+ *  locked by the caller
+ * @param p_parent the parent of the node
+ * @param p_node the node to unlink
+ * @return true if the node was unlinked, false if the tree changed
+ */
+static bool unlink_node(cavlnode * p_parent, cavlnode * p_node)
+{
+    cavlnode * p_parent_left = atomic_load(&p_parent->p_left);
+    cavlnode * p_left = atomic_load(&p_node->p_left);
+    cavlnode * p_right = atomic_load(&p_node->p_right);
+    if ((p_parent_left != p_node) && (atomic_load(&p_parent->p_right) != p_node)){
+        return false;
+    }
+    if ((NULL != p_left) && (NULL != p_right)){
+        return false;
+    }
+    cavlnode * p_splice = (NULL != p_left) ? p_left : p_right;
+    atomic_store((p_parent_left == p_node) ? &p_parent->p_left : &p_parent->p_right, p_splice);
+    if (NULL != p_splice){
+        atomic_store(&p_splice->p_parent, p_parent);
+    }
+    atomic_store(&p_node->version, UNLINKED);
+    atomic_store(&p_node->p_data, NULL);
+    return true;
+}
+
+/*
+ * @brief rotates the left child of a node up, the parent, node and child are
+ *  locked by the caller
+ * @param p_parent the parent of the node
+ * @param p_node the node moving down
+ * @param p_left the left child moving up
+ * @param right_height the height of the right subtree of the node
+ * @param left_left_height the height of the left subtree of the child
+ * @param p_left_right the right child of the child
+ * @param left_right_height the height of the right subtree of the child
+ * @return the next node that may need work or NULL
+ */
+static cavlnode * rotate_right(cavlnode * p_parent, cavlnode * p_node, cavlnode * p_left, int right_height, \
+    int left_left_height, cavlnode * p_left_right, int left_right_height)
+{
+    uint64_t version = atomic_load(&p_node->version);
+    cavlnode * p_parent_left = atomic_load(&p_parent->p_left);
+    atomic_store(&p_node->version, version | SHRINKING);
+    atomic_store(&p_node->p_left, p_left_right);
+    if (NULL != p_left_right){
+        atomic_store(&p_left_right->p_parent, p_node);
+    }
+    atomic_store(&p_left->p_right, p_node);
+    atomic_store(&p_node->p_parent, p_left);
+    atomic_store((p_parent_left == p_node) ? &p_parent->p_left : &p_parent->p_right, p_left);
+    atomic_store(&p_left->p_parent, p_parent);
+    int node_height = 1 + ((left_right_height > right_height) ? left_right_height : right_height);
+    atomic_store_explicit(&p_node->height, node_height, memory_order_relaxed);
+    atomic_store_explicit(&p_left->height, 1 + ((left_left_height > node_height) ? left_left_height : node_height), memory_order_relaxed);
+    atomic_store(&p_node->version, version + SHRINK_COUNT);
+    // the node moving down or the child moving up may still need work
+    int balance = left_right_height - right_height;
+    if ((balance < -1) || (balance > 1)){
+        return p_node;
+    }
+    if (((NULL == p_left_right) || (0 == right_height)) && (NULL == atomic_load(&p_node->p_data))){
+        return p_node;
+    }
+    balance = left_left_height - node_height;
+    if ((balance < -1) || (balance > 1)){
+        return p_left;
+    }
+    if ((0 == left_left_height) && (NULL == atomic_load(&p_left->p_data))){
+        return p_left;
+    }
+    return fix_height(p_parent);
+}
+
+/*
+ * @brief rotates the right child of a node up, the parent, node and child
+ *  are locked by the caller
+ * @param p_parent the parent of the node
+ * @param p_node the node moving down
+ * @param left_height the height of the left subtree of the node
+ * @param p_right the right child moving up
+ * @param p_right_left the left child of the child
+ * @param right_left_height the height of the left subtree of the child
+ * @param right_right_height the height of the right subtree of the child
+ * @return the next node that may need work or NULL
+ */
+static cavlnode * rotate_left(cavlnode * p_parent, cavlnode * p_node, int left_height, cavlnode * p_right, \
+    cavlnode * p_right_left, int right_left_height, int right_right_height)
+{
+    uint64_t version = atomic_load(&p_node->version);
+    cavlnode * p_parent_left = atomic_load(&p_parent->p_left);
+    atomic_store(&p_node->version, version | SHRINKING);
+    atomic_store(&p_node->p_right, p_right_left);
+    if (NULL != p_right_left){
+        atomic_store(&p_right_left->p_parent, p_node);
+    }
+    atomic_store(&p_right->p_left, p_node);
+    atomic_store(&p_node->p_parent, p_right);
+    atomic_store((p_parent_left == p_node) ? &p_parent->p_left : &p_parent->p_right, p_right);
+    atomic_store(&p_right->p_parent, p_parent);
+    int node_height = 1 + ((left_height > right_left_height) ? left_height : right_left_height);
+    atomic_store_explicit(&p_node->height, node_height, memory_order_relaxed);
+    atomic_store_explicit(&p_right->height, 1 + ((node_height > right_right_height) ? node_height : right_right_height), memory_order_relaxed);
+    atomic_store(&p_node->version, version + SHRINK_COUNT);
+    int balance = right_left_height - left_height;
+    if ((balance < -1) || (balance > 1)){
+        return p_node;
+    }
+    if (((NULL == p_right_left) || (0 == left_height)) && (NULL == atomic_load(&p_node->p_data))){
+        return p_node;
+    }
+    balance = right_right_height - node_height;
+    if ((balance < -1) || (balance > 1)){
+        return p_right;
+    }
+    if ((0 == right_right_height) && (NULL == atomic_load(&p_right->p_data))){
+        return p_right;
+    }
+    return fix_height(p_parent);
+}
+
+/*
+ * @brief rotates the right child of the left child of a node up past both,
+ *  all four nodes are locked by the caller
+ * @param p_parent the parent of the node
+ * @param p_node the node moving down to the right
+ * @param p_left the left child moving down to the left
+ * @param right_height the height of the right subtree of the node
+ * @param left_left_height the height of the left subtree of the left child
+ * @param p_left_right the grandchild moving up
+ * @param left_right_left_height the height of the left subtree of the
+ *  grandchild
+ * @return the next node that may need work or NULL
+ */
+static cavlnode * rotate_right_over_left(cavlnode * p_parent, cavlnode * p_node, cavlnode * p_left, int right_height, \
+    int left_left_height, cavlnode * p_left_right, int left_right_left_height)
+{
+    uint64_t version = atomic_load(&p_node->version);
+    uint64_t left_version = atomic_load(&p_left->version);
+    cavlnode * p_parent_left = atomic_load(&p_parent->p_left);
+    cavlnode * p_left_right_left = atomic_load(&p_left_right->p_left);
+    cavlnode * p_left_right_right = atomic_load(&p_left_right->p_right);
+    int left_right_right_height = cavltree_height(p_left_right_right);
+    atomic_store(&p_node->version, version | SHRINKING);
+    atomic_store(&p_left->version, left_version | SHRINKING);
+    atomic_store(&p_node->p_left, p_left_right_right);
+    if (NULL != p_left_right_right){
+        atomic_store(&p_left_right_right->p_parent, p_node);
+    }
+    atomic_store(&p_left->p_right, p_left_right_left);
+    if (NULL != p_left_right_left){
+        atomic_store(&p_left_right_left->p_parent, p_left);
+    }
+    atomic_store(&p_left_right->p_left, p_left);
+    atomic_store(&p_left->p_parent, p_left_right);
+    atomic_store(&p_left_right->p_right, p_node);
+    atomic_store(&p_node->p_parent, p_left_right);
+    atomic_store((p_parent_left == p_node) ? &p_parent->p_left : &p_parent->p_right, p_left_right);
+    atomic_store(&p_left_right->p_parent, p_parent);
+    int node_height = 1 + ((left_right_right_height > right_height) ? left_right_right_height : right_height);
+    int left_height = 1 + ((left_left_height > left_right_left_height) ? left_left_height : left_right_left_height);
+    atomic_store_explicit(&p_node->height, node_height, memory_order_relaxed);
+    atomic_store_explicit(&p_left->height, left_height, memory_order_relaxed);
+    atomic_store_explicit(&p_left_right->height, 1 + ((left_height > node_height) ? left_height : node_height), memory_order_relaxed);
+    atomic_store(&p_node->version, version + SHRINK_COUNT);
+    atomic_store(&p_left->version, left_version + SHRINK_COUNT);
+    int balance = left_right_right_height - right_height;
+    if ((balance < -1) || (balance > 1)){
+        return p_node;
+    }
+    if (((NULL == p_left_right_right) || (0 == right_height)) && (NULL == atomic_load(&p_node->p_data))){
+        return p_node;
+    }
+    balance = left_height - node_height;
+    if ((balance < -1) || (balance > 1)){
+        return p_left_right;
+    }
+    return fix_height(p_parent);
+}
+
+/*
+ * @brief rotates the left child of the right child of a node up past both,
+ *  all four nodes are locked by the caller
+ * @param p_parent the parent of the node
+ * @param p_node the node moving down to the left
+ * @param left_height the height of the left subtree of the node
+ * @param p_right the right child moving down to the right
+ * @param p_right_left the grandchild moving up
+ * @param right_right_height the height of the right subtree of the right
+ *  child
+ * @param right_left_right_height the height of the right subtree of the
+ *  grandchild
+ * @return the next node that may need work or NULL
+ */
+static cavlnode * rotate_left_over_right(cavlnode * p_parent, cavlnode * p_node, int left_height, cavlnode * p_right, \
+    cavlnode * p_right_left, int right_right_height, int right_left_right_height)
+{
+    uint64_t version = atomic_load(&p_node->version);
+    uint64_t right_version = atomic_load(&p_right->version);
+    cavlnode * p_parent_left = atomic_load(&p_parent->p_left);
+    cavlnode * p_right_left_left = atomic_load(&p_right_left->p_left);
+    cavlnode * p_right_left_right = atomic_load(&p_right_left->p_right);
+    int right_left_left_height = cavltree_height(p_right_left_left);
+    atomic_store(&p_node->version, version | SHRINKING);
+    atomic_store(&p_right->version, right_version | SHRINKING);
+    atomic_store(&p_node->p_right, p_right_left_left);
+    if (NULL != p_right_left_left){
+        atomic_store(&p_right_left_left->p_parent, p_node);
+    }
+    atomic_store(&p_right->p_left, p_right_left_right);
+    if (NULL != p_right_left_right){
+        atomic_store(&p_right_left_right->p_parent, p_right);
+    }
+    atomic_store(&p_right_left->p_right, p_right);
+    atomic_store(&p_right->p_parent, p_right_left);
+    atomic_store(&p_right_left->p_left, p_node);
+    atomic_store(&p_node->p_parent, p_right_left);
+    atomic_store((p_parent_left == p_node) ? &p_parent->p_left : &p_parent->p_right, p_right_left);
+    atomic_store(&p_right_left->p_parent, p_parent);
+    int node_height = 1 + ((left_height > right_left_left_height) ? left_height : right_left_left_height);
+    int right_height = 1 + ((right_left_right_height > right_right_height) ? right_left_right_height : right_right_height);
+    atomic_store_explicit(&p_node->height, node_height, memory_order_relaxed);
+    atomic_store_explicit(&p_right->height, right_height, memory_order_relaxed);
+    atomic_store_explicit(&p_right_left->height, 1 + ((node_height > right_height) ? node_height : right_height), memory_order_relaxed);
+    atomic_store(&p_node->version, version + SHRINK_COUNT);
+    atomic_store(&p_right->version, right_version + SHRINK_COUNT);
+    int balance = right_left_left_height - left_height;
+    if ((balance < -1) || (balance > 1)){
+        return p_node;
+    }
+    if (((NULL == p_right_left_left) || (0 == left_height)) && (NULL == atomic_load(&p_node->p_data))){
+        return p_node;
+    }
+    balance = right_height - node_height;
+    if ((balance < -1) || (balance > 1)){
+        return p_right_left;
+    }
+    return fix_height(p_parent);
+}
+
+/*
+ * @brief rebalances a locked node whose left subtree is too tall, locking
+ *  the children it rotates
+ * @param p_parent the locked parent of the node
+ * @param p_node the node to rebalance
+ * @param p_left the left child of the node
+ * @param right_height the height of the right subtree of the node
+ * @return the next node that may need work or NULL
+ */
+static cavlnode * rebalance_right(cavlnode * p_parent, cavlnode * p_node, cavlnode * p_left, int right_height)
+{
+    cavlnode * p_next = p_node;
+    cavltree_lock(&p_left->b_locked);
+    if (cavltree_height(p_left) - right_height <= 1){
+        // another writer fixed the node first
+        cavltree_unlock(&p_left->b_locked);
+        return p_node;
+    }
+    cavlnode * p_left_right = atomic_load(&p_left->p_right);
+    int left_left_height = cavltree_height(atomic_load(&p_left->p_left));
+    int left_right_height = cavltree_height(p_left_right);
+    if (left_left_height >= left_right_height){
+        p_next = rotate_right(p_parent, p_node, p_left, right_height, left_left_height, p_left_right, left_right_height);
+        cavltree_unlock(&p_left->b_locked);
+        return p_next;
+    }
+    cavltree_lock(&p_left_right->b_locked);
+    left_right_height = cavltree_height(p_left_right);
+    if (left_left_height >= left_right_height){
+        p_next = rotate_right(p_parent, p_node, p_left, right_height, left_left_height, p_left_right, left_right_height);
+    }
+    else {
+        int left_right_left_height = cavltree_height(atomic_load(&p_left_right->p_left));
+        int balance = left_left_height - left_right_left_height;
+        if ((balance >= -1) && (balance <= 1) && !(((0 == left_left_height) || (0 == left_right_left_height)) && \
+            (NULL == atomic_load(&p_left->p_data)))){
+            p_next = rotate_right_over_left(p_parent, p_node, p_left, right_height, left_left_height, p_left_right, left_right_left_height);
+        }
+        else {
+            // the left child is rotated on its own first, the node is
+            // rebalanced once the walk comes back to it
+            p_next = rotate_left(p_node, p_left, left_left_height, p_left_right, atomic_load(&p_left_right->p_left), \
+                left_right_left_height, cavltree_height(atomic_load(&p_left_right->p_right)));
+        }
+    }
+    cavltree_unlock(&p_left_right->b_locked);
+    cavltree_unlock(&p_left->b_locked);
+    return p_next;
+}
+
+/*
+ * @brief rebalances a locked node whose right subtree is too tall, locking
+ *  the children it rotates
+ * @param p_parent the locked parent of the node
+ * @param p_node the node to rebalance
+ * @param p_right the right child of the node
+ * @param left_height the height of the left subtree of the node
+ * @return the next node that may need work or NULL
+ */
+static cavlnode * rebalance_left(cavlnode * p_parent, cavlnode * p_node, cavlnode * p_right, int left_height)
+{
+    cavlnode * p_next = p_node;
+    cavltree_lock(&p_right->b_locked);
+    if (left_height - cavltree_height(p_right) >= -1){
+        cavltree_unlock(&p_right->b_locked);
+        return p_node;
+    }
+    cavlnode * p_right_left = atomic_load(&p_right->p_left);
+    int right_left_height = cavltree_height(p_right_left);
+    int right_right_height = cavltree_height(atomic_load(&p_right->p_right));
+    if (right_right_height >= right_left_height){
+        p_next = rotate_left(p_parent, p_node, left_height, p_right, p_right_left, right_left_height, right_right_height);
+        cavltree_unlock(&p_right->b_locked);
+        return p_next;
+    }
+    cavltree_lock(&p_right_left->b_locked);
+    right_left_height = cavltree_height(p_right_left);
+    if (right_right_height >= right_left_height){
+        p_next = rotate_left(p_parent, p_node, left_height, p_right, p_right_left, right_left_height, right_right_height);
+    }
+    else {
+        int right_left_right_height = cavltree_height(atomic_load(&p_right_left->p_right));
+        int balance = right_right_height - right_left_right_height;
+        if ((balance >= -1) && (balance <= 1) && !(((0 == right_right_height) || (0 == right_left_right_height)) && \
+            (NULL == atomic_load(&p_right->p_data)))){
+            p_next = rotate_left_over_right(p_parent, p_node, left_height, p_right, p_right_left, right_right_height, right_left_right_height);
+        }
+        else {
+            p_next = rotate_right(p_node, p_right, p_right_left, right_right_height, \
+                cavltree_height(atomic_load(&p_right_left->p_left)), atomic_load(&p_right_left->p_right), right_left_right_height);
+        }
+    }
+    cavltree_unlock(&p_right_left->b_locked);
+    cavltree_unlock(&p_right->b_locked);
+    return p_next;
+}
+
+/*
+ * @brief unlinks, rotates or updates the height of a locked node
+ * @param p_parent the locked parent of the node
+ * @param p_node the node to fix
+ * @param pp_unlinked set to the node when it was unlinked
+ * @return the next node that may need work or NULL
+ */
+static cavlnode * rebalance(cavlnode * p_parent, cavlnode * p_node, cavlnode ** pp_unlinked)
+{
+    cavlnode * p_left = atomic_load(&p_node->p_left);
+    cavlnode * p_right = atomic_load(&p_node->p_right);
+    if (((NULL == p_left) || (NULL == p_right)) && (NULL == atomic_load(&p_node->p_data))){
+        if (unlink_node(p_parent, p_node)){
+            *pp_unlinked = p_node;
+            return fix_height(p_parent);
+        }
+        return p_node;
+    }
+    int left_height = cavltree_height(p_left);
+    int right_height = cavltree_height(p_right);
+    int height = 1 + ((left_height > right_height) ? left_height : right_height);
+    int balance = left_height - right_height;
+    if (balance > 1){
+        return rebalance_right(p_parent, p_node, p_left, right_height);
+    }
+    if (balance < -1){
+        return rebalance_left(p_parent, p_node, p_right, left_height);
+    }
+    if (height != cavltree_height(p_node)){
+        atomic_store_explicit(&p_node->height, height, memory_order_relaxed);
+        return fix_height(p_parent);
+    }
+    return NULL;
+}
+
+/*
+ * @brief walks up from a node fixing heights, unlinking routing nodes and
+ *  rotating until the tree is balanced again
+ * @param p_tree the tree being fixed
+ * @param p_node the first node that may need work
+ */
+static void fix_and_rebalance(cavltree * p_tree, cavlnode * p_node)
+{
+    cavlnode * p_resume = NULL;
+    bool b_climb = false;
+    while (true){
+        // the holder has no parent and never needs work
+        if ((NULL == p_node) || (NULL == atomic_load(&p_node->p_parent)) || \
+            (0 != (atomic_load(&p_node->version) & UNLINKED))){
+            // a rotation that handed back a node below it left the heights
+            // above it to be checked once that node is fixed
+            if (NULL == p_resume){
+                return;
+            }
+            p_node = p_resume;
+            p_resume = NULL;
+            b_climb = true;
+            continue;
+        }
+        int condition = cavltree_condition(p_node);
+        if (NOTHING_REQUIRED == condition){
+            p_node = (b_climb) ? atomic_load(&p_node->p_parent) : NULL;
+            continue;
+        }
+        if ((UNLINK_REQUIRED != condition) && (REBALANCE_REQUIRED != condition)){
+            cavlnode * p_locked = p_node;
+            cavltree_lock(&p_locked->b_locked);
+            p_node = fix_height(p_locked);
+            cavltree_unlock(&p_locked->b_locked);
+            continue;
+        }
+        cavlnode * p_parent = atomic_load(&p_node->p_parent);
+        cavlnode * p_unlinked = NULL;
+        cavltree_lock(&p_parent->b_locked);
+        if ((0 == (atomic_load(&p_parent->version) & UNLINKED)) && (p_parent == atomic_load(&p_node->p_parent))){
+            cavlnode * p_locked = p_node;
+            cavlnode * p_grandparent = atomic_load(&p_parent->p_parent);
+            cavltree_lock(&p_locked->b_locked);
+            p_node = rebalance(p_parent, p_locked, &p_unlinked);
+            cavltree_unlock(&p_locked->b_locked);
+            if ((NULL != p_node) && (p_parent != p_node) && (p_grandparent != p_node)){
+                p_resume = p_parent;
+            }
+        }
+        cavltree_unlock(&p_parent->b_locked);
+        if (NULL != p_unlinked){
+            cavltree_retire(p_tree, p_unlinked);
+        }
+    }
+}
+
+/*
+ * @brief searches below a node for a key without taking locks
+ * @param p_tree the tree to search
+ * @param p_key the key to search for
+ * @param p_node the node to search below
+ * @param cmpval the result of comparing the key against the node
+ * @param version the version of the node when it was reached
+ * @param pp_data set to the data found or NULL
+ * @return 0 once the search is done or RETRY when the node changed
+ */
+static int attempt_get(cavltree * p_tree, void * p_key, cavlnode * p_node, int cmpval, uint64_t version, void ** pp_data)
+{
+    _Atomic(cavlnode *) * pp_link = cavltree_child(p_node, cmpval);
+    while (true){
+        cavlnode * p_child = atomic_load(pp_link);
+        if (NULL == p_child){
+            if (version != atomic_load(&p_node->version)){
+                return RETRY;
+            }
+            *pp_data = NULL;
+            return 0;
+        }
+        int child_cmpval = p_tree->compare(p_key, p_child->p_key);
+        if (0 == child_cmpval){
+            *pp_data = atomic_load(&p_child->p_data);
+            return 0;
+        }
+        uint64_t child_version = atomic_load(&p_child->version);
+        if (0 != (child_version & (SHRINKING | UNLINKED))){
+            if (0 != (child_version & SHRINKING)){
+                cavltree_wait(p_child, child_version);
+            }
+        }
+        else if ((p_child == atomic_load(pp_link)) && (version == atomic_load(&p_node->version))){
+            if (0 == attempt_get(p_tree, p_key, p_child, child_cmpval, child_version, pp_data)){
+                return 0;
+            }
+        }
+        // the child moved so start over from this node if it did not move too
+        if (version != atomic_load(&p_node->version)){
+            return RETRY;
+        }
+    }
+}
+
+/*
+ * @brief sets or clears the data of a node holding a key equal to the one
+ *  being updated, unlinking it when it has less than two children
+ * @param p_tree the tree being updated
+ * @param p_data the data to insert or NULL to remove
+ * @param p_parent the parent the node was reached from
+ * @param p_node the node to update
+ * @return 0 on success, -1 when the data is already in the tree or is not
+ *  there to remove, RETRY when the node changed
+ */
+static int update_node(cavltree * p_tree, void * p_data, cavlnode * p_parent, cavlnode * p_node)
+{
+    void * p_old = NULL;
+    if (NULL == p_data){
+        if (NULL == atomic_load(&p_node->p_data)){
+            return -1;
+        }
+        if ((NULL == atomic_load(&p_node->p_left)) || (NULL == atomic_load(&p_node->p_right))){
+            // unlinking changes the parent so it is locked first
+            cavltree_lock(&p_parent->b_locked);
+            if ((0 != (atomic_load(&p_parent->version) & UNLINKED)) || (p_parent != atomic_load(&p_node->p_parent))){
+                cavltree_unlock(&p_parent->b_locked);
+                return RETRY;
+            }
+            cavltree_lock(&p_node->b_locked);
+            p_old = atomic_load(&p_node->p_data);
+            if ((NULL == p_old) || !unlink_node(p_parent, p_node)){
+                cavltree_unlock(&p_node->b_locked);
+                cavltree_unlock(&p_parent->b_locked);
+                return (NULL == p_old) ? -1 : RETRY;
+            }
+            cavltree_unlock(&p_node->b_locked);
+            cavlnode * p_damaged = fix_height(p_parent);
+            cavltree_unlock(&p_parent->b_locked);
+            atomic_fetch_sub_explicit(&p_tree->size, 1, memory_order_relaxed);
+            if ((p_old != p_node->p_key) && (NULL != p_tree->destroy)){
+                p_tree->destroy(p_old);
+            }
+            cavltree_retire(p_tree, p_node);
+            fix_and_rebalance(p_tree, p_damaged);
+            return 0;
+        }
+    }
+    cavltree_lock(&p_node->b_locked);
+    if (0 != (atomic_load(&p_node->version) & UNLINKED)){
+        cavltree_unlock(&p_node->b_locked);
+        return RETRY;
+    }
+    p_old = atomic_load(&p_node->p_data);
+    if ((NULL == p_data) == (NULL == p_old)){
+        // inserting over data or removing from a routing node
+        cavltree_unlock(&p_node->b_locked);
+        return -1;
+    }
+    if ((NULL == p_data) && ((NULL == atomic_load(&p_node->p_left)) || (NULL == atomic_load(&p_node->p_right)))){
+        // a child left so the node has to be unlinked instead
+        cavltree_unlock(&p_node->b_locked);
+        return RETRY;
+    }
+    atomic_store(&p_node->p_data, p_data);
+    cavltree_unlock(&p_node->b_locked);
+    atomic_fetch_add_explicit(&p_tree->size, (NULL == p_data) ? -1 : 1, memory_order_relaxed);
+    // the key of a routing node is destroyed once the node is freed
+    if ((NULL == p_data) && (p_old != p_node->p_key) && (NULL != p_tree->destroy)){
+        p_tree->destroy(p_old);
+    }
+    return 0;
+}
+
+/*
+ * @brief inserts or removes data below a node, locking only the nodes it
+ *  changes
+ * @param p_tree the tree to update
+ * @param p_key the key of the data
+ * @param p_data the data to insert or NULL to remove
+ * @param p_node the node to search below
+ * @param cmpval the result of comparing the key against the node
+ * @param version the version of the node when it was reached
+ * @return 0 on success, -1 when the data is already in the tree, is not
+ *  there to remove or on failure, RETRY when the node changed
+ */
+static int attempt_update(cavltree * p_tree, void * p_key, void * p_data, cavlnode * p_node, int cmpval, uint64_t version)
+{
+    _Atomic(cavlnode *) * pp_link = cavltree_child(p_node, cmpval);
+    int status = RETRY;
+    while (true){
+        cavlnode * p_child = atomic_load(pp_link);
+        if (version != atomic_load(&p_node->version)){
+            return RETRY;
+        }
+        if (NULL == p_child){
+            if (NULL == p_data){
+                return -1;
+            }
+            cavlnode * p_damaged = NULL;
+            cavltree_lock(&p_node->b_locked);
+            if (version != atomic_load(&p_node->version)){
+                cavltree_unlock(&p_node->b_locked);
+                return RETRY;
+            }
+            if (NULL != atomic_load(pp_link)){
+                // another writer attached a child first
+                cavltree_unlock(&p_node->b_locked);
+                continue;
+            }
+            p_child = cavltree_node(p_data, p_node);
+            if (NULL == p_child){
+                cavltree_unlock(&p_node->b_locked);
+                return -1;
+            }
+            atomic_store(pp_link, p_child);
+            p_damaged = fix_height(p_node);
+            cavltree_unlock(&p_node->b_locked);
+            atomic_fetch_add_explicit(&p_tree->size, 1, memory_order_relaxed);
+            fix_and_rebalance(p_tree, p_damaged);
+            return 0;
+        }
+        int child_cmpval = p_tree->compare(p_key, p_child->p_key);
+        if (0 == child_cmpval){
+            status = update_node(p_tree, p_data, p_node, p_child);
+            if (RETRY != status){
+                return status;
+            }
+            continue;
+        }
+        uint64_t child_version = atomic_load(&p_child->version);
+        if (0 != (child_version & (SHRINKING | UNLINKED))){
+            if (0 != (child_version & SHRINKING)){
+                cavltree_wait(p_child, child_version);
+            }
+            continue;
+        }
+        if ((p_child != atomic_load(pp_link)) || (version != atomic_load(&p_node->version))){
+            continue;
+        }
+        status = attempt_update(p_tree, p_key, p_data, p_child, child_cmpval, child_version);
+        if (RETRY != status){
+            return status;
+        }
+    }
+}
+
+/*
+ * @brief creates a concurrent avltree where lookups take no locks and
+ *  writers only lock the nodes they change
+ * @param threads the number of threads expected to use the tree, threads
+ *  beyond it share epoch slots
+ * @param destroy user defined destroy function for the tree
+ * @param compare user defined function to compare the data in the tree
+ * @return a pointer to the newly created tree or NULL on error
+ */
+cavltree * cavltree_init(int threads, void (* destroy)(void * p_data), int8_t (* compare)(void * p_key1, void * p_key2))
+{
+    if ((NULL == compare) || (threads < 1)){
+        return NULL;
+    }
+    cavltree * p_tree = calloc(1, sizeof(*p_tree));
+    if (NULL == p_tree){
+        perror("cavltree_init ");
+        return NULL;
+    }
+    p_tree->p_slots = aligned_alloc(LINE, threads * sizeof(cavltree_slot));
+    if (NULL == p_tree->p_slots){
+        perror("cavltree_init ");
+        free(p_tree);
+        return NULL;
+    }
+    for (int index = 0; index < threads; index++){
+        for (int epoch = 0; epoch < 3; epoch++){
+            atomic_init(&p_tree->p_slots[index].pins[epoch], 0);
+        }
+    }
+    p_tree->slots = threads;
+    p_tree->destroy = destroy;
+    p_tree->compare = compare;
+    atomic_init(&p_tree->size, 0);
+    atomic_init(&p_tree->epoch, 0);
+    atomic_init(&p_tree->b_retiring, false);
+    atomic_init(&p_tree->holder.p_data, NULL);
+    atomic_init(&p_tree->holder.version, 0);
+    atomic_init(&p_tree->holder.height, 0);
+    atomic_init(&p_tree->holder.b_locked, false);
+    atomic_init(&p_tree->holder.p_parent, NULL);
+    atomic_init(&p_tree->holder.p_left, NULL);
+    atomic_init(&p_tree->holder.p_right, NULL);
+    return p_tree;
+}
+
+/*
+ * @brief tears down a concurrent avltree, no thread may be using it
+ * @param p_tree the tree to tear down
+ */
+void cavltree_destroy(cavltree * p_tree)
+{
+    if (NULL == p_tree){
+        return;
+    }
+    cavlnode * p_node = atomic_load(&p_tree->holder.p_right);
+    // flatten the tree into a list without recursion
+    while (NULL != p_node){
+        cavlnode * p_left = atomic_load(&p_node->p_left);
+        if (NULL != p_left){
+            atomic_store(&p_node->p_left, atomic_load(&p_left->p_right));
+            atomic_store(&p_left->p_right, p_node);
+            p_node = p_left;
+            continue;
+        }
+        cavlnode * p_right = atomic_load(&p_node->p_right);
+        void * p_data = atomic_load(&p_node->p_data);
+        if ((NULL != p_tree->destroy) && (NULL != p_data) && (p_data != p_node->p_key)){
+            p_tree->destroy(p_data);
+        }
+        p_node->p_retired = NULL;
+        cavltree_free(p_tree, p_node);
+        p_node = p_right;
+    }
+    for (int epoch = 0; epoch < 3; epoch++){
+        cavltree_free(p_tree, p_tree->p_limbo[epoch]);
+    }
+    free(p_tree->p_slots);
+    free(p_tree);
+}
+
+/*
+ * @brief inserts data into a concurrent avltree, safe to call from any
+ *  number of threads
+ * @param p_tree the tree to insert into
+ * @param p_data the data to insert
+ * @return 0 on success -1 when the data is already in the tree or on failure
+ */
+int8_t cavltree_insert(cavltree * p_tree, void * p_data)
+{
+    cavltree_slot * p_slot = NULL;
+    int status = RETRY;
+    if ((NULL == p_tree) || (NULL == p_data)){
+        return -1;
+    }
+    int pin = cavltree_enter(p_tree, &p_slot);
+    // the holder never rotates so nothing above it needs a retry
+    while (RETRY == status){
+        status = attempt_update(p_tree, p_data, p_data, &p_tree->holder, 1, 0);
+    }
+    cavltree_leave(p_slot, pin);
+    return (0 == status) ? 0 : -1;
+}
+
+/*
+ * @brief removes the data equal to a key from a concurrent avltree, safe to
+ *  call from any number of threads. The destroy function runs on the data
+ *  once no search can still compare against it
+ * @param p_tree the tree to remove from
+ * @param p_key the key of the data to remove
+ * @return 0 on success -1 when the data is not in the tree
+ */
+int8_t cavltree_remove(cavltree * p_tree, void * p_key)
+{
+    cavltree_slot * p_slot = NULL;
+    int status = RETRY;
+    if ((NULL == p_tree) || (NULL == p_key)){
+        return -1;
+    }
+    int pin = cavltree_enter(p_tree, &p_slot);
+    while (RETRY == status){
+        status = attempt_update(p_tree, p_key, NULL, &p_tree->holder, 1, 0);
+    }
+    cavltree_leave(p_slot, pin);
+    return (0 == status) ? 0 : -1;
+}
+
+/*
+ * @brief looks up the data equal to a key in a concurrent avltree without
+ *  taking locks or writing to the tree, safe to call from any number of
+ *  threads
+ * @param p_tree the tree to search
+ * @param p_key the key to search for
+ * @return the data in the tree or NULL when it is not in the tree
+ */
+void * cavltree_lookup(cavltree * p_tree, void * p_key)
+{
+    cavltree_slot * p_slot = NULL;
+    void * p_data = NULL;
+    if ((NULL == p_tree) || (NULL == p_key)){
+        return NULL;
+    }
+    int pin = cavltree_enter(p_tree, &p_slot);
+    while (RETRY == attempt_get(p_tree, p_key, &p_tree->holder, 1, 0, &p_data)){
+        ;
+    }
+    cavltree_leave(p_slot, pin);
+    return p_data;
+}
+
+/*
+ * @brief gets the number of data in a concurrent avltree, the value may be
+ *  stale while other threads use the tree
+ * @param p_tree the tree to get the size of
+ * @return the size of the tree or -1 on error
+ */
+int64_t cavltree_size(cavltree * p_tree)
+{
+    if (NULL == p_tree){
+        return -1;
+    }
+    return atomic_load_explicit(&p_tree->size, memory_order_relaxed);
+}
+
+/*
+ * @brief runs a function on the data of a subtree in order
+ * @param p_node the root of the subtree
+ * @param func user defined function to run with the data
+ */
+static void inorder(cavlnode * p_node, void (* func)(void * p_data))
+{
+    if (NULL == p_node){
+        return;
+    }
+    inorder(atomic_load(&p_node->p_left), func);
+    if (NULL != atomic_load(&p_node->p_data)){
+        func(atomic_load(&p_node->p_data));
+    }
+    inorder(atomic_load(&p_node->p_right), func);
+}
+
+/*
+ * @brief runs a function on the data of a concurrent avltree in order, no
+ *  thread may be changing the tree
+ * @param p_tree the tree to traverse
+ * @param func user defined function to run with the data
+ */
+void cavltree_inorder(cavltree * p_tree, void (* func)(void * p_data))
+{
+    if ((NULL == p_tree) || (NULL == func)){
+        return;
+    }
+    inorder(atomic_load(&p_tree->holder.p_right), func);
+}
+// end of source
@@ -0,0 +1,425 @@
+#include <interval.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * @brief interval tree node, the nodes are ordered by their low endpoint then
+ *  their high endpoint and each one keeps the largest high endpoint below it
+ * @param p_left the left child of the node
+ * @param p_right the right child of the node
+ * @param p_low the low endpoint of the interval
+ * @param p_high the high endpoint of the interval
+ * @param p_max the largest high endpoint in the subtree of the node
+ * @param p_data the data of the interval
+ * @param height the height of the subtree, 1 for a leaf
+ */
+typedef struct interval_node {
+    struct interval_node * p_left;
+    struct interval_node * p_right;
+    void * p_low;
+    void * p_high;
+    void * p_max;
+    void * p_data;
+    int height;
+} inode;
+
+/*
+ * @brief interval tree structure
+ * @param p_root the root node of the tree
+ * @param size the number of intervals in the tree
+ * @param destroy user defined function to tear down the data
+ * @param compare user defined function to compare two endpoints
+ */
+typedef struct interval_t {
+    inode * p_root;
+    int64_t size;
+    void (* destroy)(void * p_data);
+    int8_t (* compare)(void * p_point1, void * p_point2);
+} interval_t;
+
+/*
+ * @brief gets the height of a subtree
+ * @param p_node the root of the subtree
+ * @return the height of the subtree, 0 when it is empty
+ */
+static int height(inode * p_node)
+{
+    return (NULL == p_node) ? 0 : p_node->height;
+}
+
+/*
+ * @brief recomputes the height and largest endpoint of a node from its
+ *  children, every change to the links of a node goes through here
+ * @param p_tree the tree providing the compare function
+ * @param p_node the node to update
+ */
+static void update(interval * p_tree, inode * p_node)
+{
+    inode * p_left = p_node->p_left;
+    inode * p_right = p_node->p_right;
+    p_node->height = ((height(p_left) > height(p_right)) ? height(p_left) : height(p_right)) + 1;
+    p_node->p_max = p_node->p_high;
+    if ((NULL != p_left) && (p_tree->compare(p_left->p_max, p_node->p_max) > 0)){
+        p_node->p_max = p_left->p_max;
+    }
+    if ((NULL != p_right) && (p_tree->compare(p_right->p_max, p_node->p_max) > 0)){
+        p_node->p_max = p_right->p_max;
+    }
+}
+
+/*
+ * @brief rotates a subtree to the right so its left child becomes the root
+ * @param p_tree the tree providing the compare function
+ * @param p_node the root of the subtree
+ * @return the new root of the subtree
+ */
+static inode * rotate_right(interval * p_tree, inode * p_node)
+{
+    inode * p_left = p_node->p_left;
+    p_node->p_left = p_left->p_right;
+    p_left->p_right = p_node;
+    // the old root is below the new one so it is updated first
+    update(p_tree, p_node);
+    update(p_tree, p_left);
+    return p_left;
+}
+
+/*
+ * @brief rotates a subtree to the left so its right child becomes the root
+ * @param p_tree the tree providing the compare function
+ * @param p_node the root of the subtree
+ * @return the new root of the subtree
+ */
+static inode * rotate_left(interval * p_tree, inode * p_node)
+{
+    inode * p_right = p_node->p_right;
+    p_node->p_right = p_right->p_left;
+    p_right->p_left = p_node;
+    update(p_tree, p_node);
+    update(p_tree, p_right);
+    return p_right;
+}
+
+/*
+ * @brief updates a node whose subtrees changed and rotates it back into
+ *  balance when their heights differ by two
+ * @param p_tree the tree providing the compare function
+ * @param p_node the root of the subtree
+ * @return the new root of the subtree
+ */
+static inode * balance(interval * p_tree, inode * p_node)
+{
+    update(p_tree, p_node);
+    if (height(p_node->p_left) > height(p_node->p_right) + 1){
+        // a right heavy left child needs a left right rotation
+        if (height(p_node->p_left->p_right) > height(p_node->p_left->p_left)){
+            p_node->p_left = rotate_left(p_tree, p_node->p_left);
+        }
+        return rotate_right(p_tree, p_node);
+    }
+    if (height(p_node->p_right) > height(p_node->p_left) + 1){
+        // a left heavy right child needs a right left rotation
+        if (height(p_node->p_right->p_left) > height(p_node->p_right->p_right)){
+            p_node->p_right = rotate_right(p_tree, p_node->p_right);
+        }
+        return rotate_left(p_tree, p_node);
+    }
+    return p_node;
+}
+
+/*
+ * @brief compares an interval with the interval of a node
+ * @param p_tree the tree providing the compare function
+ * @param p_low the low endpoint of the interval
+ * @param p_high the high endpoint of the interval
+ * @param p_node the node to compare with
+ * @return less than, equal to or greater than 0 as the interval orders before,
+ *  equal to or after the interval of the node
+ */
+static int order(interval * p_tree, void * p_low, void * p_high, inode * p_node)
+{
+    int cmpval = p_tree->compare(p_low, p_node->p_low);
+    return (0 != cmpval) ? cmpval : p_tree->compare(p_high, p_node->p_high);
+}
+
+/*
+ * @brief inserts an interval into a subtree
+ * @param p_tree the tree to insert into
+ * @param p_node the root of the subtree
+ * @param p_low the low endpoint of the interval
+ * @param p_high the high endpoint of the interval
+ * @param p_data the data of the interval
+ * @param p_status set to -1 when the interval is already in the tree or on
+ *  failure
+ * @return the new root of the subtree
+ */
+static inode * insert(interval * p_tree, inode * p_node, void * p_low, void * p_high, void * p_data, int * p_status)
+{
+    int cmpval = 0;
+    if (NULL == p_node){
+        p_node = calloc(1, sizeof(*p_node));
+        if (NULL == p_node){
+            perror("interval_insert ");
+            *p_status = -1;
+            return NULL;
+        }
+        p_node->p_low = p_low;
+        p_node->p_high = p_high;
+        p_node->p_max = p_high;
+        p_node->p_data = p_data;
+        p_node->height = 1;
+        return p_node;
+    }
+    cmpval = order(p_tree, p_low, p_high, p_node);
+    if (0 == cmpval){
+        *p_status = -1;
+        return p_node;
+    }
+    if (cmpval < 0){
+        p_node->p_left = insert(p_tree, p_node->p_left, p_low, p_high, p_data, p_status);
+    }
+    else {
+        p_node->p_right = insert(p_tree, p_node->p_right, p_low, p_high, p_data, p_status);
+    }
+    return (0 == *p_status) ? balance(p_tree, p_node) : p_node;
+}
+
+/*
+ * @brief unlinks the smallest node of a subtree
+ * @param p_tree the tree to remove from
+ * @param p_node the root of the subtree
+ * @param pp_min set to the unlinked node
+ * @return the new root of the subtree
+ */
+static inode * remove_min(interval * p_tree, inode * p_node, inode ** pp_min)
+{
+    if (NULL == p_node->p_left){
+        *pp_min = p_node;
+        return p_node->p_right;
+    }
+    p_node->p_left = remove_min(p_tree, p_node->p_left, pp_min);
+    return balance(p_tree, p_node);
+}
+
+/*
+ * @brief unlinks the node holding an interval from a subtree
+ * @param p_tree the tree to remove from
+ * @param p_node the root of the subtree
+ * @param p_low the low endpoint of the interval
+ * @param p_high the high endpoint of the interval
+ * @param pp_removed set to the unlinked node
+ * @return the new root of the subtree
+ */
+static inode * remove_node(interval * p_tree, inode * p_node, void * p_low, void * p_high, inode ** pp_removed)
+{
+    inode * p_min = NULL;
+    int cmpval = 0;
+    if (NULL == p_node){
+        return NULL;
+    }
+    cmpval = order(p_tree, p_low, p_high, p_node);
+    if (cmpval < 0){
+        p_node->p_left = remove_node(p_tree, p_node->p_left, p_low, p_high, pp_removed);
+    }
+    else if (cmpval > 0){
+        p_node->p_right = remove_node(p_tree, p_node->p_right, p_low, p_high, pp_removed);
+    }
+    else {
+        *pp_removed = p_node;
+        if ((NULL == p_node->p_left) || (NULL == p_node->p_right)){
+            return (NULL == p_node->p_left) ? p_node->p_right : p_node->p_left;
+        }
+        // the successor takes the place of the node
+        p_node->p_right = remove_min(p_tree, p_node->p_right, &p_min);
+        p_min->p_left = p_node->p_left;
+        p_min->p_right = p_node->p_right;
+        p_node = p_min;
+    }
+    return (NULL == *pp_removed) ? p_node : balance(p_tree, p_node);
+}
+
+/*
+ * @brief runs a function on the intervals of a subtree overlapping a range,
+ *  subtrees whose largest endpoint is below the range and nodes whose low
+ *  endpoint is above it are never visited
+ * @param p_tree the tree to search
+ * @param p_node the root of the subtree
+ * @param p_low the low endpoint of the range
+ * @param p_high the high endpoint of the range
+ * @param func user defined function to run with the data and context
+ * @param p_ctx the context passed to the function
+ * @return the number of intervals visited
+ */
+static int64_t overlap(interval * p_tree, inode * p_node, void * p_low, void * p_high, \
+    void (* func)(void * p_data, void * p_ctx), void * p_ctx)
+{
+    int64_t count = 0;
+    while ((NULL != p_node) && (p_tree->compare(p_low, p_node->p_max) <= 0)){
+        count += overlap(p_tree, p_node->p_left, p_low, p_high, func, p_ctx);
+        // the right subtree only starts later
+        if (p_tree->compare(p_node->p_low, p_high) > 0){
+            break;
+        }
+        if (p_tree->compare(p_node->p_high, p_low) >= 0){
+            func(p_node->p_data, p_ctx);
+            count++;
+        }
+        p_node = p_node->p_right;
+    }
+    return count;
+}
+
+/*
+ * @brief frees the nodes of a subtree and runs the destroy function on
+ *  their data
+ * @param p_tree the tree the nodes are in
+ * @param p_node the root of the subtree
+ */
+static void release_all(interval * p_tree, inode * p_node)
+{
+    while (NULL != p_node){
+        inode * p_right = p_node->p_right;
+        release_all(p_tree, p_node->p_left);
+        if (NULL != p_tree->destroy){
+            p_tree->destroy(p_node->p_data);
+        }
+        free(p_node);
+        p_node = p_right;
+    }
+}
+
+/*
+ * @brief creates an empty interval tree, an avltree of closed intervals
+ *  augmented with the largest high endpoint of each subtree
+ * @param destroy user defined destroy function for the data of the intervals
+ * @param compare user defined function to compare two endpoints
+ * @return a pointer to the newly created tree or NULL on error
+ */
+interval * interval_init(void (* destroy)(void * p_data), int8_t (* compare)(void * p_point1, void * p_point2))
+{
+    if (NULL == compare){
+        return NULL;
+    }
+    interval * p_tree = calloc(1, sizeof(*p_tree));
+    if (NULL == p_tree){
+        perror("interval_init ");
+        return NULL;
+    }
+    p_tree->destroy = destroy;
+    p_tree->compare = compare;
+    return p_tree;
+}
+
+/*
+ * @brief tears down an interval tree and runs the destroy function on the
+ *  data of every interval
+ * @param p_tree the tree to tear down
+ */
+void interval_destroy(interval * p_tree)
+{
+    if (NULL == p_tree){
+        return;
+    }
+    release_all(p_tree, p_tree->p_root);
+    free(p_tree);
+}
+
+/*
+ * @brief inserts a closed interval into an interval tree in O(log n), the
+ *  endpoints are kept by reference and must not change while in the tree
+ * @param p_tree the tree to insert into
+ * @param p_low the low endpoint of the interval
+ * @param p_high the high endpoint of the interval, not below the low one
+ * @param p_data the data of the interval
+ * @return 0 on success -1 when an interval with the same endpoints is
+ *  already in the tree or on failure
+ */
+int8_t interval_insert(interval * p_tree, void * p_low, void * p_high, void * p_data)
+{
+    int status = 0;
+    if ((NULL == p_tree) || (NULL == p_low) || (NULL == p_high) || \
+        (p_tree->compare(p_low, p_high) > 0)){
+        return -1;
+    }
+    p_tree->p_root = insert(p_tree, p_tree->p_root, p_low, p_high, p_data, &status);
+    if (0 != status){
+        return -1;
+    }
+    p_tree->size++;
+    return 0;
+}
+
+/*
+ * @brief removes the interval with the given endpoints from an interval tree
+ *  in O(log n) and runs the destroy function on its data
+ * @param p_tree the tree to remove from
+ * @param p_low the low endpoint of the interval
+ * @param p_high the high endpoint of the interval
+ * @return 0 on success -1 when the interval is not in the tree
+ */
+int8_t interval_remove(interval * p_tree, void * p_low, void * p_high)
+{
+    inode * p_removed = NULL;
+    if ((NULL == p_tree) || (NULL == p_low) || (NULL == p_high)){
+        return -1;
+    }
+    p_tree->p_root = remove_node(p_tree, p_tree->p_root, p_low, p_high, &p_removed);
+    if (NULL == p_removed){
+        return -1;
+    }
+    if (NULL != p_tree->destroy){
+        p_tree->destroy(p_removed->p_data);
+    }
+    free(p_removed);
+    p_tree->size--;
+    return 0;
+}
+
+/*
+ * @brief runs a function on every interval containing a point in order of
+ *  their low endpoints, only the search path and the ancestors of the k
+ *  intervals found are visited
+ * @param p_tree the tree to search
+ * @param p_point the point to stab the intervals with
+ * @param func user defined function to run with the data and context
+ * @param p_ctx the context passed to the function
+ * @return the number of intervals visited or -1 on error
+ */
+int64_t interval_stab(interval * p_tree, void * p_point, void (* func)(void * p_data, void * p_ctx), void * p_ctx)
+{
+    return interval_overlap(p_tree, p_point, p_point, func, p_ctx);
+}
+
+/*
+ * @brief runs a function on every interval overlapping a closed range in
+ *  order of their low endpoints, only the search paths and the ancestors of
+ *  the k intervals found are visited
+ * @param p_tree the tree to search
+ * @param p_low the low endpoint of the range
+ * @param p_high the high endpoint of the range
+ * @param func user defined function to run with the data and context
+ * @param p_ctx the context passed to the function
+ * @return the number of intervals visited or -1 on error
+ */
+int64_t interval_overlap(interval * p_tree, void * p_low, void * p_high, void (* func)(void * p_data, void * p_ctx), void * p_ctx)
+{
+    if ((NULL == p_tree) || (NULL == p_low) || (NULL == p_high) || (NULL == func)){
+        return -1;
+    }
+    return overlap(p_tree, p_tree->p_root, p_low, p_high, func, p_ctx);
+}
+
+/*
+ * @brief gets the number of intervals in an interval tree
+ * @param p_tree the tree to get the size of
+ * @return the size of the tree or -1 on error
+ */
+int64_t interval_size(interval * p_tree)
+{
+    if (NULL == p_tree){
+        return -1;
+    }
+    return p_tree->size;
+}
+// end of source
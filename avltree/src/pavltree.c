@@ -0,0 +1,471 @@
+#include <pavltree.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+/*
+ * @brief node of a persistent avltree, a node never changes once it is built
+ *  so any number of versions can share it. An insert or remove builds copies
+ *  of the nodes on its path and shares every other subtree
+ * @param p_data the data in the node
+ * @param p_left the left child of the node
+ * @param p_right the right child of the node
+ * @param p_owner the node the data was first inserted with, it counts the
+ *  copies holding the data so the data is destroyed with the last of them
+ * @param refs the number of parents and versions pointing at the node
+ * @param holders the number of nodes holding the data, only used in the owner
+ * @param height the height of the subtree, 1 for a leaf
+ */
+typedef struct pavlnode pavlnode;
+struct pavlnode {
+    void * p_data;
+    pavlnode * p_left;
+    pavlnode * p_right;
+    pavlnode * p_owner;
+    atomic_int refs;
+    atomic_int holders;
+    int height;
+};
+
+/*
+ * @brief a version of a persistent avltree, writes make a new version in
+ *  place while snapshots keep the version they were taken from
+ * @param p_root the root of the version
+ * @param size the number of data in the version
+ * @param destroy the user defined destroy function
+ * @param compare the user defined compare function
+ */
+struct pavltree {
+    pavlnode * p_root;
+    int64_t size;
+    void (* destroy)(void * p_data);
+    int8_t (* compare)(void * p_key1, void * p_key2);
+};
+
+/*
+ * @brief gets the height of a subtree
+ * @param p_node the root of the subtree
+ * @return the height of the subtree, 0 when it is empty
+ */
+static int height(pavlnode * p_node)
+{
+    return (NULL == p_node) ? 0 : p_node->height;
+}
+
+/*
+ * @brief adds a reference to a node
+ * @param p_node the node to reference or NULL
+ * @return the node
+ */
+static pavlnode * retain(pavlnode * p_node)
+{
+    if (NULL != p_node){
+        atomic_fetch_add_explicit(&p_node->refs, 1, memory_order_relaxed);
+    }
+    return p_node;
+}
+
+/*
+ * @brief drops a reference to a node, a node nothing points at anymore drops
+ *  its children and its hold on the data
+ * @param p_tree the tree providing the destroy function
+ * @param p_node the node to drop or NULL
+ */
+static void release(pavltree * p_tree, pavlnode * p_node)
+{
+    while (NULL != p_node){
+        // the last reference has to see every write made through the others
+        if (1 != atomic_fetch_sub_explicit(&p_node->refs, 1, memory_order_acq_rel)){
+            return;
+        }
+        pavlnode * p_right = p_node->p_right;
+        pavlnode * p_owner = p_node->p_owner;
+        release(p_tree, p_node->p_left);
+        if (p_owner != p_node){
+            free(p_node);
+        }
+        // the owner stays allocated while copies hold its data
+        if (1 == atomic_fetch_sub_explicit(&p_owner->holders, 1, memory_order_acq_rel)){
+            if (NULL != p_tree->destroy){
+                p_tree->destroy(p_owner->p_data);
+            }
+            free(p_owner);
+        }
+        p_node = p_right;
+    }
+}
+
+/*
+ * @brief builds a node over two subtrees, taking over their references
+ * @param p_tree the tree providing the destroy function on failure
+ * @param p_source the node whose data to copy or NULL for new data
+ * @param p_data the new data when there is no source
+ * @param p_left the left subtree
+ * @param p_right the right subtree
+ * @return the node or NULL on failure, where both subtrees are dropped
+ */
+static pavlnode * make(pavltree * p_tree, pavlnode * p_source, void * p_data, pavlnode * p_left, pavlnode * p_right)
+{
+    pavlnode * p_node = malloc(sizeof(*p_node));
+    if (NULL == p_node){
+        perror("pavltree node ");
+        release(p_tree, p_left);
+        release(p_tree, p_right);
+        return NULL;
+    }
+    p_node->p_left = p_left;
+    p_node->p_right = p_right;
+    p_node->height = ((height(p_left) > height(p_right)) ? height(p_left) : height(p_right)) + 1;
+    atomic_init(&p_node->refs, 1);
+    atomic_init(&p_node->holders, 1);
+    p_node->p_owner = p_node;
+    p_node->p_data = p_data;
+    if (NULL != p_source){
+        p_node->p_owner = p_source->p_owner;
+        p_node->p_data = p_source->p_data;
+        atomic_fetch_add_explicit(&p_node->p_owner->holders, 1, memory_order_relaxed);
+    }
+    return p_node;
+}
+
+/*
+ * @brief builds a node over two subtrees whose heights differ by at most two
+ *  and rotates it back into balance, only new nodes are rotated so the old
+ *  versions keep their shape
+ * @param p_tree the tree providing the destroy function on failure
+ * @param p_source the node whose data to copy
+ * @param p_left the left subtree, its reference is taken over
+ * @param p_right the right subtree, its reference is taken over
+ * @return the root of the balanced subtree or NULL on failure
+ */
+static pavlnode * balance(pavltree * p_tree, pavlnode * p_source, pavlnode * p_left, pavlnode * p_right)
+{
+    pavlnode * p_root = NULL;
+    if (height(p_left) > height(p_right) + 1){
+        if (height(p_left->p_left) >= height(p_left->p_right)){
+            // single right rotation
+            pavlnode * p_down = make(p_tree, p_source, NULL, retain(p_left->p_right), p_right);
+            p_root = (NULL == p_down) ? NULL : make(p_tree, p_left, NULL, retain(p_left->p_left), p_down);
+        }
+        else {
+            // left right rotation
+            pavlnode * p_mid = p_left->p_right;
+            pavlnode * p_down_left = make(p_tree, p_left, NULL, retain(p_left->p_left), retain(p_mid->p_left));
+            pavlnode * p_down_right = make(p_tree, p_source, NULL, retain(p_mid->p_right), p_right);
+            if ((NULL == p_down_left) || (NULL == p_down_right)){
+                release(p_tree, p_down_left);
+                release(p_tree, p_down_right);
+            }
+            else {
+                p_root = make(p_tree, p_mid, NULL, p_down_left, p_down_right);
+            }
+        }
+        release(p_tree, p_left);
+        return p_root;
+    }
+    if (height(p_right) > height(p_left) + 1){
+        if (height(p_right->p_right) >= height(p_right->p_left)){
+            // single left rotation
+            pavlnode * p_down = make(p_tree, p_source, NULL, p_left, retain(p_right->p_left));
+            p_root = (NULL == p_down) ? NULL : make(p_tree, p_right, NULL, p_down, retain(p_right->p_right));
+        }
+        else {
+            // right left rotation
+            pavlnode * p_mid = p_right->p_left;
+            pavlnode * p_down_left = make(p_tree, p_source, NULL, p_left, retain(p_mid->p_left));
+            pavlnode * p_down_right = make(p_tree, p_right, NULL, retain(p_mid->p_right), retain(p_right->p_right));
+            if ((NULL == p_down_left) || (NULL == p_down_right)){
+                release(p_tree, p_down_left);
+                release(p_tree, p_down_right);
+            }
+            else {
+                p_root = make(p_tree, p_mid, NULL, p_down_left, p_down_right);
+            }
+        }
+        release(p_tree, p_right);
+        return p_root;
+    }
+    return make(p_tree, p_source, NULL, p_left, p_right);
+}
+
+/*
+ * @brief inserts data into a subtree by copying the path to it
+ * @param p_tree the tree to insert into
+ * @param p_node the root of the subtree, it is left as it was
+ * @param p_data the data to insert
+ * @param p_status set to -1 when the data is already in the subtree or on
+ *  failure
+ * @return the root of the new subtree or NULL on failure
+ */
+static pavlnode * insert(pavltree * p_tree, pavlnode * p_node, void * p_data, int * p_status)
+{
+    pavlnode * p_root = NULL;
+    int cmpval = 0;
+    if (NULL == p_node){
+        p_root = make(p_tree, NULL, p_data, NULL, NULL);
+    }
+    else if (0 == (cmpval = p_tree->compare(p_data, p_node->p_data))){
+        *p_status = -1;
+        return NULL;
+    }
+    else if (cmpval < 0){
+        pavlnode * p_left = insert(p_tree, p_node->p_left, p_data, p_status);
+        if (0 != *p_status){
+            return NULL;
+        }
+        p_root = balance(p_tree, p_node, p_left, retain(p_node->p_right));
+    }
+    else {
+        pavlnode * p_right = insert(p_tree, p_node->p_right, p_data, p_status);
+        if (0 != *p_status){
+            return NULL;
+        }
+        p_root = balance(p_tree, p_node, retain(p_node->p_left), p_right);
+    }
+    *p_status = (NULL == p_root) ? -1 : 0;
+    return p_root;
+}
+
+/*
+ * @brief removes the smallest node of a subtree by copying the path to it
+ * @param p_tree the tree to remove from
+ * @param p_node the root of the subtree, it is left as it was
+ * @param pp_min set to the smallest node, which stays in the old subtree
+ * @param p_status set to -1 on failure
+ * @return the root of the new subtree
+ */
+static pavlnode * remove_min(pavltree * p_tree, pavlnode * p_node, pavlnode ** pp_min, int * p_status)
+{
+    if (NULL == p_node->p_left){
+        *pp_min = p_node;
+        return retain(p_node->p_right);
+    }
+    pavlnode * p_left = remove_min(p_tree, p_node->p_left, pp_min, p_status);
+    if (0 != *p_status){
+        return NULL;
+    }
+    pavlnode * p_root = balance(p_tree, p_node, p_left, retain(p_node->p_right));
+    *p_status = (NULL == p_root) ? -1 : 0;
+    return p_root;
+}
+
+/*
+ * @brief removes the data equal to a key from a subtree by copying the path
+ *  to it
+ * @param p_tree the tree to remove from
+ * @param p_node the root of the subtree, it is left as it was
+ * @param p_key the key of the data to remove
+ * @param p_status set to -1 when the data is not in the subtree or on failure
+ * @return the root of the new subtree
+ */
+static pavlnode * remove_key(pavltree * p_tree, pavlnode * p_node, void * p_key, int * p_status)
+{
+    pavlnode * p_root = NULL;
+    int cmpval = 0;
+    if (NULL == p_node){
+        *p_status = -1;
+        return NULL;
+    }
+    cmpval = p_tree->compare(p_key, p_node->p_data);
+    if (0 == cmpval){
+        if ((NULL == p_node->p_left) || (NULL == p_node->p_right)){
+            return retain((NULL == p_node->p_left) ? p_node->p_right : p_node->p_left);
+        }
+        // the smallest data of the right subtree takes the place of the node
+        pavlnode * p_min = NULL;
+        pavlnode * p_right = remove_min(p_tree, p_node->p_right, &p_min, p_status);
+        if (0 != *p_status){
+            return NULL;
+        }
+        p_root = balance(p_tree, p_min, retain(p_node->p_left), p_right);
+    }
+    else if (cmpval < 0){
+        pavlnode * p_left = remove_key(p_tree, p_node->p_left, p_key, p_status);
+        if (0 != *p_status){
+            return NULL;
+        }
+        p_root = balance(p_tree, p_node, p_left, retain(p_node->p_right));
+    }
+    else {
+        pavlnode * p_right = remove_key(p_tree, p_node->p_right, p_key, p_status);
+        if (0 != *p_status){
+            return NULL;
+        }
+        p_root = balance(p_tree, p_node, retain(p_node->p_left), p_right);
+    }
+    *p_status = (NULL == p_root) ? -1 : 0;
+    return p_root;
+}
+
+/*
+ * @brief runs a function on the data of a subtree in order
+ * @param p_node the root of the subtree
+ * @param func user defined function to run with the data
+ */
+static void inorder(pavlnode * p_node, void (* func)(void * p_data))
+{
+    while (NULL != p_node){
+        inorder(p_node->p_left, func);
+        func(p_node->p_data);
+        p_node = p_node->p_right;
+    }
+}
+
+/*
+ * @brief creates an empty persistent avltree
+ * @param destroy user defined destroy function for the tree, it runs once no
+ *  version holds the data anymore
+ * @param compare user defined function to compare the data in the tree
+ * @return a pointer to the newly created tree or NULL on error
+ */
+pavltree * pavltree_init(void (* destroy)(void * p_data), int8_t (* compare)(void * p_key1, void * p_key2))
+{
+    if (NULL == compare){
+        return NULL;
+    }
+    pavltree * p_tree = calloc(1, sizeof(*p_tree));
+    if (NULL == p_tree){
+        perror("pavltree_init ");
+        return NULL;
+    }
+    p_tree->destroy = destroy;
+    p_tree->compare = compare;
+    return p_tree;
+}
+
+/*
+ * @brief takes a snapshot of a persistent avltree in O(1), the snapshot keeps
+ *  the current version while the tree moves on. A snapshot is a tree of its
+ *  own and can be read, written or snapshot again, from another thread too
+ *  since versions share no state but the node references
+ * @param p_tree the tree to take a snapshot of
+ * @return the snapshot or NULL on error
+ */
+pavltree * pavltree_snapshot(pavltree * p_tree)
+{
+    if (NULL == p_tree){
+        return NULL;
+    }
+    pavltree * p_snapshot = malloc(sizeof(*p_snapshot));
+    if (NULL == p_snapshot){
+        perror("pavltree_snapshot ");
+        return NULL;
+    }
+    *p_snapshot = *p_tree;
+    retain(p_snapshot->p_root);
+    return p_snapshot;
+}
+
+/*
+ * @brief tears down a version of a persistent avltree, the nodes and data
+ *  only it holds are freed
+ * @param p_tree the tree to tear down
+ */
+void pavltree_destroy(pavltree * p_tree)
+{
+    if (NULL == p_tree){
+        return;
+    }
+    release(p_tree, p_tree->p_root);
+    free(p_tree);
+}
+
+/*
+ * @brief inserts data into a persistent avltree, copying the O(log n) nodes
+ *  on its path. Snapshots taken before are left as they were
+ * @param p_tree the tree to insert into
+ * @param p_data the data to insert
+ * @return 0 on success -1 when the data is already in the tree or on failure
+ */
+int8_t pavltree_insert(pavltree * p_tree, void * p_data)
+{
+    int status = 0;
+    if ((NULL == p_tree) || (NULL == p_data)){
+        return -1;
+    }
+    pavlnode * p_root = insert(p_tree, p_tree->p_root, p_data, &status);
+    if (0 != status){
+        return -1;
+    }
+    release(p_tree, p_tree->p_root);
+    p_tree->p_root = p_root;
+    p_tree->size++;
+    return 0;
+}
+
+/*
+ * @brief removes the data equal to a key from a persistent avltree, copying
+ *  the O(log n) nodes on its path. The destroy function runs on the data once
+ *  no snapshot holds it either
+ * @param p_tree the tree to remove from
+ * @param p_key the key of the data to remove
+ * @return 0 on success -1 when the data is not in the tree or on failure
+ */
+int8_t pavltree_remove(pavltree * p_tree, void * p_key)
+{
+    int status = 0;
+    if ((NULL == p_tree) || (NULL == p_key)){
+        return -1;
+    }
+    pavlnode * p_root = remove_key(p_tree, p_tree->p_root, p_key, &status);
+    if (0 != status){
+        return -1;
+    }
+    release(p_tree, p_tree->p_root);
+    p_tree->p_root = p_root;
+    p_tree->size--;
+    return 0;
+}
+
+/*
+ * @brief looks up the data equal to a key in a version of a persistent
+ *  avltree
+ * @param p_tree the tree to search
+ * @param p_key the key to search for
+ * @return the data in the tree or NULL when it is not in the tree
+ */
+void * pavltree_lookup(pavltree * p_tree, void * p_key)
+{
+    if ((NULL == p_tree) || (NULL == p_key)){
+        return NULL;
+    }
+    pavlnode * p_node = p_tree->p_root;
+    while (NULL != p_node){
+        int8_t cmpval = p_tree->compare(p_key, p_node->p_data);
+        if (0 == cmpval){
+            return p_node->p_data;
+        }
+        p_node = (cmpval < 0) ? p_node->p_left : p_node->p_right;
+    }
+    return NULL;
+}
+
+/*
+ * @brief gets the number of data in a version of a persistent avltree
+ * @param p_tree the tree to get the size of
+ * @return the size of the tree or -1 on error
+ */
+int64_t pavltree_size(pavltree * p_tree)
+{
+    if (NULL == p_tree){
+        return -1;
+    }
+    return p_tree->size;
+}
+
+/*
+ * @brief runs a function on the data of a version of a persistent avltree in
+ *  order
+ * @param p_tree the tree to traverse
+ * @param func user defined function to run with the data
+ */
+void pavltree_inorder(pavltree * p_tree, void (* func)(void * p_data))
+{
+    if ((NULL == p_tree) || (NULL == func)){
+        return;
+    }
+    inorder(p_tree->p_root, func);
+}
+// end of source
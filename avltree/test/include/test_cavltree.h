@@ -0,0 +1,5 @@
+#ifndef _TEST_CAVLTREE_H
+#define _TEST_CAVLTREE_H
+#include <check.h>
+Suite * suite_cavltree(void);
+#endif
@@ -0,0 +1,5 @@
+#ifndef _TEST_INTERVAL_H
+#define _TEST_INTERVAL_H
+#include <check.h>
+Suite * suite_interval(void);
+#endif
@@ -0,0 +1,5 @@
+#ifndef _TEST_PAVLTREE_H
+#define _TEST_PAVLTREE_H
+#include <check.h>
+Suite * suite_pavltree(void);
+#endif
@@ -0,0 +1,296 @@
+#include <avltree.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+static int8_t bench_compare(void * p_key1, void * p_key2)
+{
+    uint64_t key1 = *(uint64_t *)p_key1;
+    uint64_t key2 = *(uint64_t *)p_key2;
+    return (key1 < key2) ? -1 : ((key1 == key2) ? 0 : 1);
+}
+
+/*
+ * @brief gets a monotonic time stamp
+ * @return the time in seconds
+ */
+static double bench_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+/*
+ * @brief inserts keys in order then looks them up in clustered runs
+ * @param p_keys storage for the keys
+ * @param count the number of keys
+ * @param b_finger true to keep the path of the last search
+ * @param p_lookup set to the nanoseconds per lookup
+ * @return the nanoseconds per insert
+ */
+static double bench_finger(uint64_t * p_keys, int64_t count, bool b_finger, double * p_lookup)
+{
+    avltree * p_tree = avltree_init(NULL, NULL, bench_compare);
+    avltree_set_finger(p_tree, b_finger);
+    for (int64_t index = 0; index < count; index++){
+        p_keys[index] = index * 2;
+    }
+    double start = bench_now();
+    for (int64_t index = 0; index < count; index++){
+        avltree_insert(p_tree, &p_keys[index]);
+    }
+    double inserted = bench_now();
+    // runs of 64 neighbouring keys starting at random places
+    srand(1);
+    for (int64_t index = 0; index < count; index += 64){
+        uint64_t key = ((uint64_t)rand() * RAND_MAX + rand()) % (2 * count);
+        for (int64_t step = 0; step < 64; step++){
+            key += 1;
+            avltree_lookup(p_tree, &key);
+        }
+    }
+    *p_lookup = ((bench_now() - inserted) * 1e9) / count;
+    avltree_destroy(p_tree);
+    return ((inserted - start) * 1e9) / count;
+}
+
+/*
+ * @brief loads sorted keys into a tree one insert at a time and in bulk
+ * @param p_keys storage for the keys
+ * @param pp_items storage for pointers to the keys
+ * @param count the number of keys
+ * @param p_build set to the nanoseconds per key of the bulk load
+ * @return the nanoseconds per key of the inserts
+ */
+static double bench_build(uint64_t * p_keys, void ** pp_items, int64_t count, double * p_build)
+{
+    for (int64_t index = 0; index < count; index++){
+        p_keys[index] = index * 2;
+        pp_items[index] = &p_keys[index];
+    }
+    double start = bench_now();
+    avltree * p_tree = avltree_init(NULL, NULL, bench_compare);
+    for (int64_t index = 0; index < count; index++){
+        avltree_insert(p_tree, pp_items[index]);
+    }
+    avltree_destroy(p_tree);
+    double inserted = bench_now();
+    p_tree = avltree_build_sorted(pp_items, count, NULL, bench_compare);
+    avltree_destroy(p_tree);
+    *p_build = ((bench_now() - inserted) * 1e9) / count;
+    return ((inserted - start) * 1e9) / count;
+}
+
+/*
+ * @brief merges a tree of odd keys into a tree of even keys one insert at a
+ *  time and with a union on one and four threads
+ * @param p_keys storage for the keys
+ * @param pp_items storage for pointers to the keys
+ * @param count the number of keys in the larger tree
+ * @param stride the step between the odd keys, 1 for trees of equal size
+ * @param p_times set to the nanoseconds per merged key of the inserts and of
+ *  the unions on one and four threads
+ */
+static void bench_union(uint64_t * p_keys, void ** pp_items, int64_t count, int64_t stride, double * p_times)
+{
+    int64_t merged = count / stride;
+    for (int64_t index = 0; index < count; index++){
+        p_keys[index] = index * 2;
+        pp_items[index] = &p_keys[index];
+    }
+    for (int64_t index = 0; index < merged; index++){
+        p_keys[count + index] = (index * stride * 2) + 1;
+        pp_items[count + index] = &p_keys[count + index];
+    }
+    for (int run = 0; run < 3; run++){
+        avltree * p_dest = avltree_build_sorted(pp_items, count, NULL, bench_compare);
+        avltree * p_source = avltree_build_sorted(pp_items + count, merged, NULL, bench_compare);
+        double start = bench_now();
+        if (0 == run){
+            for (int64_t index = 0; index < merged; index++){
+                avltree_insert(p_dest, pp_items[count + index]);
+            }
+        }
+        else {
+            avltree_union(p_dest, p_source, (1 == run) ? 1 : 4);
+        }
+        p_times[run] = ((bench_now() - start) * 1e9) / merged;
+        avltree_destroy(p_source);
+        avltree_destroy(p_dest);
+    }
+}
+
+static int8_t bench_string_compare(void * p_key1, void * p_key2)
+{
+    int cmpval = strcmp(p_key1, p_key2);
+    return (cmpval < 0) ? -1 : ((cmpval > 0) ? 1 : 0);
+}
+
+static uint64_t bench_string_prefix(void * p_data)
+{
+    // the first 8 bytes big endian, shorter strings are padded with zeros
+    const unsigned char * p_string = p_data;
+    uint64_t prefix = 0;
+    for (int index = 0; index < 8; index++){
+        prefix = (prefix << 8) | *p_string;
+        p_string += (0 != *p_string);
+    }
+    return prefix;
+}
+
+static uint64_t bench_int_prefix(void * p_data)
+{
+    return *(uint64_t *)p_data;
+}
+
+/*
+ * @brief looks up random keys with the compare function alone and with the
+ *  key prefixes inlined in the nodes
+ * @param p_keys storage for the integer keys
+ * @param count the number of keys
+ * @param kind 0 for integer keys, 1 for random strings, 2 for strings that
+ *  all start with the same 5 bytes
+ * @param p_times set to the nanoseconds per lookup without and with prefixes
+ */
+static void bench_prefix(uint64_t * p_keys, int64_t count, int kind, double * p_times)
+{
+    char * p_strings = calloc(count, 24);
+    uint64_t seed = 1;
+    if (NULL == p_strings){
+        return;
+    }
+    for (int64_t index = 0; index < count; index++){
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        p_keys[index] = seed >> 1;
+        snprintf(p_strings + (index * 24), 24, (2 == kind) ? "user:%016llx" : "%016llx", (unsigned long long)p_keys[index]);
+    }
+    for (int run = 0; run < 2; run++){
+        avltree * p_tree = avltree_init(NULL, NULL, (0 == kind) ? bench_compare : bench_string_compare);
+        if (1 == run){
+            avltree_set_prefix(p_tree, (0 == kind) ? bench_int_prefix : bench_string_prefix, (0 == kind));
+        }
+        for (int64_t index = 0; index < count; index++){
+            avltree_insert(p_tree, (0 == kind) ? (void *)&p_keys[index] : (void *)(p_strings + (index * 24)));
+        }
+        srand(49);
+        double start = bench_now();
+        for (int64_t index = 0; index < count; index++){
+            int64_t key = ((int64_t)rand() * RAND_MAX + rand()) % count;
+            avltree_lookup(p_tree, (0 == kind) ? (void *)&p_keys[key] : (void *)(p_strings + (key * 24)));
+        }
+        p_times[run] = ((bench_now() - start) * 1e9) / count;
+        avltree_destroy(p_tree);
+    }
+    free(p_strings);
+}
+
+/*
+ * @brief looks up random keys of a large tree one at a time and in batches
+ * @param count the number of keys in the tree
+ * @param b_prefix true to inline the keys in the nodes as prefixes
+ * @param p_times set to the nanoseconds per lookup of single lookups and of
+ *  batches of 256
+ */
+static void bench_batch(int64_t count, bool b_prefix, double * p_times)
+{
+    int64_t lookups = 1000000;
+    uint64_t * p_keys = calloc(count + lookups, sizeof(*p_keys));
+    void ** pp_items = calloc(count + lookups, sizeof(*pp_items));
+    void ** pp_found = calloc(lookups, sizeof(*pp_found));
+    if ((NULL == p_keys) || (NULL == pp_items) || (NULL == pp_found)){
+        free(p_keys);
+        free(pp_items);
+        free(pp_found);
+        return;
+    }
+    for (int64_t index = 0; index < count; index++){
+        p_keys[index] = index * 2;
+        pp_items[index] = &p_keys[index];
+    }
+    avltree * p_tree = avltree_build_sorted(pp_items, count, NULL, bench_compare);
+    if (b_prefix){
+        avltree_set_prefix(p_tree, bench_int_prefix, true);
+    }
+    // the probes are copies so their data is not next to the nodes
+    srand(50);
+    void ** pp_probes = pp_items + count;
+    for (int64_t index = 0; index < lookups; index++){
+        p_keys[count + index] = (((int64_t)rand() * RAND_MAX + rand()) % count) * 2;
+        pp_probes[index] = &p_keys[count + index];
+    }
+    double start = bench_now();
+    for (int64_t index = 0; index < lookups; index++){
+        pp_found[index] = avltree_lookup(p_tree, pp_probes[index]);
+    }
+    double single = bench_now();
+    for (int64_t index = 0; index < lookups; index += 256){
+        avltree_lookup_batch(p_tree, pp_probes + index, (lookups - index < 256) ? lookups - index : 256, pp_found + index);
+    }
+    p_times[1] = ((bench_now() - single) * 1e9) / lookups;
+    p_times[0] = ((single - start) * 1e9) / lookups;
+    avltree_destroy(p_tree);
+    free(p_keys);
+    free(pp_items);
+    free(pp_found);
+}
+
+int main(int argc, char ** argv)
+{
+    // the most keys to insert can be passed as the first argument
+    int64_t max_count = (argc > 1) ? strtoll(argv[1], NULL, 10) : 1000000;
+    uint64_t * p_keys = calloc(2 * max_count, sizeof(*p_keys));
+    void ** pp_items = calloc(2 * max_count, sizeof(*pp_items));
+    if ((NULL == p_keys) || (NULL == pp_items)){
+        free(p_keys);
+        free(pp_items);
+        return EXIT_FAILURE;
+    }
+    printf("%12s %14s %14s %14s %14s\n", "keys", "insert ns", "finger ins ns", "lookup ns", "finger look ns");
+    for (int64_t count = 1000; count <= max_count; count *= 10){
+        double lookup = 0;
+        double finger_lookup = 0;
+        double insert = bench_finger(p_keys, count, false, &lookup);
+        double finger_insert = bench_finger(p_keys, count, true, &finger_lookup);
+        printf("%12ld %14.1f %14.1f %14.1f %14.1f\n", (long)count, insert, finger_insert, lookup, finger_lookup);
+    }
+    printf("\n%12s %14s %14s\n", "sorted keys", "insert ns", "build ns");
+    for (int64_t count = 1000; count <= max_count; count *= 10){
+        double build = 0;
+        double insert = bench_build(p_keys, pp_items, count, &build);
+        printf("%12ld %14.1f %14.1f\n", (long)count, insert, build);
+    }
+    printf("\n%12s %14s %14s %14s %14s\n", "keys", "merged keys", "insert ns", "union ns", "union x4 ns");
+    for (int64_t count = 1000; count <= max_count; count *= 10){
+        // equal trees then a thousandth of the keys into a large tree
+        for (int64_t stride = 1; stride <= 1000; stride *= 1000){
+            double times[3] = {0};
+            bench_union(p_keys, pp_items, count, stride, times);
+            printf("%12ld %14ld %14.1f %14.1f %14.1f\n", (long)count, (long)(count / stride), times[0], times[1], times[2]);
+        }
+    }
+    printf("\n%12s %14s %14s %14s\n", "keys", "key kind", "lookup ns", "prefix look ns");
+    for (int64_t count = 1000; count <= max_count; count *= 10){
+        for (int kind = 0; kind < 3; kind++){
+            double times[2] = {0};
+            bench_prefix(p_keys, count, kind, times);
+            printf("%12ld %14s %14.1f %14.1f\n", (long)count, (0 == kind) ? "integer" : ((1 == kind) ? "string" : "shared string"), times[0], times[1]);
+        }
+    }
+    // trees of 40 byte nodes well past the size of a last level cache
+    printf("\n%12s %14s %14s %14s\n", "keys", "prefix", "lookup ns", "batch ns");
+    for (int64_t count = 1000000; count <= 16 * max_count; count *= 4){
+        for (int prefix = 0; prefix < 2; prefix++){
+            double times[2] = {0};
+            bench_batch(count, prefix, times);
+            printf("%12ld %14s %14.1f %14.1f\n", (long)count, prefix ? "yes" : "no", times[0], times[1]);
+        }
+    }
+    free(p_keys);
+    free(pp_items);
+    return EXIT_SUCCESS;
+}
+// end of source
@@ -0,0 +1,154 @@
+#include <avltree.h>
+#include <cavltree.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+
+static int8_t bench_compare(void * p_key1, void * p_key2)
+{
+    uint64_t key1 = *(uint64_t *)p_key1;
+    uint64_t key2 = *(uint64_t *)p_key2;
+    return (key1 < key2) ? -1 : ((key1 == key2) ? 0 : 1);
+}
+
+/*
+ * @brief gets a monotonic time stamp
+ * @return the time in seconds
+ */
+static double bench_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+/*
+ * @brief the work handed to each benchmark thread
+ * @param p_ctree the concurrent tree to use or NULL to use the locked tree
+ * @param p_tree the avltree shared behind p_lock
+ * @param p_lock the lock serializing every avltree operation
+ * @param p_keys the keys, each thread only inserts and removes its own
+ * @param count the number of keys of the thread
+ * @param reads the percentage of operations that are lookups
+ * @param steps the number of operations to run
+ * @param seed the seed of the thread's key generator
+ */
+typedef struct bench_arg {
+    cavltree * p_ctree;
+    avltree * p_tree;
+    pthread_mutex_t * p_lock;
+    uint64_t * p_keys;
+    int64_t count;
+    int reads;
+    int64_t steps;
+    uint64_t seed;
+} bench_arg;
+
+/*
+ * @brief looks up random keys and inserts or removes the keys of the thread
+ * @param p_arg the bench_arg of the thread
+ * @return NULL
+ */
+static void * bench_worker(void * p_arg)
+{
+    bench_arg * p_bench = p_arg;
+    uint64_t seed = p_bench->seed;
+    for (int64_t step = 0; step < p_bench->steps; step++){
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t * p_key = &p_bench->p_keys[(seed >> 33) % p_bench->count];
+        int op = (int)((seed >> 20) % 100);
+        if (NULL != p_bench->p_ctree){
+            if (op < p_bench->reads){
+                cavltree_lookup(p_bench->p_ctree, p_key);
+            }
+            else if (0 != cavltree_insert(p_bench->p_ctree, p_key)){
+                cavltree_remove(p_bench->p_ctree, p_key);
+            }
+            continue;
+        }
+        pthread_mutex_lock(p_bench->p_lock);
+        if (op < p_bench->reads){
+            avltree_lookup(p_bench->p_tree, p_key);
+        }
+        else if (0 != avltree_insert(p_bench->p_tree, p_key)){
+            avltree_remove(p_bench->p_tree, p_key);
+        }
+        pthread_mutex_unlock(p_bench->p_lock);
+    }
+    return NULL;
+}
+
+/*
+ * @brief runs threads over a tree holding half of the keys and times them
+ * @param p_keys storage for the keys
+ * @param count the number of keys
+ * @param threads the number of threads to run
+ * @param b_concurrent true for the concurrent tree, false for the avltree
+ *  behind a mutex
+ * @param reads the percentage of operations that are lookups
+ * @param steps the operations per thread
+ * @return the million operations per second across all threads
+ */
+static double bench_run(uint64_t * p_keys, int64_t count, int threads, bool b_concurrent, int reads, int64_t steps)
+{
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    cavltree * p_ctree = NULL;
+    avltree * p_tree = NULL;
+    if (b_concurrent){
+        p_ctree = cavltree_init(threads, NULL, bench_compare);
+    }
+    else {
+        p_tree = avltree_init(NULL, NULL, bench_compare);
+    }
+    for (int64_t index = 0; index < count; index++){
+        p_keys[index] = index;
+        if (0 == index % 2){
+            b_concurrent ? cavltree_insert(p_ctree, &p_keys[index]) : avltree_insert(p_tree, &p_keys[index]);
+        }
+    }
+    pthread_t * p_threads = calloc(threads, sizeof(*p_threads));
+    bench_arg * p_args = calloc(threads, sizeof(*p_args));
+    double start = bench_now();
+    for (int index = 0; index < threads; index++){
+        // each thread writes its own slice of the keys
+        int64_t slice = count / threads;
+        p_args[index] = (bench_arg){p_ctree, p_tree, &lock, &p_keys[index * slice], slice, reads, steps, (uint64_t)index + 1};
+        pthread_create(&p_threads[index], NULL, bench_worker, &p_args[index]);
+    }
+    for (int index = 0; index < threads; index++){
+        pthread_join(p_threads[index], NULL);
+    }
+    double elapsed = bench_now() - start;
+    free(p_threads);
+    free(p_args);
+    cavltree_destroy(p_ctree);
+    avltree_destroy(p_tree);
+    return (threads * steps) / elapsed / 1e6;
+}
+
+int main(int argc, char ** argv)
+{
+    // the most threads to run can be passed as the first argument
+    int max_threads = (argc > 1) ? atoi(argv[1]) : 8;
+    int64_t count = 1000000;
+    int64_t steps = 1000000;
+    uint64_t * p_keys = calloc(count, sizeof(*p_keys));
+    if (NULL == p_keys){
+        return EXIT_FAILURE;
+    }
+    printf("%8s %14s %14s %14s %14s\n", "threads", "mutex 90% Mops", "cavl 90% Mops", "mutex 50% Mops", "cavl 50% Mops");
+    for (int threads = 1; threads <= max_threads; threads *= 2){
+        printf("%8d", threads);
+        for (int reads = 90; reads >= 50; reads -= 40){
+            printf(" %14.2f", bench_run(p_keys, count, threads, false, reads, steps));
+            printf(" %14.2f", bench_run(p_keys, count, threads, true, reads, steps));
+        }
+        printf("\n");
+    }
+    free(p_keys);
+    return EXIT_SUCCESS;
+}
+// end of source
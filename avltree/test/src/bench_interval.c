@@ -0,0 +1,116 @@
+#include <avltree.h>
+#include <interval.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+/*
+ * @brief a time range
+ * @param start the first second of the range
+ * @param end the last second of the range
+ */
+typedef struct bench_range {
+    uint64_t start;
+    uint64_t end;
+} bench_range;
+
+static int8_t bench_compare(void * p_point1, void * p_point2)
+{
+    uint64_t point1 = *(uint64_t *)p_point1;
+    uint64_t point2 = *(uint64_t *)p_point2;
+    return (point1 < point2) ? -1 : ((point1 == point2) ? 0 : 1);
+}
+
+static int8_t bench_range_compare(void * p_key1, void * p_key2)
+{
+    bench_range * p_range1 = p_key1;
+    bench_range * p_range2 = p_key2;
+    int8_t cmpval = bench_compare(&p_range1->start, &p_range2->start);
+    return (0 != cmpval) ? cmpval : bench_compare(&p_range1->end, &p_range2->end);
+}
+
+/*
+ * @brief gets a monotonic time stamp
+ * @return the time in seconds
+ */
+static double bench_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+static int64_t found = 0;
+static void bench_found(void * p_data, void * p_ctx)
+{
+    (void)p_data;
+    (void)p_ctx;
+    found++;
+}
+
+// the scan has no context so the point is kept here
+static uint64_t scan_point = 0;
+static void bench_scan(void * p_data)
+{
+    bench_range * p_range = p_data;
+    found += (p_range->start <= scan_point) && (p_range->end >= scan_point);
+}
+
+/*
+ * @brief stabs random points of an interval tree and of an avltree scanned in
+ *  order
+ * @param p_ranges storage for the ranges
+ * @param count the number of ranges
+ * @param length the longest range
+ * @param p_scan set to the microseconds per scanned stab
+ * @return the microseconds per interval_stab
+ */
+static double bench_stab(bench_range * p_ranges, int64_t count, uint64_t length, double * p_scan)
+{
+    interval * p_tree = interval_init(NULL, bench_compare);
+    avltree * p_scanned = avltree_init(NULL, NULL, bench_range_compare);
+    uint64_t span = count * 10;
+    int64_t stabs = 100000;
+    int64_t scans = 20;
+    srand(48);
+    for (int64_t index = 0; index < count; index++){
+        p_ranges[index].start = ((uint64_t)rand() * RAND_MAX + rand()) % span;
+        p_ranges[index].end = p_ranges[index].start + (rand() % length);
+        interval_insert(p_tree, &p_ranges[index].start, &p_ranges[index].end, &p_ranges[index]);
+        avltree_insert(p_scanned, &p_ranges[index]);
+    }
+    double start = bench_now();
+    for (int64_t stab = 0; stab < stabs; stab++){
+        uint64_t point = ((uint64_t)rand() * RAND_MAX + rand()) % span;
+        interval_stab(p_tree, &point, bench_found, NULL);
+    }
+    double stabbed = bench_now();
+    for (int64_t scan = 0; scan < scans; scan++){
+        scan_point = ((uint64_t)rand() * RAND_MAX + rand()) % span;
+        avltree_inorder(p_scanned, bench_scan);
+    }
+    *p_scan = ((bench_now() - stabbed) * 1e6) / scans;
+    interval_destroy(p_tree);
+    avltree_destroy(p_scanned);
+    return ((stabbed - start) * 1e6) / stabs;
+}
+
+int main(void)
+{
+    int64_t count = 1000000;
+    bench_range * p_ranges = calloc(count, sizeof(*p_ranges));
+    if (NULL == p_ranges){
+        return EXIT_FAILURE;
+    }
+    printf("%10s %10s %16s %16s\n", "ranges", "longest", "stab us", "scan us");
+    for (uint64_t length = 10; length <= 10000; length *= 10){
+        double scan = 0;
+        double stab = bench_stab(p_ranges, count, length, &scan);
+        printf("%10ld %10lu %16.2f %16.2f\n", (long)count, (unsigned long)length, stab, scan);
+    }
+    free(p_ranges);
+    return EXIT_SUCCESS;
+}
+// end of source
@@ -1,14 +1,23 @@
 #include <check.h>
 #include <stdlib.h>
 #include <test_avltree.h>
+#include <test_cavltree.h>
+#include <test_pavltree.h>
+#include <test_interval.h>
 
 int main(void)
 {
     int num_failed = 0;
     // create the test suites
     Suite * p_avltree = suite_avltree();
+    Suite * p_cavltree = suite_cavltree();
+    Suite * p_pavltree = suite_pavltree();
+    Suite * p_interval = suite_interval();
     // create and add to suite runner
     SRunner * p_srunner = srunner_create(p_avltree);
+    srunner_add_suite(p_srunner, p_cavltree);
+    srunner_add_suite(p_srunner, p_pavltree);
+    srunner_add_suite(p_srunner, p_interval);
     srunner_set_fork_status(p_srunner, CK_NOFORK);
     // run all test
     srunner_run_all(p_srunner, CK_NORMAL);
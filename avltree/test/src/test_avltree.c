@@ -4,9 +4,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
+#include <pthread.h>
 
 static avltree * p_tree = NULL;
 static int num = 5;
+static int destroyed = 0;
+static int visited[2048];
+static int visits = 0;
+static avltree * halves[2];
+static int halved[2000];
+static int fresh[2][1000];
 
 int8_t test_compare(void * key1, void * key2)
 {
@@ -18,9 +26,28 @@ int8_t test_compare(void * key1, void * key2)
     return (num1 == num2) ? 0 : ((num1 < num2) ? -1 : 1);
 }
 
+static void test_destroy(void * p_data)
+{
+    (void)p_data;
+    destroyed++;
+}
+
+static void test_visit(void * p_data)
+{
+    visited[visits++] = *(int *)p_data;
+}
+
+static void test_range_visit(void * p_data, void * p_ctx)
+{
+    *(int *)p_ctx += *(int *)p_data;
+    visited[visits++] = *(int *)p_data;
+}
+
 static void setup_test_avltree(void)
 {
-    p_tree = avltree_init(&num, free, test_compare); 
+    destroyed = 0;
+    visits = 0;
+    p_tree = avltree_init(&num, test_destroy, test_compare); 
 }
 
 static void teardown_test_avltree()
@@ -31,6 +58,15 @@ static void teardown_test_avltree()
 START_TEST(test_avltree_init)
 {
     ck_assert(NULL != p_tree);
+    ck_assert(NULL == avltree_init(&num, NULL, NULL));
+    // a tree can start without data
+    avltree * p_empty = avltree_init(NULL, NULL, test_compare);
+    ck_assert_int_eq(0, avltree_size(p_empty));
+    ck_assert(NULL == avltree_root(p_empty));
+    ck_assert_int_eq(-1, avltree_remove(p_empty, &num));
+    ck_assert_int_eq(0, avltree_insert(p_empty, &num));
+    ck_assert(&num == avltree_data(avltree_root(p_empty)));
+    avltree_destroy(p_empty);
 } END_TEST
 
 START_TEST(test_avltree_size)
@@ -54,8 +90,485 @@ START_TEST(test_avltree_remove)
     avltree_insert(p_tree, &num3);
     avltree_insert(p_tree, &num4);
     ck_assert_int_eq(4, avltree_size(p_tree));
-    avltree_remove(p_tree, &num2);
-    ck_assert_int_eq(4, avltree_size(p_tree));
+    ck_assert_int_eq(0, avltree_remove(p_tree, &num2));
+    ck_assert_int_eq(3, avltree_size(p_tree));
+    ck_assert_int_eq(1, destroyed);
+    ck_assert_int_eq(-1, avltree_remove(p_tree, &num2));
+    // the root holds two children so its successor takes its place
+    ck_assert_int_eq(0, avltree_remove(p_tree, &num));
+    ck_assert(&num4 == avltree_data(avltree_root(p_tree)));
+    ck_assert_int_eq(0, avltree_remove(p_tree, &num3));
+    ck_assert_int_eq(0, avltree_remove(p_tree, &num4));
+    ck_assert_int_eq(0, avltree_size(p_tree));
+    ck_assert_int_eq(0, avltree_insert(p_tree, &num2));
+    ck_assert_int_eq(1, avltree_size(p_tree));
+} END_TEST
+
+START_TEST(test_avltree_churn)
+{
+    // removing every other key keeps the rest in order
+    static int keys[1024];
+    for (int index = 0; index < 1024; index++){
+        keys[index] = (index * 7919) % 1024 + 10;
+        ck_assert_int_eq(0, avltree_insert(p_tree, &keys[index]));
+    }
+    for (int index = 0; index < 1024; index += 2){
+        ck_assert_int_eq(0, avltree_remove(p_tree, &keys[index]));
+    }
+    ck_assert_int_eq(513, avltree_size(p_tree));
+    ck_assert_int_eq(512, destroyed);
+    avltree_inorder(p_tree, test_visit);
+    ck_assert_int_eq(513, visits);
+    for (int index = 1; index < visits; index++){
+        ck_assert_int_lt(visited[index - 1], visited[index]);
+    }
+} END_TEST
+
+START_TEST(test_avltree_lookup)
+{
+    static int keys[500];
+    int key = 0;
+    for (int finger = 0; finger < 2; finger++){
+        ck_assert_int_eq(0, avltree_set_finger(p_tree, finger));
+        for (int index = 0; index < 500; index++){
+            keys[index] = index + 100;
+            // sequential keys land next to the last insert
+            avltree_insert(p_tree, &keys[index]);
+        }
+        ck_assert_int_eq(501, avltree_size(p_tree));
+        for (int index = 0; index < 600; index++){
+            key = (index * 37) % 600 + 50;
+            if ((key >= 100) && (key < 600)){
+                ck_assert(&keys[key - 100] == avltree_lookup(p_tree, &key));
+            }
+            else {
+                ck_assert(NULL == avltree_lookup(p_tree, &key));
+            }
+        }
+        ck_assert(&num == avltree_lookup(p_tree, &num));
+        for (int index = 0; index < 500; index += 2){
+            avltree_remove(p_tree, &keys[index]);
+            key = index + 101;
+            ck_assert(&keys[index + 1] == avltree_lookup(p_tree, &key));
+        }
+        key = 100;
+        ck_assert(NULL == avltree_lookup(p_tree, &key));
+        for (int index = 1; index < 500; index += 2){
+            avltree_remove(p_tree, &keys[index]);
+        }
+    }
+    ck_assert(NULL == avltree_lookup(NULL, &num));
+} END_TEST
+
+/*
+ * @brief looks up every data of the shared tree, which has a finger set
+ * @param p_arg the number of data found
+ */
+static void * test_lookup_reader(void * p_arg)
+{
+    for (int index = 0; index < 1000; index++){
+        if (&halved[index] == avltree_lookup(p_tree, &halved[index])){
+            (*(int *)p_arg)++;
+        }
+    }
+    return NULL;
+}
+
+START_TEST(test_avltree_lookup_readers)
+{
+    pthread_t threads[2];
+    int found[2] = {0, 0};
+    ck_assert_int_eq(0, avltree_set_finger(p_tree, true));
+    for (int index = 0; index < 1000; index++){
+        halved[index] = index + 10;
+        avltree_insert(p_tree, &halved[index]);
+    }
+    // lookups leave the finger alone so readers can share the tree
+    for (int index = 0; index < 2; index++){
+        ck_assert_int_eq(0, pthread_create(&threads[index], NULL, test_lookup_reader, &found[index]));
+    }
+    for (int index = 0; index < 2; index++){
+        pthread_join(threads[index], NULL);
+        ck_assert_int_eq(1000, found[index]);
+    }
+} END_TEST
+
+START_TEST(test_avltree_rank)
+{
+    static int keys[200];
+    int low = 0;
+    int high = 0;
+    for (int index = 0; index < 200; index++){
+        keys[index] = (index * 13) % 200 + 10;
+        avltree_insert(p_tree, &keys[index]);
+    }
+    // the fixture key 5 is the smallest
+    ck_assert(&num == avltree_select(p_tree, 0));
+    for (int index = 1; index <= 200; index++){
+        ck_assert_int_eq(index + 9, *(int *)avltree_select(p_tree, index));
+        ck_assert_int_eq(index, avltree_rank(p_tree, avltree_select(p_tree, index)));
+    }
+    ck_assert(NULL == avltree_select(p_tree, 201));
+    ck_assert(NULL == avltree_select(p_tree, -1));
+    low = 50;
+    high = 59;
+    ck_assert_int_eq(10, avltree_count_range(p_tree, &low, &high));
+    ck_assert_int_eq(0, avltree_count_range(p_tree, &high, &low));
+    // hidden data leave the counts in lazy mode as well
+    avltree_set_lazy(p_tree, 0.5);
+    for (int index = 0; index < 200; index += 2){
+        avltree_remove(p_tree, &keys[index]);
+    }
+    ck_assert_int_eq(5, avltree_count_range(p_tree, &low, &high));
+    high = 1000;
+    ck_assert_int_eq(101, avltree_rank(p_tree, &high));
+    ck_assert_int_eq(0, avltree_rank(p_tree, &num));
+    ck_assert(NULL == avltree_select(p_tree, 101));
+    ck_assert(NULL != avltree_select(p_tree, 100));
+} END_TEST
+
+START_TEST(test_avltree_iter)
+{
+    static int keys[100];
+    int key = 0;
+    int sum = 0;
+    avliter * p_iter = avltree_iter_init(p_tree);
+    for (int index = 0; index < 100; index++){
+        keys[index] = index * 2 + 10;
+        avltree_insert(p_tree, &keys[index]);
+    }
+    // seeking lands on the next key when the key is not in the tree
+    key = 51;
+    ck_assert(&keys[21] == avltree_iter_seek(p_iter, &key));
+    ck_assert(&keys[22] == avltree_iter_next(p_iter));
+    ck_assert(&keys[21] == avltree_iter_prev(p_iter));
+    ck_assert(&keys[20] == avltree_iter_prev(p_iter));
+    ck_assert(&keys[20] == avltree_iter_data(p_iter));
+    key = 1000;
+    ck_assert(NULL == avltree_iter_seek(p_iter, &key));
+    ck_assert(NULL == avltree_iter_data(p_iter));
+    ck_assert(&num == avltree_iter_first(p_iter));
+    ck_assert(NULL == avltree_iter_prev(p_iter));
+    ck_assert(&keys[99] == avltree_iter_last(p_iter));
+    ck_assert(NULL == avltree_iter_next(p_iter));
+    // a range visits only the data between its keys in order
+    key = 61;
+    ck_assert_int_eq(6, avltree_range(p_tree, &keys[20], &key, test_range_visit, &sum));
+    ck_assert_int_eq(50 + 52 + 54 + 56 + 58 + 60, sum);
+    for (int index = 1; index < visits; index++){
+        ck_assert_int_lt(visited[index - 1], visited[index]);
+    }
+    ck_assert_int_eq(0, avltree_range(p_tree, &key, &keys[20], test_range_visit, &sum));
+    // hidden data are skipped
+    avltree_set_lazy(p_tree, 0.9);
+    avltree_remove(p_tree, &keys[21]);
+    ck_assert(&keys[22] == avltree_iter_seek(p_iter, &keys[21]));
+    ck_assert(&keys[20] == avltree_iter_prev(p_iter));
+    avltree_iter_destroy(p_iter);
+} END_TEST
+
+START_TEST(test_avltree_build)
+{
+    static int keys[1000];
+    static void * items[1000];
+    for (int index = 0; index < 1000; index++){
+        keys[index] = index * 3;
+        items[index] = &keys[index];
+    }
+    avltree * p_built = avltree_build_sorted(items, 1000, test_destroy, test_compare);
+    ck_assert(NULL != p_built);
+    ck_assert_int_eq(1000, avltree_size(p_built));
+    ck_assert(&keys[500] == avltree_data(avltree_root(p_built)));
+    for (int index = 0; index < 1000; index++){
+        ck_assert(&keys[index] == avltree_lookup(p_built, &keys[index]));
+        ck_assert(&keys[index] == avltree_select(p_built, index));
+    }
+    // the built tree takes inserts and removes like any other
+    ck_assert_int_eq(0, avltree_insert(p_built, &num));
+    ck_assert_int_eq(0, avltree_remove(p_built, &keys[0]));
+    ck_assert_int_eq(2, avltree_rank(p_built, &keys[2]));
+    avltree_destroy(p_built);
+    ck_assert_int_eq(1001, destroyed);
+    // unsorted or repeated items are refused
+    items[10] = &keys[9];
+    ck_assert(NULL == avltree_build_sorted(items, 1000, NULL, test_compare));
+    items[10] = &keys[11];
+    ck_assert(NULL == avltree_build_sorted(items, 1000, NULL, test_compare));
+    p_built = avltree_build_sorted(items, 0, NULL, test_compare);
+    ck_assert_int_eq(0, avltree_size(p_built));
+    avltree_destroy(p_built);
+} END_TEST
+
+START_TEST(test_avltree_lazy)
+{
+    static int keys[100];
+    ck_assert_int_eq(-1, avltree_set_lazy(p_tree, 1));
+    ck_assert_int_eq(0, avltree_set_lazy(p_tree, 0.25));
+    for (int index = 0; index < 100; index++){
+        keys[index] = index + 10;
+        avltree_insert(p_tree, &keys[index]);
+    }
+    // removed data stays in the tree until a quarter of it is hidden
+    for (int index = 0; index < 25; index++){
+        ck_assert_int_eq(0, avltree_remove(p_tree, &keys[index]));
+    }
+    ck_assert_int_eq(-1, avltree_remove(p_tree, &keys[0]));
+    ck_assert_int_eq(25, avltree_hidden(p_tree));
+    ck_assert_int_eq(0, destroyed);
+    // a hidden node takes new equal data
+    ck_assert_int_eq(0, avltree_insert(p_tree, &keys[0]));
+    ck_assert_int_eq(1, destroyed);
+    ck_assert_int_eq(77, avltree_size(p_tree));
+    ck_assert_int_eq(0, avltree_remove(p_tree, &keys[25]));
+    ck_assert_int_eq(25, avltree_hidden(p_tree));
+    ck_assert_int_eq(0, avltree_remove(p_tree, &keys[26]));
+    ck_assert_int_eq(0, avltree_hidden(p_tree));
+    ck_assert_int_eq(27, destroyed);
+    ck_assert_int_eq(75, avltree_size(p_tree));
+    avltree_inorder(p_tree, test_visit);
+    ck_assert_int_eq(75, visits);
+    // turning lazy mode off frees the hidden nodes
+    ck_assert_int_eq(0, avltree_remove(p_tree, &keys[99]));
+    ck_assert_int_eq(0, avltree_set_lazy(p_tree, 0));
+    ck_assert_int_eq(0, avltree_hidden(p_tree));
+    ck_assert_int_eq(28, destroyed);
+} END_TEST
+
+START_TEST(test_avltree_split)
+{
+    static int keys[1000];
+    for (int index = 0; index < 1000; index++){
+        keys[index] = index + 10;
+        avltree_insert(p_tree, &keys[index]);
+    }
+    avltree * p_upper = avltree_split(p_tree, &keys[400]);
+    ck_assert(NULL != p_upper);
+    ck_assert_int_eq(401, avltree_size(p_tree));
+    ck_assert_int_eq(600, avltree_size(p_upper));
+    ck_assert(NULL == avltree_lookup(p_tree, &keys[400]));
+    ck_assert(&keys[400] == avltree_select(p_upper, 0));
+    ck_assert(&keys[399] == avltree_select(p_tree, 400));
+    // overlapping trees are not joined
+    ck_assert_int_eq(-1, avltree_join(p_upper, p_tree));
+    ck_assert_int_eq(0, avltree_join(p_tree, p_upper));
+    ck_assert_int_eq(1001, avltree_size(p_tree));
+    ck_assert_int_eq(0, avltree_size(p_upper));
+    for (int index = 0; index < 1000; index++){
+        ck_assert(&keys[index] == avltree_select(p_tree, index + 1));
+    }
+    // the emptied tree still takes data
+    ck_assert_int_eq(0, avltree_insert(p_upper, &num));
+    avltree_destroy(p_upper);
+    ck_assert_int_eq(1, destroyed);
+} END_TEST
+
+/*
+ * @brief swaps the data of one half of a split tree for new data and back,
+ *  the half adds blocks of its own while the other half does too
+ * @param p_arg the index of the half
+ */
+static void * test_split_worker(void * p_arg)
+{
+    int half = *(int *)p_arg;
+    for (int round = 0; round < 4; round++){
+        for (int index = 0; index < 1000; index++){
+            avltree_insert(halves[half], &fresh[half][index]);
+        }
+        for (int index = 0; index < 1000; index++){
+            avltree_remove(halves[half], &halved[(half * 1000) + index]);
+        }
+        for (int index = 0; index < 1000; index++){
+            avltree_insert(halves[half], &halved[(half * 1000) + index]);
+            avltree_remove(halves[half], &fresh[half][index]);
+        }
+    }
+    return NULL;
+}
+
+START_TEST(test_avltree_split_threads)
+{
+    static int indexes[2] = {0, 1};
+    pthread_t threads[2];
+    halves[0] = avltree_init(NULL, NULL, test_compare);
+    for (int index = 0; index < 2000; index++){
+        halved[index] = index;
+        fresh[index / 1000][index % 1000] = 2000 + index;
+        avltree_insert(halves[0], &halved[index]);
+    }
+    halves[1] = avltree_split(halves[0], &halved[1000]);
+    ck_assert(NULL != halves[1]);
+    // the halves share the blocks of the pool but not their free nodes
+    for (int index = 0; index < 2; index++){
+        ck_assert_int_eq(0, pthread_create(&threads[index], NULL, test_split_worker, &indexes[index]));
+    }
+    for (int index = 0; index < 2; index++){
+        pthread_join(threads[index], NULL);
+        ck_assert_int_eq(1000, avltree_size(halves[index]));
+        ck_assert(&halved[index * 1000] == avltree_select(halves[index], 0));
+    }
+    ck_assert_int_eq(0, avltree_join(halves[0], halves[1]));
+    ck_assert_int_eq(2000, avltree_size(halves[0]));
+    avltree_destroy(halves[1]);
+    avltree_destroy(halves[0]);
+} END_TEST
+
+START_TEST(test_avltree_algebra)
+{
+    static int evens[10000];
+    static int threes[10000];
+    avltree * p_evens = avltree_init(NULL, test_destroy, test_compare);
+    avltree * p_threes = avltree_init(NULL, test_destroy, test_compare);
+    for (int index = 0; index < 10000; index++){
+        evens[index] = index * 2;
+        threes[index] = index * 3;
+        avltree_insert(p_evens, &evens[index]);
+        avltree_insert(p_threes, &threes[index]);
+    }
+    // multiples of six are in both trees
+    ck_assert_int_eq(0, avltree_intersection(p_evens, p_threes, 4));
+    ck_assert_int_eq(3334, avltree_size(p_evens));
+    ck_assert_int_eq(0, avltree_size(p_threes));
+    ck_assert_int_eq(16666, destroyed);
+    for (int index = 0; index < 3334; index++){
+        ck_assert(&evens[index * 3] == avltree_select(p_evens, index));
+    }
+    // the destination keeps its data when both trees hold equal data
+    for (int index = 0; index < 10000; index++){
+        avltree_insert(p_threes, &threes[index]);
+    }
+    ck_assert_int_eq(0, avltree_union(p_evens, p_threes, 4));
+    ck_assert_int_eq(10000, avltree_size(p_evens));
+    ck_assert_int_eq(20000, destroyed);
+    ck_assert(&evens[3] == avltree_lookup(p_evens, &threes[2]));
+    ck_assert(&threes[9999] == avltree_select(p_evens, 9999));
+    ck_assert_int_eq(0, avltree_insert(p_threes, &threes[1]));
+    ck_assert_int_eq(0, avltree_difference(p_evens, p_threes, 1));
+    ck_assert_int_eq(9999, avltree_size(p_evens));
+    ck_assert(NULL == avltree_lookup(p_evens, &threes[1]));
+    ck_assert_int_eq(20002, destroyed);
+    // trees that do not destroy data the same way are refused
+    avltree * p_other = avltree_init(NULL, NULL, test_compare);
+    ck_assert_int_eq(-1, avltree_union(p_evens, p_other, 1));
+    ck_assert_int_eq(-1, avltree_union(p_evens, p_evens, 1));
+    avltree_destroy(p_other);
+    avltree_destroy(p_evens);
+    avltree_destroy(p_threes);
+    ck_assert_int_eq(30001, destroyed);
+} END_TEST
+
+static int8_t test_string_compare(void * key1, void * key2)
+{
+    int cmpval = strcmp(key1, key2);
+    return (cmpval < 0) ? -1 : ((cmpval > 0) ? 1 : 0);
+}
+
+static uint64_t test_string_prefix(void * p_data)
+{
+    // the first 8 bytes big endian, shorter strings are padded with zeros
+    const unsigned char * p_string = p_data;
+    uint64_t prefix = 0;
+    for (int index = 0; index < 8; index++){
+        prefix = (prefix << 8) | *p_string;
+        p_string += (0 != *p_string);
+    }
+    return prefix;
+}
+
+static uint64_t test_int_prefix(void * p_data)
+{
+    // flip the sign bit so negative keys order first
+    return (uint64_t)(int64_t)*(int *)p_data ^ (UINT64_C(1) << 63);
+}
+
+START_TEST(test_avltree_prefix)
+{
+    static char strings[2000][16];
+    static int keys[2000];
+    avltree * p_strings = avltree_init(NULL, NULL, test_string_compare);
+    ck_assert_int_eq(-1, avltree_set_prefix(NULL, test_string_prefix, false));
+    // most strings share their first 8 bytes so the compare function breaks ties
+    for (int index = 0; index < 2000; index++){
+        snprintf(strings[(index * 7) % 2000], 16, "%s%04d", (0 == index % 3) ? "k" : "key-", index);
+        if (1000 == index){
+            ck_assert_int_eq(0, avltree_set_prefix(p_strings, test_string_prefix, false));
+        }
+        ck_assert_int_eq(0, avltree_insert(p_strings, strings[(index * 7) % 2000]));
+    }
+    for (int index = 0; index < 2000; index += 2){
+        ck_assert_int_eq(0, avltree_remove(p_strings, strings[index]));
+    }
+    ck_assert_int_eq(1000, avltree_size(p_strings));
+    for (int index = 0; index < 2000; index++){
+        ck_assert(((1 == index % 2) ? strings[index] : NULL) == avltree_lookup(p_strings, strings[index]));
+    }
+    for (int index = 1; index < 1000; index++){
+        ck_assert_int_lt(strcmp(avltree_select(p_strings, index - 1), avltree_select(p_strings, index)), 0);
+        ck_assert_int_eq(index, avltree_rank(p_strings, avltree_select(p_strings, index)));
+    }
+    avltree_destroy(p_strings);
+    // an integer key fits the prefix so the compare function is never needed
+    avltree * p_ints = avltree_init(NULL, NULL, test_compare);
+    ck_assert_int_eq(0, avltree_set_prefix(p_ints, test_int_prefix, true));
+    for (int index = 0; index < 2000; index++){
+        keys[index] = ((index * 7) % 2000) - 1000;
+        ck_assert_int_eq(0, avltree_insert(p_ints, &keys[index]));
+    }
+    ck_assert_int_eq(-1, avltree_insert(p_ints, &keys[0]));
+    avltree * p_upper = avltree_split(p_ints, &num);
+    ck_assert_int_eq(1005, avltree_size(p_ints));
+    ck_assert_int_eq(995, avltree_size(p_upper));
+    ck_assert_int_eq(-1000, *(int *)avltree_select(p_ints, 0));
+    ck_assert_int_eq(5, *(int *)avltree_select(p_upper, 0));
+    ck_assert_int_eq(0, avltree_join(p_ints, p_upper));
+    for (int index = 0; index < 2000; index++){
+        ck_assert_int_eq(index - 1000, *(int *)avltree_select(p_ints, index));
+        ck_assert(&keys[index] == avltree_lookup(p_ints, &keys[index]));
+    }
+    // trees ordering their prefixes differently are not merged
+    avltree * p_other = avltree_init(NULL, NULL, test_compare);
+    ck_assert_int_eq(-1, avltree_union(p_ints, p_other, 1));
+    avltree_destroy(p_other);
+    avltree_destroy(p_upper);
+    avltree_destroy(p_ints);
+} END_TEST
+
+START_TEST(test_avltree_lookup_batch)
+{
+    static int keys[1000];
+    static int probes[1100];
+    static void * pp_probes[1101];
+    static void * pp_found[1101];
+    for (int index = 0; index < 1000; index++){
+        keys[index] = (index * 2) + 10;
+        avltree_insert(p_tree, &keys[index]);
+    }
+    // hidden data is not found either
+    avltree_set_lazy(p_tree, 0.5);
+    avltree_remove(p_tree, &keys[0]);
+    for (int pass = 0; pass < 2; pass++){
+        for (int index = 0; index < 1100; index++){
+            probes[index] = ((index * 7) % 1100) * 2 + 10 + (index % 2);
+            pp_probes[index] = &probes[index];
+        }
+        pp_probes[1100] = NULL;
+        ck_assert_int_eq(0, avltree_lookup_batch(p_tree, pp_probes, 0, NULL));
+        ck_assert_int_eq(-1, avltree_lookup_batch(p_tree, pp_probes, 1101, NULL));
+        int64_t found = avltree_lookup_batch(p_tree, pp_probes, 1101, pp_found);
+        int64_t expected = 0;
+        for (int index = 0; index < 1101; index++){
+            void * p_data = (1100 == index) ? NULL : avltree_lookup(p_tree, pp_probes[index]);
+            expected += (NULL != p_data);
+            ck_assert(p_data == pp_found[index]);
+        }
+        ck_assert_int_eq(expected, found);
+        // the results can overwrite the keys
+        ck_assert_int_eq(expected, avltree_lookup_batch(p_tree, pp_probes, 1101, pp_probes));
+        for (int index = 0; index < 1101; index++){
+            ck_assert(pp_found[index] == pp_probes[index]);
+        }
+        avltree_set_prefix(p_tree, test_int_prefix, true);
+    }
+    ck_assert_int_eq(-1, avltree_lookup_batch(NULL, pp_probes, 1, pp_found));
 } END_TEST
 
 Suite * suite_avltree(void)
@@ -70,6 +583,18 @@ Suite * suite_avltree(void)
     tcase_add_test(p_case, test_avltree_size);
     tcase_add_test(p_case, test_avltree_insert);
     tcase_add_test(p_case, test_avltree_remove);
+    tcase_add_test(p_case, test_avltree_churn);
+    tcase_add_test(p_case, test_avltree_lookup);
+    tcase_add_test(p_case, test_avltree_lookup_readers);
+    tcase_add_test(p_case, test_avltree_rank);
+    tcase_add_test(p_case, test_avltree_iter);
+    tcase_add_test(p_case, test_avltree_build);
+    tcase_add_test(p_case, test_avltree_lazy);
+    tcase_add_test(p_case, test_avltree_split);
+    tcase_add_test(p_case, test_avltree_split_threads);
+    tcase_add_test(p_case, test_avltree_algebra);
+    tcase_add_test(p_case, test_avltree_prefix);
+    tcase_add_test(p_case, test_avltree_lookup_batch);
     // add the case to the suite
     suite_add_tcase(p_suite, p_case);
     // return the suite
@@ -0,0 +1,171 @@
+#include <check.h>
+#include <test_cavltree.h>
+#include <cavltree.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+static int8_t test_compare(void * p_key1, void * p_key2)
+{
+    int key1 = *(int *)p_key1;
+    int key2 = *(int *)p_key2;
+    return (key1 < key2) ? -1 : ((key1 == key2) ? 0 : 1);
+}
+
+static atomic_int destroyed = 0;
+static void test_destroy(void * p_data)
+{
+    (void)p_data;
+    destroyed++;
+}
+
+static int visited[16384];
+static int visits = 0;
+static void test_visit(void * p_data)
+{
+    visited[visits++] = *(int *)p_data;
+}
+
+static cavltree * p_cavltree = NULL;
+static int num = 5;
+static void start_cavltree(void)
+{
+    destroyed = 0;
+    visits = 0;
+    p_cavltree = cavltree_init(4, test_destroy, test_compare);
+    cavltree_insert(p_cavltree, &num);
+}
+
+static void teardown_cavltree(void)
+{
+    cavltree_destroy(p_cavltree);
+}
+
+START_TEST(test_cavltree_init)
+{
+    ck_assert(NULL != p_cavltree);
+    ck_assert_int_eq(1, cavltree_size(p_cavltree));
+    ck_assert_int_eq(-1, cavltree_size(NULL));
+    ck_assert(NULL == cavltree_init(0, NULL, test_compare));
+    ck_assert(NULL == cavltree_init(4, NULL, NULL));
+    ck_assert_int_eq(-1, cavltree_insert(p_cavltree, NULL));
+    ck_assert_int_eq(-1, cavltree_insert(p_cavltree, &num));
+    ck_assert(&num == cavltree_lookup(p_cavltree, &num));
+    ck_assert(NULL == cavltree_lookup(NULL, &num));
+} END_TEST
+
+START_TEST(test_cavltree_remove)
+{
+    static int keys[2000];
+    srand(46);
+    for (int index = 0; index < 2000; index++){
+        keys[index] = index + 10;
+    }
+    // shuffle so the tree has to rotate in both directions
+    for (int index = 1999; index > 0; index--){
+        int other = rand() % (index + 1);
+        int swap = keys[index];
+        keys[index] = keys[other];
+        keys[other] = swap;
+    }
+    for (int index = 0; index < 2000; index++){
+        ck_assert_int_eq(0, cavltree_insert(p_cavltree, &keys[index]));
+    }
+    ck_assert_int_eq(2001, cavltree_size(p_cavltree));
+    for (int index = 0; index < 2000; index += 2){
+        ck_assert_int_eq(0, cavltree_remove(p_cavltree, &keys[index]));
+        ck_assert(NULL == cavltree_lookup(p_cavltree, &keys[index]));
+    }
+    ck_assert_int_eq(-1, cavltree_remove(p_cavltree, &keys[0]));
+    ck_assert_int_eq(1001, cavltree_size(p_cavltree));
+    for (int index = 1; index < 2000; index += 2){
+        ck_assert(&keys[index] == cavltree_lookup(p_cavltree, &keys[index]));
+    }
+    // the data is in order and removed data is not visited
+    cavltree_inorder(p_cavltree, test_visit);
+    ck_assert_int_eq(1001, visits);
+    for (int index = 1; index < visits; index++){
+        ck_assert_int_lt(visited[index - 1], visited[index]);
+    }
+    // a removed key can be inserted again with new data
+    static int again = 0;
+    again = keys[0];
+    ck_assert_int_eq(0, cavltree_insert(p_cavltree, &again));
+    ck_assert(&again == cavltree_lookup(p_cavltree, &keys[0]));
+    cavltree_destroy(p_cavltree);
+    p_cavltree = NULL;
+    ck_assert_int_eq(2002, destroyed);
+} END_TEST
+
+#define THREADS 4
+#define PER_THREAD 4000
+static int shared[THREADS * PER_THREAD];
+static atomic_int missing = 0;
+static void * test_worker(void * p_arg)
+{
+    int first = *(int *)p_arg;
+    for (int round = 0; round < 3; round++){
+        for (int index = first; index < first + PER_THREAD; index++){
+            cavltree_insert(p_cavltree, &shared[index]);
+            // data of other threads can come and go but the fixture stays
+            if (&num != cavltree_lookup(p_cavltree, &num)){
+                missing++;
+            }
+            cavltree_lookup(p_cavltree, &shared[(index * 7) % (THREADS * PER_THREAD)]);
+        }
+        for (int index = first; index < first + PER_THREAD; index += (round + 2)){
+            if (0 != cavltree_remove(p_cavltree, &shared[index])){
+                missing++;
+            }
+        }
+    }
+    return NULL;
+}
+
+START_TEST(test_cavltree_threads)
+{
+    pthread_t threads[THREADS];
+    int firsts[THREADS];
+    for (int index = 0; index < THREADS * PER_THREAD; index++){
+        shared[index] = index + 10;
+    }
+    missing = 0;
+    for (int index = 0; index < THREADS; index++){
+        firsts[index] = index * PER_THREAD;
+        ck_assert_int_eq(0, pthread_create(&threads[index], NULL, test_worker, &firsts[index]));
+    }
+    for (int index = 0; index < THREADS; index++){
+        pthread_join(threads[index], NULL);
+    }
+    ck_assert_int_eq(0, missing);
+    // the last round of each thread removed every fourth key
+    int expected = 1;
+    for (int index = 0; index < THREADS * PER_THREAD; index++){
+        bool b_kept = (0 != (index % PER_THREAD) % 4);
+        expected += b_kept;
+        ck_assert((b_kept ? &shared[index] : NULL) == cavltree_lookup(p_cavltree, &shared[index]));
+    }
+    ck_assert_int_eq(expected, cavltree_size(p_cavltree));
+    cavltree_inorder(p_cavltree, test_visit);
+    ck_assert_int_eq(expected, visits);
+    for (int index = 1; index < visits; index++){
+        ck_assert_int_lt(visited[index - 1], visited[index]);
+    }
+} END_TEST
+
+// create suite
+Suite * suite_cavltree(void)
+{
+    Suite * p_suite = suite_create("CAVLTREE");
+    TCase * p_core = tcase_create("Core");
+    // add test cases
+    tcase_add_checked_fixture(p_core, start_cavltree, teardown_cavltree);
+    tcase_add_test(p_core, test_cavltree_init);
+    tcase_add_test(p_core, test_cavltree_remove);
+    tcase_add_test(p_core, test_cavltree_threads);
+    // add core to suite
+    suite_add_tcase(p_suite, p_core);
+    return p_suite;
+}
@@ -0,0 +1,164 @@
+#include <check.h>
+#include <test_interval.h>
+#include <interval.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+static int8_t test_compare(void * p_point1, void * p_point2)
+{
+    int point1 = *(int *)p_point1;
+    int point2 = *(int *)p_point2;
+    return (point1 < point2) ? -1 : ((point1 == point2) ? 0 : 1);
+}
+
+static int destroyed = 0;
+static void test_destroy(void * p_data)
+{
+    (void)p_data;
+    destroyed++;
+}
+
+/*
+ * @brief a closed interval used as the data of the tree
+ * @param low the low endpoint
+ * @param high the high endpoint
+ * @param b_found set when a query visits the interval
+ */
+typedef struct span {
+    int low;
+    int high;
+    bool b_found;
+} span;
+
+static int last_low = 0;
+static void test_visit(void * p_data, void * p_ctx)
+{
+    span * p_span = p_data;
+    // intervals are visited in order of their low endpoints
+    *(bool *)p_ctx &= (p_span->low >= last_low) && !p_span->b_found;
+    last_low = p_span->low;
+    p_span->b_found = true;
+}
+
+static interval * p_interval = NULL;
+static span first = {5, 10, false};
+static void start_interval(void)
+{
+    destroyed = 0;
+    last_low = 0;
+    p_interval = interval_init(test_destroy, test_compare);
+    interval_insert(p_interval, &first.low, &first.high, &first);
+}
+
+static void teardown_interval(void)
+{
+    interval_destroy(p_interval);
+}
+
+START_TEST(test_interval_init)
+{
+    static span backwards = {10, 5, false};
+    static span same = {5, 10, false};
+    bool b_ordered = true;
+    int point = 7;
+    ck_assert(NULL != p_interval);
+    ck_assert(NULL == interval_init(NULL, NULL));
+    ck_assert_int_eq(1, interval_size(p_interval));
+    ck_assert_int_eq(-1, interval_size(NULL));
+    ck_assert_int_eq(-1, interval_insert(p_interval, &backwards.low, &backwards.high, &backwards));
+    ck_assert_int_eq(-1, interval_insert(p_interval, &same.low, &same.high, &same));
+    ck_assert_int_eq(-1, interval_insert(NULL, &same.low, &same.high, &same));
+    ck_assert_int_eq(1, interval_stab(p_interval, &point, test_visit, &b_ordered));
+    ck_assert(first.b_found);
+    ck_assert_int_eq(-1, interval_stab(p_interval, &point, NULL, NULL));
+    ck_assert_int_eq(-1, interval_remove(p_interval, &backwards.low, &backwards.high));
+    ck_assert_int_eq(0, interval_remove(p_interval, &first.low, &first.high));
+    ck_assert_int_eq(1, destroyed);
+    ck_assert_int_eq(0, interval_size(p_interval));
+    ck_assert_int_eq(0, interval_stab(p_interval, &point, test_visit, &b_ordered));
+} END_TEST
+
+/*
+ * @brief checks a query finds exactly the spans overlapping a range
+ * @param p_spans the spans to check
+ * @param count the number of spans
+ * @param low the low endpoint of the range
+ * @param high the high endpoint of the range
+ * @param b_stab true to query with interval_stab, where low is the point
+ */
+static void check_query(span * p_spans, int count, int low, int high, bool b_stab)
+{
+    bool b_ordered = true;
+    int64_t expected = 0;
+    int64_t visited = 0;
+    for (int index = 0; index < count; index++){
+        p_spans[index].b_found = false;
+    }
+    last_low = 0;
+    if (b_stab){
+        visited = interval_stab(p_interval, &low, test_visit, &b_ordered);
+    }
+    else {
+        visited = interval_overlap(p_interval, &low, &high, test_visit, &b_ordered);
+    }
+    for (int index = 0; index < count; index++){
+        bool b_overlaps = (p_spans[index].low <= high) && (p_spans[index].high >= low);
+        ck_assert(b_overlaps == p_spans[index].b_found);
+        expected += b_overlaps;
+    }
+    ck_assert(b_ordered);
+    ck_assert_int_eq(expected, visited);
+}
+
+START_TEST(test_interval_query)
+{
+    static span spans[3000];
+    srand(48);
+    interval_remove(p_interval, &first.low, &first.high);
+    for (int index = 0; index < 3000; index++){
+        spans[index].low = rand() % 10000;
+        spans[index].high = spans[index].low + (rand() % 200);
+        // a few long intervals cover most of the others
+        if (0 == index % 500){
+            spans[index].high += 5000;
+        }
+        if (0 != interval_insert(p_interval, &spans[index].low, &spans[index].high, &spans[index])){
+            // drop a repeated interval from the expected results
+            spans[index].low = -1000;
+            spans[index].high = -1000;
+        }
+    }
+    for (int query = 0; query < 200; query++){
+        int low = rand() % 10400 - 200;
+        check_query(spans, 3000, low, low, true);
+        check_query(spans, 3000, low, low + (rand() % 300), false);
+    }
+    // the largest endpoints stay right once the tree rotates on removal
+    for (int index = 0; index < 3000; index += 2){
+        if (-1000 != spans[index].low){
+            ck_assert_int_eq(0, interval_remove(p_interval, &spans[index].low, &spans[index].high));
+        }
+        spans[index].low = -1000;
+        spans[index].high = -1000;
+    }
+    for (int query = 0; query < 200; query++){
+        int low = rand() % 10400 - 200;
+        check_query(spans, 3000, low, low, true);
+        check_query(spans, 3000, low, low + (rand() % 300), false);
+    }
+} END_TEST
+
+// create suite
+Suite * suite_interval(void)
+{
+    Suite * p_suite = suite_create("INTERVAL");
+    TCase * p_core = tcase_create("Core");
+    // add test cases
+    tcase_add_checked_fixture(p_core, start_interval, teardown_interval);
+    tcase_add_test(p_core, test_interval_init);
+    tcase_add_test(p_core, test_interval_query);
+    // add core to suite
+    suite_add_tcase(p_suite, p_core);
+    return p_suite;
+}
@@ -0,0 +1,180 @@
+#include <check.h>
+#include <test_pavltree.h>
+#include <pavltree.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+static int8_t test_compare(void * p_key1, void * p_key2)
+{
+    int key1 = *(int *)p_key1;
+    int key2 = *(int *)p_key2;
+    return (key1 < key2) ? -1 : ((key1 == key2) ? 0 : 1);
+}
+
+static atomic_int destroyed = 0;
+static void test_destroy(void * p_data)
+{
+    (void)p_data;
+    destroyed++;
+}
+
+static int visited[4096];
+static int visits = 0;
+static void test_visit(void * p_data)
+{
+    visited[visits++] = *(int *)p_data;
+}
+
+static pavltree * p_pavltree = NULL;
+static int num = 5;
+static void start_pavltree(void)
+{
+    destroyed = 0;
+    visits = 0;
+    p_pavltree = pavltree_init(test_destroy, test_compare);
+    pavltree_insert(p_pavltree, &num);
+}
+
+static void teardown_pavltree(void)
+{
+    pavltree_destroy(p_pavltree);
+}
+
+START_TEST(test_pavltree_init)
+{
+    ck_assert(NULL != p_pavltree);
+    ck_assert_int_eq(1, pavltree_size(p_pavltree));
+    ck_assert_int_eq(-1, pavltree_size(NULL));
+    ck_assert(NULL == pavltree_init(NULL, NULL));
+    ck_assert(NULL == pavltree_snapshot(NULL));
+    ck_assert_int_eq(-1, pavltree_insert(p_pavltree, NULL));
+    ck_assert_int_eq(-1, pavltree_insert(p_pavltree, &num));
+    ck_assert_int_eq(-1, pavltree_remove(NULL, &num));
+    ck_assert(&num == pavltree_lookup(p_pavltree, &num));
+    ck_assert(NULL == pavltree_lookup(NULL, &num));
+} END_TEST
+
+START_TEST(test_pavltree_snapshot)
+{
+    static int keys[2000];
+    srand(47);
+    for (int index = 0; index < 2000; index++){
+        keys[index] = index + 10;
+    }
+    // shuffle so the copied paths have to rotate in both directions
+    for (int index = 999; index > 0; index--){
+        int other = rand() % (index + 1);
+        int swap = keys[index];
+        keys[index] = keys[other];
+        keys[other] = swap;
+    }
+    for (int index = 0; index < 1000; index++){
+        ck_assert_int_eq(0, pavltree_insert(p_pavltree, &keys[index]));
+    }
+    pavltree * p_snapshot = pavltree_snapshot(p_pavltree);
+    ck_assert(NULL != p_snapshot);
+    for (int index = 0; index < 1000; index += 2){
+        ck_assert_int_eq(0, pavltree_remove(p_pavltree, &keys[index]));
+    }
+    for (int index = 1000; index < 2000; index++){
+        ck_assert_int_eq(0, pavltree_insert(p_pavltree, &keys[index]));
+    }
+    ck_assert_int_eq(-1, pavltree_remove(p_pavltree, &keys[0]));
+    ck_assert_int_eq(1501, pavltree_size(p_pavltree));
+    // the snapshot still holds the removed data
+    ck_assert_int_eq(0, destroyed);
+    ck_assert_int_eq(1001, pavltree_size(p_snapshot));
+    for (int index = 0; index < 2000; index++){
+        bool b_kept = (index < 1000) && (1 == index % 2);
+        ck_assert((index < 1000 ? &keys[index] : NULL) == pavltree_lookup(p_snapshot, &keys[index]));
+        ck_assert((b_kept || index >= 1000 ? &keys[index] : NULL) == pavltree_lookup(p_pavltree, &keys[index]));
+    }
+    pavltree_inorder(p_snapshot, test_visit);
+    ck_assert_int_eq(1001, visits);
+    for (int index = 1; index < visits; index++){
+        ck_assert_int_lt(visited[index - 1], visited[index]);
+    }
+    visits = 0;
+    pavltree_inorder(p_pavltree, test_visit);
+    ck_assert_int_eq(1501, visits);
+    for (int index = 1; index < visits; index++){
+        ck_assert_int_lt(visited[index - 1], visited[index]);
+    }
+    // the data only the snapshot held goes with it
+    pavltree_destroy(p_snapshot);
+    ck_assert_int_eq(500, destroyed);
+    pavltree_destroy(p_pavltree);
+    p_pavltree = NULL;
+    ck_assert_int_eq(2001, destroyed);
+} END_TEST
+
+#define READERS 3
+#define KEYS 4000
+static int shared[KEYS];
+static atomic_int broken = 0;
+static void * test_reader(void * p_arg)
+{
+    pavltree * p_snapshot = p_arg;
+    int64_t size = pavltree_size(p_snapshot);
+    // the version must not change however the tree moves on
+    for (int round = 0; round < 20; round++){
+        int64_t found = 0;
+        for (int index = 0; index < KEYS; index++){
+            found += (NULL != pavltree_lookup(p_snapshot, &shared[index]));
+        }
+        if (found + 1 != size){
+            broken++;
+        }
+    }
+    pavltree_destroy(p_snapshot);
+    return NULL;
+}
+
+START_TEST(test_pavltree_threads)
+{
+    pthread_t threads[READERS];
+    for (int index = 0; index < KEYS; index++){
+        shared[index] = index + 10;
+    }
+    broken = 0;
+    for (int reader = 0; reader < READERS; reader++){
+        for (int index = reader; index < KEYS; index += READERS){
+            ck_assert_int_eq(0, pavltree_insert(p_pavltree, &shared[index]));
+        }
+        pavltree * p_snapshot = pavltree_snapshot(p_pavltree);
+        ck_assert_int_eq(0, pthread_create(&threads[reader], NULL, test_reader, p_snapshot));
+        // the writer keeps going while the readers run
+        for (int index = 0; index < KEYS; index += 2 + reader){
+            pavltree_remove(p_pavltree, &shared[index]);
+        }
+    }
+    for (int reader = 0; reader < READERS; reader++){
+        pthread_join(threads[reader], NULL);
+    }
+    ck_assert_int_eq(0, broken);
+    int64_t found = 0;
+    for (int index = 0; index < KEYS; index++){
+        found += (NULL != pavltree_lookup(p_pavltree, &shared[index]));
+    }
+    ck_assert_int_eq(found + 1, pavltree_size(p_pavltree));
+    // every removed data is gone once the snapshots are
+    ck_assert_int_eq(KEYS - found, destroyed);
+} END_TEST
+
+// create suite
+Suite * suite_pavltree(void)
+{
+    Suite * p_suite = suite_create("PAVLTREE");
+    TCase * p_core = tcase_create("Core");
+    // add test cases
+    tcase_add_checked_fixture(p_core, start_pavltree, teardown_pavltree);
+    tcase_add_test(p_core, test_pavltree_init);
+    tcase_add_test(p_core, test_pavltree_snapshot);
+    tcase_add_test(p_core, test_pavltree_threads);
+    // add core to suite
+    suite_add_tcase(p_suite, p_core);
+    return p_suite;
+}
@@ -3,13 +3,29 @@
 #include <stdint.h>
 typedef struct heap_node hnode;
 typedef struct heap heap;
-heap * heap_init(int ordering, void (* destroy)(void * p_data), int8_t (* compare)(void * p_key1, void * p_key2));
+heap * heap_init(int ordering, int arity, void (* destroy)(void * p_data), int8_t (* compare)(void * p_key1, void * p_key2));
+heap * heap_build(int ordering, int arity, void ** pp_items, int64_t count, void (* destroy)(void * p_data), int8_t (* compare)(void * p_key1, void * p_key2));
+heap * heap_topk(int ordering, int64_t k, void (* destroy)(void * p_data), int8_t (* compare)(void * p_key1, void * p_key2));
 void heap_destroy(heap * p_heap);
 int64_t heap_size(heap * p_heap);
+int8_t heap_reserve(heap * p_heap, int64_t count);
 hnode * heap_insert(heap * p_heap, void * p_data);
 hnode * heap_peek(heap * p_heap);
 hnode * heap_pull(heap * p_heap);
+int8_t heap_push(heap * p_heap, void * p_data);
+void * heap_top(heap * p_heap);
+void * heap_pop(heap * p_heap);
+void * heap_top_max(heap * p_heap);
+hnode * heap_peek_max(heap * p_heap);
+hnode * heap_pull_max(heap * p_heap);
+void * heap_pop_max(heap * p_heap);
+int64_t heap_pull_n(heap * p_heap, void ** pp_out, int64_t k);
+int8_t heap_offer(heap * p_heap, void * p_data);
+int64_t heap_topk_sorted(heap * p_heap, void ** pp_out);
+int8_t heap_update(heap * p_heap, hnode * p_node);
+int8_t heap_remove(heap * p_heap, hnode * p_node);
 void * heap_data(hnode * p_node);
 #define MAX 1
 #define MIN 0
+#define MINMAX 2
 #endif
@@ -0,0 +1,11 @@
+#ifndef _HITTERS_H
+#define _HITTERS_H
+#include <stdint.h>
+typedef struct hitters hitters;
+hitters * hitters_init(int64_t k, void (* destroy)(void * p_key), int (* compare)(void * p_key1, void * p_key2), uint32_t (* hash)(void * p_key));
+void hitters_destroy(hitters * p_hitters);
+int64_t hitters_size(hitters * p_hitters);
+int8_t hitters_observe(hitters * p_hitters, void * p_key);
+uint64_t hitters_count(hitters * p_hitters, void * p_key, uint64_t * p_error);
+int64_t hitters_top(hitters * p_hitters, int64_t n, void ** pp_keys, uint64_t * p_counts);
+#endif
@@ -0,0 +1,13 @@
+#ifndef _KMERGE_H
+#define _KMERGE_H
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <heap.h>
+typedef struct kmerge kmerge;
+kmerge * kmerge_init(int ordering, int64_t k, void ** pp_sources, void * (* next)(void * p_source), int8_t (* compare)(void * p_key1, void * p_key2));
+kmerge * kmerge_init_arrays(int ordering, int64_t k, void *** ppp_arrays, int64_t * p_counts, int8_t (* compare)(void * p_key1, void * p_key2));
+void kmerge_destroy(kmerge * p_merge);
+int64_t kmerge_pull(kmerge * p_merge, void ** pp_out, int64_t batch);
+int8_t kmerge_sort_file(FILE * p_in, FILE * p_out, size_t record_size, size_t memory, int8_t (* compare)(void * p_key1, void * p_key2));
+#endif
@@ -0,0 +1,11 @@
+#ifndef _MQUEUE_H
+#define _MQUEUE_H
+#include <stdint.h>
+#include <heap.h>
+typedef struct mqueue mqueue;
+mqueue * mqueue_init(int ordering, int threads, int factor, void (* destroy)(void * p_data), int8_t (* compare)(void * p_key1, void * p_key2));
+void mqueue_destroy(mqueue * p_queue);
+int64_t mqueue_size(mqueue * p_queue);
+int8_t mqueue_insert(mqueue * p_queue, void * p_data);
+void * mqueue_pull(mqueue * p_queue);
+#endif
@@ -0,0 +1,16 @@
+#ifndef _PHEAP_H
+#define _PHEAP_H
+#include <stdint.h>
+#include <heap.h>
+typedef struct pheap_node phnode;
+typedef struct pheap pheap;
+pheap * pheap_init(int ordering, void (* destroy)(void * p_data), int8_t (* compare)(void * p_key1, void * p_key2));
+void pheap_destroy(pheap * p_heap);
+int64_t pheap_size(pheap * p_heap);
+phnode * pheap_insert(pheap * p_heap, void * p_data);
+phnode * pheap_peek(pheap * p_heap);
+void * pheap_pull(pheap * p_heap);
+int8_t pheap_decrease_key(pheap * p_heap, phnode * p_node);
+int8_t pheap_meld(pheap * p_dest, pheap * p_source);
+void * pheap_data(phnode * p_node);
+#endif
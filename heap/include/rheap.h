@@ -0,0 +1,11 @@
+#ifndef _RHEAP_H
+#define _RHEAP_H
+#include <stdint.h>
+typedef struct rheap rheap;
+rheap * rheap_init(void (* destroy)(void * p_data));
+void rheap_destroy(rheap * p_heap);
+int64_t rheap_size(rheap * p_heap);
+int8_t rheap_insert(rheap * p_heap, uint64_t key, void * p_data);
+void * rheap_peek(rheap * p_heap, uint64_t * p_key);
+void * rheap_pull(rheap * p_heap, uint64_t * p_key);
+#endif
@@ -0,0 +1,12 @@
+#ifndef _TWHEEL_H
+#define _TWHEEL_H
+#include <stdint.h>
+typedef struct twheel twheel;
+typedef struct twheel_timer twtimer;
+twheel * twheel_init(uint64_t start, uint64_t tick, int levels, void (* destroy)(void * p_data));
+void twheel_destroy(twheel * p_wheel);
+int64_t twheel_size(twheel * p_wheel);
+twtimer * twheel_schedule(twheel * p_wheel, uint64_t expire, void * p_data);
+int8_t twheel_cancel(twheel * p_wheel, twtimer * p_timer);
+int64_t twheel_advance(twheel * p_wheel, uint64_t now, void (* expire)(void ** pp_data, int64_t count));
+#endif
@@ -0,0 +1,14 @@
+#ifndef _XHEAP_H
+#define _XHEAP_H
+#include <stdint.h>
+#include <stddef.h>
+#include <heap.h>
+typedef struct xheap xheap;
+xheap * xheap_init(int ordering, size_t record_size, size_t memory, int8_t (* compare)(void * p_key1, void * p_key2));
+void xheap_destroy(xheap * p_xheap);
+int64_t xheap_size(xheap * p_xheap);
+int64_t xheap_runs(xheap * p_xheap);
+int8_t xheap_push(xheap * p_xheap, void * p_record);
+void * xheap_top(xheap * p_xheap);
+int8_t xheap_pop(xheap * p_xheap, void * p_record);
+#endif
@@ -3,288 +3,454 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 
 /*
- * @param INITIAL_MEMBERS the initial size of the pp_array
- * @param TOLERANCE the percentage of use space acceptable for an array
+ * @param INITIAL_MEMBERS the initial size of the p_array
+ * @param LINE the cache line size the children of an entry are aligned to
  */
-enum {INITIAL_MEMBERS = 5};
+enum {INITIAL_MEMBERS = 5, LINE = 64};
 
 /*
  * @param TOLERANCE the percentage of use space acceptable for an array
  */
 static const float TOLERANCE = .80;
 /*
- * @brief the node that is stored in a heap
+ * @brief the handle to an element stored in a heap
  * @param p_data pointer to the data in the node
- * @param index index of the node
+ * @param index index of the node or -1 once it has left the heap
  */
 struct heap_node {
     void * p_data;
-    int64_t index; 
+    int64_t index;
 };
 
 /*
- * @brief a heap structure 
+ * @brief an element stored inline in the heap array, the data is kept next
+ *  to the handle pointer so comparisons never leave the array
+ * @param p_data pointer to the data of the element
+ * @param p_node the handle of the element or NULL if it was pushed without one
+ */
+typedef struct heap_entry {
+    void * p_data;
+    hnode * p_node;
+} heap_entry;
+
+/*
+ * @brief a heap structure
  * @param ordering either min or max ordering
- * @param node_space number of nodes allocated for the heap
+ * @param arity the number of children of each entry, 2 4 or 8
+ * @param arity_shift log2 of arity
+ * @param node_space number of entries allocated for the heap
  * @param size the number of children in the heap
  * @param destroy the tear down function for the data in a heap node
  * @param compare the user defined compare function for the heap
- * @param pp_array an array of heap nodes in the heap
+ * @param p_array the contiguous array of entries in the heap
+ * @param p_block the allocation holding p_array
+ * @param limit the most elements heap_offer keeps or 0 for no limit
  */
 struct heap {
     int ordering;
+    int arity;
+    int arity_shift;
     uint64_t node_space;
     int64_t size;
+    int64_t limit;
     void (* destroy)(void * p_data);
     int8_t (* compare)(void * p_key1, void * p_key2);
-    hnode ** pp_array;
+    heap_entry * p_array;
+    heap_entry * p_block;
 };
 
 /*
- * @brief get the node at the specified index in a heap
- * @param p_heap the heap to get the node from
- * @param index the index of the node to get
- * @return the heap node in the heap
+ * @brief get the index of the parent of an entry
+ * @param p_heap the heap the entry is in
+ * @param index the index of the entry
+ * @return the index of the parent entry
  */
-static hnode * heap_member(heap * p_heap, int index)
+static int64_t heap_parent(heap * p_heap, int64_t index)
 {
-    return p_heap->pp_array[index];
+    return ((index - 1) >> p_heap->arity_shift);
 }
 
 /*
- * @brief gets the root of a heap
- * @param p_heap the heap to get the root from
- * @return pointer to the root node in the heap
+ * @brief get the index of the first child of an entry in a base 0 index, the
+ *  remaining children follow it in the array
+ * @param p_heap the heap the entry is in
+ * @param index the index of the entry
+ * @return the index of the first child entry
  */
-static hnode * heap_root(heap * p_heap)
+static int64_t heap_child(heap * p_heap, int64_t index)
 {
-    // cant get the root from a null or empty heap
-    if ((NULL == p_heap) || (0 == p_heap->size)){
-        return NULL;
-    }
-    return heap_member(p_heap, 0);
+    return ((index << p_heap->arity_shift) + 1);
 }
 
 /*
- * @brief get the last element in a heap
- * @param p_heap the heap to get the tail from
- * @return the tail node of the heap
+ * @brief checks if data belongs above other data based on the heap ordering
+ * @param p_heap the heap providing the ordering and compare function
+ * @param p_key1 the data to check
+ * @param p_key2 the data to check against
+ * @return true if p_key1 must be closer to the root than p_key2
  */
-static hnode * heap_tail(heap * p_heap)
+static bool heap_before(heap * p_heap, void * p_key1, void * p_key2)
 {
-    // an empty heap does not have a tail
-    if ((NULL == p_heap) || (0 == p_heap->size)){
-        return NULL;
-    }
-    // return the tail
-    return heap_member(p_heap, p_heap->size - 1);
+    int8_t cmpval = p_heap->compare(p_key1, p_key2);
+    return (MIN == p_heap->ordering) ? (cmpval < 0) : (cmpval > 0);
 }
 
 /*
- * @brief get the parent node of a specified heap node
- * @param p_heap the heap to search in
- * @param p_node the node to get the parent from
- * @return the parent node of the passed in heap node
+ * @brief stores an entry at an index keeping its handle in sync
+ * @param p_heap the heap to store the entry in
+ * @param index the index to store the entry at
+ * @param entry the entry to store
  */
-static hnode * heap_parent(heap * p_heap, hnode * p_node)
+static void heap_place(heap * p_heap, int64_t index, heap_entry entry)
 {
-    // check if p_node is the root node
-    if (p_node->index == 0){
-        return NULL;
+    p_heap->p_array[index] = entry;
+    if (NULL != entry.p_node){
+        entry.p_node->index = index;
     }
-
-    int index = ((p_node->index - 1) / 2);
-    return heap_member(p_heap, index);
 }
 
 /*
- * @brief get the left child of a heap in a base 0 index
- * @param p_heap the heap to search in
- * @param p_node the node to get the left child from
- * @return the left child node of the passed in node
+ * @brief moves an entry toward the root until its parent belongs above it
+ * @param p_heap the heap to rebalance
+ * @param index the index of the entry to move
  */
-static hnode * heap_left(heap * p_heap, hnode * p_node)
+static void heap_bubble_up(heap * p_heap, int64_t index)
 {
-    int index = ((2 * p_node->index) + 1);
-    return heap_member(p_heap, index);
+    // carry the entry up as a hole instead of swapping at every level
+    heap_entry entry = p_heap->p_array[index];
+    while (index > 0){
+        int64_t parent = heap_parent(p_heap, index);
+        if (!heap_before(p_heap, entry.p_data, p_heap->p_array[parent].p_data)){
+            break;
+        }
+        heap_place(p_heap, index, p_heap->p_array[parent]);
+        index = parent;
+    }
+    heap_place(p_heap, index, entry);
 }
 
 /*
- * @brief get the right child of a heap in a base 0 index
- * @param p_heap the heap to search in
- * @param p_node the node to get the right child from
- * @return the right child node of the passed in node
+ * @brief moves an entry toward the leaves until no child belongs above it
+ * @param p_heap the heap to rebalance
+ * @param index the index of the entry to move
  */
-static hnode * heap_right(heap * p_heap, hnode * p_node)
+static void heap_bubble_down(heap * p_heap, int64_t index)
 {
-    int index = ((2 * p_node->index) + 2);
-    return heap_member(p_heap, index);
+    heap_entry entry = p_heap->p_array[index];
+    while (heap_child(p_heap, index) < p_heap->size){
+        // get the child that belongs closest to the root, the children share
+        // an aligned run of the array so the scan stays within their lines
+        int64_t first = heap_child(p_heap, index);
+        int64_t last = first + p_heap->arity;
+        int64_t child = first;
+        if (last > p_heap->size){
+            last = p_heap->size;
+        }
+        for (int64_t sibling = first + 1; sibling < last; sibling++){
+            if (heap_before(p_heap, p_heap->p_array[sibling].p_data, p_heap->p_array[child].p_data)){
+                child = sibling;
+            }
+        }
+        if (!heap_before(p_heap, p_heap->p_array[child].p_data, entry.p_data)){
+            break;
+        }
+        heap_place(p_heap, index, p_heap->p_array[child]);
+        index = child;
+    }
+    heap_place(p_heap, index, entry);
 }
 
 /*
- * @brief orders a min after inserting a new node heap
- * @param p_heap the heap to rebalance as a min heap
+ * @brief checks if an entry of a min-max heap is on a min level, the root
+ *  level is a min level and the levels alternate below it
+ * @param index the index of the entry
+ * @return true if the entry is on a min level
  */
-static void heap_min_up(heap * p_heap)
+static bool heap_min_level(int64_t index)
 {
-    // while the tail node is less than its parent node
-    // swap the values
-    hnode * p_new_node = heap_tail(p_heap);
-    while((NULL != heap_parent(p_heap, p_new_node)) \
-        && (-1 == p_heap->compare(p_new_node->p_data, (heap_parent(p_heap, p_new_node))->p_data))){
-        // switch the node indexes
-        hnode * p_temp_node = heap_parent(p_heap, p_new_node);
-        int temp_index = p_temp_node->index;
-        p_temp_node->index = p_new_node->index;
-        p_new_node->index = temp_index;
-        // switch the nodes to their new indexes in the array
-        p_heap->pp_array[p_new_node->index] = p_new_node;
-        p_heap->pp_array[p_temp_node->index] = p_temp_node;
-    }
+    return (0 == ((63 - __builtin_clzll((uint64_t)index + 1)) & 1));
 }
 
 /*
- * @brief orders a max after inserting a new node heap
- * @param p_heap the heap to rebalance as a max heap
+ * @brief checks if data belongs above other data on one kind of level of a
+ *  min-max heap
+ * @param p_heap the heap providing the compare function
+ * @param p_key1 the data to check
+ * @param p_key2 the data to check against
+ * @param b_max true to check against a max level else a min level
+ * @return true if p_key1 must be closer to the root than p_key2
  */
-static void heap_max_up(heap * p_heap)
+static bool heap_minmax_before(heap * p_heap, void * p_key1, void * p_key2, bool b_max)
 {
-    // while the tail node is less than its parent node
-    // swap the values
-    hnode * p_new_node = heap_tail(p_heap);
-    while((NULL != heap_parent(p_heap, p_new_node)) \
-        && (1 == p_heap->compare(p_new_node->p_data, (heap_parent(p_heap, p_new_node))->p_data))){
-        // switch the node indexes
-        hnode * p_temp_node = heap_parent(p_heap, p_new_node);
-        int temp_index = p_temp_node->index;
-        p_temp_node->index = p_new_node->index;
-        p_new_node->index = temp_index;
-        // switch the nodes to their new indexes in the array
-        p_heap->pp_array[p_new_node->index] = p_new_node;
-        p_heap->pp_array[p_temp_node->index] = p_temp_node;
-    }
+    int8_t cmpval = p_heap->compare(p_key1, p_key2);
+    return b_max ? (cmpval > 0) : (cmpval < 0);
 }
 
 /*
- * @brief rebalances a heap after inserting a new node
+ * @brief moves an entry of a min-max heap toward the root, first across to
+ *  the other kind of level if it belongs there then up its own kind of level
  * @param p_heap the heap to rebalance
+ * @param index the index of the entry to move
  */
-static void heap_bubble_up(heap * p_heap)
+static void heap_minmax_bubble_up(heap * p_heap, int64_t index)
 {
-    // check if the last node in the heap is greater than or less than the parent
-    // this is based on the ordering of the heap
-    // min heap defined
-    if (MIN == p_heap->ordering){
-        heap_min_up(p_heap); 
+    heap_entry entry = p_heap->p_array[index];
+    bool b_max = !heap_min_level(index);
+    if (index > 0){
+        int64_t parent = (index - 1) >> 1;
+        if (heap_minmax_before(p_heap, entry.p_data, p_heap->p_array[parent].p_data, !b_max)){
+            heap_place(p_heap, index, p_heap->p_array[parent]);
+            index = parent;
+            b_max = !b_max;
+        }
     }
-    else {
-        heap_max_up(p_heap);
+    // the grandparents are the ancestors on the same kind of level
+    while (index > 2){
+        int64_t grandparent = (index - 3) >> 2;
+        if (!heap_minmax_before(p_heap, entry.p_data, p_heap->p_array[grandparent].p_data, b_max)){
+            break;
+        }
+        heap_place(p_heap, index, p_heap->p_array[grandparent]);
+        index = grandparent;
     }
+    heap_place(p_heap, index, entry);
 }
 
 /*
- * @brief rebalances a min heap after removing a new node 
+ * @brief moves an entry of a min-max heap toward the leaves, looking at its
+ *  children and grandchildren for the one that belongs in its place
  * @param p_heap the heap to rebalance
+ * @param index the index of the entry to move
+ * @return the index the entry ended at
  */
-static void heap_min_down(heap * p_heap)
-{
-    hnode * p_new_root = heap_root(p_heap);
-    bool b_done = false;
-    // continue to swap the root with its children until neither of its children is
-    // less than the current node
-    while (!b_done){
-        // get the lesser value of the two children
-        hnode * p_lesser_temp = NULL;
-        hnode * p_left = heap_left(p_heap, p_new_root);
-        hnode * p_right = heap_right(p_heap, p_new_root);
-        if (-1 == p_heap->compare(p_left, p_right)){
-            p_lesser_temp = p_left;
+static int64_t heap_minmax_trickle_down(heap * p_heap, int64_t index)
+{
+    heap_entry entry = p_heap->p_array[index];
+    bool b_max = !heap_min_level(index);
+    int64_t final = -1;
+    while (((index << 1) + 1) < p_heap->size){
+        // find the one of the two children and four grandchildren that
+        // belongs closest to the root
+        int64_t best = (index << 1) + 1;
+        if (((best + 1) < p_heap->size) && heap_minmax_before(p_heap, p_heap->p_array[best + 1].p_data, p_heap->p_array[best].p_data, b_max)){
+            best++;
         }
-        else {
-            p_lesser_temp = p_right;
+        int64_t first = (index << 2) + 3;
+        for (int64_t grandchild = first; (grandchild < (first + 4)) && (grandchild < p_heap->size); grandchild++){
+            if (heap_minmax_before(p_heap, p_heap->p_array[grandchild].p_data, p_heap->p_array[best].p_data, b_max)){
+                best = grandchild;
+            }
         }
-        // swap the values if the new_root is less than the lesser child 
-        if ((NULL != p_lesser_temp) && (-1 == p_heap->compare(p_new_root, p_lesser_temp))){
-            // switch the node indexes
-            int temp_index = p_lesser_temp->index; 
-            p_lesser_temp->index = p_new_root->index;
-            p_new_root->index = temp_index;
-            // switch the nodes to their new indexes in the array
-            p_heap->pp_array[p_new_root->index] = p_new_root;
-            p_heap->pp_array[p_lesser_temp->index] = p_lesser_temp;
+        if (!heap_minmax_before(p_heap, p_heap->p_array[best].p_data, entry.p_data, b_max)){
+            break;
         }
-        else {
-            // if the new root children are not lesser than the new root then exit the loop
-            b_done = true;
+        heap_place(p_heap, index, p_heap->p_array[best]);
+        index = best;
+        // a child has no descendants on this kind of level left to look at
+        if (best < first){
+            break;
+        }
+        // the entry must also fit below the parent of the grandchild, if it
+        // does not they trade places and the parent carries on down
+        int64_t parent = (best - 1) >> 1;
+        if (heap_minmax_before(p_heap, entry.p_data, p_heap->p_array[parent].p_data, !b_max)){
+            heap_entry swapped = p_heap->p_array[parent];
+            heap_place(p_heap, parent, entry);
+            if (-1 == final){
+                final = parent;
+            }
+            entry = swapped;
         }
     }
+    heap_place(p_heap, index, entry);
+    return (-1 == final) ? index : final;
 }
 
 /*
- * @brief rebalances a max heap after removing a new node 
+ * @brief moves an entry whose data may have changed in whichever direction
+ *  restores the heap ordering
  * @param p_heap the heap to rebalance
+ * @param index the index of the entry to move
  */
-static void heap_max_down(heap * p_heap)
-{
-    hnode * p_new_root = heap_root(p_heap);
-    bool b_done = false;
-    // continue to swap the root with its children until neither of its children is
-    // greater than the current node
-    while (!b_done){
-        // get the greater value of the two children
-        hnode * p_greater_temp = NULL;
-        hnode * p_left = heap_left(p_heap, p_new_root);
-        hnode * p_right = heap_right(p_heap, p_new_root);
-        if (1 == p_heap->compare(p_left, p_right)){
-            p_greater_temp = p_left;
-        }
-        else {
-            p_greater_temp = p_right;
-        }
-        // swap the values if the new_root is less than the lesser child 
-        if ((NULL != p_greater_temp) && (1 == p_heap->compare(p_new_root, p_greater_temp))){
-            // switch the node indexes
-            int temp_index = p_greater_temp->index; 
-            p_greater_temp->index = p_new_root->index;
-            p_new_root->index = temp_index;
-            // switch the nodes to their new indexes in the array
-            p_heap->pp_array[p_new_root->index] = p_new_root;
-            p_heap->pp_array[p_greater_temp->index] = p_greater_temp;
-        }
-        else {
-            // if the new root children are not greater than the new root then exit
-            b_done = true;
-        }
+static void heap_restore(heap * p_heap, int64_t index)
+{
+    if (MINMAX == p_heap->ordering){
+        heap_minmax_bubble_up(p_heap, heap_minmax_trickle_down(p_heap, index));
+    }
+    else if ((index > 0) && heap_before(p_heap, p_heap->p_array[index].p_data, p_heap->p_array[heap_parent(p_heap, index)].p_data)){
+        heap_bubble_up(p_heap, index);
+    }
+    else {
+        heap_bubble_down(p_heap, index);
     }
+}
 
+/*
+ * @brief checks that a handle belongs to an element currently in a heap
+ * @param p_heap the heap the handle should be in
+ * @param p_node the handle to check
+ * @return true if the handle is in the heap
+ */
+static bool heap_owns(heap * p_heap, hnode * p_node)
+{
+    return ((NULL != p_heap) && (NULL != p_node) && (0 <= p_node->index) \
+        && (p_node->index < p_heap->size) && (p_heap->p_array[p_node->index].p_node == p_node));
 }
 
 /*
- * @brief rebalances a heap after removing the root
- * @param p_heap the heap to rebalance
+ * @brief allocates room for a number of entries with every group of siblings
+ *  starting on a cache line, the entries already in the heap are kept
+ * @param p_heap the heap to allocate the entries for
+ * @param node_space the number of entries to make room for
+ * @return 0 on success else -1
+ */
+static int8_t heap_alloc(heap * p_heap, uint64_t node_space)
+{
+    // the first child sits at index 1 so pad the front of the block until
+    // index 1 lands on a boundary of a sibling group
+    size_t pad = p_heap->arity - 1;
+    size_t bytes = (pad + node_space) * sizeof(heap_entry);
+    bytes = (bytes + LINE - 1) & ~((size_t)LINE - 1);
+    heap_entry * p_block = aligned_alloc(LINE, bytes);
+    if (NULL == p_block){
+        perror("heap alloc ");
+        return -1;
+    }
+    if (NULL != p_heap->p_block){
+        memcpy(p_block + pad, p_heap->p_array, p_heap->size * sizeof(heap_entry));
+        free(p_heap->p_block);
+    }
+    p_heap->p_block = p_block;
+    p_heap->p_array = p_block + pad;
+    p_heap->node_space = node_space;
+    return 0;
+}
+
+/*
+ * @brief grows the entry array once it is used beyond TOLERANCE
+ * @param p_heap the heap about to receive a new entry
+ * @return 0 if there is room for the new entry else -1
+ */
+static int8_t heap_grow(heap * p_heap)
+{
+    if (((float)(p_heap->size + 1) / p_heap->node_space) < TOLERANCE){
+        return 0;
+    }
+    return heap_alloc(p_heap, (p_heap->size + 1) * 2);
+}
+
+/*
+ * @brief adds an entry at the end of a heap and moves it into place
+ * @param p_heap the heap to add the entry to
+ * @param entry the entry to add
+ * @return 0 on success else -1
  */
-static void heap_bubble_down(heap * p_heap){
-    if (MIN == p_heap->ordering){
-        heap_min_down(p_heap);
+static int8_t heap_add(heap * p_heap, heap_entry entry)
+{
+    if (0 != heap_grow(p_heap)){
+        return -1;
+    }
+    heap_place(p_heap, p_heap->size, entry);
+    p_heap->size++;
+    if (MINMAX == p_heap->ordering){
+        heap_minmax_bubble_up(p_heap, p_heap->size - 1);
     }
     else {
-       heap_max_down(p_heap); 
+        heap_bubble_up(p_heap, p_heap->size - 1);
+    }
+    return 0;
+}
+
+/*
+ * @brief removes an entry from a heap
+ * @param p_heap the heap to remove the entry from
+ * @param index the index of the entry
+ * @param p_entry set to the removed entry
+ */
+static void heap_take(heap * p_heap, int64_t index, heap_entry * p_entry)
+{
+    *p_entry = p_heap->p_array[index];
+    // fill the hole with the tail and move it to where it belongs
+    p_heap->size--;
+    if (index != p_heap->size){
+        heap_place(p_heap, index, p_heap->p_array[p_heap->size]);
+        heap_restore(p_heap, index);
+    }
+    if (NULL != p_entry->p_node){
+        p_entry->p_node->index = -1;
+    }
+}
+
+/*
+ * @brief removes the root entry of a non empty heap
+ * @param p_heap the heap to remove the root from
+ * @param p_root set to the old root entry
+ */
+static void heap_take_root(heap * p_heap, heap_entry * p_root)
+{
+    heap_take(p_heap, 0, p_root);
+}
+
+/*
+ * @brief gets the index of the largest entry of a non empty min-max heap
+ * @param p_heap the heap to look in
+ * @return the index of the root if it is alone else of the larger of its
+ *  children
+ */
+static int64_t heap_max_index(heap * p_heap)
+{
+    if (1 == p_heap->size){
+        return 0;
+    }
+    if ((2 == p_heap->size) || !heap_minmax_before(p_heap, p_heap->p_array[2].p_data, p_heap->p_array[1].p_data, true)){
+        return 1;
     }
+    return 2;
+}
+
+/*
+ * @brief gets the handle of an entry creating one if it was pushed without
+ * @param p_heap the heap the entry is in
+ * @param index the index of the entry
+ * @return the handle of the entry or NULL on error
+ */
+static hnode * heap_handle(heap * p_heap, int64_t index)
+{
+    heap_entry * p_entry = &p_heap->p_array[index];
+    if (NULL == p_entry->p_node){
+        p_entry->p_node = calloc(1, sizeof(*(p_entry->p_node)));
+        if (NULL == p_entry->p_node){
+            perror("heap handle ");
+            return NULL;
+        }
+        p_entry->p_node->p_data = p_entry->p_data;
+        p_entry->p_node->index = index;
+    }
+    return p_entry->p_node;
 }
 
 /*
  * @brief allocate and initialize a heap
- * @param ordering integer identifying if the heap should be min or max heap 0 or 1 respectively   
+ * @param ordering integer identifying if the heap should be min or max heap 0 or 1 respectively,
+ *  or MINMAX for a min-max heap giving access to both ends
+ * @param arity the number of children of each node 2 4 or 8, wider heaps are
+ *  shallower so a pull follows fewer dependent cache misses, a min-max heap
+ *  must be binary
  * @param destroy user defined function to tear down the nodes data
  * @param compare user defined function to compare the data in the nodes should return -1 0 or 1
  * @return a newly initialized heap or NULL on error
  */
-heap * heap_init(int ordering, void (* destroy)(void * p_data), int8_t (* compare)(void * p_key1, void * p_key2))
+heap * heap_init(int ordering, int arity, void (* destroy)(void * p_data), int8_t (* compare)(void * p_key1, void * p_key2))
 {
-    // a compare function must be passed
-    if (NULL == compare){
+    // a compare function must be passed and the arity must be supported
+    if ((NULL == compare) || ((2 != arity) && (4 != arity) && (8 != arity))){
+        return NULL;
+    }
+    // the levels of a min-max heap alternate which needs a binary tree
+    if ((MINMAX == ordering) && (2 != arity)){
         return NULL;
     }
     // create the heap
@@ -294,17 +460,93 @@ heap * heap_init(int ordering, void (* destroy)(void * p_data), int8_t (* compar
     }
     // initialize the values
     p_heap->ordering = ordering;
-    p_heap->node_space = INITIAL_MEMBERS;
+    p_heap->arity = arity;
+    p_heap->arity_shift = __builtin_ctz(arity);
     p_heap->size = 0;
+    p_heap->limit = 0;
     p_heap->destroy = destroy;
     p_heap->compare = compare;
-    p_heap->pp_array = calloc(p_heap->node_space, sizeof(*(p_heap->pp_array)));
-    if (NULL == p_heap->pp_array){
+    if (0 != heap_alloc(p_heap, INITIAL_MEMBERS)){
+        free(p_heap);
         return NULL;
     }
     return p_heap;
 }
 
+/*
+ * @brief allocate a heap holding a batch of data in O(n) using a bottom up
+ *  heapify, the data is stored inline without handles
+ * @param ordering integer identifying if the heap should be min or max heap 0 or 1 respectively
+ * @param arity the number of children of each node 2 4 or 8
+ * @param pp_items the data to fill the heap with, NULL items are skipped
+ * @param count the number of items
+ * @param destroy user defined function to tear down the nodes data
+ * @param compare user defined function to compare the data in the nodes should return -1 0 or 1
+ * @return a newly initialized heap or NULL on error
+ */
+heap * heap_build(int ordering, int arity, void ** pp_items, int64_t count, void (* destroy)(void * p_data), int8_t (* compare)(void * p_key1, void * p_key2))
+{
+    // a batch must be passed to build from
+    if ((NULL == pp_items) || (count < 0)){
+        return NULL;
+    }
+    heap * p_heap = heap_init(ordering, arity, destroy, compare);
+    if (NULL == p_heap){
+        return NULL;
+    }
+    if (0 != heap_reserve(p_heap, count)){
+        heap_destroy(p_heap);
+        return NULL;
+    }
+    for (int64_t index = 0; index < count; index++){
+        if (NULL != pp_items[index]){
+            p_heap->p_array[p_heap->size].p_data = pp_items[index];
+            p_heap->p_array[p_heap->size].p_node = NULL;
+            p_heap->size++;
+        }
+    }
+    // sink every parent starting from the last one so each subtree is a heap
+    // before its root is placed
+    for (int64_t index = heap_parent(p_heap, p_heap->size - 1); (p_heap->size > 1) && (index >= 0); index--){
+        if (MINMAX == p_heap->ordering){
+            heap_minmax_trickle_down(p_heap, index);
+        }
+        else {
+            heap_bubble_down(p_heap, index);
+        }
+    }
+    return p_heap;
+}
+
+/*
+ * @brief allocate a heap that keeps only the k best elements offered to it,
+ *  the root is the worst element kept so a new element only has to beat the
+ *  root to get in
+ * @param ordering MAX to keep the k largest or MIN to keep the k smallest
+ * @param k the number of elements to keep
+ * @param destroy user defined function to tear down the data of elements
+ *  pushed out of the heap
+ * @param compare user defined function to compare the data should return -1 0 or 1
+ * @return a newly initialized heap or NULL on error
+ */
+heap * heap_topk(int ordering, int64_t k, void (* destroy)(void * p_data), int8_t (* compare)(void * p_key1, void * p_key2))
+{
+    if (k < 1){
+        return NULL;
+    }
+    // the worst element kept has to be at the root so flip the ordering
+    heap * p_heap = heap_init((MAX == ordering) ? MIN : MAX, 4, destroy, compare);
+    if (NULL == p_heap){
+        return NULL;
+    }
+    if (0 != heap_reserve(p_heap, k)){
+        heap_destroy(p_heap);
+        return NULL;
+    }
+    p_heap->limit = k;
+    return p_heap;
+}
+
 /*
  * @brief tear down a heap
  * @param p_heap the heap to tear down
@@ -316,13 +558,13 @@ void heap_destroy(heap * p_heap)
         return;
     }
     // perform user defined destroy
-        for (int64_t index = p_heap->size; index >= 0; index--){
-            if (NULL != p_heap->destroy){
-                p_heap->destroy((heap_member(p_heap, index))->p_data);    
-            }
-            free(p_heap->pp_array[index]);
+    for (int64_t index = p_heap->size - 1; index >= 0; index--){
+        if (NULL != p_heap->destroy){
+            p_heap->destroy(p_heap->p_array[index].p_data);
         }
-    free(p_heap->pp_array);
+        free(p_heap->p_array[index].p_node);
+    }
+    free(p_heap->p_block);
     free(p_heap);
 }
 
@@ -339,6 +581,26 @@ int64_t heap_size(heap * p_heap)
     return p_heap->size;
 }
 
+/*
+ * @brief makes room for a number of elements so adding them does not
+ *  reallocate the heap
+ * @param p_heap the heap to make room in
+ * @param count the number of elements the heap should hold
+ * @return 0 on success else -1
+ */
+int8_t heap_reserve(heap * p_heap, int64_t count)
+{
+    if ((NULL == p_heap) || (count < 0)){
+        return -1;
+    }
+    // keep the use of the array below TOLERANCE once count elements are in
+    uint64_t node_space = (uint64_t)(count / TOLERANCE) + 2;
+    if (node_space <= p_heap->node_space){
+        return 0;
+    }
+    return heap_alloc(p_heap, node_space);
+}
+
 /*
  * @brief adds a new node to a heap
  * @param p_heap the heap to insert the node into
@@ -358,27 +620,32 @@ hnode * heap_insert(heap * p_heap, void * p_data)
         return NULL;
     }
     p_node->p_data = p_data;
-    p_node->index = p_heap->size;
-    // assign the new node at the end of the heap
-    p_heap->pp_array[p_node->index] = p_node;    
-    p_heap->size++;
-    // reallocate the array if needed
-    if (((float)p_heap->size / p_heap->node_space) >= TOLERANCE){
-        hnode ** pp_temp = (hnode **)realloc(p_heap->pp_array, (p_heap->size * 2) * sizeof(hnode *));
-        if (NULL == pp_temp){
-            perror("insert realloc ");
-        }
-        p_heap->pp_array = pp_temp;
-        p_heap->node_space = p_heap->size * 2;
-    }
-    // if the heap size is not zero then we have to rebalance the heap
-    if (1 != p_heap->size){
-        heap_bubble_up(p_heap);    
+    heap_entry entry = {p_data, p_node};
+    if (0 != heap_add(p_heap, entry)){
+        free(p_node);
+        return NULL;
     }
     // return the node
     return p_node;
 }
 
+/*
+ * @brief adds data to a heap without creating a handle for it, the data is
+ *  stored inline in the heap array so no allocation is made per element
+ * @param p_heap the heap to add the data to
+ * @param p_data the data to add
+ * @return 0 on success else -1
+ */
+int8_t heap_push(heap * p_heap, void * p_data)
+{
+    // cant push into a null heap or from null data
+    if ((NULL == p_heap) || (NULL == p_data)){
+        return -1;
+    }
+    heap_entry entry = {p_data, NULL};
+    return heap_add(p_heap, entry);
+}
+
 /*
  * @brief gets the data at the root of the heap but does not remove it
  * @param p_heap the heap to get the root from
@@ -390,13 +657,27 @@ hnode * heap_peek(heap * p_heap)
     if ((NULL == p_heap) || (0 == p_heap->size)){
         return NULL;
     }
-    return heap_member(p_heap, 0);
+    return heap_handle(p_heap, 0);
+}
+
+/*
+ * @brief gets the data at the root of a heap without creating a handle
+ * @param p_heap the heap to get the root from
+ * @return the data of the root or NULL if the heap is empty
+ */
+void * heap_top(heap * p_heap)
+{
+    // cant look at a null or empty heap
+    if ((NULL == p_heap) || (0 == p_heap->size)){
+        return NULL;
+    }
+    return p_heap->p_array[0].p_data;
 }
 
 /*
  * @brief gets the data at the root of the heap and removes it from the heap
  * @param p_heap the heap to get the root from
- * @return pointer to the heap that is the root
+ * @return pointer to the heap that is the root, the caller frees the node
  */
 hnode * heap_pull(heap * p_heap)
 {
@@ -404,19 +685,216 @@ hnode * heap_pull(heap * p_heap)
     if ((NULL == p_heap) || (0 == p_heap->size)){
         return NULL;
     }
-    // store the old root value to hold the heap root 
-    hnode * p_old_root = heap_member(p_heap, 0);
-    // insert the last value as the new root
-    hnode * p_new_root = heap_tail(p_heap); 
-    p_heap->pp_array[0] = p_new_root;
-    p_new_root->index = 0;
-    // we are removing the old root so we have to decrease the size
-    p_heap->size--;
-    heap_bubble_down(p_heap);
-    // while the new root is greater than or less than its children based on ordering
-    // swap with the greater or lesser child
-    // return the old root
-    return p_old_root;
+    // the caller takes ownership of the node so make sure the root has one
+    if (NULL == heap_handle(p_heap, 0)){
+        return NULL;
+    }
+    heap_entry root;
+    heap_take_root(p_heap, &root);
+    return root.p_node;
+}
+
+/*
+ * @brief removes the root of a heap and returns its data, a handle the root
+ *  was given by heap_insert or a peek is left to the caller to free as after
+ *  heap_pull and no longer belongs to the heap
+ * @param p_heap the heap to get the root from
+ * @return the data of the old root or NULL if the heap is empty
+ */
+void * heap_pop(heap * p_heap)
+{
+    // cant get the root of a NULL or empty heap
+    if ((NULL == p_heap) || (0 == p_heap->size)){
+        return NULL;
+    }
+    heap_entry root;
+    heap_take_root(p_heap, &root);
+    return root.p_data;
+}
+
+/*
+ * @brief gets the largest data of a min-max heap without creating a handle
+ * @param p_heap the min-max heap to look in
+ * @return the largest data or NULL if the heap is empty or not a min-max heap
+ */
+void * heap_top_max(heap * p_heap)
+{
+    // only a non empty min-max heap keeps its largest data near the root
+    if ((NULL == p_heap) || (MINMAX != p_heap->ordering) || (0 == p_heap->size)){
+        return NULL;
+    }
+    return p_heap->p_array[heap_max_index(p_heap)].p_data;
+}
+
+/*
+ * @brief gets the node holding the largest data of a min-max heap but does
+ *  not remove it
+ * @param p_heap the min-max heap to look in
+ * @return the node or NULL if the heap is empty or not a min-max heap
+ */
+hnode * heap_peek_max(heap * p_heap)
+{
+    if ((NULL == p_heap) || (MINMAX != p_heap->ordering) || (0 == p_heap->size)){
+        return NULL;
+    }
+    return heap_handle(p_heap, heap_max_index(p_heap));
+}
+
+/*
+ * @brief removes the node holding the largest data of a min-max heap
+ * @param p_heap the min-max heap to pull from
+ * @return the node or NULL if the heap is empty or not a min-max heap, the
+ *  caller frees the node
+ */
+hnode * heap_pull_max(heap * p_heap)
+{
+    if ((NULL == p_heap) || (MINMAX != p_heap->ordering) || (0 == p_heap->size)){
+        return NULL;
+    }
+    int64_t index = heap_max_index(p_heap);
+    // the caller takes ownership of the node so make sure the entry has one
+    if (NULL == heap_handle(p_heap, index)){
+        return NULL;
+    }
+    heap_entry entry;
+    heap_take(p_heap, index, &entry);
+    return entry.p_node;
+}
+
+/*
+ * @brief removes the largest data of a min-max heap, a handle of its entry
+ *  is left to the caller to free as with heap_pop
+ * @param p_heap the min-max heap to pop from
+ * @return the largest data or NULL if the heap is empty or not a min-max heap
+ */
+void * heap_pop_max(heap * p_heap)
+{
+    if ((NULL == p_heap) || (MINMAX != p_heap->ordering) || (0 == p_heap->size)){
+        return NULL;
+    }
+    heap_entry entry;
+    heap_take(p_heap, heap_max_index(p_heap), &entry);
+    return entry.p_data;
+}
+
+/*
+ * @brief removes up to k elements from the root of a heap in order, handles
+ *  of the elements are left to the caller to free as with heap_pop
+ * @param p_heap the heap to drain
+ * @param pp_out array of at least k entries receiving the data in order
+ * @param k the most elements to remove
+ * @return the number of elements removed or -1 on error
+ */
+int64_t heap_pull_n(heap * p_heap, void ** pp_out, int64_t k)
+{
+    if ((NULL == p_heap) || (NULL == pp_out) || (k < 0)){
+        return -1;
+    }
+    if (k > p_heap->size){
+        k = p_heap->size;
+    }
+    heap_entry root;
+    for (int64_t index = 0; index < k; index++){
+        heap_take_root(p_heap, &root);
+        pp_out[index] = root.p_data;
+    }
+    return k;
+}
+
+/*
+ * @brief offers data to a heap, a heap from heap_topk that is full only keeps
+ *  the data if it beats the root which is then pushed out with the user
+ *  defined destroy run on its data and any handle left to the caller as with
+ *  heap_pop, other heaps always keep the data
+ * @param p_heap the heap to offer the data to
+ * @param p_data the data to offer, rejected data stays with the caller
+ * @return 1 if the data was kept 0 if it was rejected or -1 on error
+ */
+int8_t heap_offer(heap * p_heap, void * p_data)
+{
+    // cant offer to a null heap or from null data
+    if ((NULL == p_heap) || (NULL == p_data)){
+        return -1;
+    }
+    if ((0 == p_heap->limit) || (p_heap->size < p_heap->limit)){
+        return (0 == heap_push(p_heap, p_data)) ? 1 : -1;
+    }
+    // the root is the worst element kept and ties keep the older element
+    if (!heap_before(p_heap, p_heap->p_array[0].p_data, p_data)){
+        return 0;
+    }
+    heap_entry root = p_heap->p_array[0];
+    heap_entry entry = {p_data, NULL};
+    if (NULL != root.p_node){
+        root.p_node->index = -1;
+    }
+    heap_place(p_heap, 0, entry);
+    heap_bubble_down(p_heap, 0);
+    if (NULL != p_heap->destroy){
+        p_heap->destroy(root.p_data);
+    }
+    return 1;
+}
+
+/*
+ * @brief empties a heap into an array in the reverse of the order it would be
+ *  pulled in, for a heap from heap_topk this puts the best element first,
+ *  handles of the elements are left to the caller to free as with heap_pop
+ * @param p_heap the heap to empty
+ * @param pp_out array of at least heap_size entries receiving the data
+ * @return the number of elements written or -1 on error
+ */
+int64_t heap_topk_sorted(heap * p_heap, void ** pp_out)
+{
+    if ((NULL == p_heap) || (NULL == pp_out)){
+        return -1;
+    }
+    int64_t count = p_heap->size;
+    heap_entry root;
+    for (int64_t index = count - 1; index >= 0; index--){
+        heap_take_root(p_heap, &root);
+        pp_out[index] = root.p_data;
+    }
+    return count;
+}
+
+/*
+ * @brief moves a node after the key in its data was changed, the node is
+ *  moved toward the root or the leaves as the new key requires
+ * @param p_heap the heap the node is in
+ * @param p_node the handle of the changed node
+ * @return 0 on success or -1 if the node is not in the heap
+ */
+int8_t heap_update(heap * p_heap, hnode * p_node)
+{
+    // only nodes that are still in this heap can be moved
+    if (!heap_owns(p_heap, p_node)){
+        return -1;
+    }
+    heap_restore(p_heap, p_node->index);
+    return 0;
+}
+
+/*
+ * @brief removes any node from a heap, the user defined destroy is run on its
+ *  data and the handle is freed
+ * @param p_heap the heap to remove the node from
+ * @param p_node the handle of the node to remove
+ * @return 0 on success or -1 if the node is not in the heap
+ */
+int8_t heap_remove(heap * p_heap, hnode * p_node)
+{
+    // only nodes that are still in this heap can be removed
+    if (!heap_owns(p_heap, p_node)){
+        return -1;
+    }
+    heap_entry entry;
+    heap_take(p_heap, p_node->index, &entry);
+    if (NULL != p_heap->destroy){
+        p_heap->destroy(p_node->p_data);
+    }
+    free(p_node);
+    return 0;
 }
 
 /*
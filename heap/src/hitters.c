@@ -0,0 +1,275 @@
+#include <hitters.h>
+#include <heap.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+ * @brief a monitored key of a heavy hitters tracker
+ * @param p_key the key being counted
+ * @param count the estimated number of times the key was seen
+ * @param error how much of count may have been inherited from the key the
+ *  counter was taken from
+ * @param p_node the handle of the counter in the heap of counters
+ */
+typedef struct hitters_counter {
+    void * p_key;
+    uint64_t count;
+    uint64_t error;
+    hnode * p_node;
+} hitters_counter;
+
+/*
+ * @brief a space saving heavy hitters tracker, k counters are kept in a min
+ *  heap so the smallest can be taken over by a new key in O(log k) and a
+ *  hash table finds the counter of a key
+ * @param k the number of counters
+ * @param size the number of counters in use
+ * @param destroy the tear down function for the keys
+ * @param compare the user defined compare function returning 0 for equal keys
+ * @param hash the user defined hash function for the keys
+ * @param p_counters the counters
+ * @param p_heap the counters in use ordered by count
+ * @param pp_table open addressed table of the counters in use by key
+ * @param mask the number of table slots minus one
+ */
+struct hitters {
+    int64_t k;
+    int64_t size;
+    void (* destroy)(void * p_key);
+    int (* compare)(void * p_key1, void * p_key2);
+    uint32_t (* hash)(void * p_key);
+    hitters_counter * p_counters;
+    heap * p_heap;
+    hitters_counter ** pp_table;
+    uint64_t mask;
+};
+
+/*
+ * @brief orders counters by their count
+ * @param p_key1 the first counter
+ * @param p_key2 the second counter
+ * @return -1 0 or 1 as the first count is below equal to or above the second
+ */
+static int8_t hitters_compare(void * p_key1, void * p_key2)
+{
+    uint64_t count1 = ((hitters_counter *)p_key1)->count;
+    uint64_t count2 = ((hitters_counter *)p_key2)->count;
+    return (count1 < count2) ? -1 : ((count1 == count2) ? 0 : 1);
+}
+
+/*
+ * @brief finds the table slot of a key or the empty slot it would go in
+ * @param p_hitters the tracker to search
+ * @param p_key the key to find
+ * @return the index of the slot
+ */
+static uint64_t hitters_slot(hitters * p_hitters, void * p_key)
+{
+    uint64_t slot = p_hitters->hash(p_key) & p_hitters->mask;
+    while ((NULL != p_hitters->pp_table[slot]) && (0 != p_hitters->compare(p_hitters->pp_table[slot]->p_key, p_key))){
+        slot = (slot + 1) & p_hitters->mask;
+    }
+    return slot;
+}
+
+/*
+ * @brief removes the counter in a table slot shifting later entries of the
+ *  probe run back so no tombstones are needed
+ * @param p_hitters the tracker to remove from
+ * @param slot the slot to empty
+ */
+static void hitters_unmap(hitters * p_hitters, uint64_t slot)
+{
+    uint64_t next = (slot + 1) & p_hitters->mask;
+    while (NULL != p_hitters->pp_table[next]){
+        uint64_t home = p_hitters->hash(p_hitters->pp_table[next]->p_key) & p_hitters->mask;
+        // move the entry back if the empty slot lies between its home and it
+        if (((next - home) & p_hitters->mask) >= ((next - slot) & p_hitters->mask)){
+            p_hitters->pp_table[slot] = p_hitters->pp_table[next];
+            slot = next;
+        }
+        next = (next + 1) & p_hitters->mask;
+    }
+    p_hitters->pp_table[slot] = NULL;
+}
+
+/*
+ * @brief allocate and initialize a heavy hitters tracker
+ * @param k the number of keys monitored, any key seen more than n / k times
+ *  in a stream of n keys is guaranteed to be monitored
+ * @param destroy user defined function to tear down keys the tracker stops
+ *  monitoring
+ * @param compare user defined function returning 0 when two keys are equal
+ * @param hash user defined function to hash a key
+ * @return a newly initialized tracker or NULL on error
+ */
+hitters * hitters_init(int64_t k, void (* destroy)(void * p_key), int (* compare)(void * p_key1, void * p_key2), uint32_t (* hash)(void * p_key))
+{
+    if ((k < 1) || (NULL == compare) || (NULL == hash)){
+        return NULL;
+    }
+    hitters * p_hitters = calloc(1, sizeof(*p_hitters));
+    if (NULL == p_hitters){
+        return NULL;
+    }
+    p_hitters->k = k;
+    p_hitters->size = 0;
+    p_hitters->destroy = destroy;
+    p_hitters->compare = compare;
+    p_hitters->hash = hash;
+    // keep the table at most half full
+    uint64_t slots = 2;
+    while (slots < (uint64_t)k * 2){
+        slots *= 2;
+    }
+    p_hitters->mask = slots - 1;
+    p_hitters->p_counters = calloc(k, sizeof(*p_hitters->p_counters));
+    p_hitters->pp_table = calloc(slots, sizeof(*p_hitters->pp_table));
+    p_hitters->p_heap = heap_init(MIN, 4, NULL, hitters_compare);
+    if ((NULL == p_hitters->p_counters) || (NULL == p_hitters->pp_table) \
+        || (NULL == p_hitters->p_heap) || (0 != heap_reserve(p_hitters->p_heap, k))){
+        hitters_destroy(p_hitters);
+        return NULL;
+    }
+    return p_hitters;
+}
+
+/*
+ * @brief tear down a heavy hitters tracker and the keys it monitors
+ * @param p_hitters the tracker to tear down
+ */
+void hitters_destroy(hitters * p_hitters)
+{
+    // cant destroy a NULL tracker
+    if (NULL == p_hitters){
+        return;
+    }
+    for (int64_t index = 0; (NULL != p_hitters->destroy) && (index < p_hitters->size); index++){
+        p_hitters->destroy(p_hitters->p_counters[index].p_key);
+    }
+    heap_destroy(p_hitters->p_heap);
+    free(p_hitters->pp_table);
+    free(p_hitters->p_counters);
+    free(p_hitters);
+}
+
+/*
+ * @brief gets the number of keys a heavy hitters tracker monitors
+ * @param p_hitters the tracker to get the size of
+ * @return the number of monitored keys or -1 on error
+ */
+int64_t hitters_size(hitters * p_hitters)
+{
+    if (NULL == p_hitters){
+        return -1;
+    }
+    return p_hitters->size;
+}
+
+/*
+ * @brief counts one occurrence of a key, once every counter is in use an
+ *  unmonitored key takes over the smallest counter adding one to its count
+ * @param p_hitters the tracker to count the key in
+ * @param p_key the key seen
+ * @return 1 if the tracker took ownership of the key 0 if an equal key was
+ *  already monitored and the key stays with the caller or -1 on error
+ */
+int8_t hitters_observe(hitters * p_hitters, void * p_key)
+{
+    // cant count in a NULL tracker or a NULL key
+    if ((NULL == p_hitters) || (NULL == p_key)){
+        return -1;
+    }
+    uint64_t slot = hitters_slot(p_hitters, p_key);
+    hitters_counter * p_counter = p_hitters->pp_table[slot];
+    if (NULL != p_counter){
+        p_counter->count++;
+        heap_update(p_hitters->p_heap, p_counter->p_node);
+        return 0;
+    }
+    if (p_hitters->size < p_hitters->k){
+        p_counter = &p_hitters->p_counters[p_hitters->size];
+        p_counter->p_key = p_key;
+        p_counter->count = 1;
+        p_counter->error = 0;
+        p_counter->p_node = heap_insert(p_hitters->p_heap, p_counter);
+        if (NULL == p_counter->p_node){
+            return -1;
+        }
+        p_hitters->size++;
+        p_hitters->pp_table[slot] = p_counter;
+        return 1;
+    }
+    // the smallest counter is handed over to the new key
+    p_counter = heap_data(heap_peek(p_hitters->p_heap));
+    hitters_unmap(p_hitters, hitters_slot(p_hitters, p_counter->p_key));
+    if (NULL != p_hitters->destroy){
+        p_hitters->destroy(p_counter->p_key);
+    }
+    p_counter->p_key = p_key;
+    p_counter->error = p_counter->count;
+    p_counter->count++;
+    heap_update(p_hitters->p_heap, p_counter->p_node);
+    p_hitters->pp_table[hitters_slot(p_hitters, p_key)] = p_counter;
+    return 1;
+}
+
+/*
+ * @brief gets the estimated count of a key, the estimate never undercounts a
+ *  monitored key and overcounts it by at most its error
+ * @param p_hitters the tracker to look in
+ * @param p_key the key to look up
+ * @param p_error set to the error of the estimate when not NULL
+ * @return the estimated count or 0 if the key is not monitored
+ */
+uint64_t hitters_count(hitters * p_hitters, void * p_key, uint64_t * p_error)
+{
+    if ((NULL == p_hitters) || (NULL == p_key)){
+        return 0;
+    }
+    hitters_counter * p_counter = p_hitters->pp_table[hitters_slot(p_hitters, p_key)];
+    if (NULL == p_counter){
+        return 0;
+    }
+    if (NULL != p_error){
+        *p_error = p_counter->error;
+    }
+    return p_counter->count;
+}
+
+/*
+ * @brief gets the monitored keys with the highest counts, selected through
+ *  a bounded heap from heap_topk
+ * @param p_hitters the tracker to report on
+ * @param n the most keys to report
+ * @param pp_keys array of at least n entries receiving the keys highest
+ *  count first
+ * @param p_counts array of at least n entries receiving the counts or NULL
+ * @return the number of keys reported or -1 on error
+ */
+int64_t hitters_top(hitters * p_hitters, int64_t n, void ** pp_keys, uint64_t * p_counts)
+{
+    if ((NULL == p_hitters) || (NULL == pp_keys) || (n < 1)){
+        return -1;
+    }
+    heap * p_top = heap_topk(MAX, n, NULL, hitters_compare);
+    if (NULL == p_top){
+        return -1;
+    }
+    for (int64_t index = 0; index < p_hitters->size; index++){
+        heap_offer(p_top, &p_hitters->p_counters[index]);
+    }
+    int64_t count = heap_topk_sorted(p_top, pp_keys);
+    heap_destroy(p_top);
+    // swap the counters for their keys in place
+    for (int64_t index = 0; index < count; index++){
+        hitters_counter * p_counter = pp_keys[index];
+        if (NULL != p_counts){
+            p_counts[index] = p_counter->count;
+        }
+        pp_keys[index] = p_counter->p_key;
+    }
+    return count;
+}
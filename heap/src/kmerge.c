@@ -0,0 +1,493 @@
+#include <kmerge.h>
+#include <heap.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * @param BLOCK_BYTES the most bytes read from or written to a file at once
+ * @param MIN_FANOUT the fewest runs a file sort merges at once
+ */
+enum {BLOCK_BYTES = 1 << 16, MIN_FANOUT = 2};
+
+/*
+ * @brief a source reading items from an array
+ * @param pp_items the items of the array
+ * @param count the number of items
+ * @param position the index of the next item
+ */
+typedef struct kmerge_array {
+    void ** pp_items;
+    int64_t count;
+    int64_t position;
+} kmerge_array;
+
+/*
+ * @brief a source reading records from a file a block at a time
+ * @param p_file the file to read
+ * @param record_size the number of bytes in a record
+ * @param block the number of records the buffer has room for
+ * @param unread the number of records still in the file
+ * @param count the number of records in the buffer
+ * @param position the index of the next record in the buffer
+ * @param p_buffer the block of records read from the file
+ */
+typedef struct kmerge_file {
+    FILE * p_file;
+    size_t record_size;
+    int64_t block;
+    int64_t unread;
+    int64_t count;
+    int64_t position;
+    char * p_buffer;
+} kmerge_file;
+
+/*
+ * @brief a k-way merge driven by a tree of losers, every internal node keeps
+ *  the source that lost the match played there so replacing the winner only
+ *  replays the matches on the path from its leaf to the root
+ * @param ordering either min or max ordering
+ * @param k the number of sources
+ * @param pp_sources the sources
+ * @param next the user defined function giving the next item of a source
+ * @param compare the user defined compare function for two items
+ * @param pp_heads the current item of each source or NULL once it is empty
+ * @param p_tree the loser of each internal node with the winner in node 0
+ * @param p_arrays the array sources made by kmerge_init_arrays or NULL
+ */
+struct kmerge {
+    int ordering;
+    int64_t k;
+    void ** pp_sources;
+    void * (* next)(void * p_source);
+    int8_t (* compare)(void * p_key1, void * p_key2);
+    void ** pp_heads;
+    int64_t * p_tree;
+    kmerge_array * p_arrays;
+};
+
+/*
+ * @brief checks if one source has to be merged before another, empty
+ *  sources lose every match and ties go to the lower source so the merge
+ *  is stable
+ * @param p_merge the merge the sources are in
+ * @param first the first source
+ * @param second the second source
+ * @return true if the head of first goes out before the head of second
+ */
+static bool kmerge_beats(kmerge * p_merge, int64_t first, int64_t second)
+{
+    void * p_first = p_merge->pp_heads[first];
+    void * p_second = p_merge->pp_heads[second];
+    if ((NULL == p_first) || (NULL == p_second)){
+        return (NULL != p_first) || ((NULL == p_second) && (first < second));
+    }
+    int8_t cmpval = p_merge->compare(p_first, p_second);
+    if (0 == cmpval){
+        return first < second;
+    }
+    return (MIN == p_merge->ordering) ? (cmpval < 0) : (cmpval > 0);
+}
+
+/*
+ * @brief plays the matches of every internal node once to fill the tree
+ * @param p_merge the merge to set up
+ * @return 0 on success else -1
+ */
+static int8_t kmerge_build(kmerge * p_merge)
+{
+    int64_t k = p_merge->k;
+    // the winners of the subtrees are only needed while building
+    int64_t * p_winners = malloc(2 * k * sizeof(*p_winners));
+    if (NULL == p_winners){
+        perror("kmerge build ");
+        return -1;
+    }
+    for (int64_t index = 0; index < k; index++){
+        p_winners[k + index] = index;
+    }
+    for (int64_t node = k - 1; node > 0; node--){
+        int64_t left = p_winners[2 * node];
+        int64_t right = p_winners[(2 * node) + 1];
+        bool b_left = kmerge_beats(p_merge, left, right);
+        p_winners[node] = b_left ? left : right;
+        p_merge->p_tree[node] = b_left ? right : left;
+    }
+    p_merge->p_tree[0] = (1 == k) ? 0 : p_winners[1];
+    free(p_winners);
+    return 0;
+}
+
+/*
+ * @brief moves the winning source to its next item and replays its path
+ * @param p_merge the merge to move along
+ */
+static void kmerge_advance(kmerge * p_merge)
+{
+    int64_t winner = p_merge->p_tree[0];
+    p_merge->pp_heads[winner] = p_merge->next(p_merge->pp_sources[winner]);
+    for (int64_t node = (winner + p_merge->k) >> 1; node > 0; node >>= 1){
+        if (kmerge_beats(p_merge, p_merge->p_tree[node], winner)){
+            int64_t loser = winner;
+            winner = p_merge->p_tree[node];
+            p_merge->p_tree[node] = loser;
+        }
+    }
+    p_merge->p_tree[0] = winner;
+}
+
+/*
+ * @brief gets the next item of an array source
+ * @param p_source the array source
+ * @return the next item or NULL at the end of the array
+ */
+static void * kmerge_array_next(void * p_source)
+{
+    kmerge_array * p_array = p_source;
+    if (p_array->position >= p_array->count){
+        return NULL;
+    }
+    return p_array->pp_items[p_array->position++];
+}
+
+/*
+ * @brief gets the next record of a file source, the record stays valid
+ *  until the next call
+ * @param p_source the file source
+ * @return pointer to the record or NULL at the end of the file or on error
+ */
+static void * kmerge_file_next(void * p_source)
+{
+    kmerge_file * p_file = p_source;
+    if (p_file->position == p_file->count){
+        int64_t count = (p_file->unread < p_file->block) ? p_file->unread : p_file->block;
+        if ((0 == count) || ((int64_t)fread(p_file->p_buffer, p_file->record_size, count, p_file->p_file) != count)){
+            return NULL;
+        }
+        p_file->unread -= count;
+        p_file->count = count;
+        p_file->position = 0;
+    }
+    return p_file->p_buffer + (p_file->position++ * p_file->record_size);
+}
+
+/*
+ * @brief allocate a k-way merge over sources read through a callback
+ * @param ordering integer identifying if the output should be ascending or descending 0 or 1 respectively
+ * @param k the number of sources
+ * @param pp_sources the sources handed to next, each already in order
+ * @param next user defined function returning the next item of a source
+ *  or NULL once it is empty, items must stay valid after later calls
+ * @param compare user defined function to compare two items should return -1 0 or 1
+ * @return a newly initialized merge or NULL on error
+ */
+kmerge * kmerge_init(int ordering, int64_t k, void ** pp_sources, void * (* next)(void * p_source), int8_t (* compare)(void * p_key1, void * p_key2))
+{
+    if ((k < 1) || (NULL == pp_sources) || (NULL == next) || (NULL == compare)){
+        return NULL;
+    }
+    kmerge * p_merge = calloc(1, sizeof(*p_merge));
+    if (NULL == p_merge){
+        return NULL;
+    }
+    p_merge->ordering = ordering;
+    p_merge->k = k;
+    p_merge->next = next;
+    p_merge->compare = compare;
+    p_merge->pp_sources = malloc(k * sizeof(*p_merge->pp_sources));
+    p_merge->pp_heads = malloc(k * sizeof(*p_merge->pp_heads));
+    p_merge->p_tree = malloc(k * sizeof(*p_merge->p_tree));
+    if ((NULL == p_merge->pp_sources) || (NULL == p_merge->pp_heads) || (NULL == p_merge->p_tree)){
+        kmerge_destroy(p_merge);
+        return NULL;
+    }
+    for (int64_t index = 0; index < k; index++){
+        p_merge->pp_sources[index] = pp_sources[index];
+        p_merge->pp_heads[index] = next(pp_sources[index]);
+    }
+    if (0 != kmerge_build(p_merge)){
+        kmerge_destroy(p_merge);
+        return NULL;
+    }
+    return p_merge;
+}
+
+/*
+ * @brief allocate a k-way merge over arrays of items
+ * @param ordering integer identifying if the output should be ascending or descending 0 or 1 respectively
+ * @param k the number of arrays
+ * @param ppp_arrays the arrays, each already in order
+ * @param p_counts the number of items in each array
+ * @param compare user defined function to compare two items should return -1 0 or 1
+ * @return a newly initialized merge or NULL on error
+ */
+kmerge * kmerge_init_arrays(int ordering, int64_t k, void *** ppp_arrays, int64_t * p_counts, int8_t (* compare)(void * p_key1, void * p_key2))
+{
+    if ((k < 1) || (NULL == ppp_arrays) || (NULL == p_counts)){
+        return NULL;
+    }
+    kmerge_array * p_arrays = calloc(k, sizeof(*p_arrays));
+    void ** pp_sources = calloc(k, sizeof(*pp_sources));
+    if ((NULL == p_arrays) || (NULL == pp_sources)){
+        free(p_arrays);
+        free(pp_sources);
+        return NULL;
+    }
+    for (int64_t index = 0; index < k; index++){
+        p_arrays[index].pp_items = ppp_arrays[index];
+        p_arrays[index].count = (NULL == ppp_arrays[index]) ? 0 : p_counts[index];
+        p_arrays[index].position = 0;
+        pp_sources[index] = &p_arrays[index];
+    }
+    kmerge * p_merge = kmerge_init(ordering, k, pp_sources, kmerge_array_next, compare);
+    free(pp_sources);
+    if (NULL == p_merge){
+        free(p_arrays);
+        return NULL;
+    }
+    p_merge->p_arrays = p_arrays;
+    return p_merge;
+}
+
+/*
+ * @brief tear down a k-way merge, the sources are left to the caller
+ * @param p_merge the merge to tear down
+ */
+void kmerge_destroy(kmerge * p_merge)
+{
+    // cant destroy a NULL merge
+    if (NULL == p_merge){
+        return;
+    }
+    free(p_merge->p_arrays);
+    free(p_merge->p_tree);
+    free(p_merge->pp_heads);
+    free(p_merge->pp_sources);
+    free(p_merge);
+}
+
+/*
+ * @brief pulls the next batch of items of a k-way merge in order
+ * @param p_merge the merge to pull from
+ * @param pp_out array of at least batch entries receiving the items
+ * @param batch the most items to pull
+ * @return the number of items pulled, 0 once every source is empty, or -1 on error
+ */
+int64_t kmerge_pull(kmerge * p_merge, void ** pp_out, int64_t batch)
+{
+    if ((NULL == p_merge) || (NULL == pp_out) || (batch < 0)){
+        return -1;
+    }
+    int64_t count = 0;
+    while ((count < batch) && (NULL != p_merge->pp_heads[p_merge->p_tree[0]])){
+        pp_out[count++] = p_merge->pp_heads[p_merge->p_tree[0]];
+        kmerge_advance(p_merge);
+    }
+    return count;
+}
+
+/*
+ * @brief sorts records with a top down merge sort
+ * @param p_records the records to sort
+ * @param p_scratch room for as many records
+ * @param count the number of records
+ * @param record_size the number of bytes in a record
+ * @param compare user defined function to compare two records
+ */
+static void kmerge_sort_records(char * p_records, char * p_scratch, int64_t count, size_t record_size, int8_t (* compare)(void * p_key1, void * p_key2))
+{
+    if (count < 2){
+        return;
+    }
+    int64_t half = count / 2;
+    kmerge_sort_records(p_records, p_scratch, half, record_size, compare);
+    kmerge_sort_records(p_records + (half * record_size), p_scratch, count - half, record_size, compare);
+    // the halves are already in order when the last of the first does not
+    // come after the first of the second
+    if (compare(p_records + ((half - 1) * record_size), p_records + (half * record_size)) <= 0){
+        return;
+    }
+    memcpy(p_scratch, p_records, half * record_size);
+    char * p_left = p_scratch;
+    char * p_left_end = p_scratch + (half * record_size);
+    char * p_right = p_records + (half * record_size);
+    char * p_right_end = p_records + (count * record_size);
+    char * p_out = p_records;
+    while ((p_left < p_left_end) && (p_right < p_right_end)){
+        if (compare(p_right, p_left) < 0){
+            memcpy(p_out, p_right, record_size);
+            p_right += record_size;
+        }
+        else {
+            memcpy(p_out, p_left, record_size);
+            p_left += record_size;
+        }
+        p_out += record_size;
+    }
+    memcpy(p_out, p_left, p_left_end - p_left);
+}
+
+/*
+ * @brief merges runs of records from temporary files into an output file
+ * @param pp_runs the files holding the runs
+ * @param p_counts the number of records in each run
+ * @param k the number of runs
+ * @param p_out the file to write to
+ * @param record_size the number of bytes in a record
+ * @param block the number of records buffered per run
+ * @param compare user defined function to compare two records
+ * @return 0 on success else -1
+ */
+static int8_t kmerge_runs(FILE ** pp_runs, int64_t * p_counts, int64_t k, FILE * p_out, size_t record_size, int64_t block, int8_t (* compare)(void * p_key1, void * p_key2))
+{
+    int8_t retval = -1;
+    kmerge_file * p_files = calloc(k, sizeof(*p_files));
+    void ** pp_sources = calloc(k, sizeof(*pp_sources));
+    char * p_buffers = malloc(k * block * record_size);
+    kmerge * p_merge = NULL;
+    if ((NULL != p_files) && (NULL != pp_sources) && (NULL != p_buffers)){
+        for (int64_t index = 0; index < k; index++){
+            rewind(pp_runs[index]);
+            p_files[index].p_file = pp_runs[index];
+            p_files[index].record_size = record_size;
+            p_files[index].block = block;
+            p_files[index].unread = p_counts[index];
+            // the buffer starts out used up so the first call reads a block
+            p_files[index].count = 0;
+            p_files[index].position = 0;
+            p_files[index].p_buffer = p_buffers + (index * block * record_size);
+            pp_sources[index] = &p_files[index];
+        }
+        p_merge = kmerge_init(MIN, k, pp_sources, kmerge_file_next, compare);
+    }
+    if (NULL != p_merge){
+        retval = 0;
+        // a record is written before its source reads past it
+        while ((0 == retval) && (NULL != p_merge->pp_heads[p_merge->p_tree[0]])){
+            if (1 != fwrite(p_merge->pp_heads[p_merge->p_tree[0]], record_size, 1, p_out)){
+                perror("kmerge write ");
+                retval = -1;
+            }
+            kmerge_advance(p_merge);
+        }
+        for (int64_t index = 0; index < k; index++){
+            if ((0 != p_files[index].unread) || ferror(pp_runs[index])){
+                retval = -1;
+            }
+        }
+    }
+    kmerge_destroy(p_merge);
+    free(p_buffers);
+    free(pp_sources);
+    free(p_files);
+    return retval;
+}
+
+/*
+ * @brief sorts a file of fixed size records larger than memory, sorted runs
+ *  are spilled to temporary files and merged through the loser tree in as
+ *  many passes as the memory allows
+ * @param p_in the file to read the records from
+ * @param p_out the file to write the sorted records to
+ * @param record_size the number of bytes in a record
+ * @param memory the bytes of records the sort may keep in memory
+ * @param compare user defined function to compare two records should return -1 0 or 1
+ * @return 0 on success else -1
+ */
+int8_t kmerge_sort_file(FILE * p_in, FILE * p_out, size_t record_size, size_t memory, int8_t (* compare)(void * p_key1, void * p_key2))
+{
+    if ((NULL == p_in) || (NULL == p_out) || (0 == record_size) || (NULL == compare)){
+        return -1;
+    }
+    // a run and its merge scratch share the memory
+    int64_t chunk = (memory / 2) / record_size;
+    int64_t block = (int64_t)(((memory < BLOCK_BYTES * MIN_FANOUT) ? memory / MIN_FANOUT : BLOCK_BYTES) / record_size);
+    if ((chunk < 1) || (block < 1)){
+        return -1;
+    }
+    int64_t fanout = (int64_t)(memory / (block * record_size));
+    char * p_records = malloc(chunk * 2 * record_size);
+    FILE ** pp_runs = NULL;
+    int64_t * p_counts = NULL;
+    int64_t runs = 0;
+    int64_t space = 0;
+    int8_t retval = (NULL == p_records) ? -1 : 0;
+    // sort the input a chunk at a time into runs
+    while (0 == retval){
+        int64_t count = (int64_t)fread(p_records, record_size, chunk, p_in);
+        if (0 == count){
+            retval = ferror(p_in) ? -1 : 0;
+            break;
+        }
+        if (runs == space){
+            space = (0 == space) ? 8 : space * 2;
+            FILE ** pp_grown = realloc(pp_runs, space * sizeof(*pp_runs));
+            pp_runs = (NULL == pp_grown) ? pp_runs : pp_grown;
+            int64_t * p_grown = realloc(p_counts, space * sizeof(*p_counts));
+            p_counts = (NULL == p_grown) ? p_counts : p_grown;
+            if ((NULL == pp_grown) || (NULL == p_grown)){
+                retval = -1;
+                break;
+            }
+        }
+        kmerge_sort_records(p_records, p_records + (chunk * record_size), count, record_size, compare);
+        pp_runs[runs] = tmpfile();
+        if (NULL == pp_runs[runs]){
+            perror("kmerge run ");
+            retval = -1;
+            break;
+        }
+        p_counts[runs] = count;
+        runs++;
+        if ((size_t)count != fwrite(p_records, record_size, count, pp_runs[runs - 1])){
+            retval = -1;
+        }
+    }
+    free(p_records);
+    // merge fanout runs at a time into a new run until one pass is enough
+    int64_t first = 0;
+    while ((0 == retval) && ((runs - first) > fanout)){
+        int64_t merging = fanout;
+        FILE * p_run = tmpfile();
+        if ((NULL == p_run) || (0 != kmerge_runs(pp_runs + first, p_counts + first, merging, p_run, record_size, block, compare))){
+            if (NULL != p_run){
+                fclose(p_run);
+            }
+            retval = -1;
+            break;
+        }
+        int64_t count = 0;
+        for (int64_t index = first; index < first + merging; index++){
+            count += p_counts[index];
+            fclose(pp_runs[index]);
+        }
+        first += merging;
+        // the merged run goes to the back so every run gets merged once a pass
+        if (runs == space){
+            space *= 2;
+            FILE ** pp_grown = realloc(pp_runs, space * sizeof(*pp_runs));
+            pp_runs = (NULL == pp_grown) ? pp_runs : pp_grown;
+            int64_t * p_grown = realloc(p_counts, space * sizeof(*p_counts));
+            p_counts = (NULL == p_grown) ? p_counts : p_grown;
+            if ((NULL == pp_grown) || (NULL == p_grown)){
+                fclose(p_run);
+                retval = -1;
+                break;
+            }
+        }
+        pp_runs[runs] = p_run;
+        p_counts[runs] = count;
+        runs++;
+    }
+    if ((0 == retval) && (runs > first)){
+        retval = kmerge_runs(pp_runs + first, p_counts + first, runs - first, p_out, record_size, block, compare);
+    }
+    for (int64_t index = first; index < runs; index++){
+        fclose(pp_runs[index]);
+    }
+    free(pp_runs);
+    free(p_counts);
+    return (0 == retval) ? ((0 == fflush(p_out)) ? 0 : -1) : -1;
+}
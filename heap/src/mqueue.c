@@ -0,0 +1,265 @@
+#include <mqueue.h>
+#include <heap.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+/*
+ * @param LINE the cache line size each lane is padded to
+ * @param ARITY the arity of the heap inside each lane
+ * @param SCAN_AFTER the number of failed random picks before a pull checks
+ *  every lane to find out if the queue is empty
+ */
+enum {LINE = 64, ARITY = 4, SCAN_AFTER = 8};
+
+/*
+ * @brief one of the heaps making up a multiqueue, a lane only has a single
+ *  owner at a time and threads move on to another lane instead of waiting
+ * @param b_locked true while a thread owns the lane
+ * @param b_empty hint read without the lock so empty lanes can be skipped
+ * @param p_heap the heap of the lane
+ */
+typedef struct mqueue_lane {
+    _Alignas(LINE) atomic_bool b_locked;
+    atomic_bool b_empty;
+    heap * p_heap;
+} mqueue_lane;
+
+/*
+ * @brief a relaxed concurrent priority queue made of several heaps
+ * @param ordering either min or max ordering
+ * @param count the number of lanes
+ * @param size the number of elements in the queue
+ * @param compare the user defined compare function
+ * @param p_lanes the lanes of the queue
+ */
+struct mqueue {
+    int ordering;
+    int count;
+    atomic_llong size;
+    int8_t (* compare)(void * p_key1, void * p_key2);
+    mqueue_lane * p_lanes;
+};
+
+/*
+ * @brief draws a random lane index from a generator private to the thread
+ * @param count the number of lanes
+ * @return a lane index below count
+ */
+static int mqueue_random(int count)
+{
+    static atomic_ullong seeds = 0x9e3779b97f4a7c15;
+    static _Thread_local uint64_t state = 0;
+    if (0 == state){
+        state = atomic_fetch_add(&seeds, 0x9e3779b97f4a7c15) | 1;
+    }
+    // xorshift64
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return (int)(state % (uint64_t)count);
+}
+
+/*
+ * @brief tries to take ownership of a lane without waiting
+ * @param p_lane the lane to take
+ * @return true if the lane is now owned by the caller
+ */
+static bool mqueue_try_lock(mqueue_lane * p_lane)
+{
+    if (atomic_load_explicit(&p_lane->b_locked, memory_order_relaxed)){
+        return false;
+    }
+    return !atomic_exchange_explicit(&p_lane->b_locked, true, memory_order_acquire);
+}
+
+/*
+ * @brief gives up ownership of a lane
+ * @param p_lane the lane to release
+ */
+static void mqueue_unlock(mqueue_lane * p_lane)
+{
+    atomic_store_explicit(&p_lane->b_empty, (0 == heap_size(p_lane->p_heap)), memory_order_relaxed);
+    atomic_store_explicit(&p_lane->b_locked, false, memory_order_release);
+}
+
+/*
+ * @brief checks if data belongs above other data based on the queue ordering
+ * @param p_queue the queue providing the ordering and compare function
+ * @param p_key1 the data to check
+ * @param p_key2 the data to check against
+ * @return true if p_key1 should be pulled before p_key2
+ */
+static bool mqueue_before(mqueue * p_queue, void * p_key1, void * p_key2)
+{
+    int8_t cmpval = p_queue->compare(p_key1, p_key2);
+    return (MIN == p_queue->ordering) ? (cmpval < 0) : (cmpval > 0);
+}
+
+/*
+ * @brief allocate and initialize a multiqueue
+ * @param ordering integer identifying if the queue should be min or max 0 or 1 respectively
+ * @param threads the number of threads expected to use the queue
+ * @param factor the number of lanes per thread, more lanes mean less
+ *  contention but pulls drift further from the exact root
+ * @param destroy user defined function to tear down the data left in the queue
+ * @param compare user defined function to compare the data should return -1 0 or 1
+ * @return a newly initialized queue or NULL on error
+ */
+mqueue * mqueue_init(int ordering, int threads, int factor, void (* destroy)(void * p_data), int8_t (* compare)(void * p_key1, void * p_key2))
+{
+    // a compare function and at least one lane are needed
+    if ((NULL == compare) || (threads < 1) || (factor < 1)){
+        return NULL;
+    }
+    mqueue * p_queue = calloc(1, sizeof(*p_queue));
+    if (NULL == p_queue){
+        return NULL;
+    }
+    p_queue->ordering = ordering;
+    p_queue->count = threads * factor;
+    p_queue->compare = compare;
+    atomic_init(&p_queue->size, 0);
+    p_queue->p_lanes = aligned_alloc(LINE, p_queue->count * sizeof(mqueue_lane));
+    if (NULL == p_queue->p_lanes){
+        free(p_queue);
+        return NULL;
+    }
+    for (int index = 0; index < p_queue->count; index++){
+        mqueue_lane * p_lane = &p_queue->p_lanes[index];
+        atomic_init(&p_lane->b_locked, false);
+        atomic_init(&p_lane->b_empty, true);
+        p_lane->p_heap = heap_init(ordering, ARITY, destroy, compare);
+        if (NULL == p_lane->p_heap){
+            p_queue->count = index;
+            mqueue_destroy(p_queue);
+            return NULL;
+        }
+    }
+    return p_queue;
+}
+
+/*
+ * @brief tear down a multiqueue, no thread may be using it
+ * @param p_queue the queue to tear down
+ */
+void mqueue_destroy(mqueue * p_queue)
+{
+    // cant destroy a NULL queue
+    if (NULL == p_queue){
+        return;
+    }
+    for (int index = 0; index < p_queue->count; index++){
+        heap_destroy(p_queue->p_lanes[index].p_heap);
+    }
+    free(p_queue->p_lanes);
+    free(p_queue);
+}
+
+/*
+ * @brief gets the number of elements in a multiqueue, the value may be stale
+ *  while other threads use the queue
+ * @param p_queue the queue to get the size of
+ * @return the size of the queue or -1 on error
+ */
+int64_t mqueue_size(mqueue * p_queue)
+{
+    if (NULL == p_queue){
+        return -1;
+    }
+    return atomic_load_explicit(&p_queue->size, memory_order_relaxed);
+}
+
+/*
+ * @brief adds data to a random lane of a multiqueue, safe to call from any
+ *  number of threads
+ * @param p_queue the queue to add the data to
+ * @param p_data the data to add
+ * @return 0 on success else -1
+ */
+int8_t mqueue_insert(mqueue * p_queue, void * p_data)
+{
+    // cant insert into a null queue or from null data
+    if ((NULL == p_queue) || (NULL == p_data)){
+        return -1;
+    }
+    mqueue_lane * p_lane = NULL;
+    do {
+        p_lane = &p_queue->p_lanes[mqueue_random(p_queue->count)];
+    } while (!mqueue_try_lock(p_lane));
+    int8_t retval = heap_push(p_lane->p_heap, p_data);
+    mqueue_unlock(p_lane);
+    if (0 == retval){
+        atomic_fetch_add_explicit(&p_queue->size, 1, memory_order_relaxed);
+    }
+    return retval;
+}
+
+/*
+ * @brief removes the better root of two random lanes of a multiqueue, safe to
+ *  call from any number of threads, the result is close to but not always
+ *  the exact root of the whole queue
+ * @param p_queue the queue to pull from
+ * @return the pulled data or NULL if the queue is empty
+ */
+void * mqueue_pull(mqueue * p_queue)
+{
+    if (NULL == p_queue){
+        return NULL;
+    }
+    int misses = 0;
+    while (true){
+        mqueue_lane * p_first = &p_queue->p_lanes[mqueue_random(p_queue->count)];
+        mqueue_lane * p_second = &p_queue->p_lanes[mqueue_random(p_queue->count)];
+        // skip empty lanes without touching their data
+        if (atomic_load_explicit(&p_first->b_empty, memory_order_relaxed)){
+            p_first = p_second;
+        }
+        else if (atomic_load_explicit(&p_second->b_empty, memory_order_relaxed)){
+            p_second = p_first;
+        }
+        if (atomic_load_explicit(&p_first->b_empty, memory_order_relaxed)){
+            if (++misses < SCAN_AFTER){
+                continue;
+            }
+            // look for any lane that still holds data before giving up
+            misses = 0;
+            p_first = NULL;
+            for (int index = 0; index < p_queue->count; index++){
+                if (!atomic_load_explicit(&p_queue->p_lanes[index].b_empty, memory_order_relaxed)){
+                    p_first = &p_queue->p_lanes[index];
+                    break;
+                }
+            }
+            if (NULL == p_first){
+                return NULL;
+            }
+            p_second = p_first;
+        }
+        if (!mqueue_try_lock(p_first)){
+            continue;
+        }
+        // the roots are only compared while both lanes are owned so no other
+        // thread can pull and tear down the data being compared
+        mqueue_lane * p_best = p_first;
+        if ((p_second != p_first) && mqueue_try_lock(p_second)){
+            void * p_top = heap_top(p_second->p_heap);
+            if ((NULL != p_top) && ((0 == heap_size(p_first->p_heap)) \
+                || mqueue_before(p_queue, p_top, heap_top(p_first->p_heap)))){
+                p_best = p_second;
+                mqueue_unlock(p_first);
+            }
+            else {
+                mqueue_unlock(p_second);
+            }
+        }
+        void * p_data = heap_pop(p_best->p_heap);
+        mqueue_unlock(p_best);
+        if (NULL != p_data){
+            atomic_fetch_sub_explicit(&p_queue->size, 1, memory_order_relaxed);
+            return p_data;
+        }
+    }
+}
@@ -0,0 +1,413 @@
+#include <pheap.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+ * @param FIRST_BLOCK the number of nodes in the first block of the pool
+ * @param LAST_BLOCK the number of nodes blocks stop growing at
+ */
+enum {FIRST_BLOCK = 64, LAST_BLOCK = 4096};
+
+/*
+ * @brief a node in a pairing heap, the children of a node form a list
+ * @param p_data pointer to the data in the node or NULL while in the pool
+ * @param p_child the first child of the node
+ * @param p_next the next sibling of the node or the next free node in the pool
+ * @param p_prev the previous sibling of the node or its parent if it is the
+ *  first child, NULL for the root
+ */
+struct pheap_node {
+    void * p_data;
+    struct pheap_node * p_child;
+    struct pheap_node * p_next;
+    struct pheap_node * p_prev;
+};
+
+/*
+ * @brief a block of nodes allocated at once for the pool
+ * @param p_next the next block in the pool
+ * @param count the number of nodes in the block
+ * @param nodes the nodes of the block
+ */
+typedef struct pheap_block {
+    struct pheap_block * p_next;
+    int64_t count;
+    phnode nodes[];
+} pheap_block;
+
+/*
+ * @brief a pairing heap structure
+ * @param ordering either min or max ordering
+ * @param size the number of nodes in the heap
+ * @param destroy the tear down function for the data in a heap node
+ * @param compare the user defined compare function for the heap
+ * @param p_root the root node of the heap
+ * @param p_blocks the blocks of the node pool
+ * @param p_last_block the last block of the pool so a meld can splice it
+ * @param p_free the nodes in the pool that are not in the heap
+ * @param p_last_free the last free node so a meld can splice the free list
+ * @param block_size the number of nodes in the next block of the pool
+ */
+struct pheap {
+    int ordering;
+    int64_t size;
+    void (* destroy)(void * p_data);
+    int8_t (* compare)(void * p_key1, void * p_key2);
+    phnode * p_root;
+    pheap_block * p_blocks;
+    pheap_block * p_last_block;
+    phnode * p_free;
+    phnode * p_last_free;
+    int64_t block_size;
+};
+
+/*
+ * @brief checks if data belongs above other data based on the heap ordering
+ * @param p_heap the heap providing the ordering and compare function
+ * @param p_key1 the data to check
+ * @param p_key2 the data to check against
+ * @return true if p_key1 must be closer to the root than p_key2
+ */
+static bool pheap_before(pheap * p_heap, void * p_key1, void * p_key2)
+{
+    int8_t cmpval = p_heap->compare(p_key1, p_key2);
+    return (MIN == p_heap->ordering) ? (cmpval < 0) : (cmpval > 0);
+}
+
+/*
+ * @brief takes a node from the pool adding a block when the pool is empty
+ * @param p_heap the heap owning the pool
+ * @return a cleared node or NULL on error
+ */
+static phnode * pheap_node_alloc(pheap * p_heap)
+{
+    if (NULL == p_heap->p_free){
+        pheap_block * p_block = calloc(1, sizeof(*p_block) + (p_heap->block_size * sizeof(phnode)));
+        if (NULL == p_block){
+            perror("pheap block ");
+            return NULL;
+        }
+        p_block->count = p_heap->block_size;
+        p_block->p_next = p_heap->p_blocks;
+        p_heap->p_blocks = p_block;
+        if (NULL == p_heap->p_last_block){
+            p_heap->p_last_block = p_block;
+        }
+        // thread the new nodes onto the free list, the first one ends it
+        p_heap->p_last_free = &p_block->nodes[0];
+        for (int64_t index = 0; index < p_block->count; index++){
+            p_block->nodes[index].p_next = p_heap->p_free;
+            p_heap->p_free = &p_block->nodes[index];
+        }
+        if (p_heap->block_size < LAST_BLOCK){
+            p_heap->block_size *= 2;
+        }
+    }
+    phnode * p_node = p_heap->p_free;
+    p_heap->p_free = p_node->p_next;
+    if (NULL == p_heap->p_free){
+        p_heap->p_last_free = NULL;
+    }
+    p_node->p_next = NULL;
+    return p_node;
+}
+
+/*
+ * @brief returns a node to the pool
+ * @param p_heap the heap owning the pool
+ * @param p_node the node to return
+ */
+static void pheap_node_free(pheap * p_heap, phnode * p_node)
+{
+    p_node->p_data = NULL;
+    p_node->p_child = NULL;
+    p_node->p_prev = NULL;
+    p_node->p_next = p_heap->p_free;
+    p_heap->p_free = p_node;
+    if (NULL == p_heap->p_last_free){
+        p_heap->p_last_free = p_node;
+    }
+}
+
+/*
+ * @brief links two roots making the one that belongs lower the first child
+ *  of the other
+ * @param p_heap the heap providing the ordering
+ * @param p_first a root with no siblings
+ * @param p_second a root with no siblings
+ * @return the root of the linked tree
+ */
+static phnode * pheap_link(pheap * p_heap, phnode * p_first, phnode * p_second)
+{
+    if (NULL == p_first){
+        return p_second;
+    }
+    if (NULL == p_second){
+        return p_first;
+    }
+    if (pheap_before(p_heap, p_second->p_data, p_first->p_data)){
+        phnode * p_temp = p_first;
+        p_first = p_second;
+        p_second = p_temp;
+    }
+    p_second->p_prev = p_first;
+    p_second->p_next = p_first->p_child;
+    if (NULL != p_first->p_child){
+        p_first->p_child->p_prev = p_second;
+    }
+    p_first->p_child = p_second;
+    p_first->p_next = NULL;
+    p_first->p_prev = NULL;
+    return p_first;
+}
+
+/*
+ * @brief combines a list of siblings into one tree with the two pass
+ *  pairing strategy
+ * @param p_heap the heap providing the ordering
+ * @param p_first the first sibling of the list
+ * @return the root of the combined tree
+ */
+static phnode * pheap_merge_pairs(pheap * p_heap, phnode * p_first)
+{
+    phnode * p_pairs = NULL;
+    // first pass link siblings in pairs from left to right, the results are
+    // kept in reverse order for the second pass
+    while (NULL != p_first){
+        phnode * p_second = p_first->p_next;
+        phnode * p_rest = (NULL == p_second) ? NULL : p_second->p_next;
+        p_first->p_next = NULL;
+        p_first->p_prev = NULL;
+        if (NULL != p_second){
+            p_second->p_next = NULL;
+            p_second->p_prev = NULL;
+        }
+        phnode * p_pair = pheap_link(p_heap, p_first, p_second);
+        p_pair->p_next = p_pairs;
+        p_pairs = p_pair;
+        p_first = p_rest;
+    }
+    // second pass link the pairs from right to left into a single tree
+    phnode * p_root = NULL;
+    while (NULL != p_pairs){
+        phnode * p_next = p_pairs->p_next;
+        p_pairs->p_next = NULL;
+        p_root = pheap_link(p_heap, p_root, p_pairs);
+        p_pairs = p_next;
+    }
+    return p_root;
+}
+
+/*
+ * @brief allocate and initialize a pairing heap
+ * @param ordering integer identifying if the heap should be min or max heap 0 or 1 respectively
+ * @param destroy user defined function to tear down the nodes data
+ * @param compare user defined function to compare the data in the nodes should return -1 0 or 1
+ * @return a newly initialized heap or NULL on error
+ */
+pheap * pheap_init(int ordering, void (* destroy)(void * p_data), int8_t (* compare)(void * p_key1, void * p_key2))
+{
+    // a compare function must be passed
+    if (NULL == compare){
+        return NULL;
+    }
+    pheap * p_heap = calloc(1, sizeof(*p_heap));
+    if (NULL == p_heap){
+        return NULL;
+    }
+    p_heap->ordering = ordering;
+    p_heap->size = 0;
+    p_heap->destroy = destroy;
+    p_heap->compare = compare;
+    p_heap->p_root = NULL;
+    p_heap->p_blocks = NULL;
+    p_heap->p_last_block = NULL;
+    p_heap->p_free = NULL;
+    p_heap->p_last_free = NULL;
+    p_heap->block_size = FIRST_BLOCK;
+    return p_heap;
+}
+
+/*
+ * @brief tear down a pairing heap and every node in its pool
+ * @param p_heap the heap to tear down
+ */
+void pheap_destroy(pheap * p_heap)
+{
+    // cant destroy a NULL heap
+    if (NULL == p_heap){
+        return;
+    }
+    // nodes in the pool have no data so only nodes in the heap are torn down
+    pheap_block * p_block = p_heap->p_blocks;
+    while (NULL != p_block){
+        pheap_block * p_next = p_block->p_next;
+        for (int64_t index = 0; index < p_block->count; index++){
+            if ((NULL != p_heap->destroy) && (NULL != p_block->nodes[index].p_data)){
+                p_heap->destroy(p_block->nodes[index].p_data);
+            }
+        }
+        free(p_block);
+        p_block = p_next;
+    }
+    free(p_heap);
+}
+
+/*
+ * @brief gets the size of a pairing heap
+ * @param p_heap the heap to get the size of
+ * @return the size of the heap or -1 on error
+ */
+int64_t pheap_size(pheap * p_heap)
+{
+    if (NULL == p_heap){
+        return -1;
+    }
+    return p_heap->size;
+}
+
+/*
+ * @brief adds a new node to a pairing heap in O(1)
+ * @param p_heap the heap to insert the node into
+ * @param p_data the data of the new node
+ * @return the handle of the new node or NULL on error, the handle stays
+ *  valid until the node is pulled
+ */
+phnode * pheap_insert(pheap * p_heap, void * p_data)
+{
+    // cant insert into a null heap or from null data
+    if ((NULL == p_heap) || (NULL == p_data)){
+        return NULL;
+    }
+    phnode * p_node = pheap_node_alloc(p_heap);
+    if (NULL == p_node){
+        return NULL;
+    }
+    p_node->p_data = p_data;
+    p_heap->p_root = pheap_link(p_heap, p_heap->p_root, p_node);
+    p_heap->size++;
+    return p_node;
+}
+
+/*
+ * @brief gets the root of a pairing heap but does not remove it
+ * @param p_heap the heap to get the root from
+ * @return the root node or NULL if the heap is empty
+ */
+phnode * pheap_peek(pheap * p_heap)
+{
+    if (NULL == p_heap){
+        return NULL;
+    }
+    return p_heap->p_root;
+}
+
+/*
+ * @brief removes the root of a pairing heap, its node goes back to the pool
+ * @param p_heap the heap to get the root from
+ * @return the data of the old root or NULL if the heap is empty
+ */
+void * pheap_pull(pheap * p_heap)
+{
+    // cant get the root of a NULL or empty heap
+    if ((NULL == p_heap) || (NULL == p_heap->p_root)){
+        return NULL;
+    }
+    phnode * p_old_root = p_heap->p_root;
+    void * p_data = p_old_root->p_data;
+    p_heap->p_root = pheap_merge_pairs(p_heap, p_old_root->p_child);
+    pheap_node_free(p_heap, p_old_root);
+    p_heap->size--;
+    return p_data;
+}
+
+/*
+ * @brief moves a node toward the root in O(1) amortized after the key in its
+ *  data was changed so it belongs closer to the root, moving a key the
+ *  other way is not supported
+ * @param p_heap the heap the node is in
+ * @param p_node the handle of the changed node
+ * @return 0 on success else -1
+ */
+int8_t pheap_decrease_key(pheap * p_heap, phnode * p_node)
+{
+    // only nodes that are in the heap can be moved
+    if ((NULL == p_heap) || (NULL == p_node) || (NULL == p_node->p_data)){
+        return -1;
+    }
+    if (p_heap->p_root == p_node){
+        return 0;
+    }
+    // cut the subtree of the node out of its siblings and link it to the root
+    if (p_node->p_prev->p_child == p_node){
+        p_node->p_prev->p_child = p_node->p_next;
+    }
+    else {
+        p_node->p_prev->p_next = p_node->p_next;
+    }
+    if (NULL != p_node->p_next){
+        p_node->p_next->p_prev = p_node->p_prev;
+    }
+    p_node->p_next = NULL;
+    p_node->p_prev = NULL;
+    p_heap->p_root = pheap_link(p_heap, p_heap->p_root, p_node);
+    return 0;
+}
+
+/*
+ * @brief moves every node of one pairing heap into another in O(1), the trees
+ *  are linked and the blocks and free nodes of the source are spliced in
+ *  front of those of the destination so handles stay valid
+ * @param p_dest the heap receiving the nodes
+ * @param p_source the heap giving up its nodes, it is left empty
+ * @return 0 on success else -1
+ */
+int8_t pheap_meld(pheap * p_dest, pheap * p_source)
+{
+    // only heaps ordered the same way can be melded
+    if ((NULL == p_dest) || (NULL == p_source) || (p_dest == p_source) \
+        || (p_dest->ordering != p_source->ordering) || (p_dest->compare != p_source->compare)){
+        return -1;
+    }
+    p_dest->p_root = pheap_link(p_dest, p_dest->p_root, p_source->p_root);
+    p_dest->size += p_source->size;
+    // splice the blocks and free nodes of the source in front of those of
+    // the destination through their last entries
+    if (NULL != p_source->p_blocks){
+        p_source->p_last_block->p_next = p_dest->p_blocks;
+        p_dest->p_blocks = p_source->p_blocks;
+        if (NULL == p_dest->p_last_block){
+            p_dest->p_last_block = p_source->p_last_block;
+        }
+    }
+    if (NULL != p_source->p_free){
+        p_source->p_last_free->p_next = p_dest->p_free;
+        p_dest->p_free = p_source->p_free;
+        if (NULL == p_dest->p_last_free){
+            p_dest->p_last_free = p_source->p_last_free;
+        }
+    }
+    p_source->p_root = NULL;
+    p_source->p_blocks = NULL;
+    p_source->p_last_block = NULL;
+    p_source->p_free = NULL;
+    p_source->p_last_free = NULL;
+    p_source->size = 0;
+    return 0;
+}
+
+/*
+ * @brief get the data in a pairing heap node
+ * @param p_node the node to get the data from
+ * @return void pointer to the nodes data
+ */
+void * pheap_data(phnode * p_node)
+{
+    // cant get the data in a null node
+    if (NULL == p_node){
+        return NULL;
+    }
+    return p_node->p_data;
+}
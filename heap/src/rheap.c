@@ -0,0 +1,256 @@
+#include <rheap.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * @param BUCKETS one bucket for keys equal to the last pulled key and one for
+ *  each bit a key can first differ from it in
+ * @param INITIAL_MEMBERS the initial size of a bucket array
+ */
+enum {BUCKETS = 65, INITIAL_MEMBERS = 16};
+
+/*
+ * @brief an element stored in a radix heap
+ * @param key the priority of the element
+ * @param p_data pointer to the data of the element
+ */
+typedef struct rheap_entry {
+    uint64_t key;
+    void * p_data;
+} rheap_entry;
+
+/*
+ * @brief a bucket holding every element whose key first differs from the
+ *  last pulled key in the same bit
+ * @param size the number of elements in the bucket
+ * @param node_space the number of elements allocated for the bucket
+ * @param p_array the elements of the bucket in no particular order
+ */
+typedef struct rheap_bucket {
+    int64_t size;
+    int64_t node_space;
+    rheap_entry * p_array;
+} rheap_bucket;
+
+/*
+ * @brief a radix heap for non decreasing integer keys
+ * @param size the number of elements in the heap
+ * @param last the last key pulled from the heap, no smaller key may be inserted
+ * @param destroy the tear down function for the data in the heap
+ * @param buckets the buckets of the heap, bucket 0 holds keys equal to last
+ */
+struct rheap {
+    int64_t size;
+    uint64_t last;
+    void (* destroy)(void * p_data);
+    rheap_bucket buckets[BUCKETS];
+};
+
+/*
+ * @brief gets the bucket a key belongs in relative to the last pulled key
+ * @param last the last pulled key
+ * @param key the key to place
+ * @return the index of the highest bit the keys differ in plus one or 0 if
+ *  they are equal
+ */
+static int rheap_bucket_index(uint64_t last, uint64_t key)
+{
+    return (key == last) ? 0 : (64 - __builtin_clzll(key ^ last));
+}
+
+/*
+ * @brief grows a bucket so it can hold a number of elements
+ * @param p_bucket the bucket to grow
+ * @param count the number of elements the bucket must hold
+ * @return 0 on success else -1
+ */
+static int8_t rheap_bucket_reserve(rheap_bucket * p_bucket, int64_t count)
+{
+    if (count <= p_bucket->node_space){
+        return 0;
+    }
+    int64_t node_space = (0 == p_bucket->node_space) ? INITIAL_MEMBERS : p_bucket->node_space;
+    while (node_space < count){
+        node_space *= 2;
+    }
+    rheap_entry * p_temp = realloc(p_bucket->p_array, node_space * sizeof(*p_temp));
+    if (NULL == p_temp){
+        perror("rheap realloc ");
+        return -1;
+    }
+    p_bucket->p_array = p_temp;
+    p_bucket->node_space = node_space;
+    return 0;
+}
+
+/*
+ * @brief makes sure bucket 0 holds the smallest keys by moving last up to the
+ *  smallest key of the first non empty bucket and spreading that bucket over
+ *  the lower buckets
+ * @param p_heap the non empty heap to prepare for a pull
+ * @return 0 on success else -1 with the heap unchanged
+ */
+static int8_t rheap_refill(rheap * p_heap)
+{
+    if (0 != p_heap->buckets[0].size){
+        return 0;
+    }
+    int index = 1;
+    while (0 == p_heap->buckets[index].size){
+        index++;
+    }
+    rheap_bucket * p_bucket = &p_heap->buckets[index];
+    uint64_t smallest = p_bucket->p_array[0].key;
+    for (int64_t member = 1; member < p_bucket->size; member++){
+        if (p_bucket->p_array[member].key < smallest){
+            smallest = p_bucket->p_array[member].key;
+        }
+    }
+    // every key in the bucket now differs from the smallest in a lower bit so
+    // each lands in a lower bucket, make room in all of them before moving
+    int64_t counts[BUCKETS] = {0};
+    for (int64_t member = 0; member < p_bucket->size; member++){
+        counts[rheap_bucket_index(smallest, p_bucket->p_array[member].key)]++;
+    }
+    for (int lower = 0; lower < index; lower++){
+        if (0 != rheap_bucket_reserve(&p_heap->buckets[lower], p_heap->buckets[lower].size + counts[lower])){
+            return -1;
+        }
+    }
+    p_heap->last = smallest;
+    for (int64_t member = 0; member < p_bucket->size; member++){
+        rheap_entry * p_entry = &p_bucket->p_array[member];
+        rheap_bucket * p_lower = &p_heap->buckets[rheap_bucket_index(smallest, p_entry->key)];
+        p_lower->p_array[p_lower->size++] = *p_entry;
+    }
+    p_bucket->size = 0;
+    return 0;
+}
+
+/*
+ * @brief allocate and initialize a radix heap
+ * @param destroy user defined function to tear down the data left in the heap
+ * @return a newly initialized heap or NULL on error
+ */
+rheap * rheap_init(void (* destroy)(void * p_data))
+{
+    rheap * p_heap = calloc(1, sizeof(*p_heap));
+    if (NULL == p_heap){
+        return NULL;
+    }
+    p_heap->size = 0;
+    p_heap->last = 0;
+    p_heap->destroy = destroy;
+    return p_heap;
+}
+
+/*
+ * @brief tear down a radix heap
+ * @param p_heap the heap to tear down
+ */
+void rheap_destroy(rheap * p_heap)
+{
+    // cant destroy a NULL heap
+    if (NULL == p_heap){
+        return;
+    }
+    for (int index = 0; index < BUCKETS; index++){
+        rheap_bucket * p_bucket = &p_heap->buckets[index];
+        for (int64_t member = 0; (NULL != p_heap->destroy) && (member < p_bucket->size); member++){
+            p_heap->destroy(p_bucket->p_array[member].p_data);
+        }
+        free(p_bucket->p_array);
+    }
+    free(p_heap);
+}
+
+/*
+ * @brief gets the size of a radix heap
+ * @param p_heap the heap to get the size of
+ * @return the size of the heap or -1 on error
+ */
+int64_t rheap_size(rheap * p_heap)
+{
+    if (NULL == p_heap){
+        return -1;
+    }
+    return p_heap->size;
+}
+
+/*
+ * @brief adds data to a radix heap in O(1)
+ * @param p_heap the heap to add the data to
+ * @param key the priority of the data, it must not be smaller than the last
+ *  key pulled from the heap
+ * @param p_data the data to add
+ * @return 0 on success else -1
+ */
+int8_t rheap_insert(rheap * p_heap, uint64_t key, void * p_data)
+{
+    // cant insert into a null heap, from null data or behind the last key
+    if ((NULL == p_heap) || (NULL == p_data) || (key < p_heap->last)){
+        return -1;
+    }
+    rheap_bucket * p_bucket = &p_heap->buckets[rheap_bucket_index(p_heap->last, key)];
+    if (0 != rheap_bucket_reserve(p_bucket, p_bucket->size + 1)){
+        return -1;
+    }
+    p_bucket->p_array[p_bucket->size].key = key;
+    p_bucket->p_array[p_bucket->size].p_data = p_data;
+    p_bucket->size++;
+    p_heap->size++;
+    return 0;
+}
+
+/*
+ * @brief gets the data with the smallest key without removing it, the lowest
+ *  non empty bucket is scanned in place so peeking never changes which keys
+ *  may still be inserted
+ * @param p_heap the heap to look at
+ * @param p_key set to the smallest key if it is not NULL
+ * @return the data with the smallest key or NULL if the heap is empty
+ */
+void * rheap_peek(rheap * p_heap, uint64_t * p_key)
+{
+    if ((NULL == p_heap) || (0 == p_heap->size)){
+        return NULL;
+    }
+    int index = 0;
+    while (0 == p_heap->buckets[index].size){
+        index++;
+    }
+    // ties go to the last of the smallest keys which is the one a pull takes
+    rheap_bucket * p_bucket = &p_heap->buckets[index];
+    int64_t best = 0;
+    for (int64_t member = 1; member < p_bucket->size; member++){
+        if (p_bucket->p_array[member].key <= p_bucket->p_array[best].key){
+            best = member;
+        }
+    }
+    if (NULL != p_key){
+        *p_key = p_bucket->p_array[best].key;
+    }
+    return p_bucket->p_array[best].p_data;
+}
+
+/*
+ * @brief removes the data with the smallest key in amortized O(log C) where C
+ *  is the largest gap between keys
+ * @param p_heap the heap to pull from
+ * @param p_key set to the key of the pulled data if it is not NULL
+ * @return the data with the smallest key or NULL if the heap is empty
+ */
+void * rheap_pull(rheap * p_heap, uint64_t * p_key)
+{
+    if ((NULL == p_heap) || (0 == p_heap->size) || (0 != rheap_refill(p_heap))){
+        return NULL;
+    }
+    rheap_bucket * p_bucket = &p_heap->buckets[0];
+    p_bucket->size--;
+    p_heap->size--;
+    if (NULL != p_key){
+        *p_key = p_bucket->p_array[p_bucket->size].key;
+    }
+    return p_bucket->p_array[p_bucket->size].p_data;
+}
@@ -0,0 +1,418 @@
+#include <twheel.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * @param SLOT_BITS the number of tick bits each level of the wheel covers
+ * @param SLOTS the number of slots in each level of the wheel
+ * @param MAX_LEVELS the most levels a wheel can have before the ticks it
+ *  covers no longer fit in 64 bits
+ * @param FIRST_BLOCK the number of timers in the first block of the pool
+ * @param LAST_BLOCK the number of timers blocks stop growing at
+ */
+enum {SLOT_BITS = 6, SLOTS = 1 << SLOT_BITS, MAX_LEVELS = 10, FIRST_BLOCK = 64, LAST_BLOCK = 4096};
+
+/*
+ * @brief a timer in a wheel, the timers of a slot form a circular list
+ *  around the slot head so a timer can unlink itself in O(1)
+ * @param p_data pointer to the data of the timer or NULL while in the pool
+ * @param tick the tick the timer expires at
+ * @param p_next the next timer in the slot or the next free timer in the pool
+ * @param p_prev the previous timer in the slot
+ */
+struct twheel_timer {
+    void * p_data;
+    uint64_t tick;
+    struct twheel_timer * p_next;
+    struct twheel_timer * p_prev;
+};
+
+/*
+ * @brief a block of timers allocated at once for the pool
+ * @param p_next the next block in the pool
+ * @param count the number of timers in the block
+ * @param timers the timers of the block
+ */
+typedef struct twheel_block {
+    struct twheel_block * p_next;
+    int64_t count;
+    twtimer timers[];
+} twheel_block;
+
+/*
+ * @brief a hierarchical timing wheel, level l has SLOTS slots of SLOTS^l
+ *  ticks each and its slots move down a level as the wheel reaches them
+ * @param tick the length of one tick in the units of the times passed in
+ * @param levels the number of levels of the wheel
+ * @param current the next tick to process
+ * @param size the number of pending timers
+ * @param destroy the tear down function for the data of a timer
+ * @param p_slots the slot heads, levels * SLOTS of them
+ * @param overdue the head of the timers scheduled for ticks already passed
+ * @param p_blocks the blocks of the timer pool
+ * @param p_free the timers in the pool that are not pending
+ * @param block_size the number of timers in the next block of the pool
+ * @param pp_expired the buffer handed to the expire callback
+ * @param expired_space the number of pointers the buffer has room for
+ */
+struct twheel {
+    uint64_t tick;
+    int levels;
+    uint64_t current;
+    int64_t size;
+    void (* destroy)(void * p_data);
+    twtimer * p_slots;
+    twtimer overdue;
+    twheel_block * p_blocks;
+    twtimer * p_free;
+    int64_t block_size;
+    void ** pp_expired;
+    int64_t expired_space;
+};
+
+/*
+ * @brief takes a timer from the pool adding a block when the pool is empty
+ * @param p_wheel the wheel owning the pool
+ * @return a timer or NULL on error
+ */
+static twtimer * twheel_timer_alloc(twheel * p_wheel)
+{
+    if (NULL == p_wheel->p_free){
+        twheel_block * p_block = calloc(1, sizeof(*p_block) + (p_wheel->block_size * sizeof(twtimer)));
+        if (NULL == p_block){
+            perror("twheel block ");
+            return NULL;
+        }
+        p_block->count = p_wheel->block_size;
+        p_block->p_next = p_wheel->p_blocks;
+        p_wheel->p_blocks = p_block;
+        // thread the new timers onto the free list
+        for (int64_t index = 0; index < p_block->count; index++){
+            p_block->timers[index].p_next = p_wheel->p_free;
+            p_wheel->p_free = &p_block->timers[index];
+        }
+        if (p_wheel->block_size < LAST_BLOCK){
+            p_wheel->block_size *= 2;
+        }
+    }
+    twtimer * p_timer = p_wheel->p_free;
+    p_wheel->p_free = p_timer->p_next;
+    return p_timer;
+}
+
+/*
+ * @brief returns a timer to the pool
+ * @param p_wheel the wheel owning the pool
+ * @param p_timer the timer to return
+ */
+static void twheel_timer_free(twheel * p_wheel, twtimer * p_timer)
+{
+    p_timer->p_data = NULL;
+    p_timer->p_prev = NULL;
+    p_timer->p_next = p_wheel->p_free;
+    p_wheel->p_free = p_timer;
+}
+
+/*
+ * @brief takes a timer out of the slot it is in
+ * @param p_timer the timer to unlink
+ */
+static void twheel_unlink(twtimer * p_timer)
+{
+    p_timer->p_prev->p_next = p_timer->p_next;
+    p_timer->p_next->p_prev = p_timer->p_prev;
+}
+
+/*
+ * @brief appends a timer to a slot
+ * @param p_head the head of the slot
+ * @param p_timer the timer to append
+ */
+static void twheel_link(twtimer * p_head, twtimer * p_timer)
+{
+    p_timer->p_next = p_head;
+    p_timer->p_prev = p_head->p_prev;
+    p_head->p_prev->p_next = p_timer;
+    p_head->p_prev = p_timer;
+}
+
+/*
+ * @brief puts a timer in the slot matching how far its tick is past the
+ *  current tick, timers beyond the last level wait in the last level and
+ *  are placed again each time their slot comes around
+ * @param p_wheel the wheel to place the timer in
+ * @param p_timer the timer to place
+ */
+static void twheel_place(twheel * p_wheel, twtimer * p_timer)
+{
+    uint64_t tick = p_timer->tick;
+    uint64_t delta = tick - p_wheel->current;
+    int level = 0;
+    while ((level < p_wheel->levels - 1) && (delta >= ((uint64_t)SLOTS << (SLOT_BITS * level)))){
+        level++;
+    }
+    if (delta >= ((uint64_t)SLOTS << (SLOT_BITS * level))){
+        tick = p_wheel->current + ((uint64_t)SLOTS << (SLOT_BITS * level)) - 1;
+    }
+    twheel_link(&p_wheel->p_slots[(level * SLOTS) + ((tick >> (SLOT_BITS * level)) & (SLOTS - 1))], p_timer);
+}
+
+/*
+ * @brief moves the timers of the slot a level has reached down the wheel,
+ *  higher levels go first so their timers can land in the lower slots
+ *  about to be moved
+ * @param p_wheel the wheel to cascade
+ */
+static void twheel_cascade(twheel * p_wheel)
+{
+    int top = 1;
+    while ((top < p_wheel->levels) && (0 == (p_wheel->current & ((1ULL << (SLOT_BITS * top)) - 1)))){
+        top++;
+    }
+    for (int level = top - 1; level > 0; level--){
+        twtimer * p_head = &p_wheel->p_slots[(level * SLOTS) + ((p_wheel->current >> (SLOT_BITS * level)) & (SLOTS - 1))];
+        if (p_head->p_next == p_head){
+            continue;
+        }
+        twtimer * p_timer = p_head->p_next;
+        // detach the list first since timers can land back in this level
+        p_head->p_prev->p_next = NULL;
+        p_head->p_next = p_head;
+        p_head->p_prev = p_head;
+        while (NULL != p_timer){
+            twtimer * p_next = p_timer->p_next;
+            twheel_place(p_wheel, p_timer);
+            p_timer = p_next;
+        }
+    }
+}
+
+/*
+ * @brief makes sure the expired buffer has room for more data
+ * @param p_wheel the wheel owning the buffer
+ * @param count the number of pointers needed
+ * @return 0 on success else -1
+ */
+static int8_t twheel_expired_reserve(twheel * p_wheel, int64_t count)
+{
+    if (count <= p_wheel->expired_space){
+        return 0;
+    }
+    int64_t space = (p_wheel->expired_space < SLOTS) ? SLOTS : p_wheel->expired_space;
+    while (space < count){
+        space *= 2;
+    }
+    void ** pp_expired = realloc(p_wheel->pp_expired, space * sizeof(*pp_expired));
+    if (NULL == pp_expired){
+        perror("twheel expired ");
+        return -1;
+    }
+    p_wheel->pp_expired = pp_expired;
+    p_wheel->expired_space = space;
+    return 0;
+}
+
+/*
+ * @brief moves the data of every due timer in a slot to the expired buffer,
+ *  a timer past the span of the wheel that was clamped into the slot is
+ *  placed again instead
+ * @param p_wheel the wheel owning the slot
+ * @param p_head the head of the slot
+ * @param p_count the number of data in the buffer, updated as data is added
+ * @return 0 on success else -1 leaving the timers not moved in the slot
+ */
+static int8_t twheel_drain(twheel * p_wheel, twtimer * p_head, int64_t * p_count)
+{
+    while (p_head->p_next != p_head){
+        twtimer * p_timer = p_head->p_next;
+        // a timer not yet due always lands in another slot of its level
+        if (p_timer->tick > p_wheel->current){
+            twheel_unlink(p_timer);
+            twheel_place(p_wheel, p_timer);
+            continue;
+        }
+        if (-1 == twheel_expired_reserve(p_wheel, *p_count + 1)){
+            return -1;
+        }
+        twheel_unlink(p_timer);
+        p_wheel->pp_expired[(*p_count)++] = p_timer->p_data;
+        twheel_timer_free(p_wheel, p_timer);
+        p_wheel->size--;
+    }
+    return 0;
+}
+
+/*
+ * @brief allocate and initialize a timing wheel
+ * @param start the time the wheel starts at
+ * @param tick the length of one tick, timers expire on tick boundaries
+ * @param levels the number of levels, the wheel covers 64^levels ticks ahead
+ *  and timers further out are placed again as the wheel turns
+ * @param destroy user defined function to tear down the data of pending
+ *  timers
+ * @return a newly initialized wheel or NULL on error
+ */
+twheel * twheel_init(uint64_t start, uint64_t tick, int levels, void (* destroy)(void * p_data))
+{
+    // a tick must have a length and the levels must fit in 64 bits
+    if ((0 == tick) || (levels < 1) || (levels > MAX_LEVELS)){
+        return NULL;
+    }
+    twheel * p_wheel = calloc(1, sizeof(*p_wheel));
+    if (NULL == p_wheel){
+        return NULL;
+    }
+    p_wheel->p_slots = calloc(levels * SLOTS, sizeof(*p_wheel->p_slots));
+    if (NULL == p_wheel->p_slots){
+        free(p_wheel);
+        return NULL;
+    }
+    for (int index = 0; index < levels * SLOTS; index++){
+        p_wheel->p_slots[index].p_next = &p_wheel->p_slots[index];
+        p_wheel->p_slots[index].p_prev = &p_wheel->p_slots[index];
+    }
+    p_wheel->overdue.p_next = &p_wheel->overdue;
+    p_wheel->overdue.p_prev = &p_wheel->overdue;
+    p_wheel->tick = tick;
+    p_wheel->levels = levels;
+    p_wheel->current = start / tick;
+    p_wheel->size = 0;
+    p_wheel->destroy = destroy;
+    p_wheel->p_blocks = NULL;
+    p_wheel->p_free = NULL;
+    p_wheel->block_size = FIRST_BLOCK;
+    p_wheel->pp_expired = NULL;
+    p_wheel->expired_space = 0;
+    return p_wheel;
+}
+
+/*
+ * @brief tear down a timing wheel and the data of its pending timers
+ * @param p_wheel the wheel to tear down
+ */
+void twheel_destroy(twheel * p_wheel)
+{
+    // cant destroy a NULL wheel
+    if (NULL == p_wheel){
+        return;
+    }
+    // timers in the pool have no data so only pending timers are torn down
+    twheel_block * p_block = p_wheel->p_blocks;
+    while (NULL != p_block){
+        twheel_block * p_next = p_block->p_next;
+        for (int64_t index = 0; index < p_block->count; index++){
+            if ((NULL != p_wheel->destroy) && (NULL != p_block->timers[index].p_data)){
+                p_wheel->destroy(p_block->timers[index].p_data);
+            }
+        }
+        free(p_block);
+        p_block = p_next;
+    }
+    free(p_wheel->pp_expired);
+    free(p_wheel->p_slots);
+    free(p_wheel);
+}
+
+/*
+ * @brief gets the number of pending timers in a timing wheel
+ * @param p_wheel the wheel to get the size of
+ * @return the number of pending timers or -1 on error
+ */
+int64_t twheel_size(twheel * p_wheel)
+{
+    if (NULL == p_wheel){
+        return -1;
+    }
+    return p_wheel->size;
+}
+
+/*
+ * @brief schedules data to expire at a time, times already passed expire on
+ *  the next advance whatever time it moves to
+ * @param p_wheel the wheel to schedule in
+ * @param expire the time to expire at, rounded up to a tick
+ * @param p_data the data handed to the expire callback
+ * @return the timer which stays valid until it expires or is cancelled or
+ *  NULL on error
+ */
+twtimer * twheel_schedule(twheel * p_wheel, uint64_t expire, void * p_data)
+{
+    // cant schedule in a NULL wheel or with NULL data
+    if ((NULL == p_wheel) || (NULL == p_data)){
+        return NULL;
+    }
+    twtimer * p_timer = twheel_timer_alloc(p_wheel);
+    if (NULL == p_timer){
+        return NULL;
+    }
+    p_timer->p_data = p_data;
+    p_timer->tick = (expire / p_wheel->tick) + ((0 == (expire % p_wheel->tick)) ? 0 : 1);
+    if (p_timer->tick < p_wheel->current){
+        twheel_link(&p_wheel->overdue, p_timer);
+    }
+    else {
+        twheel_place(p_wheel, p_timer);
+    }
+    p_wheel->size++;
+    return p_timer;
+}
+
+/*
+ * @brief cancels a pending timer in O(1) and tears down its data
+ * @param p_wheel the wheel the timer is pending in
+ * @param p_timer the timer to cancel
+ * @return 0 on success else -1
+ */
+int8_t twheel_cancel(twheel * p_wheel, twtimer * p_timer)
+{
+    // the timer must be pending
+    if ((NULL == p_wheel) || (NULL == p_timer) || (NULL == p_timer->p_data)){
+        return -1;
+    }
+    twheel_unlink(p_timer);
+    if (NULL != p_wheel->destroy){
+        p_wheel->destroy(p_timer->p_data);
+    }
+    twheel_timer_free(p_wheel, p_timer);
+    p_wheel->size--;
+    return 0;
+}
+
+/*
+ * @brief moves a timing wheel forward expiring every timer due by a time,
+ *  the expired data is handed over in one batch in expiry order and the
+ *  callback may schedule new timers
+ * @param p_wheel the wheel to move forward
+ * @param now the time to move to
+ * @param expire user defined function receiving the expired data
+ * @return the number of expired timers or -1 on error, when the expired
+ *  buffer cant grow the timers drained so far are still handed to expire and
+ *  the rest stay due for the next advance
+ */
+int64_t twheel_advance(twheel * p_wheel, uint64_t now, void (* expire)(void ** pp_data, int64_t count))
+{
+    if ((NULL == p_wheel) || (NULL == expire)){
+        return -1;
+    }
+    uint64_t target = now / p_wheel->tick;
+    int64_t count = 0;
+    int8_t retval = twheel_drain(p_wheel, &p_wheel->overdue, &count);
+    while ((0 == retval) && (p_wheel->current <= target) && (0 != p_wheel->size)){
+        if (0 == (p_wheel->current & (SLOTS - 1))){
+            twheel_cascade(p_wheel);
+        }
+        retval = twheel_drain(p_wheel, &p_wheel->p_slots[p_wheel->current & (SLOTS - 1)], &count);
+        if (0 == retval){
+            p_wheel->current++;
+        }
+    }
+    // an empty wheel jumps straight to the target
+    if ((0 == p_wheel->size) && (p_wheel->current <= target)){
+        p_wheel->current = target + 1;
+    }
+    if (0 != count){
+        expire(p_wheel->pp_expired, count);
+    }
+    return (0 == retval) ? count : -1;
+}
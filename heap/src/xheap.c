@@ -0,0 +1,624 @@
+#include <xheap.h>
+#include <heap.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * @param BLOCK_BYTES the most bytes read from a run at once
+ * @param MIN_FANOUT the fewest runs the memory must be able to buffer
+ */
+enum {BLOCK_BYTES = 1 << 16, MIN_FANOUT = 4};
+
+/*
+ * @brief a sorted run of records spilled to a temporary file, read back a
+ *  block at a time
+ * @param p_owner the queue the run belongs to
+ * @param p_file the temporary file holding the run
+ * @param unread the number of records still in the file
+ * @param count the number of records in the buffer
+ * @param position the index of the head record in the buffer
+ * @param index the index of the run in the run array of the queue
+ * @param p_buffer the block of records read from the file
+ */
+typedef struct xheap_run {
+    struct xheap * p_owner;
+    FILE * p_file;
+    int64_t unread;
+    int64_t count;
+    int64_t position;
+    int64_t index;
+    char * p_buffer;
+} xheap_run;
+
+/*
+ * @brief an external memory priority queue, records are kept in an in memory
+ *  heap until it fills up and is spilled as a sorted run, pulls take the
+ *  best of the in memory heap and the heads of the runs
+ * @param ordering either min or max ordering
+ * @param record_size the number of bytes in a record
+ * @param compare the user defined compare function for two records
+ * @param size the number of records in the queue
+ * @param capacity the number of records the in memory heap can hold
+ * @param block the number of records read from a run at once
+ * @param fanout the most runs the queue keeps before merging some of them
+ * @param p_arena the storage of the records in the in memory heap
+ * @param p_slots the free slots of the arena
+ * @param free_slots the number of free slots
+ * @param p_heap the in memory heap of pointers into the arena
+ * @param p_merge the heap of runs ordered by their head record
+ * @param pp_runs the runs of the queue
+ * @param run_count the number of runs
+ */
+struct xheap {
+    int ordering;
+    size_t record_size;
+    int8_t (* compare)(void * p_key1, void * p_key2);
+    int64_t size;
+    int64_t capacity;
+    int64_t block;
+    int64_t fanout;
+    char * p_arena;
+    int64_t * p_slots;
+    int64_t free_slots;
+    heap * p_heap;
+    heap * p_merge;
+    xheap_run ** pp_runs;
+    int64_t run_count;
+};
+
+/*
+ * @brief checks if a record belongs before another based on the ordering
+ * @param p_xheap the queue providing the ordering and compare function
+ * @param p_key1 the record to check
+ * @param p_key2 the record to check against
+ * @return true if p_key1 must be pulled before p_key2
+ */
+static bool xheap_before(xheap * p_xheap, void * p_key1, void * p_key2)
+{
+    int8_t cmpval = p_xheap->compare(p_key1, p_key2);
+    return (MIN == p_xheap->ordering) ? (cmpval < 0) : (cmpval > 0);
+}
+
+/*
+ * @brief gets the head record of a run
+ * @param p_run the run to look at
+ * @return pointer to the head record in the buffer of the run
+ */
+static void * xheap_run_head(xheap_run * p_run)
+{
+    return p_run->p_buffer + (p_run->position * p_run->p_owner->record_size);
+}
+
+/*
+ * @brief compares two runs by their head records
+ * @param p_key1 the first run
+ * @param p_key2 the second run
+ * @return the user defined compare of the head records
+ */
+static int8_t xheap_run_compare(void * p_key1, void * p_key2)
+{
+    xheap_run * p_run1 = p_key1;
+    xheap_run * p_run2 = p_key2;
+    return p_run1->p_owner->compare(xheap_run_head(p_run1), xheap_run_head(p_run2));
+}
+
+/*
+ * @brief gets the number of records left in a run
+ * @param p_run the run to count
+ * @return the records in the buffer and the file
+ */
+static int64_t xheap_run_left(xheap_run * p_run)
+{
+    return p_run->unread + (p_run->count - p_run->position);
+}
+
+/*
+ * @brief reads the next block of a run into its buffer
+ * @param p_run the run to read
+ * @return 0 on success else -1
+ */
+static int8_t xheap_run_fill(xheap_run * p_run)
+{
+    int64_t count = (p_run->unread < p_run->p_owner->block) ? p_run->unread : p_run->p_owner->block;
+    if ((int64_t)fread(p_run->p_buffer, p_run->p_owner->record_size, count, p_run->p_file) != count){
+        perror("xheap read ");
+        return -1;
+    }
+    p_run->unread -= count;
+    p_run->count = count;
+    p_run->position = 0;
+    return 0;
+}
+
+/*
+ * @brief moves past the head record of a run
+ * @param p_run the run to move along
+ * @return 1 if the run has a new head 0 if it is empty or -1 on error
+ */
+static int8_t xheap_run_next(xheap_run * p_run)
+{
+    p_run->position++;
+    if (p_run->position < p_run->count){
+        return 1;
+    }
+    if (0 == p_run->unread){
+        return 0;
+    }
+    return (0 == xheap_run_fill(p_run)) ? 1 : -1;
+}
+
+/*
+ * @brief closes a run and takes it out of the run array of its queue
+ * @param p_xheap the queue owning the run
+ * @param p_run the run to close
+ */
+static void xheap_run_close(xheap * p_xheap, xheap_run * p_run)
+{
+    p_xheap->run_count--;
+    p_xheap->pp_runs[p_run->index] = p_xheap->pp_runs[p_xheap->run_count];
+    p_xheap->pp_runs[p_run->index]->index = p_run->index;
+    fclose(p_run->p_file);
+    free(p_run->p_buffer);
+    free(p_run);
+}
+
+/*
+ * @brief the place a run had reached before a merge so it can be put back
+ *  there if the merge fails
+ * @param offset the file offset the block in the buffer was read from
+ * @param unread the number of records that were still in the file
+ * @param count the number of records that were in the buffer
+ * @param position the index the head record had in the buffer
+ */
+typedef struct xheap_mark {
+    long offset;
+    int64_t unread;
+    int64_t count;
+    int64_t position;
+} xheap_mark;
+
+/*
+ * @brief turns a temporary file holding sorted records into a run that is not
+ *  yet part of a queue
+ * @param p_xheap the queue the run is for
+ * @param p_file the file holding the records
+ * @param count the number of records in the file
+ * @return the run with its first block read or NULL on error with the file
+ *  closed
+ */
+static xheap_run * xheap_run_make(xheap * p_xheap, FILE * p_file, int64_t count)
+{
+    xheap_run * p_run = calloc(1, sizeof(*p_run));
+    char * p_buffer = malloc(p_xheap->block * p_xheap->record_size);
+    if ((NULL == p_run) || (NULL == p_buffer) || (0 != fflush(p_file)) || (0 != fseek(p_file, 0, SEEK_SET))){
+        perror("xheap run ");
+        free(p_run);
+        free(p_buffer);
+        fclose(p_file);
+        return NULL;
+    }
+    p_run->p_owner = p_xheap;
+    p_run->p_file = p_file;
+    p_run->unread = count;
+    p_run->p_buffer = p_buffer;
+    if (0 != xheap_run_fill(p_run)){
+        fclose(p_file);
+        free(p_buffer);
+        free(p_run);
+        return NULL;
+    }
+    return p_run;
+}
+
+/*
+ * @brief turns a temporary file holding sorted records into a run of a queue
+ * @param p_xheap the queue to add the run to
+ * @param p_file the file holding the records
+ * @param count the number of records in the file
+ * @return 0 on success else -1 with the file closed
+ */
+static int8_t xheap_run_open(xheap * p_xheap, FILE * p_file, int64_t count)
+{
+    xheap_run * p_run = xheap_run_make(p_xheap, p_file, count);
+    if (NULL == p_run){
+        return -1;
+    }
+    p_run->index = p_xheap->run_count;
+    p_xheap->pp_runs[p_xheap->run_count++] = p_run;
+    if (0 != heap_push(p_xheap->p_merge, p_run)){
+        xheap_run_close(p_xheap, p_run);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * @brief records the place a run has reached
+ * @param p_run the run to record
+ * @param p_mark set to the place of the run
+ * @return 0 on success else -1
+ */
+static int8_t xheap_run_mark(xheap_run * p_run, xheap_mark * p_mark)
+{
+    long offset = ftell(p_run->p_file);
+    if (-1 == offset){
+        perror("xheap tell ");
+        return -1;
+    }
+    p_mark->offset = offset - (long)(p_run->count * p_run->p_owner->record_size);
+    p_mark->unread = p_run->unread;
+    p_mark->count = p_run->count;
+    p_mark->position = p_run->position;
+    return 0;
+}
+
+/*
+ * @brief moves a run back to a place it had reached, the block it was on is
+ *  read again since the buffer may hold a later one
+ * @param p_run the run to move back
+ * @param p_mark the place to move the run to
+ * @return 0 on success else -1
+ */
+static int8_t xheap_run_restore(xheap_run * p_run, xheap_mark * p_mark)
+{
+    if (0 != fseek(p_run->p_file, p_mark->offset, SEEK_SET)){
+        perror("xheap seek ");
+        return -1;
+    }
+    p_run->unread = p_mark->unread + p_mark->count;
+    if (0 != xheap_run_fill(p_run)){
+        return -1;
+    }
+    p_run->position = p_mark->position;
+    return 0;
+}
+
+/*
+ * @brief orders runs by the number of records left in them
+ * @param p_key1 pointer to the first run pointer
+ * @param p_key2 pointer to the second run pointer
+ * @return negative zero or positive as the first run is shorter equal or longer
+ */
+static int xheap_run_shorter(const void * p_key1, const void * p_key2)
+{
+    int64_t left1 = xheap_run_left(*(xheap_run * const *)p_key1);
+    int64_t left2 = xheap_run_left(*(xheap_run * const *)p_key2);
+    return (left1 < left2) ? -1 : ((left1 == left2) ? 0 : 1);
+}
+
+/*
+ * @brief merges the shorter half of the runs into one run so a new run can
+ *  be spilled without going over the fanout, merging the shortest runs keeps
+ *  each record from being rewritten more than a logarithmic number of times
+ * @param p_xheap the queue to compact
+ * @return 0 on success else -1 with the merged runs put back where they were,
+ *  a run that cant be read again is dropped with the records left in it
+ */
+static int8_t xheap_compact(xheap * p_xheap)
+{
+    qsort(p_xheap->pp_runs, p_xheap->run_count, sizeof(*p_xheap->pp_runs), xheap_run_shorter);
+    for (int64_t index = 0; index < p_xheap->run_count; index++){
+        p_xheap->pp_runs[index]->index = index;
+    }
+    int64_t merging = p_xheap->run_count / 2;
+    // set up everything the merge needs first so running out of memory
+    // leaves the queue as it was
+    heap * p_local = heap_init(p_xheap->ordering, 4, NULL, xheap_run_compare);
+    heap * p_fresh = heap_init(p_xheap->ordering, 4, NULL, xheap_run_compare);
+    xheap_mark * p_marks = calloc(merging, sizeof(*p_marks));
+    FILE * p_file = tmpfile();
+    bool b_ready = (NULL != p_local) && (NULL != p_fresh) && (NULL != p_marks) && (NULL != p_file) \
+        && (0 == heap_reserve(p_local, merging)) && (0 == heap_reserve(p_fresh, p_xheap->fanout));
+    for (int64_t index = 0; b_ready && (index < merging); index++){
+        b_ready = (0 == xheap_run_mark(p_xheap->pp_runs[index], &p_marks[index])) \
+            && (0 == heap_push(p_local, p_xheap->pp_runs[index]));
+    }
+    if (!b_ready){
+        perror("xheap compact ");
+        heap_destroy(p_local);
+        heap_destroy(p_fresh);
+        free(p_marks);
+        if (NULL != p_file){
+            fclose(p_file);
+        }
+        return -1;
+    }
+    int64_t written = 0;
+    int8_t retval = 0;
+    // write the heads of the merged runs in order, the runs stay in the run
+    // array until the merge is over so their indexes do not move
+    while ((0 == retval) && (0 != heap_size(p_local))){
+        xheap_run * p_run = heap_pop(p_local);
+        if (1 != fwrite(xheap_run_head(p_run), p_xheap->record_size, 1, p_file)){
+            perror("xheap write ");
+            retval = -1;
+            break;
+        }
+        written++;
+        int8_t next = xheap_run_next(p_run);
+        if (-1 == next){
+            retval = -1;
+        }
+        else if (1 == next){
+            // the local heap was reserved for every merged run
+            heap_push(p_local, p_run);
+        }
+    }
+    heap_destroy(p_local);
+    xheap_run * p_merged = NULL;
+    if (0 == retval){
+        p_merged = xheap_run_make(p_xheap, p_file, written);
+        retval = (NULL == p_merged) ? -1 : 0;
+    }
+    else {
+        fclose(p_file);
+    }
+    if (0 == retval){
+        // replace the merged runs at the front of the array with the new run
+        for (int64_t index = 0; index < merging; index++){
+            fclose(p_xheap->pp_runs[index]->p_file);
+            free(p_xheap->pp_runs[index]->p_buffer);
+            free(p_xheap->pp_runs[index]);
+        }
+        p_xheap->run_count -= merging;
+        memmove(p_xheap->pp_runs, p_xheap->pp_runs + merging, p_xheap->run_count * sizeof(*p_xheap->pp_runs));
+        p_xheap->pp_runs[p_xheap->run_count++] = p_merged;
+    }
+    else {
+        // the records written so far are still in the merged runs so put the
+        // runs back, going down the array so closing one only moves a run
+        // that was already put back
+        for (int64_t index = merging - 1; index >= 0; index--){
+            if (0 != xheap_run_restore(p_xheap->pp_runs[index], &p_marks[index])){
+                p_xheap->size -= p_marks[index].unread + (p_marks[index].count - p_marks[index].position);
+                xheap_run_close(p_xheap, p_xheap->pp_runs[index]);
+            }
+        }
+    }
+    // the old merge heap orders the runs by heads that have moved, the new
+    // one was reserved for the fanout so filling it cant fail
+    for (int64_t index = 0; index < p_xheap->run_count; index++){
+        p_xheap->pp_runs[index]->index = index;
+        heap_push(p_fresh, p_xheap->pp_runs[index]);
+    }
+    heap_destroy(p_xheap->p_merge);
+    p_xheap->p_merge = p_fresh;
+    free(p_marks);
+    return retval;
+}
+
+/*
+ * @brief puts the records of a spill that failed back in the in memory heap,
+ *  they were drained from the last slots freed which still hold them
+ * @param p_xheap the queue whose spill failed
+ * @param count the number of records drained
+ */
+static void xheap_unspill(xheap * p_xheap, int64_t count)
+{
+    // the heap was reserved for the arena so pushing cant fail
+    for (int64_t index = 0; index < count; index++){
+        heap_push(p_xheap->p_heap, p_xheap->p_arena + (p_xheap->p_slots[--p_xheap->free_slots] * p_xheap->record_size));
+    }
+}
+
+/*
+ * @brief writes the in memory heap out as a sorted run and frees the arena
+ * @param p_xheap the queue to spill
+ * @return 0 on success else -1
+ */
+static int8_t xheap_spill(xheap * p_xheap)
+{
+    if ((p_xheap->run_count == p_xheap->fanout) && (0 != xheap_compact(p_xheap))){
+        return -1;
+    }
+    FILE * p_file = tmpfile();
+    if (NULL == p_file){
+        perror("xheap spill ");
+        return -1;
+    }
+    int64_t count = heap_size(p_xheap->p_heap);
+    // the heap is drained in order so the run is written sequentially
+    for (int64_t index = 0; index < count; index++){
+        void * p_record = heap_top(p_xheap->p_heap);
+        if (1 != fwrite(p_record, p_xheap->record_size, 1, p_file)){
+            perror("xheap write ");
+            fclose(p_file);
+            xheap_unspill(p_xheap, index);
+            return -1;
+        }
+        heap_pop(p_xheap->p_heap);
+        p_xheap->p_slots[p_xheap->free_slots++] = ((char *)p_record - p_xheap->p_arena) / p_xheap->record_size;
+    }
+    if (0 != xheap_run_open(p_xheap, p_file, count)){
+        xheap_unspill(p_xheap, count);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * @brief allocate and initialize an external memory priority queue
+ * @param ordering integer identifying if the queue should be min or max 0 or 1 respectively
+ * @param record_size the number of bytes in a record, records are copied in
+ *  and out of the queue
+ * @param memory the bytes of records and run buffers the queue may keep in
+ *  memory, half holds the in memory heap and half buffers the runs
+ * @param compare user defined function to compare two records should return -1 0 or 1
+ * @return a newly initialized queue or NULL on error
+ */
+xheap * xheap_init(int ordering, size_t record_size, size_t memory, int8_t (* compare)(void * p_key1, void * p_key2))
+{
+    // the memory must hold a few records and a block for several runs
+    if ((NULL == compare) || (0 == record_size) || ((memory / 2) < (MIN_FANOUT * record_size))){
+        return NULL;
+    }
+    xheap * p_xheap = calloc(1, sizeof(*p_xheap));
+    if (NULL == p_xheap){
+        return NULL;
+    }
+    p_xheap->ordering = ordering;
+    p_xheap->record_size = record_size;
+    p_xheap->compare = compare;
+    p_xheap->capacity = (memory / 2) / record_size;
+    // blocks shrink with the memory so at least MIN_FANOUT runs fit
+    size_t block_bytes = (memory / 2) / MIN_FANOUT;
+    if (block_bytes > BLOCK_BYTES){
+        block_bytes = BLOCK_BYTES;
+    }
+    p_xheap->block = (block_bytes < record_size) ? 1 : (block_bytes / record_size);
+    p_xheap->fanout = (memory / 2) / (p_xheap->block * record_size);
+    p_xheap->p_arena = malloc(p_xheap->capacity * record_size);
+    p_xheap->p_slots = malloc(p_xheap->capacity * sizeof(*p_xheap->p_slots));
+    p_xheap->pp_runs = calloc(p_xheap->fanout, sizeof(*p_xheap->pp_runs));
+    p_xheap->p_heap = heap_init(ordering, 4, NULL, compare);
+    p_xheap->p_merge = heap_init(ordering, 4, NULL, xheap_run_compare);
+    if ((NULL == p_xheap->p_arena) || (NULL == p_xheap->p_slots) || (NULL == p_xheap->pp_runs) \
+        || (0 != heap_reserve(p_xheap->p_heap, p_xheap->capacity)) || (0 != heap_reserve(p_xheap->p_merge, p_xheap->fanout))){
+        xheap_destroy(p_xheap);
+        return NULL;
+    }
+    for (int64_t index = 0; index < p_xheap->capacity; index++){
+        p_xheap->p_slots[index] = p_xheap->capacity - 1 - index;
+    }
+    p_xheap->free_slots = p_xheap->capacity;
+    return p_xheap;
+}
+
+/*
+ * @brief tear down an external memory priority queue and its temporary files
+ * @param p_xheap the queue to tear down
+ */
+void xheap_destroy(xheap * p_xheap)
+{
+    // cant destroy a NULL queue
+    if (NULL == p_xheap){
+        return;
+    }
+    while (0 != p_xheap->run_count){
+        xheap_run_close(p_xheap, p_xheap->pp_runs[0]);
+    }
+    heap_destroy(p_xheap->p_merge);
+    heap_destroy(p_xheap->p_heap);
+    free(p_xheap->pp_runs);
+    free(p_xheap->p_slots);
+    free(p_xheap->p_arena);
+    free(p_xheap);
+}
+
+/*
+ * @brief gets the number of records in an external memory priority queue
+ * @param p_xheap the queue to get the size of
+ * @return the number of records or -1 on error
+ */
+int64_t xheap_size(xheap * p_xheap)
+{
+    if (NULL == p_xheap){
+        return -1;
+    }
+    return p_xheap->size;
+}
+
+/*
+ * @brief gets the number of runs an external memory priority queue has on disk
+ * @param p_xheap the queue to get the runs of
+ * @return the number of runs or -1 on error
+ */
+int64_t xheap_runs(xheap * p_xheap)
+{
+    if (NULL == p_xheap){
+        return -1;
+    }
+    return p_xheap->run_count;
+}
+
+/*
+ * @brief copies a record into an external memory priority queue, spilling
+ *  the in memory heap to disk when it is full
+ * @param p_xheap the queue to push into
+ * @param p_record the record to copy
+ * @return 0 on success else -1
+ */
+int8_t xheap_push(xheap * p_xheap, void * p_record)
+{
+    // cant push into a NULL queue or from a NULL record
+    if ((NULL == p_xheap) || (NULL == p_record)){
+        return -1;
+    }
+    if ((0 == p_xheap->free_slots) && (0 != xheap_spill(p_xheap))){
+        return -1;
+    }
+    char * p_slot = p_xheap->p_arena + (p_xheap->p_slots[--p_xheap->free_slots] * p_xheap->record_size);
+    memcpy(p_slot, p_record, p_xheap->record_size);
+    if (0 != heap_push(p_xheap->p_heap, p_slot)){
+        p_xheap->free_slots++;
+        return -1;
+    }
+    p_xheap->size++;
+    return 0;
+}
+
+/*
+ * @brief gets the best record of an external memory priority queue
+ * @param p_xheap the queue to look in
+ * @return pointer to the record valid until the queue is next changed or
+ *  NULL if the queue is empty
+ */
+void * xheap_top(xheap * p_xheap)
+{
+    if ((NULL == p_xheap) || (0 == p_xheap->size)){
+        return NULL;
+    }
+    void * p_record = heap_top(p_xheap->p_heap);
+    xheap_run * p_run = heap_top(p_xheap->p_merge);
+    if ((NULL != p_run) && ((NULL == p_record) || xheap_before(p_xheap, xheap_run_head(p_run), p_record))){
+        return xheap_run_head(p_run);
+    }
+    return p_record;
+}
+
+/*
+ * @brief removes the best record of an external memory priority queue
+ * @param p_xheap the queue to pop from
+ * @param p_record receives a copy of the record when not NULL
+ * @return 0 on success else -1 if the queue is empty or the run the record
+ *  came from cant be read further, that run is then dropped with the records
+ *  left in it after its head is copied out
+ */
+int8_t xheap_pop(xheap * p_xheap, void * p_record)
+{
+    if ((NULL == p_xheap) || (0 == p_xheap->size)){
+        return -1;
+    }
+    void * p_top = heap_top(p_xheap->p_heap);
+    xheap_run * p_run = heap_top(p_xheap->p_merge);
+    if ((NULL == p_top) && (NULL == p_run)){
+        return -1;
+    }
+    if ((NULL == p_run) || ((NULL != p_top) && !xheap_before(p_xheap, xheap_run_head(p_run), p_top))){
+        if (NULL != p_record){
+            memcpy(p_record, p_top, p_xheap->record_size);
+        }
+        heap_pop(p_xheap->p_heap);
+        p_xheap->p_slots[p_xheap->free_slots++] = ((char *)p_top - p_xheap->p_arena) / p_xheap->record_size;
+        p_xheap->size--;
+        return 0;
+    }
+    if (NULL != p_record){
+        memcpy(p_record, xheap_run_head(p_run), p_xheap->record_size);
+    }
+    heap_pop(p_xheap->p_merge);
+    p_xheap->size--;
+    int8_t next = xheap_run_next(p_run);
+    if ((1 == next) && (0 == heap_push(p_xheap->p_merge, p_run))){
+        return 0;
+    }
+    // an empty run is done with and one that cant be read or put back is
+    // dropped so the size only counts records that can still be reached
+    p_xheap->size -= xheap_run_left(p_run);
+    xheap_run_close(p_xheap, p_run);
+    return (0 == next) ? 0 : -1;
+}
+// end of source
@@ -0,0 +1,5 @@
+#ifndef _TEST_HITTERS_H
+#define _TEST_HITTERS_H
+#include <check.h>
+Suite * suite_hitters(void);
+#endif
@@ -0,0 +1,5 @@
+#ifndef _TEST_KMERGE_H
+#define _TEST_KMERGE_H
+#include <check.h>
+Suite * suite_kmerge(void);
+#endif
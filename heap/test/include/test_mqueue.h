@@ -0,0 +1,5 @@
+#ifndef _TEST_MQUEUE_H
+#define _TEST_MQUEUE_H
+#include <check.h>
+Suite * suite_mqueue(void);
+#endif
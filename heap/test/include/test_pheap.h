@@ -0,0 +1,5 @@
+#ifndef _TEST_PHEAP_H
+#define _TEST_PHEAP_H
+#include <check.h>
+Suite * suite_pheap(void);
+#endif
@@ -0,0 +1,5 @@
+#ifndef _TEST_RHEAP_H
+#define _TEST_RHEAP_H
+#include <check.h>
+Suite * suite_rheap(void);
+#endif
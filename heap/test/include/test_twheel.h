@@ -0,0 +1,5 @@
+#ifndef _TEST_TWHEEL_H
+#define _TEST_TWHEEL_H
+#include <check.h>
+Suite * suite_twheel(void);
+#endif
@@ -0,0 +1,5 @@
+#ifndef _TEST_XHEAP_H
+#define _TEST_XHEAP_H
+#include <check.h>
+Suite * suite_xheap(void);
+#endif
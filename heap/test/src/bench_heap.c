@@ -0,0 +1,343 @@
+#include <heap.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+static int8_t bench_compare(void * p_key1, void * p_key2)
+{
+    int key1 = *(int *)p_key1;
+    int key2 = *(int *)p_key2;
+    return (key1 < key2) ? -1 : ((key1 == key2) ? 0 : 1);
+}
+
+/*
+ * @brief gets a monotonic time stamp
+ * @return the time in seconds
+ */
+static double bench_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+/*
+ * @brief a node of the layout the heap had before its entries were stored
+ *  inline, every element is allocated on its own
+ * @param p_data pointer to the data in the node
+ * @param index index of the node in the pointer array
+ */
+typedef struct bench_node {
+    void * p_data;
+    int64_t index;
+} bench_node;
+
+/*
+ * @brief the heap layout the inline entries replaced, an array of pointers
+ *  to nodes swapped a level at a time, kept here as the baseline to measure
+ *  against
+ * @param size the number of nodes in the heap
+ * @param node_space the number of pointers allocated
+ * @param compare the compare function called through a pointer as the heap does
+ * @param pp_array the nodes of the heap
+ */
+typedef struct bench_pointer_heap {
+    int64_t size;
+    int64_t node_space;
+    int8_t (* compare)(void * p_key1, void * p_key2);
+    bench_node ** pp_array;
+} bench_pointer_heap;
+
+/*
+ * @brief swaps two nodes of a pointer heap and their indexes
+ * @param p_heap the heap holding the nodes
+ * @param first the index of the first node
+ * @param second the index of the second node
+ */
+static void bench_pointer_swap(bench_pointer_heap * p_heap, int64_t first, int64_t second)
+{
+    bench_node * p_node = p_heap->pp_array[first];
+    p_heap->pp_array[first] = p_heap->pp_array[second];
+    p_heap->pp_array[second] = p_node;
+    p_heap->pp_array[first]->index = first;
+    p_heap->pp_array[second]->index = second;
+}
+
+/*
+ * @brief allocates a node and adds it to a min pointer heap
+ * @param p_heap the heap to add to
+ * @param p_data the data of the node
+ * @return 0 on success else -1
+ */
+static int8_t bench_pointer_insert(bench_pointer_heap * p_heap, void * p_data)
+{
+    bench_node * p_node = calloc(1, sizeof(*p_node));
+    if (NULL == p_node){
+        return -1;
+    }
+    if (((float)(p_heap->size + 1) / p_heap->node_space) >= .80){
+        bench_node ** pp_array = realloc(p_heap->pp_array, (p_heap->size + 1) * 2 * sizeof(*pp_array));
+        if (NULL == pp_array){
+            free(p_node);
+            return -1;
+        }
+        p_heap->pp_array = pp_array;
+        p_heap->node_space = (p_heap->size + 1) * 2;
+    }
+    p_node->p_data = p_data;
+    p_node->index = p_heap->size;
+    p_heap->pp_array[p_heap->size++] = p_node;
+    int64_t index = p_node->index;
+    while ((index > 0) && (-1 == p_heap->compare(p_heap->pp_array[index]->p_data, p_heap->pp_array[(index - 1) / 2]->p_data))){
+        bench_pointer_swap(p_heap, index, (index - 1) / 2);
+        index = (index - 1) / 2;
+    }
+    return 0;
+}
+
+/*
+ * @brief removes the root node of a non empty min pointer heap
+ * @param p_heap the heap to pull from
+ * @return the old root which the caller frees
+ */
+static bench_node * bench_pointer_pull(bench_pointer_heap * p_heap)
+{
+    bench_node * p_root = p_heap->pp_array[0];
+    p_heap->size--;
+    bench_pointer_swap(p_heap, 0, p_heap->size);
+    int64_t index = 0;
+    while (((2 * index) + 1) < p_heap->size){
+        int64_t child = (2 * index) + 1;
+        if (((child + 1) < p_heap->size) && (-1 == p_heap->compare(p_heap->pp_array[child + 1]->p_data, p_heap->pp_array[child]->p_data))){
+            child++;
+        }
+        if (-1 != p_heap->compare(p_heap->pp_array[child]->p_data, p_heap->pp_array[index]->p_data)){
+            break;
+        }
+        bench_pointer_swap(p_heap, index, child);
+        index = child;
+    }
+    return p_root;
+}
+
+/*
+ * @brief fills and drains the baseline pointer heap
+ * @param p_keys the keys to insert
+ * @param count the number of keys
+ * @return the nanoseconds per insert and pull pair
+ */
+static double bench_pointer(int * p_keys, int64_t count)
+{
+    bench_pointer_heap pointer_heap = {0, 5, bench_compare, calloc(5, sizeof(bench_node *))};
+    if (NULL == pointer_heap.pp_array){
+        return 0;
+    }
+    double start = bench_now();
+    for (int64_t index = 0; index < count; index++){
+        bench_pointer_insert(&pointer_heap, &p_keys[index]);
+    }
+    while (0 != pointer_heap.size){
+        free(bench_pointer_pull(&pointer_heap));
+    }
+    double elapsed = bench_now() - start;
+    free(pointer_heap.pp_array);
+    return (elapsed * 1e9) / count;
+}
+
+/*
+ * @brief fills and drains a heap through node handles
+ * @param p_keys the keys to insert
+ * @param count the number of keys
+ * @return the nanoseconds per insert and pull pair
+ */
+static double bench_handles(int * p_keys, int64_t count)
+{
+    heap * p_heap = heap_init(MIN, 2, NULL, bench_compare);
+    double start = bench_now();
+    for (int64_t index = 0; index < count; index++){
+        heap_insert(p_heap, &p_keys[index]);
+    }
+    for (int64_t index = 0; index < count; index++){
+        free(heap_pull(p_heap));
+    }
+    double elapsed = bench_now() - start;
+    heap_destroy(p_heap);
+    return (elapsed * 1e9) / count;
+}
+
+/*
+ * @brief fills and drains a heap through inline entries
+ * @param p_keys the keys to push
+ * @param count the number of keys
+ * @param arity the arity of the heap
+ * @param p_push set to the nanoseconds per push
+ * @param p_pop set to the nanoseconds per pop
+ */
+static void bench_inline(int * p_keys, int64_t count, int arity, double * p_push, double * p_pop)
+{
+    heap * p_heap = heap_init(MIN, arity, NULL, bench_compare);
+    double start = bench_now();
+    for (int64_t index = 0; index < count; index++){
+        heap_push(p_heap, &p_keys[index]);
+    }
+    double middle = bench_now();
+    for (int64_t index = 0; index < count; index++){
+        heap_pop(p_heap);
+    }
+    double end = bench_now();
+    heap_destroy(p_heap);
+    *p_push = ((middle - start) * 1e9) / count;
+    *p_pop = ((end - middle) * 1e9) / count;
+}
+
+/*
+ * @brief compares loading a heap one push at a time with a bulk build and
+ *  draining it one pop at a time with batches of heap_pull_n
+ * @param p_keys the keys to load
+ * @param count the number of keys
+ */
+static void bench_batch(int * p_keys, int64_t count)
+{
+    void ** pp_items = calloc(count, sizeof(*pp_items));
+    if (NULL == pp_items){
+        return;
+    }
+    for (int64_t index = 0; index < count; index++){
+        pp_items[index] = &p_keys[index];
+    }
+    double start = bench_now();
+    heap * p_heap = heap_init(MIN, 4, NULL, bench_compare);
+    for (int64_t index = 0; index < count; index++){
+        heap_push(p_heap, pp_items[index]);
+    }
+    double pushed = bench_now();
+    for (int64_t index = 0; index < count; index++){
+        heap_pop(p_heap);
+    }
+    double popped = bench_now();
+    heap_destroy(p_heap);
+    p_heap = heap_build(MIN, 4, pp_items, count, NULL, bench_compare);
+    double built = bench_now();
+    while (0 != heap_pull_n(p_heap, pp_items, 256)){
+    }
+    double pulled = bench_now();
+    heap_destroy(p_heap);
+    free(pp_items);
+    printf("%12ld %12.1f %12.1f %12.1f %12.1f\n", (long)count, ((pushed - start) * 1e9) / count, \
+        ((built - popped) * 1e9) / count, ((popped - pushed) * 1e9) / count, ((pulled - built) * 1e9) / count);
+}
+
+/*
+ * @brief compares selecting the k largest keys of a stream by pushing the
+ *  whole stream and pulling k times with offering it to a bounded heap
+ * @param p_keys the keys of the stream
+ * @param count the number of keys
+ * @param k the number of keys to select
+ */
+static void bench_topk(int * p_keys, int64_t count, int64_t k)
+{
+    void ** pp_out = calloc(k, sizeof(*pp_out));
+    if (NULL == pp_out){
+        return;
+    }
+    double start = bench_now();
+    heap * p_heap = heap_init(MAX, 4, NULL, bench_compare);
+    for (int64_t index = 0; index < count; index++){
+        heap_push(p_heap, &p_keys[index]);
+    }
+    heap_pull_n(p_heap, pp_out, k);
+    heap_destroy(p_heap);
+    double full = bench_now();
+    p_heap = heap_topk(MAX, k, NULL, bench_compare);
+    for (int64_t index = 0; index < count; index++){
+        heap_offer(p_heap, &p_keys[index]);
+    }
+    heap_topk_sorted(p_heap, pp_out);
+    heap_destroy(p_heap);
+    double bounded = bench_now();
+    free(pp_out);
+    printf("%12ld %6ld %14.1f %14.1f\n", (long)count, (long)k, ((full - start) * 1e9) / count, \
+        ((bounded - full) * 1e9) / count);
+}
+
+/*
+ * @brief times a binary heap that only serves one end against a min-max heap
+ *  popping from both ends in turn
+ * @param p_keys the keys to load
+ * @param count the number of keys
+ */
+static void bench_minmax(int * p_keys, int64_t count)
+{
+    double times[2][2];
+    int orderings[2] = {MIN, MINMAX};
+    for (int kind = 0; kind < 2; kind++){
+        double start = bench_now();
+        heap * p_heap = heap_init(orderings[kind], 2, NULL, bench_compare);
+        for (int64_t index = 0; index < count; index++){
+            heap_push(p_heap, &p_keys[index]);
+        }
+        double pushed = bench_now();
+        for (int64_t index = 0; index < count; index++){
+            if ((MINMAX == orderings[kind]) && (index & 1)){
+                heap_pop_max(p_heap);
+            }
+            else {
+                heap_pop(p_heap);
+            }
+        }
+        times[kind][0] = ((pushed - start) * 1e9) / count;
+        times[kind][1] = ((bench_now() - pushed) * 1e9) / count;
+        heap_destroy(p_heap);
+    }
+    printf("%12ld %12.1f %12.1f %12.1f %12.1f\n", (long)count, times[0][0], times[0][1], times[1][0], times[1][1]);
+}
+
+int main(int argc, char ** argv)
+{
+    // the largest heap to measure can be passed as the first argument
+    int64_t max_count = (argc > 1) ? strtoll(argv[1], NULL, 10) : 1000000;
+    int * p_keys = calloc(max_count, sizeof(*p_keys));
+    if (NULL == p_keys){
+        return EXIT_FAILURE;
+    }
+    srand(1);
+    for (int64_t index = 0; index < max_count; index++){
+        p_keys[index] = rand();
+    }
+    // the pointer column is the layout before the entries were inlined
+    printf("%12s %18s %18s %18s\n", "elements", "pointer ns", "insert/pull ns", "push/pop ns");
+    for (int64_t count = 10000; count <= max_count; count *= 10){
+        double push = 0;
+        double pop = 0;
+        double pointer = bench_pointer(p_keys, count);
+        bench_inline(p_keys, count, 2, &push, &pop);
+        printf("%12ld %18.1f %18.1f %18.1f\n", (long)count, pointer, bench_handles(p_keys, count), push + pop);
+    }
+    printf("\n%12s %6s %12s %12s\n", "elements", "arity", "push ns", "pop ns");
+    for (int64_t count = 10000; count <= max_count; count *= 10){
+        for (int arity = 2; arity <= 8; arity *= 2){
+            double push = 0;
+            double pop = 0;
+            bench_inline(p_keys, count, arity, &push, &pop);
+            printf("%12ld %6d %12.1f %12.1f\n", (long)count, arity, push, pop);
+        }
+    }
+    printf("\n%12s %12s %12s %12s %12s\n", "elements", "push ns", "build ns", "pop ns", "pull_n ns");
+    for (int64_t count = 10000; count <= max_count; count *= 10){
+        bench_batch(p_keys, count);
+    }
+    printf("\n%12s %6s %14s %14s\n", "elements", "k", "push+pull ns", "topk ns");
+    for (int64_t count = 10000; count <= max_count; count *= 10){
+        for (int64_t k = 10; k <= 1000; k *= 10){
+            bench_topk(p_keys, count, k);
+        }
+    }
+    printf("\n%12s %12s %12s %12s %12s\n", "elements", "min push ns", "min pop ns", "mm push ns", "mm pop ns");
+    for (int64_t count = 10000; count <= max_count; count *= 10){
+        bench_minmax(p_keys, count);
+    }
+    free(p_keys);
+    return EXIT_SUCCESS;
+}
+// end of source
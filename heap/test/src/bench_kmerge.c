@@ -0,0 +1,161 @@
+#include <heap.h>
+#include <kmerge.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+static int8_t bench_compare(void * p_key1, void * p_key2)
+{
+    uint64_t key1 = *(uint64_t *)p_key1;
+    uint64_t key2 = *(uint64_t *)p_key2;
+    return (key1 < key2) ? -1 : ((key1 == key2) ? 0 : 1);
+}
+
+/*
+ * @brief a run being merged through a heap
+ */
+typedef struct bench_run {
+    void ** pp_items;
+    int64_t count;
+    int64_t position;
+} bench_run;
+
+static int8_t bench_run_compare(void * p_key1, void * p_key2)
+{
+    bench_run * p_run1 = p_key1;
+    bench_run * p_run2 = p_key2;
+    return bench_compare(p_run1->pp_items[p_run1->position], p_run2->pp_items[p_run2->position]);
+}
+
+/*
+ * @brief gets a monotonic time stamp
+ * @return the time in seconds
+ */
+static double bench_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+/*
+ * @brief merges k sorted runs through a heap of runs with a pop and a push
+ *  per item
+ * @param ppp_runs the runs
+ * @param p_counts the number of items in each run
+ * @param k the number of runs
+ * @param pp_out receives the merged items
+ * @return the nanoseconds per item
+ */
+static double bench_heap(void *** ppp_runs, int64_t * p_counts, int64_t k, void ** pp_out)
+{
+    double start = bench_now();
+    bench_run * p_runs = calloc(k, sizeof(*p_runs));
+    heap * p_heap = heap_init(MIN, 4, NULL, bench_run_compare);
+    int64_t total = 0;
+    for (int64_t index = 0; index < k; index++){
+        p_runs[index] = (bench_run){ppp_runs[index], p_counts[index], 0};
+        heap_push(p_heap, &p_runs[index]);
+    }
+    while (0 != heap_size(p_heap)){
+        bench_run * p_run = heap_pop(p_heap);
+        pp_out[total++] = p_run->pp_items[p_run->position++];
+        if (p_run->position < p_run->count){
+            heap_push(p_heap, p_run);
+        }
+    }
+    heap_destroy(p_heap);
+    free(p_runs);
+    return ((bench_now() - start) * 1e9) / total;
+}
+
+/*
+ * @brief merges k sorted runs through the loser tree in batches
+ * @param ppp_runs the runs
+ * @param p_counts the number of items in each run
+ * @param k the number of runs
+ * @param pp_out receives the merged items
+ * @return the nanoseconds per item
+ */
+static double bench_loser(void *** ppp_runs, int64_t * p_counts, int64_t k, void ** pp_out)
+{
+    double start = bench_now();
+    kmerge * p_merge = kmerge_init_arrays(MIN, k, ppp_runs, p_counts, bench_compare);
+    int64_t total = 0;
+    int64_t pulled = 0;
+    while (0 < (pulled = kmerge_pull(p_merge, pp_out + total, 4096))){
+        total += pulled;
+    }
+    kmerge_destroy(p_merge);
+    return ((bench_now() - start) * 1e9) / total;
+}
+
+/*
+ * @brief sorts a file of random keys with a memory limit
+ * @param count the number of keys
+ * @param memory the memory limit in bytes
+ */
+static void bench_file(int64_t count, size_t memory)
+{
+    FILE * p_in = tmpfile();
+    FILE * p_out = tmpfile();
+    if ((NULL == p_in) || (NULL == p_out)){
+        return;
+    }
+    uint64_t seed = 1;
+    for (int64_t index = 0; index < count; index++){
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        fwrite(&seed, sizeof(seed), 1, p_in);
+    }
+    rewind(p_in);
+    double start = bench_now();
+    int8_t retval = kmerge_sort_file(p_in, p_out, sizeof(uint64_t), memory, bench_compare);
+    double elapsed = bench_now() - start;
+    printf("%12ld %10zu %10.2f %10.1f %s\n", (long)count, memory >> 10, elapsed, (elapsed * 1e9) / count, \
+        (0 == retval) ? "ok" : "failed");
+    fclose(p_in);
+    fclose(p_out);
+}
+
+int main(int argc, char ** argv)
+{
+    // the number of items to merge can be passed as the first argument
+    int64_t total = (argc > 1) ? strtoll(argv[1], NULL, 10) : 4000000;
+    uint64_t * p_keys = malloc(total * sizeof(*p_keys));
+    void ** pp_items = malloc(total * sizeof(*pp_items));
+    void ** pp_out = malloc(total * sizeof(*pp_out));
+    if ((NULL == p_keys) || (NULL == pp_items) || (NULL == pp_out)){
+        return EXIT_FAILURE;
+    }
+    printf("%8s %12s %12s %12s\n", "runs", "items", "heap ns", "loser ns");
+    for (int64_t k = 4; k <= 4096; k *= 4){
+        void *** ppp_runs = malloc(k * sizeof(*ppp_runs));
+        int64_t * p_counts = malloc(k * sizeof(*p_counts));
+        int64_t length = total / k;
+        // every run counts up from a random start so the runs interleave
+        srand(1);
+        for (int64_t run = 0; run < k; run++){
+            uint64_t key = (uint64_t)rand();
+            for (int64_t index = 0; index < length; index++){
+                key += (uint64_t)(rand() % 1000);
+                p_keys[(run * length) + index] = key;
+                pp_items[(run * length) + index] = &p_keys[(run * length) + index];
+            }
+            ppp_runs[run] = pp_items + (run * length);
+            p_counts[run] = length;
+        }
+        printf("%8ld %12ld %12.1f %12.1f\n", (long)k, (long)(length * k), bench_heap(ppp_runs, p_counts, k, pp_out), \
+            bench_loser(ppp_runs, p_counts, k, pp_out));
+        free(ppp_runs);
+        free(p_counts);
+    }
+    printf("\n%12s %10s %10s %10s\n", "keys", "memory KiB", "seconds", "ns/key");
+    bench_file(total, 1 << 20);
+    bench_file(total, 8 << 20);
+    free(p_keys);
+    free(pp_items);
+    free(pp_out);
+    return EXIT_SUCCESS;
+}
+// end of source
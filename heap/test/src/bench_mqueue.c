@@ -0,0 +1,135 @@
+#include <heap.h>
+#include <mqueue.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+static int8_t bench_compare(void * p_key1, void * p_key2)
+{
+    uint64_t key1 = *(uint64_t *)p_key1;
+    uint64_t key2 = *(uint64_t *)p_key2;
+    return (key1 < key2) ? -1 : ((key1 == key2) ? 0 : 1);
+}
+
+/*
+ * @brief gets a monotonic time stamp
+ * @return the time in seconds
+ */
+static double bench_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+/*
+ * @brief the work handed to each benchmark thread
+ * @param p_queue the multiqueue to use or NULL to use the locked heap
+ * @param p_heap the heap shared behind p_lock
+ * @param p_lock the lock serializing every heap operation
+ * @param steps the number of pull and insert pairs to run
+ * @param seed the seed of the thread's key generator
+ */
+typedef struct bench_arg {
+    mqueue * p_queue;
+    heap * p_heap;
+    pthread_mutex_t * p_lock;
+    int64_t steps;
+    uint64_t seed;
+} bench_arg;
+
+/*
+ * @brief pulls an element, bumps its key and inserts it again
+ * @param p_arg the bench_arg of the thread
+ * @return NULL
+ */
+static void * bench_worker(void * p_arg)
+{
+    bench_arg * p_bench = p_arg;
+    uint64_t seed = p_bench->seed;
+    for (int64_t step = 0; step < p_bench->steps; step++){
+        uint64_t * p_key = NULL;
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        if (NULL != p_bench->p_queue){
+            p_key = mqueue_pull(p_bench->p_queue);
+            *p_key += seed >> 44;
+            mqueue_insert(p_bench->p_queue, p_key);
+        }
+        else {
+            pthread_mutex_lock(p_bench->p_lock);
+            p_key = heap_pop(p_bench->p_heap);
+            *p_key += seed >> 44;
+            heap_push(p_bench->p_heap, p_key);
+            pthread_mutex_unlock(p_bench->p_lock);
+        }
+    }
+    return NULL;
+}
+
+/*
+ * @brief runs threads over a prefilled queue and times them
+ * @param p_keys storage for the keys in the queue
+ * @param count the number of keys in the queue
+ * @param threads the number of threads to run
+ * @param factor the lanes per thread or 0 for the mutex wrapped heap
+ * @param steps the pull and insert pairs per thread
+ * @return the million operation pairs per second across all threads
+ */
+static double bench_run(uint64_t * p_keys, int64_t count, int threads, int factor, int64_t steps)
+{
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    mqueue * p_queue = NULL;
+    heap * p_heap = NULL;
+    if (0 == factor){
+        p_heap = heap_init(MIN, 4, NULL, bench_compare);
+    }
+    else {
+        p_queue = mqueue_init(MIN, threads, factor, NULL, bench_compare);
+    }
+    for (int64_t index = 0; index < count; index++){
+        p_keys[index] = (uint64_t)rand();
+        (NULL != p_queue) ? mqueue_insert(p_queue, &p_keys[index]) : heap_push(p_heap, &p_keys[index]);
+    }
+    pthread_t * p_threads = calloc(threads, sizeof(*p_threads));
+    bench_arg * p_args = calloc(threads, sizeof(*p_args));
+    double start = bench_now();
+    for (int index = 0; index < threads; index++){
+        p_args[index] = (bench_arg){p_queue, p_heap, &lock, steps, (uint64_t)index + 1};
+        pthread_create(&p_threads[index], NULL, bench_worker, &p_args[index]);
+    }
+    for (int index = 0; index < threads; index++){
+        pthread_join(p_threads[index], NULL);
+    }
+    double elapsed = bench_now() - start;
+    free(p_threads);
+    free(p_args);
+    mqueue_destroy(p_queue);
+    heap_destroy(p_heap);
+    return (threads * steps) / elapsed / 1e6;
+}
+
+int main(int argc, char ** argv)
+{
+    // the most threads to run can be passed as the first argument
+    int max_threads = (argc > 1) ? atoi(argv[1]) : 8;
+    int64_t count = 1000000;
+    int64_t steps = 1000000;
+    uint64_t * p_keys = calloc(count, sizeof(*p_keys));
+    if (NULL == p_keys){
+        return EXIT_FAILURE;
+    }
+    printf("%8s %14s %14s %14s %14s\n", "threads", "mutex Mops", "mq c=1 Mops", "mq c=2 Mops", "mq c=4 Mops");
+    for (int threads = 1; threads <= max_threads; threads *= 2){
+        srand(1);
+        printf("%8d %14.2f", threads, bench_run(p_keys, count, threads, 0, steps));
+        for (int factor = 1; factor <= 4; factor *= 2){
+            printf(" %14.2f", bench_run(p_keys, count, threads, factor, steps));
+        }
+        printf("\n");
+    }
+    free(p_keys);
+    return EXIT_SUCCESS;
+}
+// end of source
@@ -0,0 +1,171 @@
+#include <heap.h>
+#include <pheap.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * @param DEGREE the number of edges leaving each vertex
+ * @param MAX_WEIGHT the largest edge weight
+ */
+enum {DEGREE = 8, MAX_WEIGHT = 1000};
+
+/*
+ * @brief a vertex of the benchmark graph
+ * @param distance the best known distance from the source
+ * @param p_edges the targets of the edges leaving the vertex
+ * @param p_weights the weights of the edges leaving the vertex
+ */
+typedef struct vertex {
+    int64_t distance;
+    int32_t p_edges[DEGREE];
+    int32_t p_weights[DEGREE];
+} vertex;
+
+static int8_t bench_compare(void * p_key1, void * p_key2)
+{
+    int64_t key1 = ((vertex *)p_key1)->distance;
+    int64_t key2 = ((vertex *)p_key2)->distance;
+    return (key1 < key2) ? -1 : ((key1 == key2) ? 0 : 1);
+}
+
+/*
+ * @brief gets a monotonic time stamp
+ * @return the time in seconds
+ */
+static double bench_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+/*
+ * @brief resets every distance before a search
+ * @param p_graph the vertices of the graph
+ * @param count the number of vertices
+ */
+static void bench_reset(vertex * p_graph, int64_t count)
+{
+    for (int64_t index = 0; index < count; index++){
+        p_graph[index].distance = INT64_MAX;
+    }
+    p_graph[0].distance = 0;
+}
+
+/*
+ * @brief runs dijkstra from vertex 0 with the array heap and heap_update
+ * @param p_graph the vertices of the graph
+ * @param count the number of vertices
+ * @param arity the arity of the heap
+ * @param pp_handles scratch space for a handle per vertex
+ * @param p_updates set to the number of decrease key operations
+ * @return the sum of the distances to check the searches agree
+ */
+static int64_t bench_heap(vertex * p_graph, int64_t count, int arity, hnode ** pp_handles, int64_t * p_updates)
+{
+    heap * p_heap = heap_init(MIN, arity, NULL, bench_compare);
+    int64_t total = 0;
+    bench_reset(p_graph, count);
+    for (int64_t index = 0; index < count; index++){
+        pp_handles[index] = NULL;
+    }
+    pp_handles[0] = heap_insert(p_heap, &p_graph[0]);
+    while (0 != heap_size(p_heap)){
+        hnode * p_node = heap_pull(p_heap);
+        vertex * p_vertex = heap_data(p_node);
+        free(p_node);
+        total += p_vertex->distance;
+        for (int edge = 0; edge < DEGREE; edge++){
+            int32_t target = p_vertex->p_edges[edge];
+            int64_t distance = p_vertex->distance + p_vertex->p_weights[edge];
+            if (distance >= p_graph[target].distance){
+                continue;
+            }
+            p_graph[target].distance = distance;
+            if (NULL == pp_handles[target]){
+                pp_handles[target] = heap_insert(p_heap, &p_graph[target]);
+            }
+            else {
+                heap_update(p_heap, pp_handles[target]);
+                (*p_updates)++;
+            }
+        }
+    }
+    heap_destroy(p_heap);
+    return total;
+}
+
+/*
+ * @brief runs dijkstra from vertex 0 with the pairing heap
+ * @param p_graph the vertices of the graph
+ * @param count the number of vertices
+ * @param pp_handles scratch space for a handle per vertex
+ * @return the sum of the distances to check the searches agree
+ */
+static int64_t bench_pheap(vertex * p_graph, int64_t count, phnode ** pp_handles)
+{
+    pheap * p_heap = pheap_init(MIN, NULL, bench_compare);
+    int64_t total = 0;
+    bench_reset(p_graph, count);
+    for (int64_t index = 0; index < count; index++){
+        pp_handles[index] = NULL;
+    }
+    pp_handles[0] = pheap_insert(p_heap, &p_graph[0]);
+    while (0 != pheap_size(p_heap)){
+        vertex * p_vertex = pheap_pull(p_heap);
+        total += p_vertex->distance;
+        for (int edge = 0; edge < DEGREE; edge++){
+            int32_t target = p_vertex->p_edges[edge];
+            int64_t distance = p_vertex->distance + p_vertex->p_weights[edge];
+            if (distance >= p_graph[target].distance){
+                continue;
+            }
+            p_graph[target].distance = distance;
+            if (NULL == pp_handles[target]){
+                pp_handles[target] = pheap_insert(p_heap, &p_graph[target]);
+            }
+            else {
+                pheap_decrease_key(p_heap, pp_handles[target]);
+            }
+        }
+    }
+    pheap_destroy(p_heap);
+    return total;
+}
+
+int main(int argc, char ** argv)
+{
+    // the largest graph to search can be passed as the first argument
+    int64_t max_count = (argc > 1) ? strtoll(argv[1], NULL, 10) : 1000000;
+    vertex * p_graph = calloc(max_count, sizeof(*p_graph));
+    void ** pp_handles = calloc(max_count, sizeof(*pp_handles));
+    if ((NULL == p_graph) || (NULL == pp_handles)){
+        return EXIT_FAILURE;
+    }
+    printf("%12s %12s %12s %12s %12s %12s\n", "vertices", "updates", "binary ms", "4-ary ms", "pairing ms", "agree");
+    for (int64_t count = 10000; count <= max_count; count *= 10){
+        srand(1);
+        for (int64_t index = 0; index < count; index++){
+            for (int edge = 0; edge < DEGREE; edge++){
+                p_graph[index].p_edges[edge] = rand() % count;
+                p_graph[index].p_weights[edge] = 1 + (rand() % MAX_WEIGHT);
+            }
+        }
+        int64_t updates = 0;
+        double start = bench_now();
+        int64_t binary = bench_heap(p_graph, count, 2, (hnode **)pp_handles, &updates);
+        double middle = bench_now();
+        int64_t quad = bench_heap(p_graph, count, 4, (hnode **)pp_handles, &updates);
+        double paired = bench_now();
+        int64_t pairing = bench_pheap(p_graph, count, (phnode **)pp_handles);
+        double end = bench_now();
+        printf("%12ld %12ld %12.1f %12.1f %12.1f %12s\n", (long)count, (long)(updates / 2), (middle - start) * 1e3, \
+            (paired - middle) * 1e3, (end - paired) * 1e3, ((binary == quad) && (quad == pairing)) ? "yes" : "no");
+    }
+    free(p_graph);
+    free(pp_handles);
+    return EXIT_SUCCESS;
+}
+// end of source
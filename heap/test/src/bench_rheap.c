@@ -0,0 +1,134 @@
+#include <heap.h>
+#include <rheap.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+static int8_t bench_compare(void * p_key1, void * p_key2)
+{
+    uint64_t key1 = *(uint64_t *)p_key1;
+    uint64_t key2 = *(uint64_t *)p_key2;
+    return (key1 < key2) ? -1 : ((key1 == key2) ? 0 : 1);
+}
+
+/*
+ * @brief gets a monotonic time stamp
+ * @return the time in seconds
+ */
+static double bench_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+/*
+ * @brief gets the delay before the next event of a simulation
+ * @return a pseudo random delay of up to a million ticks
+ */
+static uint64_t bench_delay(void)
+{
+    return (uint64_t)rand() % 1000000;
+}
+
+/*
+ * @brief runs an event simulation where each pulled event schedules another
+ *  on the array heap through heap_insert and heap_pull
+ * @param p_keys storage for one key per live event
+ * @param count the number of live events
+ * @param steps the number of events to process
+ * @return the nanoseconds per pull and insert pair
+ */
+static double bench_heap(uint64_t * p_keys, int64_t count, int64_t steps)
+{
+    heap * p_heap = heap_init(MIN, 2, NULL, bench_compare);
+    srand(1);
+    for (int64_t index = 0; index < count; index++){
+        p_keys[index] = bench_delay();
+        heap_insert(p_heap, &p_keys[index]);
+    }
+    double start = bench_now();
+    for (int64_t step = 0; step < steps; step++){
+        hnode * p_node = heap_pull(p_heap);
+        uint64_t * p_key = heap_data(p_node);
+        free(p_node);
+        *p_key += bench_delay();
+        heap_insert(p_heap, p_key);
+    }
+    double elapsed = bench_now() - start;
+    heap_destroy(p_heap);
+    return (elapsed * 1e9) / steps;
+}
+
+/*
+ * @brief runs the same simulation on the array heap with inline entries
+ * @param p_keys storage for one key per live event
+ * @param count the number of live events
+ * @param steps the number of events to process
+ * @return the nanoseconds per pop and push pair
+ */
+static double bench_inline(uint64_t * p_keys, int64_t count, int64_t steps)
+{
+    heap * p_heap = heap_init(MIN, 4, NULL, bench_compare);
+    srand(1);
+    for (int64_t index = 0; index < count; index++){
+        p_keys[index] = bench_delay();
+        heap_push(p_heap, &p_keys[index]);
+    }
+    double start = bench_now();
+    for (int64_t step = 0; step < steps; step++){
+        uint64_t * p_key = heap_pop(p_heap);
+        *p_key += bench_delay();
+        heap_push(p_heap, p_key);
+    }
+    double elapsed = bench_now() - start;
+    heap_destroy(p_heap);
+    return (elapsed * 1e9) / steps;
+}
+
+/*
+ * @brief runs the same simulation on the radix heap
+ * @param p_keys storage for one key per live event
+ * @param count the number of live events
+ * @param steps the number of events to process
+ * @return the nanoseconds per pull and insert pair
+ */
+static double bench_radix(uint64_t * p_keys, int64_t count, int64_t steps)
+{
+    rheap * p_heap = rheap_init(NULL);
+    srand(1);
+    for (int64_t index = 0; index < count; index++){
+        p_keys[index] = bench_delay();
+        rheap_insert(p_heap, p_keys[index], &p_keys[index]);
+    }
+    double start = bench_now();
+    for (int64_t step = 0; step < steps; step++){
+        uint64_t key = 0;
+        uint64_t * p_key = rheap_pull(p_heap, &key);
+        *p_key = key + bench_delay();
+        rheap_insert(p_heap, *p_key, p_key);
+    }
+    double elapsed = bench_now() - start;
+    rheap_destroy(p_heap);
+    return (elapsed * 1e9) / steps;
+}
+
+int main(int argc, char ** argv)
+{
+    // the most live events to simulate can be passed as the first argument
+    int64_t max_count = (argc > 1) ? strtoll(argv[1], NULL, 10) : 1000000;
+    uint64_t * p_keys = calloc(max_count, sizeof(*p_keys));
+    if (NULL == p_keys){
+        return EXIT_FAILURE;
+    }
+    printf("%12s %18s %18s %18s\n", "live events", "insert/pull ns", "4-ary push/pop ns", "radix ns");
+    for (int64_t count = 1000; count <= max_count; count *= 10){
+        int64_t steps = 4 * max_count;
+        printf("%12ld %18.1f %18.1f %18.1f\n", (long)count, bench_heap(p_keys, count, steps), \
+            bench_inline(p_keys, count, steps), bench_radix(p_keys, count, steps));
+    }
+    free(p_keys);
+    return EXIT_SUCCESS;
+}
+// end of source
@@ -0,0 +1,133 @@
+#include <heap.h>
+#include <twheel.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+static int8_t bench_compare(void * p_key1, void * p_key2)
+{
+    uint64_t key1 = *(uint64_t *)p_key1;
+    uint64_t key2 = *(uint64_t *)p_key2;
+    return (key1 < key2) ? -1 : ((key1 == key2) ? 0 : 1);
+}
+
+static int64_t fired = 0;
+static void bench_expire(void ** pp_data, int64_t count)
+{
+    (void)pp_data;
+    fired += count;
+}
+
+/*
+ * @brief gets a monotonic time stamp
+ * @return the time in seconds
+ */
+static double bench_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+/*
+ * @brief gets the timeout of the timer scheduled at a step, longer than
+ *  the live window so a timer is always pending when its turn to be
+ *  cancelled comes
+ * @param live the number of timers scheduled ahead of a cancel
+ * @return a pseudo random timeout
+ */
+static uint64_t bench_timeout(int64_t live)
+{
+    return (uint64_t)live + 1 + ((uint64_t)rand() % (uint64_t)live);
+}
+
+/*
+ * @brief schedules a timer every tick and cancels the one scheduled live
+ *  ticks earlier unless it is one of the few left to expire, using heap
+ *  handles with heap_remove as the cancel
+ * @param p_expires storage for the expiry of every step
+ * @param pp_nodes storage for the handle of every step
+ * @param live the number of timers scheduled ahead of a cancel
+ * @param steps the number of ticks to run
+ * @return the nanoseconds per tick
+ */
+static double bench_heap(uint64_t * p_expires, hnode ** pp_nodes, int64_t live, int64_t steps)
+{
+    heap * p_heap = heap_init(MIN, 4, NULL, bench_compare);
+    srand(1);
+    fired = 0;
+    double start = bench_now();
+    for (int64_t step = 0; step < steps; step++){
+        p_expires[step] = (uint64_t)step + bench_timeout(live);
+        pp_nodes[step] = heap_insert(p_heap, &p_expires[step]);
+        if ((step >= live) && (0 != ((step - live) % 10))){
+            heap_remove(p_heap, pp_nodes[step - live]);
+        }
+        hnode * p_node = heap_peek(p_heap);
+        while ((NULL != p_node) && (*(uint64_t *)heap_data(p_node) <= (uint64_t)step)){
+            free(heap_pull(p_heap));
+            fired++;
+            p_node = heap_peek(p_heap);
+        }
+    }
+    double elapsed = bench_now() - start;
+    heap_destroy(p_heap);
+    return (elapsed * 1e9) / steps;
+}
+
+/*
+ * @brief runs the same timer load on the timing wheel
+ * @param p_expires storage for the expiry of every step
+ * @param pp_timers storage for the timer of every step
+ * @param live the number of timers scheduled ahead of a cancel
+ * @param steps the number of ticks to run
+ * @return the nanoseconds per tick
+ */
+static double bench_wheel(uint64_t * p_expires, twtimer ** pp_timers, int64_t live, int64_t steps)
+{
+    twheel * p_wheel = twheel_init(0, 1, 4, NULL);
+    srand(1);
+    fired = 0;
+    double start = bench_now();
+    for (int64_t step = 0; step < steps; step++){
+        p_expires[step] = (uint64_t)step + bench_timeout(live);
+        pp_timers[step] = twheel_schedule(p_wheel, p_expires[step], &p_expires[step]);
+        if ((step >= live) && (0 != ((step - live) % 10))){
+            twheel_cancel(p_wheel, pp_timers[step - live]);
+        }
+        twheel_advance(p_wheel, (uint64_t)step, bench_expire);
+    }
+    double elapsed = bench_now() - start;
+    twheel_destroy(p_wheel);
+    return (elapsed * 1e9) / steps;
+}
+
+int main(int argc, char ** argv)
+{
+    // the most timers scheduled ahead of a cancel can be passed as the first argument
+    int64_t max_live = (argc > 1) ? strtoll(argv[1], NULL, 10) : 1000000;
+    int64_t steps = 4 * max_live;
+    uint64_t * p_expires = calloc(steps, sizeof(*p_expires));
+    hnode ** pp_nodes = calloc(steps, sizeof(*pp_nodes));
+    twtimer ** pp_timers = calloc(steps, sizeof(*pp_timers));
+    if ((NULL == p_expires) || (NULL == pp_nodes) || (NULL == pp_timers)){
+        free(p_expires);
+        free(pp_nodes);
+        free(pp_timers);
+        return EXIT_FAILURE;
+    }
+    printf("%12s %14s %14s %10s\n", "live timers", "heap ns/tick", "wheel ns/tick", "fired");
+    for (int64_t live = 1000; live <= max_live; live *= 10){
+        double heap_ns = bench_heap(p_expires, pp_nodes, live, steps);
+        int64_t heap_fired = fired;
+        double wheel_ns = bench_wheel(p_expires, pp_timers, live, steps);
+        printf("%12ld %14.1f %14.1f %10ld%s\n", (long)live, heap_ns, wheel_ns, (long)fired, \
+            (heap_fired == fired) ? "" : " mismatch");
+    }
+    free(p_expires);
+    free(pp_nodes);
+    free(pp_timers);
+    return EXIT_SUCCESS;
+}
+// end of source
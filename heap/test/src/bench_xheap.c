@@ -0,0 +1,82 @@
+#include <heap.h>
+#include <xheap.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * @brief a record with a key and a payload like a queued job
+ */
+typedef struct bench_record {
+    uint64_t key;
+    uint64_t payload[3];
+} bench_record;
+
+static int8_t bench_compare(void * p_key1, void * p_key2)
+{
+    uint64_t key1 = ((bench_record *)p_key1)->key;
+    uint64_t key2 = ((bench_record *)p_key2)->key;
+    return (key1 < key2) ? -1 : ((key1 == key2) ? 0 : 1);
+}
+
+/*
+ * @brief gets a monotonic time stamp
+ * @return the time in seconds
+ */
+static double bench_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+/*
+ * @brief pushes random records into a queue with a memory limit then pops
+ *  them all checking the order
+ * @param memory the memory limit of the queue in bytes
+ * @param count the number of records
+ */
+static void bench_run(size_t memory, int64_t count)
+{
+    xheap * p_xheap = xheap_init(MIN, sizeof(bench_record), memory, bench_compare);
+    if (NULL == p_xheap){
+        return;
+    }
+    uint64_t seed = 1;
+    double start = bench_now();
+    for (int64_t index = 0; index < count; index++){
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        bench_record record = {seed >> 16, {0, 0, 0}};
+        if (0 != xheap_push(p_xheap, &record)){
+            break;
+        }
+    }
+    double pushed = bench_now();
+    int64_t runs = xheap_runs(p_xheap);
+    uint64_t last = 0;
+    int64_t disordered = 0;
+    bench_record record;
+    while (0 == xheap_pop(p_xheap, &record)){
+        disordered += (record.key < last);
+        last = record.key;
+    }
+    double popped = bench_now();
+    printf("%10zu %12ld %8.0fx %6ld %10.1f %10.1f %s\n", memory >> 10, (long)count, \
+        ((double)count * sizeof(bench_record)) / memory, (long)runs, ((pushed - start) * 1e9) / count, \
+        ((popped - pushed) * 1e9) / count, (0 == disordered) ? "ok" : "disordered");
+    xheap_destroy(p_xheap);
+}
+
+int main(int argc, char ** argv)
+{
+    // the most records to queue can be passed as the first argument
+    int64_t max_count = (argc > 1) ? strtoll(argv[1], NULL, 10) : 10000000;
+    size_t memory = 4 << 20;
+    printf("%10s %12s %9s %6s %10s %10s\n", "memory KiB", "records", "data/mem", "runs", "push ns", "pop ns");
+    for (int64_t count = max_count / 100; count <= max_count; count *= 10){
+        bench_run(memory, count);
+    }
+    return EXIT_SUCCESS;
+}
+// end of source
@@ -1,14 +1,35 @@
 #include <check.h>
 #include <stdlib.h>
 #include <test_heap.h>
+#include <test_pheap.h>
+#include <test_rheap.h>
+#include <test_mqueue.h>
+#include <test_twheel.h>
+#include <test_hitters.h>
+#include <test_xheap.h>
+#include <test_kmerge.h>
 
 int main(void)
 {
     int num_failed = 0;
     // create the test suites
     Suite * p_heap = suite_heap();
+    Suite * p_pheap = suite_pheap();
+    Suite * p_rheap = suite_rheap();
+    Suite * p_mqueue = suite_mqueue();
+    Suite * p_twheel = suite_twheel();
+    Suite * p_hitters = suite_hitters();
+    Suite * p_xheap = suite_xheap();
+    Suite * p_kmerge = suite_kmerge();
     // create and add to suite runner
     SRunner * p_srunner = srunner_create(p_heap);
+    srunner_add_suite(p_srunner, p_pheap);
+    srunner_add_suite(p_srunner, p_rheap);
+    srunner_add_suite(p_srunner, p_mqueue);
+    srunner_add_suite(p_srunner, p_twheel);
+    srunner_add_suite(p_srunner, p_hitters);
+    srunner_add_suite(p_srunner, p_xheap);
+    srunner_add_suite(p_srunner, p_kmerge);
     srunner_set_fork_status(p_srunner, CK_NOFORK);
     // run all test
     srunner_run_all(p_srunner, CK_NORMAL);
@@ -13,10 +13,11 @@ static int8_t test_compare(void * p_key1, void * p_key2){
 
 heap * p_heap = NULL;
 int num = 10;
+static hnode * p_first = NULL;
 static void start_heap(void)
 {
-    p_heap = heap_init(MAX, NULL, test_compare); 
-    heap_insert(p_heap, &num);
+    p_heap = heap_init(MAX, 2, NULL, test_compare); 
+    p_first = heap_insert(p_heap, &num);
 }
 
 static void teardown_heap(void)
@@ -57,12 +58,13 @@ START_TEST(test_heap_data)
 
 START_TEST(test_heap_init_null)
 {
-    ck_assert(NULL == heap_init(MIN, NULL, NULL));
+    ck_assert(NULL == heap_init(MIN, 2, NULL, NULL));
+    ck_assert(NULL == heap_init(MIN, 3, NULL, test_compare));
 } END_TEST
 
 START_TEST(test_heap_init_min)
 {
-    heap * p_min_heap = heap_init(MIN, NULL, test_compare);
+    heap * p_min_heap = heap_init(MIN, 2, NULL, test_compare);
     int num1 = 10;
     int num2 = 20;
     int num3 = 30;
@@ -73,6 +75,364 @@ START_TEST(test_heap_init_min)
     heap_destroy(p_min_heap);
 } END_TEST
 
+START_TEST(test_heap_pull_order)
+{
+    static int nums[1000];
+    heap * p_min_heap = heap_init(MIN, 2, NULL, test_compare);
+    srand(27);
+    for (int index = 0; index < 1000; index++){
+        nums[index] = rand() % 500;
+        heap_insert(p_min_heap, &nums[index]);
+    }
+    int last = -1;
+    for (int index = 0; index < 1000; index++){
+        hnode * p_node = heap_pull(p_min_heap);
+        ck_assert(NULL != p_node);
+        ck_assert_int_le(last, *(int *)heap_data(p_node));
+        last = *(int *)heap_data(p_node);
+        free(p_node);
+    }
+    ck_assert_int_eq(0, heap_size(p_min_heap));
+    ck_assert(NULL == heap_pull(p_min_heap));
+    heap_destroy(p_min_heap);
+} END_TEST
+
+START_TEST(test_heap_push_pop)
+{
+    static int nums[1000];
+    srand(270);
+    for (int index = 0; index < 1000; index++){
+        nums[index] = rand() % 500;
+        ck_assert_int_eq(0, heap_push(p_heap, &nums[index]));
+    }
+    ck_assert_int_eq(1001, heap_size(p_heap));
+    int last = 500;
+    for (int index = 0; index < 1001; index++){
+        hnode * p_peeked = heap_peek(p_heap);
+        ck_assert_int_eq(*(int *)heap_top(p_heap), *(int *)heap_data(p_peeked));
+        int * p_num = heap_pop(p_heap);
+        // the handle made by the peek is left with the caller
+        free(p_peeked);
+        ck_assert(NULL != p_num);
+        ck_assert_int_ge(last, *p_num);
+        last = *p_num;
+    }
+    ck_assert(NULL == heap_pop(p_heap));
+    ck_assert(NULL == heap_top(p_heap));
+} END_TEST
+
+START_TEST(test_heap_pull_pushed)
+{
+    int num2 = 20;
+    heap_push(p_heap, &num2);
+    // pulling an element pushed without a handle still hands back a node
+    hnode * p_node = heap_pull(p_heap);
+    ck_assert_int_eq(num2, *(int *)heap_data(p_node));
+    free(p_node);
+    ck_assert_int_eq(num, *(int *)heap_pop(p_heap));
+    free(p_first);
+} END_TEST
+
+START_TEST(test_heap_pop_inserted)
+{
+    int num2 = 20;
+    int num3 = 30;
+    hnode * p_node = heap_insert(p_heap, &num2);
+    heap_push(p_heap, &num3);
+    ck_assert_int_eq(num3, *(int *)heap_pop(p_heap));
+    // popping an element added with heap_insert leaves its handle with the
+    // caller and out of the heap
+    ck_assert_int_eq(num2, *(int *)heap_pop(p_heap));
+    ck_assert_int_eq(num2, *(int *)heap_data(p_node));
+    num2 = 50;
+    ck_assert_int_eq(-1, heap_update(p_heap, p_node));
+    ck_assert_int_eq(-1, heap_remove(p_heap, p_node));
+    ck_assert_int_eq(num, *(int *)heap_top(p_heap));
+    ck_assert_int_eq(0, heap_update(p_heap, p_first));
+    free(p_node);
+} END_TEST
+
+START_TEST(test_heap_update)
+{
+    int num2 = 20;
+    int num3 = 30;
+    heap_insert(p_heap, &num2);
+    hnode * p_node = heap_insert(p_heap, &num3);
+    // lower the max below every other key so it must sink
+    num3 = 5;
+    ck_assert_int_eq(0, heap_update(p_heap, p_node));
+    ck_assert_int_eq(num2, *(int *)heap_data(heap_peek(p_heap)));
+    // raise it back above the others so it must rise
+    num3 = 50;
+    ck_assert_int_eq(0, heap_update(p_heap, p_node));
+    ck_assert(p_node == heap_peek(p_heap));
+    ck_assert_int_eq(-1, heap_update(p_heap, NULL));
+} END_TEST
+
+START_TEST(test_heap_remove)
+{
+    int num2 = 20;
+    int num3 = 30;
+    hnode * p_node = heap_insert(p_heap, &num2);
+    hnode * p_popped = heap_insert(p_heap, &num3);
+    ck_assert_int_eq(0, heap_remove(p_heap, p_node));
+    ck_assert_int_eq(2, heap_size(p_heap));
+    ck_assert_int_eq(num3, *(int *)heap_pop(p_heap));
+    ck_assert_int_eq(num, *(int *)heap_pop(p_heap));
+    free(p_popped);
+    free(p_first);
+    hnode * p_pulled = heap_insert(p_heap, &num2);
+    ck_assert(p_pulled == heap_pull(p_heap));
+    // a node that already left the heap can not be removed again
+    ck_assert_int_eq(-1, heap_remove(p_heap, p_pulled));
+    free(p_pulled);
+} END_TEST
+
+START_TEST(test_heap_update_random)
+{
+    // random key changes and removals through handles must leave a heap that
+    // still pulls every remaining key in order
+    enum {COUNT = 512};
+    static int keys[COUNT];
+    static hnode * handles[COUNT];
+    heap * p_min_heap = heap_init(MIN, 2, NULL, test_compare);
+    srand(28);
+    for (int index = 0; index < COUNT; index++){
+        keys[index] = rand() % 1000;
+        handles[index] = heap_insert(p_min_heap, &keys[index]);
+    }
+    int64_t size = COUNT;
+    for (int step = 0; step < 5000; step++){
+        int index = rand() % COUNT;
+        if (NULL == handles[index]){
+            continue;
+        }
+        if (0 == (step % 10)){
+            ck_assert_int_eq(0, heap_remove(p_min_heap, handles[index]));
+            handles[index] = NULL;
+            size--;
+        }
+        else {
+            keys[index] = rand() % 1000;
+            ck_assert_int_eq(0, heap_update(p_min_heap, handles[index]));
+        }
+        // the root must always hold the smallest remaining key
+        int smallest = 1000;
+        for (int other = 0; other < COUNT; other++){
+            if ((NULL != handles[other]) && (keys[other] < smallest)){
+                smallest = keys[other];
+            }
+        }
+        ck_assert_int_eq(smallest, *(int *)heap_top(p_min_heap));
+    }
+    ck_assert_int_eq(size, heap_size(p_min_heap));
+    int last = -1;
+    while (0 != heap_size(p_min_heap)){
+        hnode * p_node = heap_pull(p_min_heap);
+        ck_assert_int_le(last, *(int *)heap_data(p_node));
+        last = *(int *)heap_data(p_node);
+        // every pulled node must be one of the handles still in the heap
+        int index = (int *)heap_data(p_node) - keys;
+        ck_assert(handles[index] == p_node);
+        handles[index] = NULL;
+        free(p_node);
+    }
+    heap_destroy(p_min_heap);
+} END_TEST
+
+START_TEST(test_heap_arity)
+{
+    static int keys[2000];
+    static hnode * handles[2000];
+    int arities[] = {4, 8};
+    for (int arity = 0; arity < 2; arity++){
+        heap * p_wide_heap = heap_init(MAX, arities[arity], NULL, test_compare);
+        srand(29);
+        for (int index = 0; index < 2000; index++){
+            keys[index] = rand() % 3000;
+            handles[index] = heap_insert(p_wide_heap, &keys[index]);
+        }
+        // move half of the keys and drop a tenth through their handles
+        for (int index = 0; index < 2000; index += 2){
+            keys[index] = rand() % 3000;
+            ck_assert_int_eq(0, heap_update(p_wide_heap, handles[index]));
+        }
+        for (int index = 1; index < 2000; index += 10){
+            ck_assert_int_eq(0, heap_remove(p_wide_heap, handles[index]));
+        }
+        ck_assert_int_eq(1800, heap_size(p_wide_heap));
+        int last = 3000;
+        while (0 != heap_size(p_wide_heap)){
+            int * p_num = heap_pop(p_wide_heap);
+            ck_assert_int_ge(last, *p_num);
+            last = *p_num;
+        }
+        heap_destroy(p_wide_heap);
+        // the popped handles are the caller's, the removed ones were freed
+        for (int index = 0; index < 2000; index++){
+            if (1 != index % 10){
+                free(handles[index]);
+            }
+        }
+    }
+} END_TEST
+
+START_TEST(test_heap_build)
+{
+    static int keys[1000];
+    static void * items[1000];
+    int arities[] = {2, 4, 8};
+    srand(30);
+    for (int index = 0; index < 1000; index++){
+        keys[index] = rand() % 700;
+        items[index] = &keys[index];
+    }
+    for (int arity = 0; arity < 3; arity++){
+        heap * p_built = heap_build(MIN, arities[arity], items, 1000, NULL, test_compare);
+        ck_assert(NULL != p_built);
+        ck_assert_int_eq(1000, heap_size(p_built));
+        int last = -1;
+        while (0 != heap_size(p_built)){
+            int * p_num = heap_pop(p_built);
+            ck_assert_int_le(last, *p_num);
+            last = *p_num;
+        }
+        heap_destroy(p_built);
+    }
+    heap * p_empty = heap_build(MAX, 2, items, 0, NULL, test_compare);
+    ck_assert_int_eq(0, heap_size(p_empty));
+    heap_destroy(p_empty);
+    ck_assert(NULL == heap_build(MAX, 2, NULL, 10, NULL, test_compare));
+} END_TEST
+
+START_TEST(test_heap_reserve)
+{
+    static int keys[100];
+    ck_assert_int_eq(0, heap_reserve(p_heap, 100));
+    ck_assert_int_eq(-1, heap_reserve(NULL, 100));
+    for (int index = 0; index < 100; index++){
+        keys[index] = index;
+        heap_push(p_heap, &keys[index]);
+    }
+    ck_assert_int_eq(99, *(int *)heap_top(p_heap));
+} END_TEST
+
+START_TEST(test_heap_pull_n)
+{
+    static int keys[50];
+    static hnode * handles[50];
+    void * out[60];
+    for (int index = 0; index < 50; index++){
+        keys[index] = (index * 7) % 50;
+        handles[index] = heap_insert(p_heap, &keys[index]);
+    }
+    // the fixture holds 10 as well so 10 is pulled twice
+    ck_assert_int_eq(20, heap_pull_n(p_heap, out, 20));
+    ck_assert_int_eq(49, *(int *)out[0]);
+    for (int index = 1; index < 20; index++){
+        ck_assert_int_ge(*(int *)out[index - 1], *(int *)out[index]);
+    }
+    ck_assert_int_eq(31, heap_pull_n(p_heap, out, 60));
+    ck_assert_int_eq(0, *(int *)out[30]);
+    ck_assert_int_eq(0, heap_pull_n(p_heap, out, 5));
+    for (int index = 0; index < 50; index++){
+        free(handles[index]);
+    }
+    free(p_first);
+} END_TEST
+
+START_TEST(test_heap_topk)
+{
+    static int keys[200];
+    void * out[20];
+    heap * p_top = heap_topk(MAX, 10, NULL, test_compare);
+    ck_assert(NULL != p_top);
+    ck_assert(NULL == heap_topk(MAX, 0, NULL, test_compare));
+    srand(35);
+    for (int index = 0; index < 200; index++){
+        keys[index] = rand() % 1000;
+        ck_assert_int_ne(-1, heap_offer(p_top, &keys[index]));
+        ck_assert_int_le(heap_size(p_top), 10);
+    }
+    // the root is the smallest of the ten kept so a smaller key is turned away
+    int small = -1;
+    ck_assert_int_eq(0, heap_offer(p_top, &small));
+    ck_assert_int_eq(10, heap_topk_sorted(p_top, out));
+    ck_assert_int_eq(0, heap_size(p_top));
+    int larger = 0;
+    for (int index = 0; index < 200; index++){
+        larger += (keys[index] > *(int *)out[9]);
+    }
+    ck_assert_int_le(larger, 9);
+    for (int index = 1; index < 10; index++){
+        ck_assert_int_ge(*(int *)out[index - 1], *(int *)out[index]);
+    }
+    heap_destroy(p_top);
+    // without a limit every offer is kept
+    ck_assert_int_eq(1, heap_offer(p_heap, &keys[0]));
+    ck_assert_int_eq(2, heap_size(p_heap));
+    ck_assert_int_eq(-1, heap_offer(p_heap, NULL));
+} END_TEST
+
+START_TEST(test_heap_minmax)
+{
+    static int keys[300];
+    hnode * nodes[300];
+    ck_assert(NULL == heap_init(MINMAX, 4, NULL, test_compare));
+    ck_assert(NULL == heap_top_max(p_heap));
+    heap * p_minmax = heap_init(MINMAX, 2, NULL, test_compare);
+    ck_assert(NULL == heap_pop_max(p_minmax));
+    srand(36);
+    for (int index = 0; index < 300; index++){
+        keys[index] = rand() % 1000;
+        nodes[index] = heap_insert(p_minmax, &keys[index]);
+    }
+    // move and remove keys through their handles
+    for (int index = 0; index < 100; index++){
+        keys[index] = rand() % 1000;
+        ck_assert_int_eq(0, heap_update(p_minmax, nodes[index]));
+    }
+    for (int index = 100; index < 150; index++){
+        ck_assert_int_eq(0, heap_remove(p_minmax, nodes[index]));
+    }
+    int low = -1;
+    int high = 1000;
+    for (int index = 0; index < 125; index++){
+        int * p_min = heap_top(p_minmax);
+        int * p_max = heap_top_max(p_minmax);
+        ck_assert(p_min == heap_pop(p_minmax));
+        ck_assert(p_max == heap_pop_max(p_minmax));
+        ck_assert_int_ge(*p_min, low);
+        ck_assert_int_le(*p_max, high);
+        ck_assert_int_le(*p_min, *p_max);
+        low = *p_min;
+        high = *p_max;
+    }
+    ck_assert_int_eq(0, heap_size(p_minmax));
+    heap_destroy(p_minmax);
+    for (int index = 0; index < 300; index++){
+        if ((index < 100) || (index >= 150)){
+            free(nodes[index]);
+        }
+    }
+    // a bulk built min-max heap drains from both ends in order
+    void * items[300];
+    for (int index = 0; index < 300; index++){
+        keys[index] = rand() % 1000;
+        items[index] = &keys[index];
+    }
+    p_minmax = heap_build(MINMAX, 2, items, 300, NULL, test_compare);
+    hnode * p_node = heap_pull_max(p_minmax);
+    high = *(int *)heap_data(p_node);
+    free(p_node);
+    for (int index = 0; index < 299; index++){
+        int * p_max = heap_pop_max(p_minmax);
+        ck_assert_int_le(*p_max, high);
+        high = *p_max;
+    }
+    heap_destroy(p_minmax);
+} END_TEST
+
 // create suite
 Suite * suite_heap(void)
 {
@@ -87,6 +447,19 @@ Suite * suite_heap(void)
     tcase_add_test(p_core, test_heap_data);
     tcase_add_test(p_core, test_heap_init_null);
     tcase_add_test(p_core, test_heap_init_min);
+    tcase_add_test(p_core, test_heap_pull_order);
+    tcase_add_test(p_core, test_heap_push_pop);
+    tcase_add_test(p_core, test_heap_pull_pushed);
+    tcase_add_test(p_core, test_heap_pop_inserted);
+    tcase_add_test(p_core, test_heap_update);
+    tcase_add_test(p_core, test_heap_remove);
+    tcase_add_test(p_core, test_heap_update_random);
+    tcase_add_test(p_core, test_heap_arity);
+    tcase_add_test(p_core, test_heap_build);
+    tcase_add_test(p_core, test_heap_reserve);
+    tcase_add_test(p_core, test_heap_pull_n);
+    tcase_add_test(p_core, test_heap_topk);
+    tcase_add_test(p_core, test_heap_minmax);
     // add core to suite
     suite_add_tcase(p_suite, p_core);
     return p_suite;
@@ -0,0 +1,153 @@
+#include <check.h>
+#include <test_hitters.h>
+#include <hitters.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+static int test_compare(void * p_key1, void * p_key2)
+{
+    return *(int *)p_key1 - *(int *)p_key2;
+}
+
+static uint32_t test_hash(void * p_key)
+{
+    // a weak hash so probe runs form and wrap around the table
+    return (uint32_t)(*(int *)p_key % 7);
+}
+
+static int destroyed = 0;
+static void test_destroy(void * p_key)
+{
+    destroyed++;
+    free(p_key);
+}
+
+/*
+ * @brief makes a key the tracker can take ownership of
+ * @param value the value of the key
+ * @return the new key
+ */
+static int * test_key(int value)
+{
+    int * p_key = malloc(sizeof(*p_key));
+    *p_key = value;
+    return p_key;
+}
+
+/*
+ * @brief counts a key freeing it when the tracker already has an equal one
+ * @param p_hitters the tracker to count the key in
+ * @param value the value of the key
+ */
+static void test_observe(hitters * p_hitters, int value)
+{
+    int * p_key = test_key(value);
+    if (1 != hitters_observe(p_hitters, p_key)){
+        free(p_key);
+    }
+}
+
+static hitters * p_hitters = NULL;
+static void start_hitters(void)
+{
+    destroyed = 0;
+    p_hitters = hitters_init(8, test_destroy, test_compare, test_hash);
+    test_observe(p_hitters, 10);
+}
+
+static void teardown_hitters(void)
+{
+    hitters_destroy(p_hitters);
+}
+
+START_TEST(test_hitters_init)
+{
+    ck_assert(NULL != p_hitters);
+    ck_assert_int_eq(1, hitters_size(p_hitters));
+    ck_assert_int_eq(-1, hitters_size(NULL));
+    ck_assert(NULL == hitters_init(0, NULL, test_compare, test_hash));
+    ck_assert(NULL == hitters_init(8, NULL, NULL, test_hash));
+    ck_assert(NULL == hitters_init(8, NULL, test_compare, NULL));
+    ck_assert_int_eq(-1, hitters_observe(p_hitters, NULL));
+} END_TEST
+
+START_TEST(test_hitters_exact)
+{
+    // fewer distinct keys than counters are counted exactly
+    int num = 3;
+    for (int index = 0; index < 4; index++){
+        test_observe(p_hitters, 3);
+    }
+    test_observe(p_hitters, 10);
+    uint64_t error = 1;
+    ck_assert_uint_eq(4, hitters_count(p_hitters, &num, &error));
+    ck_assert_uint_eq(0, error);
+    num = 4;
+    ck_assert_uint_eq(0, hitters_count(p_hitters, &num, NULL));
+    void * keys[4];
+    uint64_t counts[4];
+    ck_assert_int_eq(2, hitters_top(p_hitters, 4, keys, counts));
+    ck_assert_int_eq(3, *(int *)keys[0]);
+    ck_assert_uint_eq(4, counts[0]);
+    ck_assert_int_eq(10, *(int *)keys[1]);
+    ck_assert_uint_eq(2, counts[1]);
+} END_TEST
+
+START_TEST(test_hitters_stream)
+{
+    // three keys make up half of a stream of mostly distinct keys
+    srand(35);
+    int heavy[3] = {1000, 2000, 3000};
+    uint64_t seen[3] = {0, 0, 0};
+    for (int index = 0; index < 6000; index++){
+        int which = rand() % 6;
+        if (which < 3){
+            test_observe(p_hitters, heavy[which]);
+            seen[which]++;
+        }
+        else {
+            test_observe(p_hitters, 4000 + (rand() % 5000));
+        }
+    }
+    ck_assert_int_eq(8, hitters_size(p_hitters));
+    void * keys[3];
+    uint64_t counts[3];
+    ck_assert_int_eq(3, hitters_top(p_hitters, 3, keys, counts));
+    for (int index = 0; index < 3; index++){
+        int key = *(int *)keys[index];
+        ck_assert(((1000 == key) || (2000 == key) || (3000 == key)));
+        uint64_t error = 0;
+        ck_assert_uint_eq(counts[index], hitters_count(p_hitters, &heavy[(key / 1000) - 1], &error));
+        // the estimate never undercounts and overcounts by at most the error
+        ck_assert(counts[index] >= seen[(key / 1000) - 1]);
+        ck_assert(counts[index] - error <= seen[(key / 1000) - 1]);
+    }
+    ck_assert_int_gt(destroyed, 0);
+} END_TEST
+
+START_TEST(test_hitters_destroy)
+{
+    for (int index = 0; index < 20; index++){
+        test_observe(p_hitters, index);
+    }
+    int before = destroyed;
+    hitters_destroy(p_hitters);
+    ck_assert_int_eq(before + 8, destroyed);
+    p_hitters = NULL;
+} END_TEST
+
+// create suite
+Suite * suite_hitters(void)
+{
+    Suite * p_suite = suite_create("Heavy Hitters");
+    TCase * p_core = tcase_create("Core");
+    // add test cases
+    tcase_add_checked_fixture(p_core, start_hitters, teardown_hitters);
+    tcase_add_test(p_core, test_hitters_init);
+    tcase_add_test(p_core, test_hitters_exact);
+    tcase_add_test(p_core, test_hitters_stream);
+    tcase_add_test(p_core, test_hitters_destroy);
+    // add core to suite
+    suite_add_tcase(p_suite, p_core);
+    return p_suite;
+}
@@ -0,0 +1,168 @@
+#include <check.h>
+#include <test_kmerge.h>
+#include <kmerge.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+static int8_t test_compare(void * p_key1, void * p_key2)
+{
+    int key1 = *(int *)p_key1;
+    int key2 = *(int *)p_key2;
+    return (key1 < key2) ? -1 : ((key1 == key2) ? 0 : 1);
+}
+
+/*
+ * @brief a source counting up by a step to a limit
+ */
+typedef struct test_counter {
+    int values[40];
+    int step;
+    int limit;
+    int position;
+} test_counter;
+
+static void * test_next(void * p_source)
+{
+    test_counter * p_counter = p_source;
+    int value = (p_counter->position + 1) * p_counter->step;
+    if (value > p_counter->limit){
+        return NULL;
+    }
+    // every item keeps its own storage so pulled items stay valid
+    p_counter->values[p_counter->position] = value;
+    return &p_counter->values[p_counter->position++];
+}
+
+static int keys[5][40];
+static void * items[5][40];
+static void ** arrays[5];
+static int64_t counts[5] = {40, 0, 17, 1, 33};
+static kmerge * p_kmerge = NULL;
+static void start_kmerge(void)
+{
+    srand(38);
+    for (int array = 0; array < 5; array++){
+        int key = 0;
+        for (int index = 0; index < counts[array]; index++){
+            key += rand() % 10;
+            keys[array][index] = key;
+            items[array][index] = &keys[array][index];
+        }
+        arrays[array] = items[array];
+    }
+    p_kmerge = kmerge_init_arrays(MIN, 5, arrays, counts, test_compare);
+}
+
+static void teardown_kmerge(void)
+{
+    kmerge_destroy(p_kmerge);
+}
+
+START_TEST(test_kmerge_init)
+{
+    void * out[4];
+    ck_assert(NULL != p_kmerge);
+    ck_assert(NULL == kmerge_init_arrays(MIN, 0, arrays, counts, test_compare));
+    ck_assert(NULL == kmerge_init_arrays(MIN, 5, arrays, counts, NULL));
+    ck_assert(NULL == kmerge_init(MIN, 5, NULL, test_next, test_compare));
+    ck_assert_int_eq(-1, kmerge_pull(NULL, out, 4));
+    ck_assert_int_eq(-1, kmerge_pull(p_kmerge, NULL, 4));
+} END_TEST
+
+START_TEST(test_kmerge_arrays)
+{
+    void * out[16];
+    int64_t total = 0;
+    int64_t pulled = 0;
+    int last = -1;
+    // pull in batches that do not line up with the array sizes
+    while (0 != (pulled = kmerge_pull(p_kmerge, out, 16))){
+        for (int64_t index = 0; index < pulled; index++){
+            ck_assert_int_ge(*(int *)out[index], last);
+            last = *(int *)out[index];
+        }
+        total += pulled;
+    }
+    ck_assert_int_eq(91, total);
+    ck_assert_int_eq(0, kmerge_pull(p_kmerge, out, 16));
+} END_TEST
+
+START_TEST(test_kmerge_stable)
+{
+    // equal items come out in the order of their sources
+    int same[3] = {7, 7, 7};
+    void * lists[3][1] = {{&same[0]}, {&same[1]}, {&same[2]}};
+    void ** heads[3] = {lists[0], lists[1], lists[2]};
+    int64_t ones[3] = {1, 1, 1};
+    void * out[3];
+    kmerge * p_stable = kmerge_init_arrays(MAX, 3, heads, ones, test_compare);
+    ck_assert_int_eq(3, kmerge_pull(p_stable, out, 3));
+    ck_assert(&same[0] == out[0]);
+    ck_assert(&same[1] == out[1]);
+    ck_assert(&same[2] == out[2]);
+    kmerge_destroy(p_stable);
+} END_TEST
+
+START_TEST(test_kmerge_callback)
+{
+    // sources counting by 3 5 and 7 merge into one ascending stream
+    test_counter counters[3] = {{{0}, 3, 100, 0}, {{0}, 5, 100, 0}, {{0}, 7, 100, 0}};
+    void * sources[3] = {&counters[0], &counters[1], &counters[2]};
+    kmerge * p_counts = kmerge_init(MIN, 3, sources, test_next, test_compare);
+    void * out[1];
+    int last = 0;
+    int total = 0;
+    while (1 == kmerge_pull(p_counts, out, 1)){
+        ck_assert_int_ge(*(int *)out[0], last);
+        last = *(int *)out[0];
+        total++;
+    }
+    ck_assert_int_eq(33 + 20 + 14, total);
+    kmerge_destroy(p_counts);
+} END_TEST
+
+START_TEST(test_kmerge_sort_file)
+{
+    FILE * p_in = tmpfile();
+    FILE * p_out = tmpfile();
+    ck_assert(NULL != p_in);
+    ck_assert(NULL != p_out);
+    srand(39);
+    for (int index = 0; index < 20000; index++){
+        int key = rand() % 1000000;
+        fwrite(&key, sizeof(key), 1, p_in);
+    }
+    rewind(p_in);
+    // 256 bytes of memory forces many runs and several merge passes
+    ck_assert_int_eq(0, kmerge_sort_file(p_in, p_out, sizeof(int), 256, test_compare));
+    rewind(p_out);
+    int key = 0;
+    int last = -1;
+    int total = 0;
+    while (1 == fread(&key, sizeof(key), 1, p_out)){
+        ck_assert_int_ge(key, last);
+        last = key;
+        total++;
+    }
+    ck_assert_int_eq(20000, total);
+    ck_assert_int_eq(-1, kmerge_sort_file(p_in, p_out, 0, 256, test_compare));
+    fclose(p_in);
+    fclose(p_out);
+} END_TEST
+
+// create suite
+Suite * suite_kmerge(void)
+{
+    Suite * p_suite = suite_create("K-way Merge");
+    TCase * p_core = tcase_create("Core");
+    // add test cases
+    tcase_add_checked_fixture(p_core, start_kmerge, teardown_kmerge);
+    tcase_add_test(p_core, test_kmerge_init);
+    tcase_add_test(p_core, test_kmerge_arrays);
+    tcase_add_test(p_core, test_kmerge_stable);
+    tcase_add_test(p_core, test_kmerge_callback);
+    tcase_add_test(p_core, test_kmerge_sort_file);
+    // add core to suite
+    suite_add_tcase(p_suite, p_core);
+    return p_suite;
+}
@@ -0,0 +1,174 @@
+#include <check.h>
+#include <test_mqueue.h>
+#include <mqueue.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+
+static int8_t test_compare(void * p_key1, void * p_key2)
+{
+    int key1 = *(int *)p_key1;
+    int key2 = *(int *)p_key2;
+    return (key1 < key2) ? -1 : ((key1 == key2) ? 0 : 1);
+}
+
+static int destroyed = 0;
+static void test_destroy(void * p_data)
+{
+    (void)p_data;
+    destroyed++;
+}
+
+static mqueue * p_mqueue = NULL;
+static int num = 10;
+static void start_mqueue(void)
+{
+    destroyed = 0;
+    p_mqueue = mqueue_init(MIN, 4, 2, test_destroy, test_compare);
+    mqueue_insert(p_mqueue, &num);
+}
+
+static void teardown_mqueue(void)
+{
+    mqueue_destroy(p_mqueue);
+}
+
+START_TEST(test_mqueue_init)
+{
+    ck_assert(NULL != p_mqueue);
+    ck_assert_int_eq(1, mqueue_size(p_mqueue));
+    ck_assert_int_eq(-1, mqueue_size(NULL));
+    ck_assert(NULL == mqueue_init(MIN, 0, 2, NULL, test_compare));
+    ck_assert(NULL == mqueue_init(MIN, 4, 0, NULL, test_compare));
+    ck_assert(NULL == mqueue_init(MIN, 4, 2, NULL, NULL));
+    ck_assert_int_eq(-1, mqueue_insert(p_mqueue, NULL));
+    ck_assert(NULL == mqueue_pull(NULL));
+} END_TEST
+
+START_TEST(test_mqueue_exact)
+{
+    // a single lane has no relaxation and pulls in exact order
+    mqueue * p_exact = mqueue_init(MAX, 1, 1, NULL, test_compare);
+    static int keys[500];
+    srand(33);
+    for (int index = 0; index < 500; index++){
+        keys[index] = rand() % 1000;
+        ck_assert_int_eq(0, mqueue_insert(p_exact, &keys[index]));
+    }
+    int last = 1000;
+    for (int index = 0; index < 500; index++){
+        int * p_key = mqueue_pull(p_exact);
+        ck_assert(NULL != p_key);
+        ck_assert_int_le(*p_key, last);
+        last = *p_key;
+    }
+    ck_assert(NULL == mqueue_pull(p_exact));
+    mqueue_destroy(p_exact);
+} END_TEST
+
+START_TEST(test_mqueue_pull)
+{
+    static int keys[1000];
+    static int seen[1000];
+    for (int index = 0; index < 1000; index++){
+        keys[index] = index;
+        seen[index] = 0;
+        mqueue_insert(p_mqueue, &keys[index]);
+    }
+    ck_assert_int_eq(1001, mqueue_size(p_mqueue));
+    // every element comes out exactly once even though the order is relaxed
+    int fixture = 0;
+    for (int index = 0; index < 1001; index++){
+        int * p_key = mqueue_pull(p_mqueue);
+        ck_assert(NULL != p_key);
+        if (&num == p_key){
+            fixture++;
+        }
+        else {
+            seen[*p_key]++;
+        }
+    }
+    ck_assert(NULL == mqueue_pull(p_mqueue));
+    ck_assert_int_eq(1, fixture);
+    for (int index = 0; index < 1000; index++){
+        ck_assert_int_eq(1, seen[index]);
+    }
+    ck_assert_int_eq(0, mqueue_size(p_mqueue));
+    ck_assert_int_eq(0, destroyed);
+} END_TEST
+
+#define THREADS 4
+#define PER_THREAD 5000
+static int shared[THREADS * PER_THREAD];
+static _Atomic int pulled[THREADS * PER_THREAD];
+static void * test_worker(void * p_arg)
+{
+    int first = *(int *)p_arg;
+    for (int index = first; index < first + PER_THREAD; index++){
+        mqueue_insert(p_mqueue, &shared[index]);
+        // pull roughly every other insert so lanes fill and drain concurrently
+        if (index % 2){
+            int * p_key = mqueue_pull(p_mqueue);
+            if ((NULL != p_key) && (&num != p_key)){
+                pulled[*p_key]++;
+            }
+        }
+    }
+    return NULL;
+}
+
+START_TEST(test_mqueue_threads)
+{
+    pthread_t threads[THREADS];
+    int firsts[THREADS];
+    for (int index = 0; index < THREADS * PER_THREAD; index++){
+        shared[index] = index;
+        pulled[index] = 0;
+    }
+    for (int index = 0; index < THREADS; index++){
+        firsts[index] = index * PER_THREAD;
+        ck_assert_int_eq(0, pthread_create(&threads[index], NULL, test_worker, &firsts[index]));
+    }
+    for (int index = 0; index < THREADS; index++){
+        pthread_join(threads[index], NULL);
+    }
+    int * p_key = NULL;
+    while (NULL != (p_key = mqueue_pull(p_mqueue))){
+        if (&num != p_key){
+            pulled[*p_key]++;
+        }
+    }
+    // nothing is lost or handed out twice
+    for (int index = 0; index < THREADS * PER_THREAD; index++){
+        ck_assert_int_eq(1, pulled[index]);
+    }
+    ck_assert_int_eq(0, mqueue_size(p_mqueue));
+} END_TEST
+
+START_TEST(test_mqueue_destroy)
+{
+    static int keys[50];
+    for (int index = 0; index < 50; index++){
+        mqueue_insert(p_mqueue, &keys[index]);
+    }
+    mqueue_destroy(p_mqueue);
+    ck_assert_int_eq(51, destroyed);
+    p_mqueue = NULL;
+} END_TEST
+
+// create suite
+Suite * suite_mqueue(void)
+{
+    Suite * p_suite = suite_create("MultiQueue");
+    TCase * p_core = tcase_create("Core");
+    // add test cases
+    tcase_add_checked_fixture(p_core, start_mqueue, teardown_mqueue);
+    tcase_add_test(p_core, test_mqueue_init);
+    tcase_add_test(p_core, test_mqueue_exact);
+    tcase_add_test(p_core, test_mqueue_pull);
+    tcase_add_test(p_core, test_mqueue_threads);
+    tcase_add_test(p_core, test_mqueue_destroy);
+    // add core to suite
+    suite_add_tcase(p_suite, p_core);
+    return p_suite;
+}
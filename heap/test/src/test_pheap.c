@@ -0,0 +1,172 @@
+#include <check.h>
+#include <test_pheap.h>
+#include <pheap.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+static int8_t test_compare(void * p_key1, void * p_key2){
+    int key1 = *(int*)p_key1;
+    int key2 = *(int*)p_key2;
+    return (key1 < key2) ? -1 : ((key1 == key2) ? 0 : 1);
+}
+
+static int destroyed = 0;
+static void test_destroy(void * p_data)
+{
+    (void)p_data;
+    destroyed++;
+}
+
+static pheap * p_pheap = NULL;
+static int num = 10;
+static void start_pheap(void)
+{
+    destroyed = 0;
+    p_pheap = pheap_init(MIN, test_destroy, test_compare);
+    pheap_insert(p_pheap, &num);
+}
+
+static void teardown_pheap(void)
+{
+    pheap_destroy(p_pheap);
+}
+
+START_TEST(test_pheap_init)
+{
+    ck_assert(NULL != p_pheap);
+    ck_assert_int_eq(1, pheap_size(p_pheap));
+    ck_assert(NULL == pheap_init(MIN, NULL, NULL));
+} END_TEST
+
+START_TEST(test_pheap_pull_order)
+{
+    static int keys[2000];
+    srand(31);
+    for (int index = 0; index < 2000; index++){
+        keys[index] = rand() % 1000;
+        ck_assert(NULL != pheap_insert(p_pheap, &keys[index]));
+    }
+    ck_assert_int_eq(2001, pheap_size(p_pheap));
+    int last = -1;
+    while (0 != pheap_size(p_pheap)){
+        ck_assert_int_eq(*(int *)pheap_data(pheap_peek(p_pheap)), *(int *)pheap_data(pheap_peek(p_pheap)));
+        int * p_num = pheap_pull(p_pheap);
+        ck_assert_int_le(last, *p_num);
+        last = *p_num;
+    }
+    ck_assert(NULL == pheap_pull(p_pheap));
+    ck_assert(NULL == pheap_peek(p_pheap));
+    // pulled data is handed back so it is not torn down
+    ck_assert_int_eq(0, destroyed);
+} END_TEST
+
+START_TEST(test_pheap_decrease_key)
+{
+    static int keys[1000];
+    static phnode * handles[1000];
+    srand(310);
+    for (int index = 0; index < 1000; index++){
+        keys[index] = 1000 + (rand() % 1000);
+        handles[index] = pheap_insert(p_pheap, &keys[index]);
+    }
+    // interleave pulls with decreases like a shortest path search
+    for (int round = 0; round < 5; round++){
+        for (int step = 0; step < 300; step++){
+            int index = rand() % 1000;
+            if (NULL == handles[index]){
+                continue;
+            }
+            keys[index] -= rand() % 500;
+            ck_assert_int_eq(0, pheap_decrease_key(p_pheap, handles[index]));
+        }
+        for (int step = 0; step < 100; step++){
+            int * p_num = pheap_pull(p_pheap);
+            if (p_num != &num){
+                handles[p_num - keys] = NULL;
+            }
+        }
+    }
+    int last = -1000;
+    while (0 != pheap_size(p_pheap)){
+        int * p_num = pheap_pull(p_pheap);
+        ck_assert_int_le(last, *p_num);
+        last = *p_num;
+    }
+} END_TEST
+
+START_TEST(test_pheap_meld)
+{
+    static int keys[400];
+    pheap * p_other = pheap_init(MIN, test_destroy, test_compare);
+    phnode * p_handle = NULL;
+    for (int index = 0; index < 400; index++){
+        keys[index] = (index * 37) % 400;
+        p_handle = pheap_insert((index % 2) ? p_pheap : p_other, &keys[index]);
+    }
+    ck_assert_int_eq(-1, pheap_meld(p_pheap, p_pheap));
+    ck_assert_int_eq(0, pheap_meld(p_pheap, p_other));
+    ck_assert_int_eq(401, pheap_size(p_pheap));
+    ck_assert_int_eq(0, pheap_size(p_other));
+    // handles from the melded heap stay valid
+    keys[399] = -1;
+    ck_assert_int_eq(0, pheap_decrease_key(p_pheap, p_handle));
+    ck_assert_int_eq(-1, *(int *)pheap_pull(p_pheap));
+    pheap_destroy(p_other);
+    int last = -1;
+    for (int index = 0; index < 200; index++){
+        int * p_num = pheap_pull(p_pheap);
+        ck_assert_int_le(last, *p_num);
+        last = *p_num;
+    }
+    // the remaining nodes are torn down with the heap
+    pheap_destroy(p_pheap);
+    ck_assert_int_eq(200, destroyed);
+    p_pheap = NULL;
+} END_TEST
+
+START_TEST(test_pheap_meld_drained)
+{
+    static int keys[600];
+    pheap * p_drained = pheap_init(MIN, NULL, test_compare);
+    for (int index = 0; index < 300; index++){
+        keys[index] = index;
+        pheap_insert(p_drained, &keys[index]);
+    }
+    while (0 != pheap_size(p_drained)){
+        pheap_pull(p_drained);
+    }
+    // only free nodes come across and both heaps keep working after the meld
+    ck_assert_int_eq(0, pheap_meld(p_pheap, p_drained));
+    ck_assert_int_eq(1, pheap_size(p_pheap));
+    for (int index = 300; index < 600; index++){
+        keys[index] = 600 - index;
+        ck_assert(NULL != pheap_insert((index % 2) ? p_pheap : p_drained, &keys[index]));
+    }
+    ck_assert_int_eq(151, pheap_size(p_pheap));
+    ck_assert_int_eq(150, pheap_size(p_drained));
+    ck_assert_int_eq(0, pheap_meld(p_drained, p_pheap));
+    int last = -1;
+    while (0 != pheap_size(p_drained)){
+        int * p_num = pheap_pull(p_drained);
+        ck_assert_int_le(last, *p_num);
+        last = *p_num;
+    }
+    pheap_destroy(p_drained);
+} END_TEST
+
+// create suite
+Suite * suite_pheap(void)
+{
+    Suite * p_suite = suite_create("Pairing Heap");
+    TCase * p_core = tcase_create("Core");
+    // add test cases
+    tcase_add_checked_fixture(p_core, start_pheap, teardown_pheap);
+    tcase_add_test(p_core, test_pheap_init);
+    tcase_add_test(p_core, test_pheap_pull_order);
+    tcase_add_test(p_core, test_pheap_decrease_key);
+    tcase_add_test(p_core, test_pheap_meld);
+    tcase_add_test(p_core, test_pheap_meld_drained);
+    // add core to suite
+    suite_add_tcase(p_suite, p_core);
+    return p_suite;
+}
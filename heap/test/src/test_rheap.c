@@ -0,0 +1,136 @@
+#include <check.h>
+#include <test_rheap.h>
+#include <rheap.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+static int destroyed = 0;
+static void test_destroy(void * p_data)
+{
+    (void)p_data;
+    destroyed++;
+}
+
+static rheap * p_rheap = NULL;
+static int num = 10;
+static void start_rheap(void)
+{
+    destroyed = 0;
+    p_rheap = rheap_init(test_destroy);
+    rheap_insert(p_rheap, 10, &num);
+}
+
+static void teardown_rheap(void)
+{
+    rheap_destroy(p_rheap);
+}
+
+START_TEST(test_rheap_init)
+{
+    ck_assert(NULL != p_rheap);
+    ck_assert_int_eq(1, rheap_size(p_rheap));
+    ck_assert_int_eq(-1, rheap_size(NULL));
+} END_TEST
+
+START_TEST(test_rheap_pull)
+{
+    int num2 = 20;
+    int num3 = 5;
+    uint64_t key = 0;
+    ck_assert_int_eq(0, rheap_insert(p_rheap, 20, &num2));
+    ck_assert_int_eq(0, rheap_insert(p_rheap, 5, &num3));
+    ck_assert(&num3 == rheap_peek(p_rheap, &key));
+    ck_assert_uint_eq(5, key);
+    ck_assert(&num3 == rheap_pull(p_rheap, &key));
+    // keys below the last pulled key break the monotone contract
+    ck_assert_int_eq(-1, rheap_insert(p_rheap, 4, &num3));
+    ck_assert_int_eq(0, rheap_insert(p_rheap, 5, &num3));
+    ck_assert(&num3 == rheap_pull(p_rheap, NULL));
+    ck_assert(&num == rheap_pull(p_rheap, &key));
+    ck_assert_uint_eq(10, key);
+    ck_assert(&num2 == rheap_pull(p_rheap, &key));
+    ck_assert_uint_eq(20, key);
+    ck_assert(NULL == rheap_pull(p_rheap, &key));
+    ck_assert_int_eq(0, destroyed);
+} END_TEST
+
+START_TEST(test_rheap_peek)
+{
+    int num2 = 100;
+    int num3 = 50;
+    int num4 = 100;
+    uint64_t key = 0;
+    ck_assert(&num == rheap_pull(p_rheap, NULL));
+    ck_assert_int_eq(0, rheap_insert(p_rheap, 100, &num2));
+    ck_assert(&num2 == rheap_peek(p_rheap, &key));
+    ck_assert_uint_eq(100, key);
+    // a peek must not raise the smallest key that can be inserted
+    ck_assert_int_eq(0, rheap_insert(p_rheap, 50, &num3));
+    ck_assert(&num3 == rheap_peek(p_rheap, &key));
+    ck_assert_uint_eq(50, key);
+    ck_assert(&num3 == rheap_pull(p_rheap, NULL));
+    // with equal keys the peek shows the data the pull takes
+    ck_assert_int_eq(0, rheap_insert(p_rheap, 100, &num4));
+    void * p_peeked = rheap_peek(p_rheap, NULL);
+    ck_assert(p_peeked == rheap_pull(p_rheap, &key));
+    ck_assert_uint_eq(100, key);
+    p_peeked = rheap_peek(p_rheap, NULL);
+    ck_assert(p_peeked == rheap_pull(p_rheap, NULL));
+    ck_assert(NULL == rheap_peek(p_rheap, NULL));
+} END_TEST
+
+START_TEST(test_rheap_monotone)
+{
+    // a simulated event queue where every event schedules later ones
+    static int events[3000];
+    uint64_t last = 10;
+    uint64_t key = 0;
+    srand(32);
+    for (int index = 0; index < 1000; index++){
+        ck_assert_int_eq(0, rheap_insert(p_rheap, 10 + (rand() % 100000), &events[index]));
+    }
+    int next = 1000;
+    while (0 != rheap_size(p_rheap)){
+        void * p_peeked = rheap_peek(p_rheap, NULL);
+        ck_assert(p_peeked == rheap_pull(p_rheap, &key));
+        ck_assert(last <= key);
+        last = key;
+        if ((next < 3000) && (rand() % 2)){
+            uint64_t later = key + ((rand() % 3) ? (uint64_t)(rand() % 50) : ((uint64_t)rand() << 20));
+            ck_assert_int_eq(0, rheap_insert(p_rheap, later, &events[next++]));
+        }
+    }
+} END_TEST
+
+START_TEST(test_rheap_destroy)
+{
+    static int events[100];
+    for (int index = 0; index < 100; index++){
+        rheap_insert(p_rheap, UINT64_MAX - index, &events[index]);
+    }
+    uint64_t key = 0;
+    ck_assert(&num == rheap_pull(p_rheap, &key));
+    // the widest gap between keys still lands in the top bucket
+    ck_assert(&events[99] == rheap_pull(p_rheap, &key));
+    ck_assert_uint_eq(UINT64_MAX - 99, key);
+    rheap_destroy(p_rheap);
+    ck_assert_int_eq(99, destroyed);
+    p_rheap = NULL;
+} END_TEST
+
+// create suite
+Suite * suite_rheap(void)
+{
+    Suite * p_suite = suite_create("Radix Heap");
+    TCase * p_core = tcase_create("Core");
+    // add test cases
+    tcase_add_checked_fixture(p_core, start_rheap, teardown_rheap);
+    tcase_add_test(p_core, test_rheap_init);
+    tcase_add_test(p_core, test_rheap_pull);
+    tcase_add_test(p_core, test_rheap_peek);
+    tcase_add_test(p_core, test_rheap_monotone);
+    tcase_add_test(p_core, test_rheap_destroy);
+    // add core to suite
+    suite_add_tcase(p_suite, p_core);
+    return p_suite;
+}
@@ -0,0 +1,228 @@
+#include <check.h>
+#include <test_twheel.h>
+#include <twheel.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+
+static int destroyed = 0;
+static void test_destroy(void * p_data)
+{
+    (void)p_data;
+    destroyed++;
+}
+
+static void * expired[4096];
+static int64_t num_expired = 0;
+static int batches = 0;
+static void test_expire(void ** pp_data, int64_t count)
+{
+    for (int64_t index = 0; index < count; index++){
+        expired[num_expired++] = pp_data[index];
+    }
+    batches++;
+}
+
+static twheel * p_twheel = NULL;
+static int num = 10;
+static void start_twheel(void)
+{
+    destroyed = 0;
+    num_expired = 0;
+    batches = 0;
+    p_twheel = twheel_init(0, 1, 4, test_destroy);
+    twheel_schedule(p_twheel, 10, &num);
+}
+
+static void teardown_twheel(void)
+{
+    twheel_destroy(p_twheel);
+}
+
+START_TEST(test_twheel_init)
+{
+    ck_assert(NULL != p_twheel);
+    ck_assert_int_eq(1, twheel_size(p_twheel));
+    ck_assert_int_eq(-1, twheel_size(NULL));
+    ck_assert(NULL == twheel_init(0, 0, 4, NULL));
+    ck_assert(NULL == twheel_init(0, 1, 0, NULL));
+    ck_assert(NULL == twheel_init(0, 1, 11, NULL));
+    ck_assert(NULL == twheel_schedule(p_twheel, 5, NULL));
+    ck_assert_int_eq(-1, twheel_cancel(p_twheel, NULL));
+    ck_assert_int_eq(-1, twheel_advance(p_twheel, 5, NULL));
+} END_TEST
+
+START_TEST(test_twheel_advance)
+{
+    int num2 = 20;
+    int num3 = 5;
+    twheel_schedule(p_twheel, 20, &num2);
+    twheel_schedule(p_twheel, 5, &num3);
+    ck_assert_int_eq(0, twheel_advance(p_twheel, 4, test_expire));
+    ck_assert_int_eq(1, twheel_advance(p_twheel, 5, test_expire));
+    ck_assert(&num3 == expired[0]);
+    // one batch holds every timer due by the new time in expiry order
+    ck_assert_int_eq(2, twheel_advance(p_twheel, 100, test_expire));
+    ck_assert(&num == expired[1]);
+    ck_assert(&num2 == expired[2]);
+    ck_assert_int_eq(2, batches);
+    ck_assert_int_eq(0, twheel_size(p_twheel));
+    // times already passed expire on the next advance
+    twheel_schedule(p_twheel, 50, &num);
+    ck_assert_int_eq(1, twheel_advance(p_twheel, 100, test_expire));
+    ck_assert_int_eq(0, destroyed);
+} END_TEST
+
+START_TEST(test_twheel_cancel)
+{
+    int num2 = 20;
+    twtimer * p_timer = twheel_schedule(p_twheel, 20, &num2);
+    ck_assert_int_eq(0, twheel_cancel(p_twheel, p_timer));
+    ck_assert_int_eq(1, destroyed);
+    ck_assert_int_eq(1, twheel_size(p_twheel));
+    ck_assert_int_eq(1, twheel_advance(p_twheel, 30, test_expire));
+    ck_assert(&num == expired[0]);
+} END_TEST
+
+START_TEST(test_twheel_cascade)
+{
+    // times spread over every level and past the last one
+    static uint64_t times[3000];
+    srand(34);
+    for (int index = 0; index < 3000; index++){
+        times[index] = 11 + ((uint64_t)rand() % ((index % 3) ? 5000 : 40000000));
+        ck_assert(NULL != twheel_schedule(p_twheel, times[index], &times[index]));
+    }
+    uint64_t now = 0;
+    uint64_t last = 0;
+    while (0 != twheel_size(p_twheel)){
+        now += 1 + ((uint64_t)rand() % 2000);
+        int64_t start = num_expired;
+        twheel_advance(p_twheel, now, test_expire);
+        for (int64_t index = start; index < num_expired; index++){
+            if (&num == expired[index]){
+                continue;
+            }
+            uint64_t time = *(uint64_t *)expired[index];
+            // nothing expires early or out of order or later than its tick
+            ck_assert(time <= now);
+            ck_assert(time + 2000 >= now);
+            ck_assert(time >= last);
+            last = time;
+        }
+        num_expired = 0;
+    }
+} END_TEST
+
+START_TEST(test_twheel_tick)
+{
+    int num2 = 20;
+    twheel * p_coarse = twheel_init(1000, 10, 2, NULL);
+    twheel_schedule(p_coarse, 1001, &num);
+    twheel_schedule(p_coarse, 1010, &num2);
+    // times round up to the next tick
+    ck_assert_int_eq(0, twheel_advance(p_coarse, 1009, test_expire));
+    ck_assert_int_eq(2, twheel_advance(p_coarse, 1010, test_expire));
+    twheel_destroy(p_coarse);
+} END_TEST
+
+START_TEST(test_twheel_span)
+{
+    // timers past the ticks the levels cover must still wait until due
+    static uint64_t times[3] = {1000, 5000, 70000};
+    for (int levels = 1; levels <= 2; levels++){
+        twheel * p_short = twheel_init(0, 1, levels, NULL);
+        for (int index = 0; index < 3; index++){
+            twheel_schedule(p_short, times[index], &times[index]);
+        }
+        num_expired = 0;
+        for (uint64_t now = 1; now <= 70000; now++){
+            int64_t count = twheel_advance(p_short, now, test_expire);
+            ck_assert_int_ne(-1, count);
+            for (int64_t index = num_expired - count; index < num_expired; index++){
+                ck_assert_int_eq(now, *(uint64_t *)expired[index]);
+            }
+        }
+        ck_assert_int_eq(3, num_expired);
+        ck_assert_int_eq(0, twheel_size(p_short));
+        twheel_destroy(p_short);
+    }
+} END_TEST
+
+START_TEST(test_twheel_destroy)
+{
+    static int timers[100];
+    for (int index = 0; index < 100; index++){
+        twheel_schedule(p_twheel, 1000 + index, &timers[index]);
+    }
+    twheel_advance(p_twheel, 1010, test_expire);
+    ck_assert_int_eq(12, num_expired);
+    twheel_destroy(p_twheel);
+    ck_assert_int_eq(89, destroyed);
+    p_twheel = NULL;
+} END_TEST
+
+/*
+ * @brief the test binary is linked with realloc wrapped so growing a buffer
+ *  past a size can be made to fail
+ */
+static size_t realloc_limit = 0;
+void * __real_realloc(void * p_memory, size_t size);
+void * __wrap_realloc(void * p_memory, size_t size)
+{
+    if ((0 != realloc_limit) && (size > realloc_limit)){
+        errno = ENOMEM;
+        return NULL;
+    }
+    return __real_realloc(p_memory, size);
+}
+
+static int64_t counted = 0;
+static void test_count(void ** pp_data, int64_t count)
+{
+    (void)pp_data;
+    counted += count;
+    batches++;
+}
+
+START_TEST(test_twheel_no_memory)
+{
+    static int timers[5000];
+    for (int index = 0; index < 5000; index++){
+        ck_assert(NULL != twheel_schedule(p_twheel, 20, &timers[index]));
+    }
+    // the expired buffer can hold 1024 pointers but not grow past them
+    realloc_limit = 1024 * sizeof(void *);
+    counted = 0;
+    int64_t retval = twheel_advance(p_twheel, 20, test_count);
+    realloc_limit = 0;
+    // the timers drained are handed over and the rest stay due
+    ck_assert_int_eq(-1, retval);
+    ck_assert_int_eq(1, batches);
+    ck_assert_int_eq(1024, counted);
+    ck_assert_int_eq(5001 - 1024, twheel_size(p_twheel));
+    ck_assert_int_eq(5001 - 1024, twheel_advance(p_twheel, 20, test_count));
+    ck_assert_int_eq(5001, counted);
+    ck_assert_int_eq(2, batches);
+    ck_assert_int_eq(0, twheel_size(p_twheel));
+} END_TEST
+
+// create suite
+Suite * suite_twheel(void)
+{
+    Suite * p_suite = suite_create("Timing Wheel");
+    TCase * p_core = tcase_create("Core");
+    // add test cases
+    tcase_add_checked_fixture(p_core, start_twheel, teardown_twheel);
+    tcase_add_test(p_core, test_twheel_init);
+    tcase_add_test(p_core, test_twheel_advance);
+    tcase_add_test(p_core, test_twheel_cancel);
+    tcase_add_test(p_core, test_twheel_cascade);
+    tcase_add_test(p_core, test_twheel_tick);
+    tcase_add_test(p_core, test_twheel_span);
+    tcase_add_test(p_core, test_twheel_destroy);
+    tcase_add_test(p_core, test_twheel_no_memory);
+    // add core to suite
+    suite_add_tcase(p_suite, p_core);
+    return p_suite;
+}
@@ -0,0 +1,168 @@
+#include <check.h>
+#include <test_xheap.h>
+#include <xheap.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <signal.h>
+#include <sys/resource.h>
+
+/*
+ * @brief a record with a key and a payload checked on the way out
+ */
+typedef struct test_record {
+    int key;
+    int check;
+} test_record;
+
+static int8_t test_compare(void * p_key1, void * p_key2)
+{
+    int key1 = ((test_record *)p_key1)->key;
+    int key2 = ((test_record *)p_key2)->key;
+    return (key1 < key2) ? -1 : ((key1 == key2) ? 0 : 1);
+}
+
+static xheap * p_xheap = NULL;
+static void start_xheap(void)
+{
+    // room for 64 records in memory and 4 runs of 16 records
+    p_xheap = xheap_init(MIN, sizeof(test_record), 1024, test_compare);
+    test_record record = {10, -10};
+    xheap_push(p_xheap, &record);
+}
+
+static void teardown_xheap(void)
+{
+    xheap_destroy(p_xheap);
+}
+
+START_TEST(test_xheap_init)
+{
+    test_record record = {0, 0};
+    ck_assert(NULL != p_xheap);
+    ck_assert_int_eq(1, xheap_size(p_xheap));
+    ck_assert_int_eq(0, xheap_runs(p_xheap));
+    ck_assert_int_eq(-1, xheap_size(NULL));
+    ck_assert(NULL == xheap_init(MIN, 0, 1024, test_compare));
+    ck_assert(NULL == xheap_init(MIN, sizeof(test_record), 16, test_compare));
+    ck_assert(NULL == xheap_init(MIN, sizeof(test_record), 1024, NULL));
+    ck_assert_int_eq(-1, xheap_push(p_xheap, NULL));
+    ck_assert_int_eq(10, ((test_record *)xheap_top(p_xheap))->key);
+    ck_assert_int_eq(0, xheap_pop(p_xheap, &record));
+    ck_assert_int_eq(-10, record.check);
+    ck_assert_int_eq(-1, xheap_pop(p_xheap, &record));
+    ck_assert(NULL == xheap_top(p_xheap));
+} END_TEST
+
+START_TEST(test_xheap_spill)
+{
+    // far more records than fit in memory so runs spill and get compacted
+    srand(37);
+    for (int index = 0; index < 5000; index++){
+        test_record record = {rand() % 100000, 0};
+        record.check = -record.key;
+        ck_assert_int_eq(0, xheap_push(p_xheap, &record));
+        ck_assert_int_le(xheap_runs(p_xheap), 4);
+    }
+    ck_assert_int_gt(xheap_runs(p_xheap), 0);
+    ck_assert_int_eq(5001, xheap_size(p_xheap));
+    int last = -1;
+    for (int index = 0; index < 5001; index++){
+        test_record record = {0, 1};
+        int top = ((test_record *)xheap_top(p_xheap))->key;
+        ck_assert_int_eq(0, xheap_pop(p_xheap, &record));
+        ck_assert_int_eq(top, record.key);
+        ck_assert_int_eq(-record.key, record.check);
+        ck_assert_int_ge(record.key, last);
+        last = record.key;
+    }
+    ck_assert_int_eq(0, xheap_size(p_xheap));
+    ck_assert_int_eq(0, xheap_runs(p_xheap));
+} END_TEST
+
+START_TEST(test_xheap_mixed)
+{
+    // pushes between pops may beat the heads of runs already on disk
+    xheap * p_max = xheap_init(MAX, sizeof(test_record), 1024, test_compare);
+    int pushed = 0;
+    int popped = 0;
+    int last = 1 << 30;
+    srand(38);
+    for (int round = 0; round < 50; round++){
+        for (int index = 0; index < 200; index++){
+            test_record record = {rand() % 100000, 0};
+            xheap_push(p_max, &record);
+            pushed++;
+        }
+        // keys pushed after a pop can be larger than the last popped key
+        last = 1 << 30;
+        for (int index = 0; index < 150; index++){
+            test_record record;
+            ck_assert_int_eq(0, xheap_pop(p_max, &record));
+            ck_assert_int_le(record.key, last);
+            last = record.key;
+            popped++;
+        }
+    }
+    ck_assert_int_eq(pushed - popped, xheap_size(p_max));
+    xheap_destroy(p_max);
+} END_TEST
+
+START_TEST(test_xheap_full_disk)
+{
+    // runs of 64 records fit under the file limit but a compacted run does
+    // not, so the compaction has to fail and put the merged runs back
+    struct rlimit limit;
+    struct rlimit small;
+    int8_t results[320];
+    getrlimit(RLIMIT_FSIZE, &limit);
+    small = limit;
+    small.rlim_cur = 768;
+    signal(SIGXFSZ, SIG_IGN);
+    srand(39);
+    // nothing is asserted while the limit is down as check writes to files
+    setrlimit(RLIMIT_FSIZE, &small);
+    for (int index = 0; index < 320; index++){
+        test_record record = {rand() % 100000, 0};
+        record.check = -record.key;
+        results[index] = xheap_push(p_xheap, &record);
+    }
+    setrlimit(RLIMIT_FSIZE, &limit);
+    int pushed = 1;
+    for (int index = 0; index < 320; index++){
+        pushed += (0 == results[index]);
+    }
+    ck_assert_int_lt(pushed, 321);
+    ck_assert_int_eq(pushed, xheap_size(p_xheap));
+    ck_assert_int_eq(4, xheap_runs(p_xheap));
+    // once the disk has room the queue carries on with nothing lost
+    for (int index = 0; index < 100; index++){
+        test_record record = {rand() % 100000, 0};
+        record.check = -record.key;
+        ck_assert_int_eq(0, xheap_push(p_xheap, &record));
+    }
+    int last = -1;
+    for (int index = 0; index < pushed + 100; index++){
+        test_record record;
+        ck_assert_int_eq(0, xheap_pop(p_xheap, &record));
+        ck_assert_int_eq(-record.key, record.check);
+        ck_assert_int_ge(record.key, last);
+        last = record.key;
+    }
+    ck_assert_int_eq(0, xheap_size(p_xheap));
+} END_TEST
+
+// create suite
+Suite * suite_xheap(void)
+{
+    Suite * p_suite = suite_create("External Heap");
+    TCase * p_core = tcase_create("Core");
+    // add test cases
+    tcase_add_checked_fixture(p_core, start_xheap, teardown_xheap);
+    tcase_add_test(p_core, test_xheap_init);
+    tcase_add_test(p_core, test_xheap_spill);
+    tcase_add_test(p_core, test_xheap_mixed);
+    tcase_add_test(p_core, test_xheap_full_disk);
+    // add core to suite
+    suite_add_tcase(p_suite, p_core);
+    return p_suite;
+}
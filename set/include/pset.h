@@ -0,0 +1,16 @@
+#ifndef _PSET_H
+#define _PSET_H
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+typedef struct pset pset;
+pset * pset_init(void (* destroy)(void * p_data), int (* compare)(void * key1, void * key2), uint32_t (* hash)(void * p_data));
+void pset_destroy(pset * p_set);
+pset * pset_snapshot(pset * p_set);
+pset * pset_insert(pset * p_set, void * p_data);
+pset * pset_remove(pset * p_set, void * p_data);
+void * pset_is_member(pset * p_set, void * p_data);
+int8_t pset_iter(pset * p_set, void (* func)(void * p_data));
+// getters
+size_t pset_size(pset * p_set);
+#endif
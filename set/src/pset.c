@@ -0,0 +1,636 @@
+#include <pset.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/*
+ * @param BITS the number of hash bits consumed at each level of the trie
+ * @param WIDTH the maximum number of children of a branch node
+ */
+enum {BITS = 5, WIDTH = 32};
+
+/*
+ * @brief the kinds of nodes stored in a persistent set
+ * @param LEAF a node holding a single member
+ * @param BRANCH a node indexing up to WIDTH children by a bitmap
+ * @param COLLISION a node holding leaves whose hashes are all equal
+ */
+enum {LEAF, BRANCH, COLLISION};
+
+/*
+ * @brief a node in the hash array mapped trie, nodes are never modified
+ *  once they are reachable from a version of the set
+ * @param refs the number of versions and parent nodes referencing the node
+ * @param type the kind of node, LEAF BRANCH or COLLISION
+ * @param hash the hash of the member(s) for LEAF and COLLISION nodes
+ * @param bitmap the occupied child slots of a BRANCH node
+ * @param count the number of children of a BRANCH or COLLISION node
+ * @param p_data the member of a LEAF node
+ * @param p_children the children of a BRANCH or COLLISION node
+ */
+typedef struct pset_node {
+    atomic_long refs;
+    uint8_t type;
+    uint32_t hash;
+    uint32_t bitmap;
+    uint32_t count;
+    void * p_data;
+    struct pset_node * p_children[];
+} pset_node;
+
+/*
+ * @brief a single version of a persistent set
+ * @param destroy user defined function to tear down members no version references
+ * @param compare user defined function returning 0 when two members are equal
+ * @param hash user defined function hashing a member
+ * @param p_root the root node of this version
+ * @param size the number of members in this version
+ */
+struct pset {
+    void (* destroy)(void * p_data);
+    int (* compare)(void * key1, void * key2);
+    uint32_t (* hash)(void * p_data);
+    pset_node * p_root;
+    size_t size;
+};
+
+/*
+ * @brief allocates a node with room for a number of children
+ * @param type the kind of node to allocate
+ * @param count the number of children the node will hold
+ * @return the new node with a single reference or NULL on error
+ */
+static pset_node * node_alloc(uint8_t type, uint32_t count)
+{
+    pset_node * p_node = calloc(1, sizeof(*p_node) + (count * sizeof(pset_node *)));
+    if (NULL == p_node){
+        return NULL;
+    }
+    atomic_init(&p_node->refs, 1);
+    p_node->type = type;
+    p_node->count = count;
+    return p_node;
+}
+
+/*
+ * @brief takes a reference to a node
+ * @param p_node the node to reference
+ * @return the referenced node
+ */
+static pset_node * node_retain(pset_node * p_node)
+{
+    if (NULL != p_node){
+        atomic_fetch_add_explicit(&p_node->refs, 1, memory_order_relaxed);
+    }
+    return p_node;
+}
+
+/*
+ * @brief drops a reference to a node freeing it and its unreferenced
+ *  children once the last reference is gone
+ * @param p_set the set providing the destroy function
+ * @param p_node the node to release
+ */
+static void node_release(pset * p_set, pset_node * p_node)
+{
+    if (NULL == p_node){
+        return;
+    }
+    if (1 != atomic_fetch_sub_explicit(&p_node->refs, 1, memory_order_acq_rel)){
+        return;
+    }
+    // the last reference is gone so tear down the node
+    if (LEAF == p_node->type){
+        if (NULL != p_set->destroy){
+            p_set->destroy(p_node->p_data);
+        }
+    }
+    else {
+        for (uint32_t index = 0; index < p_node->count; index++){
+            node_release(p_set, p_node->p_children[index]);
+        }
+    }
+    free(p_node);
+}
+
+/*
+ * @brief creates a new leaf node
+ * @param hash the hash of the member
+ * @param p_data the member
+ * @return the new leaf or NULL on error
+ */
+static pset_node * leaf_init(uint32_t hash, void * p_data)
+{
+    pset_node * p_leaf = node_alloc(LEAF, 0);
+    if (NULL == p_leaf){
+        return NULL;
+    }
+    p_leaf->hash = hash;
+    p_leaf->p_data = p_data;
+    return p_leaf;
+}
+
+/*
+ * @brief gets the slot of a hash at a level of the trie
+ * @param hash the hash to get the slot from
+ * @param shift the number of hash bits consumed above this level
+ * @return the bit identifying the slot in a branch bitmap
+ */
+static uint32_t hash_bit(uint32_t hash, uint32_t shift)
+{
+    return (uint32_t)1 << ((hash >> shift) & (WIDTH - 1));
+}
+
+/*
+ * @brief gets the position of a slot in the children of a branch
+ * @param p_node the branch node
+ * @param bit the slot bit
+ * @return index into p_children for the slot
+ */
+static uint32_t branch_index(pset_node * p_node, uint32_t bit)
+{
+    return (uint32_t)__builtin_popcount(p_node->bitmap & (bit - 1));
+}
+
+/*
+ * @brief copies a branch or collision node while replacing, adding or
+ *  dropping one child, every child carried over is referenced by the copy
+ * @param p_node the node to copy
+ * @param index the position of the child to change
+ * @param p_child the new child at index or NULL to drop the child
+ * @param b_add true if p_child is added at index instead of replacing
+ * @return the new node or NULL on error
+ */
+static pset_node * node_copy(pset_node * p_node, uint32_t index, pset_node * p_child, bool b_add)
+{
+    uint32_t count = p_node->count;
+    if (b_add){
+        count++;
+    }
+    else if (NULL == p_child){
+        count--;
+    }
+    pset_node * p_copy = node_alloc(p_node->type, count);
+    if (NULL == p_copy){
+        return NULL;
+    }
+    p_copy->hash = p_node->hash;
+    p_copy->bitmap = p_node->bitmap;
+    uint32_t dest = 0;
+    for (uint32_t source = 0; source < p_node->count; source++){
+        if (source == index){
+            if (NULL != p_child){
+                p_copy->p_children[dest++] = p_child;
+            }
+            if (!b_add){
+                continue;
+            }
+        }
+        p_copy->p_children[dest++] = node_retain(p_node->p_children[source]);
+    }
+    if (b_add && (index == p_node->count)){
+        p_copy->p_children[dest] = p_child;
+    }
+    return p_copy;
+}
+
+/*
+ * @brief joins two nodes whose hashes differ below a level into one subtree,
+ *  the references to both nodes are taken over and released on error
+ * @param p_set the set the nodes belong to
+ * @param p_old a leaf or collision node already in the set
+ * @param p_new a leaf node being added to the set
+ * @param shift the number of hash bits consumed above this level
+ * @return the new subtree referencing both nodes or NULL on error
+ */
+static pset_node * node_merge(pset * p_set, pset_node * p_old, pset_node * p_new, uint32_t shift)
+{
+    pset_node * p_node = NULL;
+    // equal hashes can only be told apart by the compare function
+    if (p_old->hash == p_new->hash){
+        if (LEAF == p_old->type){
+            p_node = node_alloc(COLLISION, 2);
+            if (NULL != p_node){
+                p_node->hash = p_old->hash;
+                p_node->p_children[0] = p_old;
+                p_node->p_children[1] = p_new;
+                return p_node;
+            }
+        }
+        else {
+            p_node = node_copy(p_old, p_old->count, p_new, true);
+            if (NULL != p_node){
+                node_release(p_set, p_old);
+                return p_node;
+            }
+        }
+        node_release(p_set, p_old);
+        node_release(p_set, p_new);
+        return NULL;
+    }
+    uint32_t old_bit = hash_bit(p_old->hash, shift);
+    uint32_t new_bit = hash_bit(p_new->hash, shift);
+    if (old_bit == new_bit){
+        // both hashes share this slot so push them down a level
+        pset_node * p_child = node_merge(p_set, p_old, p_new, shift + BITS);
+        if (NULL == p_child){
+            return NULL;
+        }
+        p_node = node_alloc(BRANCH, 1);
+        if (NULL == p_node){
+            node_release(p_set, p_child);
+            return NULL;
+        }
+        p_node->bitmap = old_bit;
+        p_node->p_children[0] = p_child;
+        return p_node;
+    }
+    p_node = node_alloc(BRANCH, 2);
+    if (NULL == p_node){
+        node_release(p_set, p_old);
+        node_release(p_set, p_new);
+        return NULL;
+    }
+    p_node->bitmap = old_bit | new_bit;
+    p_node->p_children[(old_bit < new_bit) ? 0 : 1] = p_old;
+    p_node->p_children[(old_bit < new_bit) ? 1 : 0] = p_new;
+    return p_node;
+}
+
+/*
+ * @brief builds the path copy of a subtree with a member added
+ * @param p_set the set being inserted into
+ * @param p_node the root of the subtree
+ * @param hash the hash of the new member
+ * @param shift the number of hash bits consumed above this level
+ * @param p_data the new member
+ * @param p_added set to true if the member was not already in the subtree
+ * @return the new subtree or NULL on error
+ */
+static pset_node * insert(pset * p_set, pset_node * p_node, uint32_t hash, uint32_t shift, void * p_data, bool * p_added)
+{
+    pset_node * p_leaf = NULL;
+    pset_node * p_child = NULL;
+    pset_node * p_copy = NULL;
+    // an empty subtree becomes a single leaf
+    if (NULL == p_node){
+        *p_added = true;
+        return leaf_init(hash, p_data);
+    }
+    switch (p_node->type){
+        case LEAF:
+            if ((p_node->hash == hash) && (0 == p_set->compare(p_node->p_data, p_data))){
+                return node_retain(p_node);
+            }
+            break;
+        case COLLISION:
+            if (p_node->hash == hash){
+                for (uint32_t index = 0; index < p_node->count; index++){
+                    if (0 == p_set->compare(p_node->p_children[index]->p_data, p_data)){
+                        return node_retain(p_node);
+                    }
+                }
+            }
+            break;
+        case BRANCH: {
+            uint32_t bit = hash_bit(hash, shift);
+            uint32_t index = branch_index(p_node, bit);
+            if (0 == (p_node->bitmap & bit)){
+                // the slot is free so the new leaf goes straight into the copy
+                p_leaf = leaf_init(hash, p_data);
+                if (NULL == p_leaf){
+                    return NULL;
+                }
+                p_copy = node_copy(p_node, index, p_leaf, true);
+                if (NULL == p_copy){
+                    node_release(p_set, p_leaf);
+                    return NULL;
+                }
+                p_copy->bitmap |= bit;
+                *p_added = true;
+                return p_copy;
+            }
+            p_child = insert(p_set, p_node->p_children[index], hash, shift + BITS, p_data, p_added);
+            if (NULL == p_child){
+                return NULL;
+            }
+            if (!(*p_added)){
+                // the member was found so this version can be shared as is
+                node_release(p_set, p_child);
+                return node_retain(p_node);
+            }
+            p_copy = node_copy(p_node, index, p_child, false);
+            if (NULL == p_copy){
+                node_release(p_set, p_child);
+            }
+            return p_copy;
+        }
+    }
+    // the leaf or collision does not hold the member so split it
+    p_leaf = leaf_init(hash, p_data);
+    if (NULL == p_leaf){
+        return NULL;
+    }
+    p_copy = node_merge(p_set, node_retain(p_node), p_leaf, shift);
+    if (NULL == p_copy){
+        return NULL;
+    }
+    *p_added = true;
+    return p_copy;
+}
+
+/*
+ * @brief builds the path copy of a subtree with a member removed
+ * @param p_set the set being removed from
+ * @param p_node the root of the subtree
+ * @param hash the hash of the member to remove
+ * @param shift the number of hash bits consumed above this level
+ * @param p_data the member to remove
+ * @param p_removed set to true if the member was found in the subtree
+ * @param p_error set to true on allocation failure
+ * @return the new subtree which may be NULL when it becomes empty
+ */
+static pset_node * erase(pset * p_set, pset_node * p_node, uint32_t hash, uint32_t shift, void * p_data, bool * p_removed, bool * p_error)
+{
+    pset_node * p_child = NULL;
+    pset_node * p_copy = NULL;
+    if (NULL == p_node){
+        return NULL;
+    }
+    switch (p_node->type){
+        case LEAF:
+            if ((p_node->hash == hash) && (0 == p_set->compare(p_node->p_data, p_data))){
+                *p_removed = true;
+                return NULL;
+            }
+            return node_retain(p_node);
+        case COLLISION:
+            if (p_node->hash == hash){
+                for (uint32_t index = 0; index < p_node->count; index++){
+                    if (0 != p_set->compare(p_node->p_children[index]->p_data, p_data)){
+                        continue;
+                    }
+                    *p_removed = true;
+                    // a collision of two collapses into the remaining leaf
+                    if (2 == p_node->count){
+                        return node_retain(p_node->p_children[(0 == index) ? 1 : 0]);
+                    }
+                    p_copy = node_copy(p_node, index, NULL, false);
+                    if (NULL == p_copy){
+                        *p_error = true;
+                    }
+                    return p_copy;
+                }
+            }
+            return node_retain(p_node);
+    }
+    uint32_t bit = hash_bit(hash, shift);
+    uint32_t index = branch_index(p_node, bit);
+    if (0 == (p_node->bitmap & bit)){
+        return node_retain(p_node);
+    }
+    p_child = erase(p_set, p_node->p_children[index], hash, shift + BITS, p_data, p_removed, p_error);
+    if (*p_error){
+        return NULL;
+    }
+    if (!(*p_removed)){
+        node_release(p_set, p_child);
+        return node_retain(p_node);
+    }
+    if (NULL == p_child){
+        if (1 == p_node->count){
+            return NULL;
+        }
+        // pull a lone leaf or collision up so the trie stays minimal
+        if ((2 == p_node->count) && (BRANCH != p_node->p_children[(0 == index) ? 1 : 0]->type)){
+            return node_retain(p_node->p_children[(0 == index) ? 1 : 0]);
+        }
+        p_copy = node_copy(p_node, index, NULL, false);
+        if (NULL != p_copy){
+            p_copy->bitmap &= ~bit;
+        }
+    }
+    else if ((1 == p_node->count) && (BRANCH != p_child->type)){
+        return p_child;
+    }
+    else {
+        p_copy = node_copy(p_node, index, p_child, false);
+        if (NULL == p_copy){
+            node_release(p_set, p_child);
+        }
+    }
+    if (NULL == p_copy){
+        *p_error = true;
+    }
+    return p_copy;
+}
+
+/*
+ * @brief runs a function on every member in a subtree
+ * @param p_node the root of the subtree
+ * @param func the function to run
+ */
+static void iter(pset_node * p_node, void (* func)(void * p_data))
+{
+    if (NULL == p_node){
+        return;
+    }
+    if (LEAF == p_node->type){
+        func(p_node->p_data);
+        return;
+    }
+    for (uint32_t index = 0; index < p_node->count; index++){
+        iter(p_node->p_children[index], func);
+    }
+}
+
+/*
+ * @brief creates a new version sharing the configuration of another
+ * @param p_set the version to copy the configuration from
+ * @param p_root the root of the new version, the reference is taken over
+ * @param size the number of members in the new version
+ * @return the new version or NULL on error
+ */
+static pset * pset_version(pset * p_set, pset_node * p_root, size_t size)
+{
+    pset * p_version = calloc(1, sizeof(*p_version));
+    if (NULL == p_version){
+        node_release(p_set, p_root);
+        return NULL;
+    }
+    p_version->destroy = p_set->destroy;
+    p_version->compare = p_set->compare;
+    p_version->hash = p_set->hash;
+    p_version->p_root = p_root;
+    p_version->size = size;
+    return p_version;
+}
+
+/*
+ * @brief creates an empty persistent set
+ * @param destroy user defined function to tear down a member once no
+ *  version of the set holds it
+ * @param compare user defined function returning 0 when members are equal
+ * @param hash user defined function hashing a member, equal members must
+ *  have equal hashes
+ * @return a newly allocated empty set or NULL on error
+ */
+pset * pset_init(void (* destroy)(void * p_data), int (* compare)(void * key1, void * key2), uint32_t (* hash)(void * p_data))
+{
+    // members can not be found without compare and hash functions
+    if ((NULL == compare) || (NULL == hash)){
+        return NULL;
+    }
+    pset * p_set = calloc(1, sizeof(*p_set));
+    if (NULL == p_set){
+        return NULL;
+    }
+    p_set->destroy = destroy;
+    p_set->compare = compare;
+    p_set->hash = hash;
+    p_set->p_root = NULL;
+    p_set->size = 0;
+    return p_set;
+}
+
+/*
+ * @brief releases a version of a set, members are only torn down once
+ *  every version holding them has been released
+ * @param p_set the version to release
+ */
+void pset_destroy(pset * p_set)
+{
+    if (NULL == p_set){
+        return;
+    }
+    node_release(p_set, p_set->p_root);
+    free(p_set);
+}
+
+/*
+ * @brief creates a new version of a set with the same members in O(1),
+ *  the versions share every node and may be used from different threads
+ *  without locking
+ * @param p_set the version to snapshot
+ * @return the new version or NULL on error
+ */
+pset * pset_snapshot(pset * p_set)
+{
+    if (NULL == p_set){
+        return NULL;
+    }
+    return pset_version(p_set, node_retain(p_set->p_root), p_set->size);
+}
+
+/*
+ * @brief creates a new version of a set with a member added, the passed
+ *  version is left unchanged
+ * @param p_set the version to add the member to
+ * @param p_data the member to add
+ * @return the new version or NULL on error, if the member is already in the
+ *  set the new version shares its root with p_set
+ */
+pset * pset_insert(pset * p_set, void * p_data)
+{
+    // do not insert into a null set or insert null data
+    if ((NULL == p_set) || (NULL == p_data)){
+        return NULL;
+    }
+    bool b_added = false;
+    pset_node * p_root = insert(p_set, p_set->p_root, p_set->hash(p_data), 0, p_data, &b_added);
+    if (NULL == p_root){
+        return NULL;
+    }
+    return pset_version(p_set, p_root, b_added ? p_set->size + 1 : p_set->size);
+}
+
+/*
+ * @brief creates a new version of a set with a member removed, the passed
+ *  version is left unchanged
+ * @param p_set the version to remove the member from
+ * @param p_data data equal to the member to remove
+ * @return the new version or NULL on error, if the member is not in the
+ *  set the new version shares its root with p_set
+ */
+pset * pset_remove(pset * p_set, void * p_data)
+{
+    // do not remove from a null set or remove null data
+    if ((NULL == p_set) || (NULL == p_data)){
+        return NULL;
+    }
+    bool b_removed = false;
+    bool b_error = false;
+    pset_node * p_root = erase(p_set, p_set->p_root, p_set->hash(p_data), 0, p_data, &b_removed, &b_error);
+    if (b_error){
+        return NULL;
+    }
+    return pset_version(p_set, p_root, b_removed ? p_set->size - 1 : p_set->size);
+}
+
+/*
+ * @brief checks if data is a member of a version of a set
+ * @param p_set the version to search
+ * @param p_data the data to search for
+ * @return the member equal to p_data or NULL if it is not in the set
+ */
+void * pset_is_member(pset * p_set, void * p_data)
+{
+    // do not search in a null set or for null data
+    if ((NULL == p_set) || (NULL == p_data)){
+        return NULL;
+    }
+    uint32_t hash = p_set->hash(p_data);
+    uint32_t shift = 0;
+    pset_node * p_node = p_set->p_root;
+    while ((NULL != p_node) && (BRANCH == p_node->type)){
+        uint32_t bit = hash_bit(hash, shift);
+        if (0 == (p_node->bitmap & bit)){
+            return NULL;
+        }
+        p_node = p_node->p_children[branch_index(p_node, bit)];
+        shift += BITS;
+    }
+    if ((NULL == p_node) || (p_node->hash != hash)){
+        return NULL;
+    }
+    if (LEAF == p_node->type){
+        return (0 == p_set->compare(p_node->p_data, p_data)) ? p_node->p_data : NULL;
+    }
+    for (uint32_t index = 0; index < p_node->count; index++){
+        if (0 == p_set->compare(p_node->p_children[index]->p_data, p_data)){
+            return p_node->p_children[index]->p_data;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * @brief runs a function on every member of a version of a set
+ * @param p_set the version to iterate over
+ * @param func the function to run on each member
+ * @return 0 on success else -1
+ */
+int8_t pset_iter(pset * p_set, void (* func)(void * p_data))
+{
+    if ((NULL == p_set) || (NULL == func)){
+        return -1;
+    }
+    iter(p_set->p_root, func);
+    return 0;
+}
+
+// getters
+
+/*
+ * @brief gets the number of members in a version of a set
+ * @param p_set the version to get the size of
+ * @return the number of members or 0 for a null set
+ */
+size_t pset_size(pset * p_set)
+{
+    if (NULL == p_set){
+        return 0;
+    }
+    return p_set->size;
+}
@@ -0,0 +1,5 @@
+#ifndef _TEST_PSET_H
+#define _TEST_PSET_H
+#include <check.h>
+Suite * suite_pset(void);
+#endif
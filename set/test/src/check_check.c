@@ -1,14 +1,17 @@
 #include <check.h>
 #include <stdlib.h>
 #include <test_set.h>
+#include <test_pset.h>
 
 int main(void)
 {
     int num_failed = 0;
     // create the test suites
     Suite * p_set = suite_set();
+    Suite * p_pset = suite_pset();
     // create and add to suite runner
     SRunner * p_srunner = srunner_create(p_set);
+    srunner_add_suite(p_srunner, p_pset);
     srunner_set_fork_status(p_srunner, CK_NOFORK);
     // run all test
     srunner_run_all(p_srunner, CK_NORMAL);
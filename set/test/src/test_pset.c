@@ -0,0 +1,186 @@
+#include <check.h>
+#include <test_pset.h>
+#include <pset.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+
+static int test_compare(void * key1, void * key2)
+{
+    return *(int *)key1 == *(int*)key2 ? 0 : -1;
+}
+
+static uint32_t test_hash(void * p_data)
+{
+    return (uint32_t)(*(int *)p_data) * 2654435761u;
+}
+
+// every key lands in the same collision node
+static uint32_t test_hash_collide(void * p_data)
+{
+    return (uint32_t)(*(int *)p_data) % 2;
+}
+
+static int destroyed = 0;
+static void test_destroy(void * p_data)
+{
+    (void)p_data;
+    destroyed++;
+}
+
+static int nums[64];
+static pset * p_set = NULL;
+static void start_pset(void)
+{
+    for (int index = 0; index < 64; index++){
+        nums[index] = index * 10;
+    }
+    destroyed = 0;
+    p_set = pset_init(test_destroy, test_compare, test_hash);
+}
+
+static void teardown_pset(void)
+{
+    pset_destroy(p_set);
+}
+
+/*
+ * @brief replaces the version under test with a new one
+ */
+static void advance(pset * p_next)
+{
+    ck_assert(NULL != p_next);
+    pset_destroy(p_set);
+    p_set = p_next;
+}
+
+START_TEST(test_pset_init)
+{
+    ck_assert(NULL != p_set);
+    ck_assert_int_eq(0, pset_size(p_set));
+    ck_assert(NULL == pset_init(NULL, test_compare, NULL));
+} END_TEST
+
+START_TEST(test_pset_insert)
+{
+    int num10_too = 10;
+    for (int index = 0; index < 64; index++){
+        advance(pset_insert(p_set, &nums[index]));
+    }
+    ck_assert_int_eq(64, pset_size(p_set));
+    advance(pset_insert(p_set, &num10_too));
+    ck_assert_int_eq(64, pset_size(p_set));
+    ck_assert(&nums[1] == pset_is_member(p_set, &num10_too));
+    // replaced versions must not have torn down shared members
+    ck_assert_int_eq(0, destroyed);
+} END_TEST
+
+START_TEST(test_pset_remove)
+{
+    int missing = 5;
+    for (int index = 0; index < 64; index++){
+        advance(pset_insert(p_set, &nums[index]));
+    }
+    for (int index = 0; index < 64; index += 2){
+        advance(pset_remove(p_set, &nums[index]));
+    }
+    advance(pset_remove(p_set, &missing));
+    ck_assert_int_eq(32, pset_size(p_set));
+    ck_assert_int_eq(32, destroyed);
+    for (int index = 0; index < 64; index++){
+        ck_assert((index % 2) ? (NULL != pset_is_member(p_set, &nums[index])) : (NULL == pset_is_member(p_set, &nums[index])));
+    }
+} END_TEST
+
+START_TEST(test_pset_snapshot)
+{
+    for (int index = 0; index < 32; index++){
+        advance(pset_insert(p_set, &nums[index]));
+    }
+    pset * p_snapshot = pset_snapshot(p_set);
+    for (int index = 0; index < 32; index++){
+        advance(pset_remove(p_set, &nums[index]));
+    }
+    for (int index = 32; index < 64; index++){
+        advance(pset_insert(p_set, &nums[index]));
+    }
+    // the snapshot still sees exactly the members it was taken with
+    ck_assert_int_eq(32, pset_size(p_snapshot));
+    for (int index = 0; index < 64; index++){
+        ck_assert((index < 32) == (NULL != pset_is_member(p_snapshot, &nums[index])));
+        ck_assert((index >= 32) == (NULL != pset_is_member(p_set, &nums[index])));
+    }
+    ck_assert_int_eq(0, destroyed);
+    pset_destroy(p_snapshot);
+    ck_assert_int_eq(32, destroyed);
+} END_TEST
+
+START_TEST(test_pset_collision)
+{
+    pset * p_collide = pset_init(test_destroy, test_compare, test_hash_collide);
+    for (int index = 0; index < 16; index++){
+        pset * p_next = pset_insert(p_collide, &nums[index]);
+        pset_destroy(p_collide);
+        p_collide = p_next;
+    }
+    ck_assert_int_eq(16, pset_size(p_collide));
+    for (int index = 0; index < 16; index++){
+        ck_assert(&nums[index] == pset_is_member(p_collide, &nums[index]));
+    }
+    for (int index = 0; index < 15; index++){
+        pset * p_next = pset_remove(p_collide, &nums[index]);
+        pset_destroy(p_collide);
+        p_collide = p_next;
+    }
+    ck_assert_int_eq(1, pset_size(p_collide));
+    ck_assert(&nums[15] == pset_is_member(p_collide, &nums[15]));
+    pset_destroy(p_collide);
+    ck_assert_int_eq(16, destroyed);
+} END_TEST
+
+START_TEST(test_pset_random)
+{
+    // compare against a plain membership table over many versions
+    static int keys[4096];
+    bool present[4096] = {false};
+    size_t size = 0;
+    srand(26);
+    for (int index = 0; index < 4096; index++){
+        keys[index] = index;
+    }
+    for (int step = 0; step < 20000; step++){
+        int key = rand() % 4096;
+        if (rand() % 3){
+            advance(pset_insert(p_set, &keys[key]));
+            size += present[key] ? 0 : 1;
+            present[key] = true;
+        }
+        else {
+            advance(pset_remove(p_set, &keys[key]));
+            size -= present[key] ? 1 : 0;
+            present[key] = false;
+        }
+    }
+    ck_assert_uint_eq(size, pset_size(p_set));
+    for (int index = 0; index < 4096; index++){
+        ck_assert(present[index] == (NULL != pset_is_member(p_set, &keys[index])));
+    }
+} END_TEST
+
+// create suite
+Suite * suite_pset(void)
+{
+    Suite * p_suite = suite_create("PSET");
+    TCase * p_core = tcase_create("Core");
+    // add test cases
+    tcase_add_checked_fixture(p_core, start_pset, teardown_pset);
+    tcase_add_test(p_core, test_pset_init);
+    tcase_add_test(p_core, test_pset_insert);
+    tcase_add_test(p_core, test_pset_remove);
+    tcase_add_test(p_core, test_pset_snapshot);
+    tcase_add_test(p_core, test_pset_collision);
+    tcase_add_test(p_core, test_pset_random);
+    // add core to suite
+    suite_add_tcase(p_suite, p_core);
+    return p_suite;
+}